@@ -296,8 +296,13 @@ static int find_compatible_pertrans(AggState *aggstate, Aggref *newagg,
 						 Oid aggserialfn, Oid aggdeserialfn,
 						 Datum initValue, bool initValueIsNull,
 						 List *transnos);
+static bool yb_agg_group_cols_pushdown_supported(AggState *aggstate);
 static void yb_agg_pushdown_supported(AggState *aggstate);
 static void yb_agg_pushdown(AggState *aggstate);
+static void yb_agg_combine_pushdown_tuple(AggState *aggstate,
+							  AggStatePerGroup pergroup,
+							  TupleTableSlot *outerslot);
+static void yb_agg_fill_hash_table_pushdown(AggState *aggstate);
 
 
 /*
@@ -1522,6 +1527,52 @@ lookup_hash_entries(AggState *aggstate)
 	}
 }
 
+/*
+ * Evaluates whether grouping columns of hashed aggregation could be pushed
+ * down to DocDB along with the aggregates.
+ */
+static bool
+yb_agg_group_cols_pushdown_supported(AggState *aggstate)
+{
+	AggStatePerHash perhash = &aggstate->perhash[0];
+	List	   *outerTlist = outerPlanState(aggstate)->plan->targetlist;
+	int			i;
+
+	/*
+	 * Hash table should contain grouping columns only. Other columns, which
+	 * are needed by the target list or HAVING quals, are not returned by DocDB.
+	 */
+	if (perhash->numhashGrpCols != perhash->numCols)
+		return false;
+
+	for (i = 0; i < perhash->numCols; i++)
+	{
+		TargetEntry *tle = list_nth_node(TargetEntry, outerTlist,
+										 perhash->aggnode->grpColIdx[i] - 1);
+		Var		   *var;
+
+		/* Only support grouping by simple columns of the scanned table. */
+		if (!IsA(tle->expr, Var))
+			return false;
+		var = castNode(Var, tle->expr);
+		if (IS_SPECIAL_VARNO(var->varno) || var->varoattno <= 0)
+			return false;
+
+		/*
+		 * DocDB groups rows with byte-wise equal values. It is fine to return
+		 * several partial groups for values Postgres considers equal, since
+		 * the executor merges them, but byte-wise equal values should never be
+		 * distinct for Postgres. Types that are allowed to be YB keys are safe
+		 * in this respect. Like for MIN/MAX, non-C collations are not
+		 * supported.
+		 */
+		if (!YbDataTypeIsValidForKey(var->vartype) ||
+			YBIsCollationValidNonC(var->varcollid))
+			return false;
+	}
+	return true;
+}
+
 /*
  * Evaluates whether plan supports pushdowns of aggregates to DocDB, and sets
  * yb_pushdown_supported accordingly in AggState.
@@ -1537,15 +1588,25 @@ yb_agg_pushdown_supported(AggState *aggstate)
 	/* Initially set pushdown supported to false. */
 	aggstate->yb_pushdown_supported = false;
 
-	/* Phase 0 is a dummy phase, so there should be two phases. */
-	if (aggstate->numphases != 2)
-		return;
-
-	/* Plain agg strategy. */
-	if (aggstate->phase->aggstrategy != AGG_PLAIN)
+	if (aggstate->phase->aggstrategy == AGG_PLAIN)
+	{
+		/* Phase 0 is a dummy phase, so there should be two phases. */
+		if (aggstate->numphases != 2)
+			return;
+	}
+	else if (aggstate->phase->aggstrategy == AGG_HASHED)
+	{
+		/* Hashed GROUP BY, with a single hash table in the only phase. */
+		if (!yb_enable_group_by_pushdown ||
+			aggstate->numphases != 1 ||
+			aggstate->num_hashes != 1 ||
+			aggstate->numaggs == 0)
+			return;
+	}
+	else
 		return;
 
-	/* No GROUP BY. */
+	/* No GROUPING SETS. */
 	if (aggstate->phase->numsets != 0)
 		return;
 
@@ -1563,6 +1624,10 @@ yb_agg_pushdown_supported(AggState *aggstate)
 	if (scan_state->ss.ps.qual)
 		return;
 
+	if (aggstate->phase->aggstrategy == AGG_HASHED &&
+		!yb_agg_group_cols_pushdown_supported(aggstate))
+		return;
+
 	check_outer_plan = false;
 
 	foreach(lc_agg, aggstate->aggs)
@@ -1710,10 +1775,134 @@ yb_agg_pushdown(AggState *aggstate)
 		pushdown_aggs = lappend(pushdown_aggs, aggref);
 	}
 	scan_state->yb_fdw_aggs = pushdown_aggs;
+
+	if (aggstate->phase->aggstrategy == AGG_HASHED)
+	{
+		AggStatePerHash perhash = &aggstate->perhash[0];
+		List	   *outerTlist = outerPlanState(aggstate)->plan->targetlist;
+		List	   *group_cols = NIL;
+		int			i;
+
+		for (i = 0; i < perhash->numCols; i++)
+		{
+			TargetEntry *tle = list_nth_node(TargetEntry, outerTlist,
+											 perhash->aggnode->grpColIdx[i] - 1);
+
+			group_cols = lappend(group_cols, tle->expr);
+		}
+		scan_state->yb_fdw_group_cols = group_cols;
+	}
 	/* Disable projection for tuples produced by pushed down aggregate operators. */
 	scan_state->ss.ps.ps_ProjInfo = NULL;
 }
 
+/*
+ * Combines aggregate results of a tuple produced by pushed down aggregate
+ * operators into the transition states of a group. The first values of the
+ * tuple are the aggregate results, one for each aggno.
+ *
+ * We special case for COUNT and sum values so it returns the proper count
+ * aggregated across all responses.
+ */
+static void
+yb_agg_combine_pushdown_tuple(AggState *aggstate, AggStatePerGroup pergroup,
+							  TupleTableSlot *outerslot)
+{
+	int			aggno;
+
+	for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+	{
+		MemoryContext oldContext;
+		int transno = aggstate->peragg[aggno].transno;
+		Aggref *aggref = aggstate->peragg[aggno].aggref;
+		char *func_name = get_func_name(aggref->aggfnoid);
+		AggStatePerGroup pergroupstate = &pergroup[transno];
+		AggStatePerTrans pertrans = &aggstate->pertrans[transno];
+		FunctionCallInfo fcinfo = &pertrans->transfn_fcinfo;
+		Datum value = outerslot->tts_values[aggno];
+		bool isnull = outerslot->tts_isnull[aggno];
+
+		if (strcmp(func_name, "count") == 0)
+		{
+			/*
+			 * Sum results from each response for COUNT. It is safe to do this
+			 * directly on the datum as it is guaranteed to be an int64.
+			 */
+			oldContext = MemoryContextSwitchTo(
+				aggstate->curaggcontext->ecxt_per_tuple_memory);
+			pergroupstate->transValue += value;
+			MemoryContextSwitchTo(oldContext);
+		}
+		else
+		{
+			/* Set slot result as argument, then advance the transition function. */
+			fcinfo->arg[1] = value;
+			fcinfo->argnull[1] = isnull;
+			advance_transition_function(aggstate, pertrans, pergroupstate);
+		}
+	}
+}
+
+/*
+ * Fills the hash table from groups produced by pushed down aggregate
+ * operators. Each tuple contains the aggregate results followed by the values
+ * of the grouping columns. The same group could be returned several times, by
+ * different tablets or pages, so results are merged into the group's
+ * transition states.
+ */
+static void
+yb_agg_fill_hash_table_pushdown(AggState *aggstate)
+{
+	AggStatePerHash perhash = &aggstate->perhash[0];
+	TupleTableSlot *groupslot = aggstate->ss.ss_ScanTupleSlot;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	TupleTableSlot *outerslot;
+	int			i;
+
+	for (;;)
+	{
+		outerslot = fetch_input_tuple(aggstate);
+		if (TupIsNull(outerslot))
+			break;
+
+		Assert(aggstate->numaggs + perhash->numCols == outerslot->tts_nvalid);
+
+		/*
+		 * Put grouping values into the slot shaped like the outer plan's
+		 * tuple, where lookup_hash_entries expects to find them.
+		 */
+		ExecClearTuple(groupslot);
+		memset(groupslot->tts_isnull, true,
+			   groupslot->tts_tupleDescriptor->natts * sizeof(bool));
+		for (i = 0; i < perhash->numCols; i++)
+		{
+			int			varNumber = perhash->aggnode->grpColIdx[i] - 1;
+
+			groupslot->tts_values[varNumber] =
+				outerslot->tts_values[aggstate->numaggs + i];
+			groupslot->tts_isnull[varNumber] =
+				outerslot->tts_isnull[aggstate->numaggs + i];
+		}
+		ExecStoreVirtualTuple(groupslot);
+
+		/* Find or build hashtable entry */
+		tmpcontext->ecxt_outertuple = groupslot;
+		lookup_hash_entries(aggstate);
+
+		yb_agg_combine_pushdown_tuple(aggstate, aggstate->hash_pergroup[0],
+									  outerslot);
+
+		/* Reset per-input-tuple context after each tuple */
+		ResetExprContext(aggstate->tmpcontext);
+	}
+
+	aggstate->table_filled = true;
+	/* Initialize to walk the first hash table */
+	select_current_set(aggstate, 0, true);
+	ResetTupleHashIterator(aggstate->perhash[0].hashtable,
+						   &aggstate->perhash[0].hashiter);
+}
+
 /*
  * ExecAgg -
  *
@@ -1754,7 +1943,12 @@ ExecAgg(PlanState *pstate)
 		{
 			case AGG_HASHED:
 				if (!node->table_filled)
-					agg_fill_hash_table(node);
+				{
+					if (node->yb_pushdown_supported)
+						yb_agg_fill_hash_table_pushdown(node);
+					else
+						agg_fill_hash_table(node);
+				}
 				switch_fallthrough();
 			case AGG_MIXED:
 				result = agg_retrieve_hash_table(node);
@@ -1792,7 +1986,6 @@ agg_retrieve_direct(AggState *aggstate)
 	int			nextSetSize;
 	int			numReset;
 	int			i;
-	int			aggno;
 
 	/*
 	 * get state info from node
@@ -1945,9 +2138,6 @@ agg_retrieve_direct(AggState *aggstate)
 			 * Aggs were pushed down to YB, so handle returned aggregate results. The slot
 			 * contains one value for each aggno, and there is one result per RPC response.
 			 * We need to aggregate the results from all responses.
-			 *
-			 * We special case for COUNT and sum values so it returns the proper count
-			 * aggregated across all responses.
 			 */
 			for (;;)
 			{
@@ -1960,38 +2150,7 @@ agg_retrieve_direct(AggState *aggstate)
 
 				Assert(aggstate->numaggs == outerslot->tts_nvalid);
 
-				for (aggno = 0; aggno < aggstate->numaggs; aggno++)
-				{
-					MemoryContext oldContext;
-					int transno = peragg[aggno].transno;
-					Aggref *aggref = aggstate->peragg[aggno].aggref;
-					char *func_name = get_func_name(aggref->aggfnoid);
-					AggStatePerGroup pergroup = pergroups[currentSet];
-					AggStatePerGroup pergroupstate = &pergroup[transno];
-					AggStatePerTrans pertrans = &aggstate->pertrans[transno];
-					FunctionCallInfo fcinfo = &pertrans->transfn_fcinfo;
-					Datum value = outerslot->tts_values[aggno];
-					bool isnull = outerslot->tts_isnull[aggno];
-
-					if (strcmp(func_name, "count") == 0)
-					{
-						/*
-						 * Sum results from each response for COUNT. It is safe to do this
-						 * directly on the datum as it is guaranteed to be an int64.
-						 */
-						oldContext = MemoryContextSwitchTo(
-							aggstate->curaggcontext->ecxt_per_tuple_memory);
-						pergroupstate->transValue += value;
-						MemoryContextSwitchTo(oldContext);
-					}
-					else
-					{
-						/* Set slot result as argument, then advance the transition function. */
-						fcinfo->arg[1] = value;
-						fcinfo->argnull[1] = isnull;
-						advance_transition_function(aggstate, pertrans, pergroupstate);
-					}
-				}
+				yb_agg_combine_pushdown_tuple(aggstate, pergroups[currentSet], outerslot);
 
 				/* Reset per-input-tuple context after each tuple */
 				ResetExprContext(tmpcontext);
@@ -16,10 +16,123 @@
 #include "postgres.h"
 
 #include "access/parallel.h"
+#include "catalog/pg_type.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSort.h"
 #include "miscadmin.h"
 #include "utils/tuplesort.h"
+#include "utils/typcache.h"
+
+#include "pg_yb_utils.h"
+
+static void yb_sort_pushdown_top_n(SortState *node);
+
+/*
+ * Whether DocDB orders values of the type the same way as Postgres does.
+ */
+static bool
+yb_sort_type_pushdown_supported(Oid typid)
+{
+	switch (typid)
+	{
+		case BOOLOID:
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case OIDOID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		case TEXTOID:
+		case VARCHAROID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * If the bounded sort reads a YB table scan, asks DocDB to return only the
+ * first rows of each tablet in the sort order. The sort still merges rows
+ * returned by the tablets, so the pushdown only reduces the number of rows
+ * transferred.
+ */
+static void
+yb_sort_pushdown_top_n(SortState *node)
+{
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	ForeignScanState *scan_state;
+	List	   *outerTlist;
+	List	   *sort_cols = NIL;
+	List	   *sort_desc = NIL;
+	List	   *sort_nulls_first = NIL;
+	int			i;
+
+	if (!IsA(outerPlanState(node), ForeignScanState))
+		return;
+
+	scan_state = castNode(ForeignScanState, outerPlanState(node));
+	scan_state->yb_fdw_sort_cols = NIL;
+	scan_state->yb_fdw_sort_desc = NIL;
+	scan_state->yb_fdw_sort_nulls_first = NIL;
+	scan_state->yb_fdw_sort_bound = 0;
+
+	if (!yb_enable_top_n_pushdown || !node->bounded || node->bound <= 0)
+		return;
+
+	/* Foreign relation we are scanning is a YB table. */
+	if (!IsYBRelation(scan_state->ss.ss_currentRelation))
+		return;
+
+	/* No WHERE quals evaluated by Postgres, and no aggregate pushdown. */
+	if (scan_state->ss.ps.qual || scan_state->yb_fdw_aggs != NIL)
+		return;
+
+	outerTlist = scan_state->ss.ps.plan->targetlist;
+	for (i = 0; i < plannode->numCols; i++)
+	{
+		TargetEntry *tle = list_nth_node(TargetEntry, outerTlist,
+										 plannode->sortColIdx[i] - 1);
+		TypeCacheEntry *typentry;
+		Var		   *var;
+		bool		is_descending;
+
+		/* Only support sorting by simple columns of the scanned table. */
+		if (!IsA(tle->expr, Var))
+			return;
+		var = castNode(Var, tle->expr);
+		if (IS_SPECIAL_VARNO(var->varno) || var->varoattno <= 0)
+			return;
+
+		/* Like for GROUP BY, non-C collations are not supported. */
+		if (!yb_sort_type_pushdown_supported(var->vartype) ||
+			YBIsCollationValidNonC(var->varcollid))
+			return;
+
+		/* Only the default ordering of the type, in either direction. */
+		typentry = lookup_type_cache(var->vartype,
+									 TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+		if (plannode->sortOperators[i] == typentry->lt_opr)
+			is_descending = false;
+		else if (plannode->sortOperators[i] == typentry->gt_opr)
+			is_descending = true;
+		else
+			return;
+
+		sort_cols = lappend(sort_cols, var);
+		sort_desc = lappend_int(sort_desc, is_descending);
+		sort_nulls_first = lappend_int(sort_nulls_first,
+									   plannode->nullsFirst[i]);
+	}
+
+	scan_state->yb_fdw_sort_cols = sort_cols;
+	scan_state->yb_fdw_sort_desc = sort_desc;
+	scan_state->yb_fdw_sort_nulls_first = sort_nulls_first;
+	scan_state->yb_fdw_sort_bound = node->bound;
+}
 
 
 /* ----------------------------------------------------------------
@@ -84,6 +197,7 @@ ExecSort(PlanState *pstate)
 		 */
 		if (IsYugaByteEnabled()) {
 			estate->yb_exec_params.limit_use_default = true;
+			yb_sort_pushdown_top_n(node);
 		}
 
 		/*
@@ -519,11 +519,31 @@ ybcSetupScanTargets(ForeignScanState *node)
 			HandleYBStatus(YBCPgDmlAppendTarget(ybc_state->handle, op_handle));
 		}
 
+		/*
+		 * Set grouping columns. DocDB returns a row per group, where their values follow the
+		 * aggregate results.
+		 */
+		foreach(lc, node->yb_fdw_group_cols)
+		{
+			/* Like aggregate arguments, use original attribute number. */
+			int attno = lfirst_node(Var, lc)->varoattno;
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, attno - 1);
+			YBCPgTypeAttrs type_attrs = {attr->atttypmod};
+
+			YBCPgExpr expr = YBCNewColumnRef(ybc_state->handle,
+											 attno,
+											 attr->atttypid,
+											 attr->attcollation,
+											 &type_attrs);
+			HandleYBStatus(YBCPgDmlAppendGroupBy(ybc_state->handle, expr));
+		}
+
 		/*
 		 * Setup the scan slot based on new tuple descriptor for the given targets. This is a dummy
 		 * tupledesc that only includes the number of attributes.
 		 */
-		TupleDesc target_tupdesc = CreateTemplateTupleDesc(list_length(node->yb_fdw_aggs),
+		TupleDesc target_tupdesc = CreateTemplateTupleDesc(list_length(node->yb_fdw_aggs) +
+														   list_length(node->yb_fdw_group_cols),
 														   false /* hasoid */);
 		ExecInitScanTupleSlot(estate, &node->ss, target_tupdesc);
 
@@ -604,6 +624,50 @@ ybSetupScanColumnRefs(ForeignScanState *node)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * ybSetupScanOrderBy
+ *		Add the sort keys of pushed down top-N to the DocDB statement.
+ */
+static void
+ybSetupScanOrderBy(ForeignScanState *node)
+{
+	YbFdwExecState *ybc_state = (YbFdwExecState *) node->fdw_state;
+	TupleDesc	tupdesc = RelationGetDescr(node->ss.ss_currentRelation);
+	ListCell   *lc_col;
+	ListCell   *lc_desc;
+	ListCell   *lc_nulls_first;
+	MemoryContext oldcontext;
+
+	if (node->yb_fdw_sort_cols == NIL)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(node->ss.ps.ps_ExprContext->ecxt_per_query_memory);
+
+	forthree(lc_col, node->yb_fdw_sort_cols,
+			 lc_desc, node->yb_fdw_sort_desc,
+			 lc_nulls_first, node->yb_fdw_sort_nulls_first)
+	{
+		/* Like grouping columns, use original attribute number. */
+		int attno = lfirst_node(Var, lc_col)->varoattno;
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, attno - 1);
+		YBCPgTypeAttrs type_attrs = {attr->atttypmod};
+
+		YBCPgExpr expr = YBCNewColumnRef(ybc_state->handle,
+										 attno,
+										 attr->atttypid,
+										 attr->attcollation,
+										 &type_attrs);
+		HandleYBStatus(YBCPgDmlAppendOrderBy(ybc_state->handle,
+											 expr,
+											 lfirst_int(lc_desc),
+											 lfirst_int(lc_nulls_first)));
+	}
+	HandleYBStatus(YBCPgDmlSetOrderByLimit(ybc_state->handle,
+										   node->yb_fdw_sort_bound));
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * ybcIterateForeignScan
  *		Read next record from the data file and store it into the
@@ -624,6 +688,7 @@ ybcIterateForeignScan(ForeignScanState *node)
 		ybcSetupScanTargets(node);
 		ybSetupScanQual(node);
 		ybSetupScanColumnRefs(node);
+		ybSetupScanOrderBy(node);
 		HandleYBStatus(YBCPgExecSelect(ybc_state->handle, ybc_state->exec_params));
 		ybc_state->is_exec_done = true;
 	}
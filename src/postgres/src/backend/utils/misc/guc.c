@@ -2088,6 +2088,24 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"yb_enable_group_by_pushdown", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Push aggregates with GROUP BY down to DocDB for partial evaluation."),
+			NULL
+		},
+		&yb_enable_group_by_pushdown,
+		false,
+		NULL, NULL, NULL
+	},
+	{
+		{"yb_enable_top_n_pushdown", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Push ORDER BY ... LIMIT down to DocDB, so each tablet returns only its first rows."),
+			NULL
+		},
+		&yb_enable_top_n_pushdown,
+		false,
+		NULL, NULL, NULL
+	},
 
 	{
 		{"yb_bypass_cond_recheck", PGC_USERSET, QUERY_TUNING_METHOD,
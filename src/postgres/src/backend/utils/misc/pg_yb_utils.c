@@ -125,7 +125,12 @@ YbGetCatalogCacheVersionForTablePrefetching()
 	//       YbGetMasterCatalogVersion to reduce numer of RPCs to a master.
 	//       But this requires some additional changes. This optimization will
 	//       be done separately.
-	if (!*YBCGetGFlags()->ysql_enable_read_request_caching)
+	/*
+	 * Cached responses and catalog snapshot are stamped with the catalog
+	 * version, so it must be confirmed by the master.
+	 */
+	if (!*YBCGetGFlags()->ysql_enable_read_request_caching &&
+		!*YBCGetGFlags()->ysql_enable_catalog_snapshot)
 		return YB_CATCACHE_VERSION_UNINITIALIZED;
 	YBCPgResetCatalogReadTime();
 	return YbGetMasterCatalogVersion();
@@ -1022,6 +1027,8 @@ PowerWithUpperLimit(double base, int exp, double upper_limit)
 bool yb_enable_create_with_table_oid = false;
 int yb_index_state_flags_update_delay = 1000;
 bool yb_enable_expression_pushdown = true;
+bool yb_enable_group_by_pushdown = false;
+bool yb_enable_top_n_pushdown = false;
 bool yb_enable_optimizer_statistics = false;
 bool yb_bypass_cond_recheck = false;
 bool yb_make_next_ddl_statement_nonbreaking = false;
@@ -1741,6 +1741,14 @@ typedef struct ForeignScanState
 
 	/* YB specific attributes. */
 	List	   *yb_fdw_aggs;	/* aggregate pushdown information */
+	List	   *yb_fdw_group_cols;	/* grouping columns (Vars) of pushed down
+									 * aggregates */
+	List	   *yb_fdw_sort_cols;	/* sort columns (Vars) of pushed down
+									 * top-N */
+	List	   *yb_fdw_sort_desc;	/* per sort column, true if descending */
+	List	   *yb_fdw_sort_nulls_first;	/* per sort column, true if NULLS
+											 * FIRST */
+	int64		yb_fdw_sort_bound;	/* number of rows to return per tablet */
 } ForeignScanState;
 
 /* ----------------
@@ -439,6 +439,20 @@ extern int yb_index_state_flags_update_delay;
  */
 extern bool yb_enable_expression_pushdown;
 
+/*
+ * Enables pushdown of aggregates with GROUP BY.
+ * If true, hashed aggregation over a YB table scan is partially performed by
+ * DocDB, separately for each group, and the executor merges partial results.
+ */
+extern bool yb_enable_group_by_pushdown;
+
+/*
+ * Enables pushdown of ORDER BY ... LIMIT.
+ * If true, each tablet scanned by a sequential scan under a bounded sort
+ * returns only its first rows in the sort order, and the sort merges them.
+ */
+extern bool yb_enable_top_n_pushdown;
+
 /*
  * YSQL guc variable that is used to enable the use of Postgres's selectivity
  * functions and YSQL table statistics.
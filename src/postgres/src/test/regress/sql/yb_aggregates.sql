@@ -129,3 +129,16 @@ EXPLAIN (COSTS OFF) SELECT COUNT(*), SUM(int_4) FROM ybaggtest;
 EXPLAIN (COSTS OFF) SELECT int_2, COUNT(*), SUM(int_4) FROM ybaggtest GROUP BY int_2;
 EXPLAIN (COSTS OFF) SELECT DISTINCT int_4 FROM ybaggtest;
 EXPLAIN (COSTS OFF) SELECT COUNT(distinct int_4), SUM(int_4) FROM ybaggtest;
+
+-- Test GROUP BY pushdown
+CREATE TABLE ybgroupbytest (id int PRIMARY KEY, g int, v int);
+INSERT INTO ybgroupbytest SELECT i, i % 3, i FROM generate_series(1, 30) AS i;
+INSERT INTO ybgroupbytest VALUES (31, NULL, 31), (32, NULL, NULL);
+SET yb_enable_group_by_pushdown = on;
+EXPLAIN (COSTS OFF) SELECT g, COUNT(*), SUM(v), MIN(v), MAX(v) FROM ybgroupbytest GROUP BY g;
+SELECT g, COUNT(*), SUM(v), MIN(v), MAX(v) FROM ybgroupbytest GROUP BY g ORDER BY g;
+SELECT g, COUNT(v) FROM ybgroupbytest GROUP BY g HAVING SUM(v) > 150 ORDER BY g;
+-- Negative test - grouping by an expression is not pushed down
+EXPLAIN (COSTS OFF) SELECT g + 1, COUNT(*) FROM ybgroupbytest GROUP BY g + 1;
+RESET yb_enable_group_by_pushdown;
+DROP TABLE ybgroupbytest;
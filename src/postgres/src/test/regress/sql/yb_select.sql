@@ -113,3 +113,18 @@ EXPLAIN EXECUTE myplan(null);
 EXECUTE myplan(null);
 EXECUTE myplan(0);
 EXECUTE myplan(1);
+
+-- Top-N pushdown
+CREATE TABLE top_n_test(k int PRIMARY KEY, v int, t text) SPLIT INTO 3 TABLETS;
+INSERT INTO top_n_test SELECT k, NULLIF(k % 7, 6), 'row ' || k FROM generate_series(1, 20) k;
+SET yb_enable_top_n_pushdown = on;
+SELECT v, k FROM top_n_test ORDER BY v, k LIMIT 5;
+SELECT v, k FROM top_n_test ORDER BY v DESC, k LIMIT 5;
+SELECT v, k FROM top_n_test ORDER BY v DESC NULLS LAST, k LIMIT 4;
+SELECT k, t FROM top_n_test ORDER BY k DESC LIMIT 3;
+-- Sort by expression is not pushed down
+SELECT k FROM top_n_test ORDER BY -k LIMIT 3;
+-- Top-N of the filtered rows
+SELECT k FROM top_n_test WHERE t LIKE '%1' ORDER BY k DESC LIMIT 2;
+RESET yb_enable_top_n_pushdown;
+DROP TABLE top_n_test;
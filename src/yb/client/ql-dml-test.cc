@@ -29,11 +29,14 @@
 #include "yb/rocksdb/db.h"
 
 #include "yb/tablet/tablet.h"
+#include "yb/tablet/tablet_metadata.h"
 #include "yb/tablet/tablet_peer.h"
 
 #include "yb/tserver/mini_tablet_server.h"
+#include "yb/tserver/service_util.h"
 #include "yb/tserver/tablet_server.h"
 #include "yb/tserver/ts_tablet_manager.h"
+#include "yb/tserver/tserver_error.h"
 
 #include "yb/util/async_util.h"
 #include "yb/util/backoff_waiter.h"
@@ -56,6 +59,7 @@ DECLARE_int32(yb_num_shards_per_tserver);
 DECLARE_int64(db_block_cache_size_bytes);
 DECLARE_bool(flush_rocksdb_on_shutdown);
 DECLARE_uint64(max_stale_read_bound_time_ms);
+DECLARE_uint64(follower_read_safe_time_lease_ms);
 
 using namespace std::literals;
 
@@ -1290,6 +1294,57 @@ TEST_F(QLDmlTest, ReadFollower) {
   ASSERT_TRUE(missing_rows.empty()) << "Missing rows: " << yb::ToString(missing_rows);
 }
 
+// Tests that a follower rejects reads once it has not received safe time from the leader for
+// longer than follower_read_safe_time_lease_ms.
+TEST_F(QLDmlTest, FollowerSafeTimeLease) {
+  DontVerifyClusterBeforeNextTearDown();
+  ASSERT_NO_FATALS(InsertRows(1));
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_max_stale_read_bound_time_ms) = 0;
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_follower_read_safe_time_lease_ms) = 2000 * kTimeMultiplier;
+
+  size_t follower_idx = 0;
+  tablet::TabletPeerPtr follower;
+  for (size_t i = 0; i != cluster_->num_tablet_servers() && !follower; ++i) {
+    auto* tablet_manager = cluster_->mini_tablet_server(i)->server()->tablet_manager();
+    for (const auto& peer : tablet_manager->GetTabletPeers()) {
+      if (peer->tablet_metadata()->table_id() == table_->id() &&
+          peer->LeaderStatus() == consensus::LeaderStatus::NOT_LEADER) {
+        follower_idx = i;
+        follower = peer;
+        break;
+      }
+    }
+  }
+  ASSERT_NE(follower, nullptr);
+  auto* tablet_manager = cluster_->mini_tablet_server(follower_idx)->server()->tablet_manager();
+  auto get_tablet = [tablet_manager, follower] {
+    return tserver::GetTablet(
+        tablet_manager, follower->tablet_id(), follower, YBConsistencyLevel::CONSISTENT_PREFIX,
+        AllowSplitTablet::kFalse);
+  };
+
+  // Follower regularly receives safe time from the leader.
+  ASSERT_OK(get_tablet());
+
+  // Without other replicas the follower neither receives safe time nor becomes the leader.
+  for (size_t i = 0; i != cluster_->num_tablet_servers(); ++i) {
+    if (i != follower_idx) {
+      cluster_->mini_tablet_server(i)->Shutdown();
+    }
+  }
+
+  ASSERT_OK(WaitFor([&get_tablet] {
+    auto result = get_tablet();
+    return !result.ok() &&
+           tserver::TabletServerError(result.status()) ==
+               tserver::TabletServerErrorPB::STALE_FOLLOWER;
+  }, 10s * kTimeMultiplier, "Follower read rejected"));
+
+  // Only the lease causes rejection.
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_follower_read_safe_time_lease_ms) = 0;
+  ASSERT_OK(get_tablet());
+}
+
 TEST_F(QLDmlTest, DeletePartialRangeKey) {
   auto session = NewSession();
   RowKey row_key{1, "a", 2, "b"};
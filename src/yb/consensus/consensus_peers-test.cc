@@ -59,6 +59,8 @@ using namespace std::chrono_literals;
 
 METRIC_DECLARE_entity(tablet);
 
+DECLARE_int32(consensus_adaptive_batching_max_delay_us);
+
 namespace yb {
 namespace consensus {
 
@@ -208,6 +210,9 @@ TEST_F(ConsensusPeersTest, TestRemotePeer) {
   consensus_->WaitForMajorityReplicatedIndex(20);
   // Verify that the replicated watermark corresponds to the last replicated message.
   CheckLastRemoteEntry(proxy, 2, 20);
+  // Adaptive batching is disabled, so no batching decisions are counted.
+  ASSERT_EQ(message_queue_->metrics().num_batching_immediate_requests->value(), 0);
+  ASSERT_EQ(message_queue_->metrics().num_batching_delayed_requests->value(), 0);
 }
 
 TEST_F(ConsensusPeersTest, TestLocalAppendAndRemotePeerDelay) {
@@ -414,5 +419,37 @@ TEST_F(ConsensusPeersTest, TestDontSendOneRpcPerWriteWhenPeerIsDown) {
   ASSERT_LT(mock_proxy->update_count() - initial_update_count, 5);
 }
 
+TEST(AdaptiveBatchingControllerTest, DelayOnlyUnderLoad) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_consensus_adaptive_batching_max_delay_us) = 5000;
+  AdaptiveBatchingController controller;
+  auto now = CoarseMonoClock::Now();
+
+  // No RTT samples yet.
+  controller.OperationsAppended(now);
+  ASSERT_EQ(controller.NextRequestDelay(100, now), MonoDelta::kZero);
+
+  controller.RequestCompleted(now - 20ms, now);
+
+  // Appends arrive rarely compared to the possible delay.
+  now += 10ms;
+  controller.OperationsAppended(now);
+  ASSERT_EQ(controller.NextRequestDelay(100, now), MonoDelta::kZero);
+
+  // Steady stream of appends, 10us apart.
+  for (int i = 0; i != 100; ++i) {
+    now += 10us;
+    controller.OperationsAppended(now);
+  }
+  // Delay is bounded by a fraction of RTT.
+  ASSERT_EQ(controller.NextRequestDelay(100, now), MonoDelta::FromMilliseconds(2));
+  // Previous request was large enough.
+  ASSERT_EQ(controller.NextRequestDelay(1024 * 1024, now), MonoDelta::kZero);
+  // Appends stopped.
+  ASSERT_EQ(controller.NextRequestDelay(100, now + 10ms), MonoDelta::kZero);
+
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_consensus_adaptive_batching_max_delay_us) = 0;
+  ASSERT_EQ(controller.NextRequestDelay(100, now), MonoDelta::kZero);
+}
+
 }  // namespace consensus
 }  // namespace yb
@@ -51,6 +51,7 @@
 #include "yb/consensus/multi_raft_batcher.h"
 #include "yb/gutil/strings/substitute.h"
 
+#include "yb/rpc/messenger.h"
 #include "yb/rpc/periodic.h"
 #include "yb/rpc/rpc_controller.h"
 
@@ -62,16 +63,20 @@
 #include "yb/util/flags.h"
 #include "yb/util/format.h"
 #include "yb/util/logging.h"
+#include "yb/util/metrics.h"
 #include "yb/util/monotime.h"
 #include "yb/util/net/net_util.h"
 #include "yb/util/scope_exit.h"
+#include "yb/util/size_literals.h"
 #include "yb/util/status_callback.h"
 #include "yb/util/status_format.h"
+#include "yb/util/status_log.h"
 #include "yb/util/threadpool.h"
 #include "yb/util/tsan_util.h"
 
 using namespace std::literals;
 using namespace std::placeholders;
+using namespace yb::size_literals;
 
 DEFINE_UNKNOWN_int32(consensus_rpc_timeout_ms, 3000,
              "Timeout used for all consensus internal RPC communications.");
@@ -86,6 +91,23 @@ TAG_FLAG(max_wait_for_processresponse_before_closing_ms, advanced);
 DECLARE_int32(raft_heartbeat_interval_ms);
 
 DECLARE_bool(enable_multi_raft_heartbeat_batcher);
+DECLARE_bool(enable_multi_raft_data_batching);
+DECLARE_uint64(multi_raft_max_batched_request_bytes);
+
+DEFINE_RUNTIME_int32(consensus_adaptive_batching_max_delay_us, 0,
+    "Maximum time the leader could hold back a small consensus update request to a peer, so "
+    "more operations could be accumulated into it. 0 to disable adaptive batching.");
+TAG_FLAG(consensus_adaptive_batching_max_delay_us, advanced);
+
+DEFINE_RUNTIME_double(consensus_adaptive_batching_rtt_fraction, 0.1,
+    "Adaptive batching does not hold back a consensus update request for longer than this "
+    "fraction of the smoothed round trip time to the peer.");
+TAG_FLAG(consensus_adaptive_batching_rtt_fraction, advanced);
+
+DEFINE_RUNTIME_uint64(consensus_adaptive_batching_min_bytes, 64_KB,
+    "Consensus update requests carrying at least this number of bytes of operations are "
+    "considered large enough, so the following request is not held back.");
+TAG_FLAG(consensus_adaptive_batching_min_bytes, advanced);
 
 DEFINE_test_flag(double, fault_crash_on_leader_request_fraction, 0.0,
                  "Fraction of the time when the leader will crash just before sending an "
@@ -104,6 +126,7 @@ DEFINE_test_flag(bool, enable_remote_bootstrap, true,
                  "replica.");
 
 DECLARE_int32(TEST_log_change_config_every_n);
+DECLARE_int32(consensus_max_outstanding_requests_per_peer);
 
 namespace yb {
 namespace consensus {
@@ -116,6 +139,57 @@ using rpc::PeriodicTimer;
 using rpc::RpcController;
 using strings::Substitute;
 
+namespace {
+
+// Weight of the new sample in exponentially weighted moving averages, the same as for TCP SRTT.
+constexpr int kSmoothingFactorInverse = 8;
+
+MonoDelta Smooth(MonoDelta average, MonoDelta sample) {
+  if (!average.Initialized()) {
+    return sample;
+  }
+  return average + (sample - average) / kSmoothingFactorInverse;
+}
+
+} // namespace
+
+void AdaptiveBatchingController::OperationsAppended(CoarseTimePoint now) {
+  std::lock_guard<simple_spinlock> lock(mutex_);
+  if (last_append_time_ != CoarseTimePoint()) {
+    append_interval_ = Smooth(append_interval_, now - last_append_time_);
+  }
+  last_append_time_ = now;
+}
+
+void AdaptiveBatchingController::RequestCompleted(
+    CoarseTimePoint send_time, CoarseTimePoint now) {
+  std::lock_guard<simple_spinlock> lock(mutex_);
+  rtt_ = Smooth(rtt_, now - send_time);
+}
+
+MonoDelta AdaptiveBatchingController::NextRequestDelay(
+    size_t last_request_bytes, CoarseTimePoint now) const {
+  auto max_delay_us = FLAGS_consensus_adaptive_batching_max_delay_us;
+  if (max_delay_us <= 0 || last_request_bytes >= FLAGS_consensus_adaptive_batching_min_bytes) {
+    return MonoDelta::kZero;
+  }
+
+  std::lock_guard<simple_spinlock> lock(mutex_);
+  if (!rtt_.Initialized() || !append_interval_.Initialized()) {
+    return MonoDelta::kZero;
+  }
+  auto delay = std::min(
+      MonoDelta::FromMicroseconds(max_delay_us),
+      MonoDelta::FromNanoseconds(static_cast<int64_t>(
+          rtt_.ToNanoseconds() * FLAGS_consensus_adaptive_batching_rtt_fraction)));
+  // Holding back the request is worth it only if appends are still coming, and at least two of
+  // them are expected during the delay.
+  if (now - last_append_time_ > delay || append_interval_ * 2 > delay) {
+    return MonoDelta::kZero;
+  }
+  return delay;
+}
+
 Peer::Peer(
     const RaftPeerPB& peer_pb, string tablet_id, string leader_uuid, PeerProxyPtr proxy,
     PeerMessageQueue* queue, MultiRaftHeartbeatBatcherPtr multi_raft_batcher,
@@ -155,13 +229,22 @@ Status Peer::Init() {
 }
 
 Status Peer::SignalRequest(RequestTriggerMode trigger_mode) {
+  if (trigger_mode == RequestTriggerMode::kNonEmptyOnly) {
+    batching_controller_.OperationsAppended(CoarseMonoClock::Now());
+  }
+
   // If the peer is currently sending, return Status::OK().
   // If there are new requests in the queue we'll get them on ProcessResponse().
   auto performing_update_lock = LockPerformingUpdate(std::try_to_lock);
   if (!performing_update_lock.owns_lock()) {
+    if (trigger_mode == RequestTriggerMode::kNonEmptyOnly &&
+        FLAGS_consensus_max_outstanding_requests_per_peer > 1) {
+      return TrySendPipelinedRequest();
+    }
     return Status::OK();
   }
 
+  MonoDelta batching_delay = MonoDelta::kZero;
   {
     auto processing_lock = StartProcessingUnlocked();
     if (!processing_lock.owns_lock()) {
@@ -188,7 +271,18 @@ Status Peer::SignalRequest(RequestTriggerMode trigger_mode) {
       return Status::OK();
     }
 
-    using_thread_pool_.fetch_add(1, std::memory_order_acq_rel);
+    // New operations could be held back before sending, so more of them are sent in one request.
+    if (trigger_mode == RequestTriggerMode::kNonEmptyOnly) {
+      batching_delay = NextRequestBatchingDelay();
+    }
+    if (batching_delay == MonoDelta::kZero) {
+      using_thread_pool_.fetch_add(1, std::memory_order_acq_rel);
+    }
+  }
+  if (batching_delay > MonoDelta::kZero) {
+    ScheduleNextRequest(batching_delay);
+    performing_update_lock.release();
+    return Status::OK();
   }
   auto status = raft_pool_token_->SubmitFunc(
       std::bind(&Peer::SendNextRequest, shared_from_this(), trigger_mode));
@@ -330,16 +424,16 @@ void Peer::SendNextRequest(RequestTriggerMode trigger_mode) {
       return;
     }
 
-    // TODO(lw_uc) support multiraft heartbeat with LW
-    update_request_->ToGoogleProtobuf(&heartbeat_request_);
-    update_response_->ToGoogleProtobuf(&heartbeat_response_);
+    // Heartbeat outlives performing_update_mutex_, so it is copied to its own arena. It does not
+    // contain ops, so the copy is cheap.
+    heartbeat_arena_.Reset(ResetMode::kKeepFirst);
+    heartbeat_request_ = heartbeat_arena_.NewArenaObject<LWConsensusRequestPB>(*update_request_);
     cur_heartbeat_id_++;
     processing_lock.unlock();
     performing_update_lock.unlock();
     performing_heartbeat_lock.release();
     multi_raft_batcher_->AddRequestToBatch(
-        &heartbeat_request_, &heartbeat_response_,
-        std::bind(&Peer::ProcessHeartbeatResponse, retain_self, _1));
+        heartbeat_request_, std::bind(&Peer::ProcessHeartbeatResponse, retain_self, _1, _2));
     return;
   }
 
@@ -351,6 +445,19 @@ void Peer::SendNextRequest(RequestTriggerMode trigger_mode) {
   // and this new request in the same order they were received by the remote peer.
   // TODO: Remove batched but unsent heartbeats (in the respective MultiRaftBatcher) in this case
   minimum_viable_heartbeat_ = cur_heartbeat_id_ + 1;
+  last_request_send_time_ = CoarseMonoClock::Now();
+  last_request_bytes_ = msgs_holder.messages_size();
+  // Small requests to the same tserver are sent with requests of other tablets in a single RPC.
+  // update_request_ is kept until the response is processed, so the batch references it directly.
+  if (multi_raft_batcher_ && FLAGS_enable_multi_raft_heartbeat_batcher &&
+      FLAGS_enable_multi_raft_data_batching &&
+      last_request_bytes_ <= FLAGS_multi_raft_max_batched_request_bytes) {
+    processing_lock.unlock();
+    performing_update_lock.release();
+    multi_raft_batcher_->AddDataRequestToBatch(
+        update_request_, std::bind(&Peer::ProcessBatchedResponse, retain_self, _1, _2));
+    return;
+  }
   processing_lock.unlock();
   performing_update_lock.release();
   controller_.set_invoke_callback_mode(rpc::InvokeCallbackMode::kThreadPoolHigh);
@@ -369,7 +476,8 @@ std::unique_lock<simple_spinlock> Peer::StartProcessingUnlocked() {
 }
 
 bool Peer::ProcessResponseWithStatus(const Status& status,
-                                     LWConsensusResponsePB* response) {
+                                     LWConsensusResponsePB* response,
+                                     const PipelinedUpdate* pipelined) {
   if (!status.ok()) {
     if (status.IsRemoteError()) {
       // Most controller errors are caused by network issues or corner cases like shutdown and
@@ -433,7 +541,14 @@ bool Peer::ProcessResponseWithStatus(const Status& status,
   }
 
   failed_attempts_ = 0;
-  return queue_->ResponseFromPeer(peer_pb_.permanent_uuid(), *response);
+  if (pipelined) {
+    return queue_->PipelinedResponseFromPeer(
+        peer_pb_.permanent_uuid(), pipelined->request->preceding_id().index(), *response);
+  }
+  return queue_->ResponseFromPeer(
+      peer_pb_.permanent_uuid(),
+      update_request_->has_preceding_id() ? update_request_->preceding_id().index() : -1,
+      *response);
 }
 
 void Peer::ProcessResponse() {
@@ -444,23 +559,172 @@ void Peer::ProcessResponse() {
   }
   controller_.Reset();
 
+  HandleUpdateResponse(status, update_response_);
+}
+
+void Peer::ProcessBatchedResponse(const Status& status, LWConsensusResponsePB* response) {
+  DCHECK(performing_update_mutex_.is_locked()) << "Got a response when nothing was pending.";
+  HandleUpdateResponse(status, response ? response : update_response_);
+}
+
+void Peer::HandleUpdateResponse(const Status& status, LWConsensusResponsePB* response) {
   auto performing_update_lock = LockPerformingUpdate(std::adopt_lock);
   auto processing_lock = StartProcessingUnlocked();
   if (!processing_lock.owns_lock()) {
     return;
   }
-  bool more_pending = ProcessResponseWithStatus(status, update_response_);
+  auto now = CoarseMonoClock::Now();
+  if (status.ok()) {
+    batching_controller_.RequestCompleted(last_request_send_time_, now);
+  }
+  bool more_pending = ProcessResponseWithStatus(status, response);
 
   if (more_pending) {
+    // Operations appended while the request was in flight are sent immediately, they were already
+    // accumulated during the round trip.
     processing_lock.unlock();
     performing_update_lock.release();
     SendNextRequest(RequestTriggerMode::kAlwaysSend);
   }
 }
 
-void Peer::ProcessHeartbeatResponse(const Status& status) {
+MonoDelta Peer::NextRequestBatchingDelay() {
+  if (FLAGS_consensus_adaptive_batching_max_delay_us <= 0 || !messenger_) {
+    return MonoDelta::kZero;
+  }
+  auto delay = batching_controller_.NextRequestDelay(last_request_bytes_, CoarseMonoClock::Now());
+  if (delay > MonoDelta::kZero) {
+    queue_->metrics().num_batching_delayed_requests->Increment();
+    queue_->metrics().batching_delay_us->IncrementBy(delay.ToMicroseconds());
+  } else {
+    queue_->metrics().num_batching_immediate_requests->Increment();
+  }
+  return delay;
+}
+
+void Peer::ScheduleNextRequest(MonoDelta delay) {
+  DCHECK(performing_update_mutex_.is_locked());
+  messenger_->scheduler().Schedule(
+      [retain_self = shared_from_this()](const Status& status) {
+        retain_self->SubmitDelayedRequest(status);
+      },
+      delay.ToSteadyDuration());
+}
+
+void Peer::SubmitDelayedRequest(const Status& status) {
+  auto performing_update_lock = LockPerformingUpdate(std::adopt_lock);
+  if (!status.ok()) {
+    LOG_WITH_PREFIX(INFO) << "Delayed request was not sent: " << status;
+    return;
+  }
+  {
+    auto processing_lock = StartProcessingUnlocked();
+    if (!processing_lock.owns_lock()) {
+      return;
+    }
+    using_thread_pool_.fetch_add(1, std::memory_order_acq_rel);
+  }
+  auto submit_status = raft_pool_token_->SubmitFunc(
+      std::bind(&Peer::SendNextRequest, shared_from_this(), RequestTriggerMode::kAlwaysSend));
+  using_thread_pool_.fetch_sub(1, std::memory_order_acq_rel);
+  if (submit_status.ok()) {
+    performing_update_lock.release();
+  }
+}
+
+struct Peer::PipelinedUpdate {
+  ThreadSafeArena arena;
+  LWConsensusRequestPB* request = arena.NewObject<LWConsensusRequestPB>(&arena);
+  LWConsensusResponsePB* response = arena.NewObject<LWConsensusResponsePB>(&arena);
+  rpc::RpcController controller;
+};
+
+Status Peer::TrySendPipelinedRequest() {
+  {
+    auto processing_lock = StartProcessingUnlocked();
+    // Regular request will report that the peer was closed, nothing to pipeline in this case.
+    if (!processing_lock.owns_lock()) {
+      return Status::OK();
+    }
+    // The window also includes the regular request that is in flight.
+    if (state_ != kPeerRunning || failed_attempts_ > 0 ||
+        pipelined_requests_in_flight_ + 1 >= FLAGS_consensus_max_outstanding_requests_per_peer) {
+      return Status::OK();
+    }
+    ++pipelined_requests_in_flight_;
+    using_thread_pool_.fetch_add(1, std::memory_order_acq_rel);
+  }
+  auto status = raft_pool_token_->SubmitFunc(
+      std::bind(&Peer::SendPipelinedRequest, shared_from_this()));
+  using_thread_pool_.fetch_sub(1, std::memory_order_acq_rel);
+  if (!status.ok()) {
+    std::lock_guard<simple_spinlock> lock(peer_lock_);
+    --pipelined_requests_in_flight_;
+  }
+  return status;
+}
+
+void Peer::SendPipelinedRequest() {
+  auto retain_self = shared_from_this();
+  auto update = std::make_shared<PipelinedUpdate>();
+  {
+    std::lock_guard<simple_spinlock> lock(peer_lock_);
+    if (state_ == kPeerClosed) {
+      --pipelined_requests_in_flight_;
+      return;
+    }
+    bool needs_remote_bootstrap = false;
+    LWReplicateMsgsHolder msgs_holder;
+    auto status = queue_->RequestForPeer(
+        peer_pb_.permanent_uuid(), update->request, &msgs_holder, &needs_remote_bootstrap,
+        nullptr /* member_type */, nullptr /* last_exchange_successful */,
+        PipelinedRequest::kTrue);
+    // Nothing new to pipeline, the regular request will take care of the peer.
+    if (!status.ok() || needs_remote_bootstrap || update->request->ops().empty()) {
+      VLOG_WITH_PREFIX(3) << "Pipelined request was not sent: " << status;
+      --pipelined_requests_in_flight_;
+      return;
+    }
+
+    update->request->ref_tablet_id(tablet_id_);
+    update->request->ref_caller_uuid(leader_uuid_);
+    update->request->ref_dest_uuid(peer_pb_.permanent_uuid());
+    heartbeater_->Snooze();
+  }
+
+  update->controller.set_invoke_callback_mode(rpc::InvokeCallbackMode::kThreadPoolHigh);
+  proxy_->UpdateAsync(
+      update->request, RequestTriggerMode::kNonEmptyOnly, update->response, &update->controller,
+      [retain_self, update] {
+        retain_self->ProcessPipelinedResponse(update);
+      });
+}
+
+void Peer::ProcessPipelinedResponse(const std::shared_ptr<PipelinedUpdate>& update) {
+  auto status = update->controller.status();
+  if (status.ok()) {
+    status = update->controller.thread_pool_failure();
+  }
+
+  bool more_pending = false;
+  {
+    std::lock_guard<simple_spinlock> lock(peer_lock_);
+    if (state_ != kPeerClosed) {
+      more_pending = ProcessResponseWithStatus(status, update->response, update.get());
+    }
+    // Close() waits for this counter to drop to zero, so the peer should not be touched after it.
+    --pipelined_requests_in_flight_;
+  }
+
+  if (more_pending) {
+    WARN_NOT_OK(SignalRequest(RequestTriggerMode::kAlwaysSend),
+                "Failed to send request after pipelined response");
+  }
+}
+
+void Peer::ProcessHeartbeatResponse(const Status& status, LWConsensusResponsePB* response) {
   DCHECK(performing_heartbeat_mutex_.is_locked()) << "Got a heartbeat when nothing was pending.";
-  DCHECK(heartbeat_request_.ops().empty()) << "Got a heartbeat with a non-zero number of ops.";
+  DCHECK(heartbeat_request_->ops().empty()) << "Got a heartbeat with a non-zero number of ops.";
 
   auto performing_heartbeat_lock = LockPerformingHeartbeat(std::adopt_lock);
   auto processing_lock = StartProcessingUnlocked();
@@ -476,9 +740,7 @@ void Peer::ProcessHeartbeatResponse(const Status& status) {
     return;
   }
 
-  // TODO(lw_uc) support multiraft heartbeat with LW
-  auto lw_response = rpc::CopySharedMessage(heartbeat_response_);
-  bool more_pending = ProcessResponseWithStatus(status, lw_response.get());
+  bool more_pending = ProcessResponseWithStatus(status, response);
 
   if (more_pending) {
     auto performing_update_lock = LockPerformingUpdate(std::try_to_lock);
@@ -533,8 +795,10 @@ void Peer::ProcessRemoteBootstrapResponse() {
 }
 
 void Peer::ProcessResponseError(const Status& status) {
-  DCHECK(performing_update_mutex_.is_locked() || performing_heartbeat_mutex_.is_locked());
+  DCHECK(performing_update_mutex_.is_locked() || performing_heartbeat_mutex_.is_locked() ||
+         pipelined_requests_in_flight_ > 0);
   failed_attempts_++;
+  queue_->ResetPeerPipeline(peer_pb_.permanent_uuid());
   YB_LOG_WITH_PREFIX_EVERY_N_SECS(WARNING, 5) << "Couldn't send request. "
       << " Status: " << status.ToString() << ". Retrying in the next heartbeat period."
       << " Already tried " << failed_attempts_ << " times. State: " << state_;
@@ -575,6 +839,26 @@ void Peer::Close() {
     LOG_WITH_PREFIX(INFO) << "Closing peer";
   }
 
+  // Pipelined requests are not covered by performing_update_mutex_, so wait for their responses
+  // before untracking the peer.
+  {
+    auto deadline = std::chrono::steady_clock::now() +
+                    FLAGS_max_wait_for_processresponse_before_closing_ms * 1ms;
+    BackoffWaiter waiter(deadline, 100ms);
+    for (;;) {
+      {
+        std::lock_guard<simple_spinlock> processing_lock(peer_lock_);
+        if (pipelined_requests_in_flight_ == 0) {
+          break;
+        }
+      }
+      if (!waiter.Wait()) {
+        LOG_WITH_PREFIX(DFATAL) << "Timed out waiting for pipelined requests to finish";
+        break;
+      }
+    }
+  }
+
   auto retain_self = shared_from_this();
 
   queue_->UntrackPeer(peer_pb_.permanent_uuid());
@@ -58,6 +58,7 @@
 #include "yb/util/atomic.h"
 #include "yb/util/countdown_latch.h"
 #include "yb/util/locks.h"
+#include "yb/util/monotime.h"
 #include "yb/util/memory/arena.h"
 #include "yb/util/net/net_util.h"
 #include "yb/util/result.h"
@@ -128,6 +129,33 @@ namespace consensus {
 class Peer;
 typedef std::shared_ptr<Peer> PeerPtr;
 
+// Decides whether the next UpdateConsensus request to a peer should be held back for a short
+// period, so more operations could be accumulated into it.
+//
+// The delay is applied only when the previous request was small, appends arrive fast enough to
+// expect more of them during the delay, and is bounded by a fraction of the observed round trip
+// time. So under low load requests are sent immediately and latency is not affected.
+class AdaptiveBatchingController {
+ public:
+  // Called when the leader has new operations to replicate to the peer.
+  void OperationsAppended(CoarseTimePoint now);
+
+  // Called when response for a request sent at send_time was received.
+  void RequestCompleted(CoarseTimePoint send_time, CoarseTimePoint now);
+
+  // Returns how long the next request with pending operations should be held back,
+  // zero if it should be sent immediately.
+  MonoDelta NextRequestDelay(size_t last_request_bytes, CoarseTimePoint now) const;
+
+ private:
+  mutable simple_spinlock mutex_;
+  // Smoothed round trip time of UpdateConsensus requests.
+  MonoDelta rtt_ GUARDED_BY(mutex_);
+  // Smoothed interval between appends.
+  MonoDelta append_interval_ GUARDED_BY(mutex_);
+  CoarseTimePoint last_append_time_ GUARDED_BY(mutex_);
+};
+
 class Peer : public std::enable_shared_from_this<Peer> {
  public:
   Peer(const RaftPeerPB& peer, std::string tablet_id, std::string leader_uuid,
@@ -186,12 +214,42 @@ class Peer : public std::enable_shared_from_this<Peer> {
   // requires IO or may block.
   void ProcessResponse();
 
+  // Signals that a response for the request sent via multi-Raft batcher was received.
+  // response is null when the batch failed.
+  void ProcessBatchedResponse(const Status& status, LWConsensusResponsePB* response);
+
+  // Common part of ProcessResponse and ProcessBatchedResponse, called with
+  // performing_update_mutex_ held.
+  void HandleUpdateResponse(const Status& status, LWConsensusResponsePB* response);
+
   // Signals that a heartbeat response was received from the peer.
-  void ProcessHeartbeatResponse(const Status& status);
+  void ProcessHeartbeatResponse(const Status& status, LWConsensusResponsePB* response);
+
+  // Consensus update request sent while the regular request is still in flight.
+  struct PipelinedUpdate;
+
+  // Sends additional request with new operations, if pipelining window allows it.
+  Status TrySendPipelinedRequest();
+
+  void SendPipelinedRequest();
+
+  void ProcessPipelinedResponse(const std::shared_ptr<PipelinedUpdate>& update);
+
+  // Returns how long the request with newly appended operations should be held back by adaptive
+  // batching, and updates batching metrics. Requires performing_update_mutex_ to be held.
+  MonoDelta NextRequestBatchingDelay();
+
+  // Sends next request after delay, holding performing_update_mutex_ meanwhile.
+  void ScheduleNextRequest(MonoDelta delay);
+
+  // Callback for ScheduleNextRequest.
+  void SubmitDelayedRequest(const Status& status);
 
   // Returns true if there are more pending ops to process, false otherwise.
+  // pipelined is the pipelined request, this response belongs to, or nullptr for regular requests.
   bool ProcessResponseWithStatus(const Status& status,
-                                 LWConsensusResponsePB* response);
+                                 LWConsensusResponsePB* response,
+                                 const PipelinedUpdate* pipelined = nullptr);
 
   // Fetch the desired remote bootstrap request from the queue and send it to the peer. The callback
   // goes to ProcessRemoteBootstrapResponse().
@@ -232,15 +290,18 @@ class Peer : public std::enable_shared_from_this<Peer> {
 
   PeerMessageQueue* queue_;
   uint64_t failed_attempts_ = 0;
+  // Number of pipelined update requests in flight, protected by peer_lock_. Close() waits for it
+  // to drop to zero.
+  int pipelined_requests_in_flight_ = 0;
 
   // The latest consensus update request and response stored in arena_.
   ThreadSafeArena arena_;
   LWConsensusRequestPB* update_request_ = nullptr;
   LWConsensusResponsePB* update_response_ = nullptr;
 
-  // Latest heartbeat request and response
-  ConsensusRequestPB heartbeat_request_;
-  ConsensusResponsePB heartbeat_response_;
+  // Latest heartbeat request sent via multi-Raft batcher, stored in heartbeat_arena_.
+  ThreadSafeArena heartbeat_arena_;
+  LWConsensusRequestPB* heartbeat_request_ = nullptr;
 
   // Each time a heartbeat request is sent this value is incremented.
   int64_t cur_heartbeat_id_ = 0;
@@ -257,6 +318,12 @@ class Peer : public std::enable_shared_from_this<Peer> {
 
   rpc::RpcController controller_;
 
+  AdaptiveBatchingController batching_controller_;
+  // Send time and ops size of the latest consensus update request. The size is taken from the log
+  // cache, that computes it once per operation.
+  CoarseTimePoint last_request_send_time_;
+  size_t last_request_bytes_ = 0;
+
   // Held if there is an outstanding request.  This is used in order to ensure that we only have a
   // single request outstanding at a time, and to wait for the outstanding requests at Close().
   AtomicTryMutex performing_update_mutex_;
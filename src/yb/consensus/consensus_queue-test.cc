@@ -57,6 +57,7 @@ using std::string;
 
 DECLARE_bool(enable_data_block_fsync);
 DECLARE_uint64(consensus_max_batch_size_bytes);
+DECLARE_int32(consensus_max_outstanding_requests_per_peer);
 
 METRIC_DECLARE_entity(tablet);
 
@@ -274,6 +275,213 @@ TEST_F(ConsensusQueueTest, TestStartTrackingAfterStart) {
   ASSERT_TRUE(request.ops().empty());
 }
 
+// Tests that a pipelined request continues after ops that are still in flight, and that a stale
+// response does not move the peer back.
+TEST_F(ConsensusQueueTest, TestPipelinedRequests) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_consensus_max_outstanding_requests_per_peer) = 2;
+  queue_->Init(OpId::Min());
+  queue_->SetLeaderMode(
+      OpId::Min(), OpId::Min().term, OpId::Min(), BuildRaftConfigPBForTests(2));
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 1, 50);
+
+  ThreadSafeArena arena;
+  LWConsensusRequestPB request(&arena);
+  LWConsensusResponsePB response(&arena);
+  response.ref_responder_uuid(kPeerUuid);
+
+  ASSERT_TRUE(UpdatePeerWatermarkToOp(
+      &request, &response, MakeOpIdForIndex(25), OpId::Min()));
+
+  LWReplicateMsgsHolder refs;
+  bool needs_remote_bootstrap;
+
+  // Pipelining is not allowed until the peer is in sync.
+  ASSERT_NOK(queue_->RequestForPeer(
+      kPeerUuid, &request, &refs, &needs_remote_bootstrap, nullptr, nullptr,
+      PipelinedRequest::kTrue));
+  request.Clear();
+
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  ASSERT_EQ(25, request.ops().size());
+  SetLastReceivedAndLastCommitted(&response, MakeOpIdForIndex(50));
+  ASSERT_FALSE(queue_->ResponseFromPeer(response.responder_uuid().ToBuffer(), response));
+
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 51, 10);
+  request.Clear();
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  ASSERT_EQ(10, request.ops().size());
+  ASSERT_EQ(60, request.ops().back().id().index());
+
+  // Ops 51..60 are in flight, so the pipelined request continues after them.
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 61, 10);
+  LWConsensusRequestPB pipelined_request(&arena);
+  LWReplicateMsgsHolder pipelined_refs;
+  ASSERT_OK(queue_->RequestForPeer(
+      kPeerUuid, &pipelined_request, &pipelined_refs, &needs_remote_bootstrap, nullptr, nullptr,
+      PipelinedRequest::kTrue));
+  ASSERT_EQ(10, pipelined_request.ops().size());
+  ASSERT_EQ(60, pipelined_request.preceding_id().index());
+  ASSERT_FALSE(pipelined_request.has_leader_lease_duration_ms());
+
+  // Response to the pipelined request arrives first.
+  SetLastReceivedAndLastCommitted(&response, MakeOpIdForIndex(70));
+  ASSERT_FALSE(queue_->PipelinedResponseFromPeer(
+      response.responder_uuid().ToBuffer(), 60, response));
+
+  // Stale response to the regular request should not move the peer back.
+  SetLastReceivedAndLastCommitted(&response, MakeOpIdForIndex(60));
+  ASSERT_FALSE(queue_->ResponseFromPeer(response.responder_uuid().ToBuffer(), response));
+  ASSERT_EQ(70, queue_->GetTrackedPeerForTests(kPeerUuid).last_received.index);
+
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_consensus_max_outstanding_requests_per_peer) = 1;
+}
+
+// Tests that a pipelined request that reached the follower before the earlier request does not
+// reset the pipeline, and that a failed request makes the next request start from next_index.
+TEST_F(ConsensusQueueTest, TestPipelinedResponsesReorderedOrFailed) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_consensus_max_outstanding_requests_per_peer) = 3;
+  queue_->Init(OpId::Min());
+  queue_->SetLeaderMode(
+      OpId::Min(), OpId::Min().term, OpId::Min(), BuildRaftConfigPBForTests(2));
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 1, 50);
+
+  ThreadSafeArena arena;
+  LWConsensusRequestPB request(&arena);
+  LWConsensusResponsePB response(&arena);
+  response.ref_responder_uuid(kPeerUuid);
+
+  ASSERT_TRUE(UpdatePeerWatermarkToOp(
+      &request, &response, MakeOpIdForIndex(25), OpId::Min()));
+
+  LWReplicateMsgsHolder refs;
+  bool needs_remote_bootstrap;
+  request.Clear();
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  SetLastReceivedAndLastCommitted(&response, MakeOpIdForIndex(50));
+  ASSERT_FALSE(queue_->ResponseFromPeer(kPeerUuid, response));
+
+  // Regular request with ops 51..60, followed by pipelined requests with ops 61..70 and 71..80.
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 51, 10);
+  request.Clear();
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  ASSERT_EQ(50, request.preceding_id().index());
+  for (int64_t preceding_index : {60, 70}) {
+    AppendReplicateMessagesToQueue(queue_.get(), clock_, preceding_index + 1, 10);
+    LWConsensusRequestPB pipelined_request(&arena);
+    LWReplicateMsgsHolder pipelined_refs;
+    ASSERT_OK(queue_->RequestForPeer(
+        kPeerUuid, &pipelined_request, &pipelined_refs, &needs_remote_bootstrap, nullptr, nullptr,
+        PipelinedRequest::kTrue));
+    ASSERT_EQ(preceding_index, pipelined_request.preceding_id().index());
+  }
+  ASSERT_EQ(81, queue_->GetTrackedPeerForTests(kPeerUuid).pipelined_next_index);
+
+  // Both pipelined requests reached the follower before the regular one and were rejected.
+  for (int64_t preceding_index : {70, 60}) {
+    LWConsensusResponsePB lmp_response(&arena);
+    lmp_response.ref_responder_uuid(kPeerUuid);
+    RefuseWithLogPropertyMismatch(&lmp_response, MakeOpIdForIndex(50), MakeOpIdForIndex(50));
+    ASSERT_TRUE(queue_->PipelinedResponseFromPeer(kPeerUuid, preceding_index, lmp_response));
+  }
+  {
+    auto peer = queue_->GetTrackedPeerForTests(kPeerUuid);
+    // Pipeline is kept, but rejected ops should be sent again.
+    ASSERT_TRUE(peer.is_last_exchange_successful);
+    ASSERT_EQ(61, peer.pipelined_next_index);
+  }
+
+  // Regular request is acked, so the next request resends rejected ops.
+  SetLastReceivedAndLastCommitted(&response, MakeOpIdForIndex(60));
+  ASSERT_TRUE(queue_->ResponseFromPeer(kPeerUuid, response));
+  request.Clear();
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  ASSERT_EQ(60, request.preceding_id().index());
+  ASSERT_EQ(61, request.ops().front().id().index());
+  ASSERT_EQ(81, queue_->GetTrackedPeerForTests(kPeerUuid).pipelined_next_index);
+
+  // This request fails, so the next one starts from next_index instead of continuing after it.
+  queue_->ResetPeerPipeline(kPeerUuid);
+  request.Clear();
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  ASSERT_EQ(60, request.preceding_id().index());
+
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_consensus_max_outstanding_requests_per_peer) = 1;
+}
+
+// Tests that a heartbeat sent while pipelined requests are in flight, that reached the follower
+// before them, does not reset the pipeline.
+TEST_F(ConsensusQueueTest, TestHeartbeatOvertakesPipelinedRequest) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_consensus_max_outstanding_requests_per_peer) = 3;
+  queue_->Init(OpId::Min());
+  queue_->SetLeaderMode(
+      OpId::Min(), OpId::Min().term, OpId::Min(), BuildRaftConfigPBForTests(2));
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 1, 50);
+
+  ThreadSafeArena arena;
+  LWConsensusRequestPB request(&arena);
+  LWConsensusResponsePB response(&arena);
+  response.ref_responder_uuid(kPeerUuid);
+
+  ASSERT_TRUE(UpdatePeerWatermarkToOp(
+      &request, &response, MakeOpIdForIndex(25), OpId::Min()));
+
+  LWReplicateMsgsHolder refs;
+  bool needs_remote_bootstrap;
+  request.Clear();
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  SetLastReceivedAndLastCommitted(&response, MakeOpIdForIndex(50));
+  ASSERT_FALSE(queue_->ResponseFromPeer(kPeerUuid, response));
+
+  // Regular request with ops 51..60, followed by pipelined request with ops 61..70.
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 51, 10);
+  request.Clear();
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  ASSERT_EQ(50, request.preceding_id().index());
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 61, 10);
+  LWConsensusRequestPB pipelined_request(&arena);
+  LWReplicateMsgsHolder pipelined_refs;
+  ASSERT_OK(queue_->RequestForPeer(
+      kPeerUuid, &pipelined_request, &pipelined_refs, &needs_remote_bootstrap, nullptr, nullptr,
+      PipelinedRequest::kTrue));
+  ASSERT_EQ(60, pipelined_request.preceding_id().index());
+
+  // Heartbeat continues after ops in flight.
+  LWConsensusRequestPB heartbeat(&arena);
+  LWReplicateMsgsHolder heartbeat_refs;
+  ASSERT_OK(queue_->RequestForPeer(
+      kPeerUuid, &heartbeat, &heartbeat_refs, &needs_remote_bootstrap));
+  ASSERT_EQ(70, heartbeat.preceding_id().index());
+  ASSERT_TRUE(heartbeat.ops().empty());
+
+  // Heartbeat reached the follower before both requests and was rejected.
+  LWConsensusResponsePB lmp_response(&arena);
+  lmp_response.ref_responder_uuid(kPeerUuid);
+  RefuseWithLogPropertyMismatch(&lmp_response, MakeOpIdForIndex(50), MakeOpIdForIndex(50));
+  ASSERT_TRUE(queue_->ResponseFromPeer(
+      kPeerUuid, heartbeat.preceding_id().index(), lmp_response));
+  {
+    auto peer = queue_->GetTrackedPeerForTests(kPeerUuid);
+    ASSERT_TRUE(peer.is_last_exchange_successful);
+    ASSERT_EQ(71, peer.pipelined_next_index);
+    ASSERT_EQ(51, peer.next_index);
+  }
+
+  // Requests in flight are acked, and the pipeline is drained.
+  SetLastReceivedAndLastCommitted(&response, MakeOpIdForIndex(60));
+  ASSERT_TRUE(queue_->ResponseFromPeer(kPeerUuid, request.preceding_id().index(), response));
+  SetLastReceivedAndLastCommitted(&response, MakeOpIdForIndex(70));
+  ASSERT_FALSE(queue_->PipelinedResponseFromPeer(
+      kPeerUuid, pipelined_request.preceding_id().index(), response));
+  {
+    auto peer = queue_->GetTrackedPeerForTests(kPeerUuid);
+    ASSERT_TRUE(peer.is_last_exchange_successful);
+    ASSERT_EQ(0, peer.pipelined_next_index);
+    ASSERT_EQ(71, peer.next_index);
+  }
+
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_consensus_max_outstanding_requests_per_peer) = 1;
+}
+
 // Tests that the peers gets the messages pages, with the size of a page being
 // 'consensus_max_batch_size_bytes'
 TEST_F(ConsensusQueueTest, TestGetPagedMessages) {
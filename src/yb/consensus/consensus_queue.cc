@@ -102,6 +102,12 @@ DEFINE_UNKNOWN_int32(cdc_checkpoint_opid_interval_ms, 60 * 1000,
              "specified by cdc_checkpoint_opid_interval, then log cache does not consider that "
              "consumer while determining which op IDs to evict.");
 
+DEFINE_RUNTIME_int32(consensus_max_outstanding_requests_per_peer, 1,
+    "Maximum number of consensus update requests carrying operations that the leader could have "
+    "in flight to a single peer. Values greater than 1 allow pipelining of replication on high "
+    "latency links.");
+TAG_FLAG(consensus_max_outstanding_requests_per_peer, advanced);
+
 DEFINE_RUNTIME_bool(enable_consensus_exponential_backoff, true,
     "Whether exponential backoff based on number of retransmissions at tablet leader "
     "for number of entries to replicate to lagging follower is enabled.");
@@ -174,6 +180,18 @@ METRIC_DEFINE_gauge_int64(tablet, in_progress_ops, "Leader Operations in Progres
                           "Number of operations in the leader queue ack'd by a minority of "
                           "peers.");
 
+METRIC_DEFINE_counter(tablet, consensus_batching_delayed_requests,
+                      "Delayed Consensus Update Requests", MetricUnit::kRequests,
+                      "Number of consensus update requests that were held back by adaptive "
+                      "batching to accumulate more operations.");
+METRIC_DEFINE_counter(tablet, consensus_batching_immediate_requests,
+                      "Immediate Consensus Update Requests", MetricUnit::kRequests,
+                      "Number of consensus update requests with pending operations that adaptive "
+                      "batching decided to send immediately.");
+METRIC_DEFINE_counter(tablet, consensus_batching_delay_us,
+                      "Consensus Update Requests Batching Delay", MetricUnit::kMicroseconds,
+                      "Total time consensus update requests were held back by adaptive batching.");
+
 const auto kCDCConsumerCheckpointInterval = FLAGS_cdc_checkpoint_opid_interval_ms * 1ms;
 
 std::string MajorityReplicatedData::ToString() const {
@@ -207,7 +225,12 @@ void PeerMessageQueue::TrackedPeer::ResetLastRequest() {
   x.Instantiate(metric_entity, 0)
 PeerMessageQueue::Metrics::Metrics(const scoped_refptr<MetricEntity>& metric_entity)
   : num_majority_done_ops(INSTANTIATE_METRIC(METRIC_majority_done_ops)),
-    num_in_progress_ops(INSTANTIATE_METRIC(METRIC_in_progress_ops)) {
+    num_in_progress_ops(INSTANTIATE_METRIC(METRIC_in_progress_ops)),
+    num_batching_delayed_requests(
+        METRIC_consensus_batching_delayed_requests.Instantiate(metric_entity)),
+    num_batching_immediate_requests(
+        METRIC_consensus_batching_immediate_requests.Instantiate(metric_entity)),
+    batching_delay_us(METRIC_consensus_batching_delay_us.Instantiate(metric_entity)) {
 }
 #undef INSTANTIATE_METRIC
 
@@ -481,7 +504,8 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
                                         LWReplicateMsgsHolder* msgs_holder,
                                         bool* needs_remote_bootstrap,
                                         PeerMemberType* member_type,
-                                        bool* last_exchange_successful) {
+                                        bool* last_exchange_successful,
+                                        PipelinedRequest pipelined) {
   static constexpr uint64_t kSendUnboundedLogOps = std::numeric_limits<uint64_t>::max();
   DCHECK(request->ops().empty()) << request->ShortDebugString();
 
@@ -513,7 +537,15 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
     HybridTime now_ht;
 
     is_new = peer->is_new;
-    if (!is_new) {
+    if (pipelined && (is_new || !peer->is_last_exchange_successful ||
+                      peer->needs_remote_bootstrap)) {
+      return STATUS(IllegalState, "Peer is not ready for pipelined requests");
+    }
+
+    // Pipelined request is sent while the follower has not replied to the previous request yet,
+    // so the leader lease is propagated only through regular requests, whose replies are matched
+    // with the lease they carried.
+    if (!is_new && !pipelined) {
       now_ht = clock_->Now();
 
       auto ht_lease_expiration_micros = now_ht.GetPhysicalValueMicros() +
@@ -536,6 +568,10 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
       peer->leader_lease_expiration.last_sent =
           CoarseMonoClock::Now() + leader_lease_duration_ms * 1ms - kCoarseClockPrecision * 2;
       peer->leader_ht_lease_expiration.last_sent = ht_lease_expiration_micros;
+    } else if (!is_new) {
+      now_ht = clock_->Now();
+      request->clear_leader_lease_duration_ms();
+      request->clear_ht_lease_expiration();
     } else {
       now_ht = clock_->Now();
       request->clear_leader_lease_duration_ms();
@@ -583,7 +619,14 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
     *needs_remote_bootstrap = peer->needs_remote_bootstrap;
 
     previously_sent_index = peer->next_index - 1;
-    if (FLAGS_enable_consensus_exponential_backoff && peer->last_num_messages_sent >= 0) {
+    if (peer->pipelined_next_index > peer->next_index) {
+      // Ops up to pipelined_next_index are already in flight, continue after them.
+      previously_sent_index = peer->pipelined_next_index - 1;
+    }
+    if (pipelined) {
+      // Previous request was not acked because it is still in flight, not because it was lost.
+      num_log_ops_to_send = kSendUnboundedLogOps;
+    } else if (FLAGS_enable_consensus_exponential_backoff && peer->last_num_messages_sent >= 0) {
       // Previous request to peer has not been acked. Reduce number of entries to be sent
       // in this attempt using exponential backoff. Note that to_index is inclusive.
       num_log_ops_to_send = GetNumMessagesToSendWithBackoff(peer->last_num_messages_sent);
@@ -662,13 +705,17 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
       }
 
       peer->last_num_messages_sent = result->messages.size();
+      if (FLAGS_consensus_max_outstanding_requests_per_peer > 1 && !result->messages.empty()) {
+        peer->pipelined_next_index = result->messages.back()->id().index() + 1;
+      }
     }
 
     ScopedTrackedConsumption consumption;
     if (result->read_from_disk_size) {
       consumption = ScopedTrackedConsumption(operations_mem_tracker_, result->read_from_disk_size);
     }
-    *msgs_holder = LWReplicateMsgsHolder(std::move(result->messages), std::move(consumption));
+    *msgs_holder = LWReplicateMsgsHolder(
+        std::move(result->messages), std::move(consumption), result->messages_size);
 
     if (propagated_safe_time &&
         !result->have_more_messages &&
@@ -1207,8 +1254,36 @@ void PeerMessageQueue::RequestWasNotSent(const std::string& peer_uuid) {
 }
 
 
+void PeerMessageQueue::ResetPeerPipeline(const std::string& peer_uuid) {
+  LockGuard scoped_lock(queue_lock_);
+  TrackedPeer* peer = FindPtrOrNull(peers_map_, peer_uuid);
+  if (peer) {
+    peer->pipelined_next_index = 0;
+  }
+}
+
+bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
+                                        const LWConsensusResponsePB& response) {
+  return DoResponseFromPeer(peer_uuid, response, -1, PipelinedRequest::kFalse);
+}
+
 bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
+                                        int64_t preceding_index,
                                         const LWConsensusResponsePB& response) {
+  return DoResponseFromPeer(peer_uuid, response, preceding_index, PipelinedRequest::kFalse);
+}
+
+bool PeerMessageQueue::PipelinedResponseFromPeer(const std::string& peer_uuid,
+                                                 int64_t preceding_index,
+                                                 const LWConsensusResponsePB& response) {
+  DCHECK_GE(preceding_index, 0);
+  return DoResponseFromPeer(peer_uuid, response, preceding_index, PipelinedRequest::kTrue);
+}
+
+bool PeerMessageQueue::DoResponseFromPeer(const std::string& peer_uuid,
+                                          const LWConsensusResponsePB& response,
+                                          int64_t preceding_index,
+                                          PipelinedRequest pipelined) {
   MajorityReplicatedData majority_replicated;
   Mode mode_copy;
   bool result = false;
@@ -1279,7 +1354,31 @@ bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
       // log, which is guaranteed by the Raft protocol to be a valid op.
 
       bool peer_has_prefix_of_log = IsOpInLog(OpId::FromPB(status.last_received()));
-      if (peer_has_prefix_of_log) {
+      // The request continued after unacked ops that are still in flight, both pipelined and
+      // regular requests (including heartbeats) do so.
+      const bool sent_after_unacked_ops = preceding_index >= peer->next_index;
+      if (sent_after_unacked_ops && peer_has_prefix_of_log && status.has_error() &&
+          status.error().code() == ConsensusErrorPB::PRECEDING_ENTRY_DIDNT_MATCH &&
+          status.last_received().index() < preceding_index) {
+        // The follower got this request before the earlier one, its log is not divergent.
+        // Keep the pipeline and only resend ops starting from this request.
+        VLOG_WITH_PREFIX_UNLOCKED(2) << "Request arrived before ops in flight: "
+                                     << peer->ToString();
+        if (peer->pipelined_next_index > preceding_index + 1) {
+          peer->pipelined_next_index = preceding_index + 1;
+        }
+        if (peer->next_index >= peer->pipelined_next_index) {
+          peer->pipelined_next_index = 0;
+        }
+        return true;
+      }
+      if (peer_has_prefix_of_log && !status.has_error() &&
+          FLAGS_consensus_max_outstanding_requests_per_peer > 1 &&
+          status.last_received().index() < peer->last_received.index) {
+        // With several requests in flight responses could arrive out of order. Don't move back
+        // because of a stale reply.
+        VLOG_WITH_PREFIX_UNLOCKED(2) << "Stale response from peer: " << peer->ToString();
+      } else if (peer_has_prefix_of_log) {
         // If the latest thing in their log is in our log, we are in sync.
         peer->last_received = OpId::FromPB(status.last_received());
         peer->next_index = peer->last_received.index + 1;
@@ -1302,6 +1401,8 @@ bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
 
       if (PREDICT_FALSE(status.has_error())) {
         peer->is_last_exchange_successful = false;
+        // Ops that are in flight will be rejected as well, restart from next_index.
+        peer->pipelined_next_index = 0;
         switch (status.error().code()) {
           case ConsensusErrorPB::PRECEDING_ENTRY_DIDNT_MATCH: {
             DCHECK(status.has_last_received());
@@ -1333,6 +1434,10 @@ bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
 
     peer->is_last_exchange_successful = true;
     peer->num_sst_files = response.num_sst_files();
+    if (peer->next_index >= peer->pipelined_next_index) {
+      // All ops sent to the peer were acked.
+      peer->pipelined_next_index = 0;
+    }
 
     if (response.has_responder_term()) {
       // The peer must have responded with a term that is greater than or equal to the last known
@@ -1365,8 +1470,10 @@ bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
         }
       }
 
-      peer->leader_lease_expiration.OnReplyFromFollower();
-      peer->leader_ht_lease_expiration.OnReplyFromFollower();
+      if (!pipelined) {
+        peer->leader_lease_expiration.OnReplyFromFollower();
+        peer->leader_ht_lease_expiration.OnReplyFromFollower();
+      }
 
       majority_replicated.op_id = queue_state_.majority_replicated_op_id;
       majority_replicated.leader_lease_expiration = LeaderLeaseExpirationWatermark();
@@ -151,6 +151,11 @@ class PeerMessageQueue {
     // Next index to send to the peer.  This corresponds to "nextIndex" as specified in Raft.
     int64_t next_index = kInvalidOpIdIndex;
 
+    // Index following the last op sent to the peer, while it has requests in flight that were not
+    // acked yet. Pipelined requests continue from this index instead of next_index.
+    // 0 when there are no unacked ops in flight.
+    int64_t pipelined_next_index = 0;
+
     // Number of ops starting from next_index_ to retransmit.
     int64_t last_num_messages_sent = -1;
 
@@ -297,7 +302,8 @@ class PeerMessageQueue {
       LWReplicateMsgsHolder* msgs_holder,
       bool* needs_remote_bootstrap,
       PeerMemberType* member_type = nullptr,
-      bool* last_exchange_successful = nullptr);
+      bool* last_exchange_successful = nullptr,
+      PipelinedRequest pipelined = PipelinedRequest::kFalse);
 
   // Fill in a StartRemoteBootstrapRequest for the specified peer.  If that peer should not remotely
   // bootstrap, returns a non-OK status.  On success, also internally resets
@@ -321,6 +327,24 @@ class PeerMessageQueue {
   virtual bool ResponseFromPeer(const std::string& peer_uuid,
                                 const LWConsensusResponsePB& response);
 
+  // Same as above, but preceding_index is the index of the op preceding ops of the request. While
+  // pipelined requests are in flight, a regular request continues after them and could overtake
+  // them, such mismatch is not treated as divergent log.
+  bool ResponseFromPeer(const std::string& peer_uuid,
+                        int64_t preceding_index,
+                        const LWConsensusResponsePB& response);
+
+  // Same as ResponseFromPeer, but for a request sent while another request to the same peer was
+  // in flight. Responses to such requests could arrive out of order, and they don't carry leader
+  // leases. preceding_index is the index of the op preceding ops of the request.
+  bool PipelinedResponseFromPeer(const std::string& peer_uuid,
+                                 int64_t preceding_index,
+                                 const LWConsensusResponsePB& response);
+
+  // Forgets about unacked ops in flight to the peer, so the next request starts from next_index.
+  // Called when a request to the peer has failed.
+  void ResetPeerPipeline(const std::string& peer_uuid);
+
   void RequestWasNotSent(const std::string& peer_uuid);
 
   // Closes the queue, peers are still allowed to call UntrackPeer() and ResponseFromPeer() but no
@@ -367,6 +391,12 @@ class PeerMessageQueue {
     scoped_refptr<AtomicGauge<int64_t> > num_majority_done_ops;
     // Keeps track of the number of ops. that are still in progress (IsDone() returns false).
     scoped_refptr<AtomicGauge<int64_t> > num_in_progress_ops;
+    // Number of update requests with pending operations that were held back by adaptive batching,
+    // and that were sent immediately.
+    scoped_refptr<Counter> num_batching_delayed_requests;
+    scoped_refptr<Counter> num_batching_immediate_requests;
+    // Total time update requests were held back by adaptive batching.
+    scoped_refptr<Counter> batching_delay_us;
 
     explicit Metrics(const scoped_refptr<MetricEntity>& metric_entity);
   };
@@ -376,6 +406,10 @@ class PeerMessageQueue {
   void NotifyObserversOfFailedFollower(const std::string& uuid,
                                        const std::string& reason);
 
+  Metrics& metrics() {
+    return metrics_;
+  }
+
   void SetContext(ConsensusContext* context) {
     context_ = context;
   }
@@ -437,6 +471,12 @@ class PeerMessageQueue {
 
   static constexpr ssize_t kUninitializedMajoritySize = -1;
 
+  // preceding_index is the preceding index of the request, or -1 when unknown.
+  bool DoResponseFromPeer(const std::string& peer_uuid,
+                          const LWConsensusResponsePB& response,
+                          int64_t preceding_index,
+                          PipelinedRequest pipelined);
+
   struct QueueState {
 
     // The last operation that has been replicated to all currently tracked peers.
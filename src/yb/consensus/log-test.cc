@@ -63,6 +63,7 @@ DECLARE_bool(never_fsync);
 DECLARE_bool(writable_file_use_fsync);
 DECLARE_int32(o_direct_block_alignment_bytes);
 DECLARE_int32(o_direct_block_size_bytes);
+DECLARE_bool(enable_log_segment_mmap_reads);
 
 namespace yb {
 namespace log {
@@ -573,6 +574,44 @@ TEST_F(LogTest, TestSegmentRollover) {
   ASSERT_EQ(num_entries, total_read);
 }
 
+// Tests that entries of closed segments read through memory mapping match regular reads.
+TEST_F(LogTest, TestMmapReadsOfClosedSegments) {
+  BuildLog();
+  OpIdPB op_id = MakeOpId(1, 1);
+  ASSERT_OK(AppendMultiSegmentSequence(3, 10, &op_id, nullptr));
+
+  SegmentSequence segments;
+  ASSERT_OK(log_->GetLogReader()->GetSegmentsSnapshot(&segments));
+  ASSERT_EQ(segments.size(), 3);
+
+  for (const auto& segment : segments) {
+    auto regular_entries = segment->ReadEntries();
+    ASSERT_OK(regular_entries.status);
+
+    ANNOTATE_UNPROTECTED_WRITE(FLAGS_enable_log_segment_mmap_reads) = true;
+    auto mapped_entries = segment->ReadEntries();
+    ANNOTATE_UNPROTECTED_WRITE(FLAGS_enable_log_segment_mmap_reads) = false;
+    ASSERT_OK(mapped_entries.status);
+
+    ASSERT_EQ(regular_entries.entries.size(), mapped_entries.entries.size());
+    for (size_t i = 0; i != regular_entries.entries.size(); ++i) {
+      ASSERT_EQ(regular_entries.entries[i]->ShortDebugString(),
+                mapped_entries.entries[i]->ShortDebugString());
+    }
+  }
+
+  // Released segment, i.e. deleted by GC, keeps serving reads through the opened file.
+  auto segment = ASSERT_RESULT(segments.front());
+  auto expected_entries = segment->ReadEntries();
+  ASSERT_OK(expected_entries.status);
+  segment->ReleaseMapping();
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_enable_log_segment_mmap_reads) = true;
+  auto released_entries = segment->ReadEntries();
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_enable_log_segment_mmap_reads) = false;
+  ASSERT_OK(released_entries.status);
+  ASSERT_EQ(expected_entries.entries.size(), released_entries.entries.size());
+}
+
 TEST_F(LogTest, TestWriteAndReadToAndFromInProgressSegment) {
   const int kNumEntries = 4;
   BuildLog();
@@ -1350,6 +1350,7 @@ Status Log::GC(int64_t min_op_idx, int32_t* num_gced) {
                             << " (GCed ops < " << segment->footer().max_replicate_index() + 1
                             << ")";
       RETURN_NOT_OK(get_env()->DeleteFile(segment->path()));
+      segment->ReleaseMapping();
       (*num_gced)++;
 
       if (metrics_) {
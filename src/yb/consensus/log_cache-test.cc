@@ -54,6 +54,7 @@
 #include "yb/server/hybrid_clock.h"
 
 #include "yb/util/mem_tracker.h"
+#include "yb/util/memory/arena.h"
 #include "yb/util/metrics.h"
 #include "yb/util/monotime.h"
 #include "yb/util/scope_exit.h"
@@ -405,6 +406,32 @@ TEST_F(LogCacheTest, TestGlobalMemoryLimitPercentage) {
   ASSERT_LE(cache_->BytesUsed(), 1_MB);
 }
 
+// Test that memory usage of a cached message is taken from its arena, while its wire size is taken
+// from the serialized message. Messages received in the same request share its arena, so they split
+// its memory.
+TEST_F(LogCacheTest, TestEntrySizes) {
+  const size_t kPayloadSize = 16_KB;
+  auto arena = SharedArena();
+  ReplicateMsgs msgs;
+  for (int64_t index = 1; index <= 2; ++index) {
+    auto msg = CreateDummyReplicate(0 /* term */, index, clock_->Now(), kPayloadSize);
+    msgs.push_back(rpc::SharedField(arena, arena->NewArenaObject<LWReplicateMsg>(*msg)));
+  }
+  ASSERT_OK(cache_->AppendOperations(
+      msgs, OpId() /* committed_op_id */, RestartSafeCoarseMonoClock().Now(),
+      Bind(&FatalOnError)));
+  ASSERT_OK(log_->WaitUntilAllFlushed());
+
+  std::lock_guard<simple_spinlock> lock(cache_->lock_);
+  for (const auto& msg : msgs) {
+    const auto& entry = cache_->cache_.at(msg->id().index());
+    ASSERT_EQ(entry.mem_usage, arena->memory_footprint() / msgs.size());
+    ASSERT_GE(entry.mem_usage, kPayloadSize);
+    ASSERT_GT(entry.wire_size, msg->SerializedSize());
+    ASSERT_LT(entry.wire_size, msg->SerializedSize() + 8);
+  }
+}
+
 // Test that the log cache properly replaces messages when an index
 // is reused. This is a regression test for a bug where the memtracker's
 // consumption wasn't properly managed when messages were replaced.
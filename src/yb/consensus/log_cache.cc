@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <map>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "yb/consensus/consensus.messages.h"
@@ -104,6 +105,15 @@ namespace {
 
 const std::string kParentMemTrackerId = "log_cache"s;
 
+// Calculate the total byte size that will be used on the wire to replicate this message as part of
+// a consensus update request. This accounts for the length delimiting and tagging of the message.
+int64_t TotalByteSizeForMessage(const LWReplicateMsg& msg) {
+  auto msg_size = google::protobuf::internal::WireFormatLite::LengthDelimitedSize(
+      msg.SerializedSize());
+  msg_size += 1; // for the type tag
+  return msg_size;
+}
+
 }
 
 typedef vector<const ReplicateMsg*>::const_iterator MsgIter;
@@ -178,8 +188,18 @@ LogCache::PrepareAppendResult LogCache::PrepareAppendOperations(const ReplicateM
   PrepareAppendResult result;
   std::vector<CacheEntry> entries_to_insert;
   entries_to_insert.reserve(msgs.size());
+  // Messages received from the leader share the arena of the request, so its memory is split
+  // between them.
+  std::unordered_map<const ThreadSafeArena*, size_t> messages_per_arena;
+  for (const auto& msg : msgs) {
+    ++messages_per_arena[&msg->arena()];
+  }
   for (const auto& msg : msgs) {
-    CacheEntry e = { msg, msg->SpaceUsedLong() };
+    CacheEntry e = {
+      .msg = msg,
+      .mem_usage = msg->arena().memory_footprint() / messages_per_arena[&msg->arena()],
+      .wire_size = TotalByteSizeForMessage(*msg),
+    };
     result.mem_required += e.mem_usage;
     entries_to_insert.emplace_back(std::move(e));
   }
@@ -319,15 +339,6 @@ Result<yb::OpId> LogCache::LookupOpId(int64_t op_index) const {
 
 namespace {
 
-// Calculate the total byte size that will be used on the wire to replicate this message as part of
-// a consensus update request. This accounts for the length delimiting and tagging of the message.
-int64_t TotalByteSizeForMessage(const LWReplicateMsg& msg) {
-  auto msg_size = google::protobuf::internal::WireFormatLite::LengthDelimitedSize(
-      msg.SerializedSize());
-  msg_size += 1; // for the type tag
-  return msg_size;
-}
-
 Status UpdateResultHeaderSchemaFromSegment(
     log::LogReader* log_reader, const int64_t segment_seq_num, ReadOpsResult* result) {
   const auto segment_result = log_reader->GetSegmentBySequenceNumber(segment_seq_num);
@@ -447,6 +458,7 @@ Result<ReadOpsResult> LogCache::ReadOps(
           result.header_schema_version = msg->change_metadata_request().schema_version();
         }
         result.read_from_disk_size += current_message_size;
+        result.messages_size += current_message_size;
         next_index++;
       }
     } else {
@@ -471,13 +483,14 @@ Result<ReadOpsResult> LogCache::ReadOps(
           continue;
         }
 
-        auto current_message_size = TotalByteSizeForMessage(*msg);
+        auto current_message_size = iter->second.wire_size;
         remaining_space -= current_message_size;
         if (remaining_space < 0 && !result.messages.empty()) {
           break;
         }
 
         result.messages.push_back(msg);
+        result.messages_size += current_message_size;
         if (msg->op_type() == consensus::OperationType::CHANGE_METADATA_OP) {
           msg->change_metadata_request().schema().ToGoogleProtobuf(&result.header_schema);
           result.header_schema_version = msg->change_metadata_request().schema_version();
@@ -82,6 +82,8 @@ struct ReadOpsResult {
   uint32_t header_schema_version;
   HaveMoreMessages have_more_messages = HaveMoreMessages::kFalse;
   int64_t read_from_disk_size = 0;
+  // Number of bytes messages occupy inside a ConsensusRequestPB.
+  int64_t messages_size = 0;
 };
 
 // Write-through cache for the log.
@@ -190,17 +192,23 @@ class LogCache {
   FRIEND_TEST(LogCacheTest, TestGlobalMemoryLimitMB);
   FRIEND_TEST(LogCacheTest, TestGlobalMemoryLimitPercentage);
   FRIEND_TEST(LogCacheTest, TestReplaceMessages);
+  FRIEND_TEST(LogCacheTest, TestEntrySizes);
   friend class LogCacheTest;
 
   // An entry in the cache.
   struct CacheEntry {
     ReplicateMsgPtr msg;
-    // The cached value of msg->SpaceUsedLong(). This method is expensive
-    // to compute, so we compute it only once upon insertion.
+    // Memory used by the message, i.e. its part of the arena the message is allocated in.
+    // Computed once upon insertion.
     size_t mem_usage = 0;
 
     // Did we start memory tracking for this entry.
     bool tracked = false;
+
+    // Number of bytes this message occupies inside a ConsensusRequestPB, i.e. including the tag
+    // and length prefix. Computed once on insertion, so that reading the same entry for every
+    // peer does not walk the message again.
+    int64_t wire_size = 0;
   };
 
   typedef boost::container::small_vector<ReplicateMsgPtr, 8> ReplicateMsgVector;
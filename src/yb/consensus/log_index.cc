@@ -62,6 +62,7 @@
 #include "yb/util/atomic.h"
 #include "yb/util/scope_exit.h"
 #include "yb/util/env.h"
+#include "yb/util/errno.h"
 #include "yb/util/file_util.h"
 #include "yb/util/flags.h"
 #include "yb/util/locks.h"
@@ -80,10 +81,6 @@ using std::string;
 using std::vector;
 using strings::Substitute;
 
-#define RETRY_ON_EINTR(ret, expr) do { \
-  ret = expr; \
-} while ((ret == -1) && (errno == EINTR));
-
 namespace yb {
 namespace log {
 
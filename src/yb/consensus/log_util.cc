@@ -45,6 +45,7 @@
 #include "yb/consensus/opid_util.h"
 #include "yb/consensus/log.messages.h"
 #include "yb/consensus/log_index.h"
+#include "yb/consensus/mapped_log_segment.h"
 
 #include "yb/fs/fs_manager.h"
 
@@ -68,6 +69,10 @@
 #include "yb/util/status_format.h"
 #include "yb/util/status_log.h"
 
+DEFINE_RUNTIME_bool(enable_log_segment_mmap_reads, false,
+    "Read entries of closed WAL segments through a memory mapping instead of copying them "
+    "into freshly allocated buffers. Used by log cache misses, CDC and remote bootstrap.");
+
 DEFINE_UNKNOWN_int32(log_segment_size_mb, 64,
              "The default segment size for log roll-overs, in MB");
 TAG_FLAG(log_segment_size_mb, advanced);
@@ -856,9 +861,14 @@ Result<std::shared_ptr<LWLogEntryBatchPB>> ReadableLogSegment::ReadEntryHeaderAn
 Status ReadableLogSegment::ReadEntryHeader(int64_t *offset, EntryHeader* header) {
   uint8_t scratch[kEntryHeaderSize];
   Slice slice;
-  RETURN_NOT_OK_PREPEND(ReadFully(readable_file().get(), *offset, kEntryHeaderSize,
-                                  &slice, scratch),
-                        "Could not read log entry header");
+  auto mapping = VERIFY_RESULT(MappingForRead());
+  if (mapping && *offset + kEntryHeaderSize <= mapping->size()) {
+    slice = Slice(mapping->data().data() + *offset, kEntryHeaderSize);
+  } else {
+    RETURN_NOT_OK_PREPEND(ReadFully(readable_file().get(), *offset, kEntryHeaderSize,
+                                    &slice, scratch),
+                          "Could not read log entry header");
+  }
 
   RETURN_NOT_OK(DecodeEntryHeader(slice, header));
   *offset += slice.size();
@@ -901,6 +911,17 @@ Result<std::shared_ptr<LWLogEntryBatchPB>> ReadableLogSegment::ReadEntryBatch(
                    header.msg_length, *offset, path_, limit));
   }
 
+  auto mapping = VERIFY_RESULT(MappingForRead());
+  if (mapping) {
+    if (PREDICT_FALSE(*offset + header.msg_length > mapping->size())) {
+      return STATUS_FORMAT(
+          Corruption, "Entry at offset $0, length $1 is beyond mapped size $2 of $3",
+          *offset, header.msg_length, mapping->size(), path_);
+    }
+    return ParseEntryBatch(
+        mapping, Slice(mapping->data().data() + *offset, header.msg_length), header, offset);
+  }
+
   RefCntBuffer buffer(header.msg_length);
   Slice entry_batch_slice;
 
@@ -912,6 +933,12 @@ Result<std::shared_ptr<LWLogEntryBatchPB>> ReadableLogSegment::ReadEntryBatch(
         header.msg_length, s);
   }
 
+  return ParseEntryBatch(buffer, entry_batch_slice, header, offset);
+}
+
+template <class Data>
+Result<std::shared_ptr<LWLogEntryBatchPB>> ReadableLogSegment::ParseEntryBatch(
+    const Data& data, Slice entry_batch_slice, const EntryHeader& header, int64_t* offset) {
   // Verify the CRC.
   uint32_t read_crc = crc::Crc32c(entry_batch_slice.data(), entry_batch_slice.size());
   if (PREDICT_FALSE(read_crc != header.msg_crc)) {
@@ -922,16 +949,17 @@ Result<std::shared_ptr<LWLogEntryBatchPB>> ReadableLogSegment::ReadEntryBatch(
   }
 
   // TODO(lw_uc) embed buffer and first arena block into holder itself.
+  // Parsed batch refers to the data, so keep it alive while the batch is alive.
   struct DataHolder {
-    RefCntBuffer buffer;
+    Data data;
     ThreadSafeArena arena;
 
-    explicit DataHolder(const RefCntBuffer& buffer_) : buffer(buffer_) {}
+    explicit DataHolder(const Data& data_) : data(data_) {}
   };
 
-  auto holder = std::make_shared<DataHolder>(buffer);
-  auto batch = holder->arena.NewArenaObject<LWLogEntryBatchPB>();
-  s = batch->ParseFromSlice(entry_batch_slice.Prefix(header.msg_length));
+  auto holder = std::make_shared<DataHolder>(data);
+  auto batch = holder->arena.template NewArenaObject<LWLogEntryBatchPB>();
+  auto s = batch->ParseFromSlice(entry_batch_slice.Prefix(header.msg_length));
 
   if (!s.ok()) {
     return STATUS_FORMAT(
@@ -943,6 +971,19 @@ Result<std::shared_ptr<LWLogEntryBatchPB>> ReadableLogSegment::ReadEntryBatch(
   return rpc::SharedField(holder, batch);
 }
 
+Result<std::shared_ptr<MappedLogSegment>> ReadableLogSegment::MappingForRead() {
+  // Only closed segments are immutable, and encrypted segments have to be decrypted on read.
+  if (!FLAGS_enable_log_segment_mmap_reads || !HasFooter() || footer_was_rebuilt_ ||
+      readable_file_->IsEncrypted()) {
+    return nullptr;
+  }
+  return MappedLogSegmentCache::Instance().Get(&mapping_slot_, path_, file_size());
+}
+
+void ReadableLogSegment::ReleaseMapping() {
+  MappedLogSegmentCache::Instance().Release(&mapping_slot_);
+}
+
 const LogSegmentHeaderPB& ReadableLogSegment::header() const {
   DCHECK(header_.IsInitialized());
   return header_;
@@ -45,6 +45,7 @@
 #include "yb/consensus/log_fwd.h"
 #include "yb/consensus/log.fwd.h"
 #include "yb/consensus/log.pb.h"
+#include "yb/consensus/mapped_log_segment.h"
 
 #include "yb/gutil/macros.h"
 #include "yb/gutil/ref_counted.h"
@@ -66,6 +67,7 @@ DECLARE_string(fs_data_dirs);
 namespace yb {
 namespace log {
 
+
 // Suffix for temporary files
 extern const char kTmpSuffix[];
 
@@ -239,6 +241,10 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
 
   const LogSegmentHeaderPB& header() const;
 
+  // Drops memory mapping of the segment and disables further mapped reads. Should be invoked when
+  // the segment file is deleted, reads continue through the still opened file.
+  void ReleaseMapping();
+
   // Indicates whether this segment has a footer.
   //
   // Segments that were properly closed, e.g. because they were rolled over,
@@ -346,6 +352,14 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
   Result<std::shared_ptr<LWLogEntryBatchPB>> ReadEntryBatch(
       int64_t *offset, const EntryHeader& header);
 
+  // Verifies and parses entry batch stored in entry_batch_slice, that points into data.
+  template <class Data>
+  Result<std::shared_ptr<LWLogEntryBatchPB>> ParseEntryBatch(
+      const Data& data, Slice entry_batch_slice, const EntryHeader& header, int64_t* offset);
+
+  // Returns mapping of this segment, when entries could be read through it, nullptr otherwise.
+  Result<std::shared_ptr<MappedLogSegment>> MappingForRead();
+
   void UpdateReadableToOffset(int64_t readable_to_offset);
 
   int64_t ReadEntriesUpTo();
@@ -378,6 +392,9 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
   // True if the footer was rebuilt, rather than actually found on disk.
   bool footer_was_rebuilt_;
 
+  // Mapping of the segment file in MappedLogSegmentCache.
+  MappedLogSegmentSlot mapping_slot_;
+
   // the offset of the first entry in the log.
   int64_t first_entry_offset_;
 
@@ -0,0 +1,148 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include "yb/consensus/mapped_log_segment.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "yb/util/errno.h"
+#include "yb/util/flags.h"
+#include "yb/util/logging.h"
+#include "yb/util/monotime.h"
+#include "yb/util/size_literals.h"
+#include "yb/util/status_format.h"
+
+using namespace yb::size_literals;
+
+DEFINE_NON_RUNTIME_uint64(log_segment_mmap_budget_mb, 256,
+    "Maximum total size of closed WAL segments that are kept memory mapped for reads, when "
+    "enable_log_segment_mmap_reads is set.");
+TAG_FLAG(log_segment_mmap_budget_mb, advanced);
+
+namespace yb {
+namespace log {
+
+namespace {
+
+const std::string kMemTrackerId = "LogSegmentMmap";
+
+} // namespace
+
+MappedLogSegment::MappedLogSegment(
+    uint8_t* data, size_t size, ScopedTrackedConsumption consumption)
+    : data_(data), size_(size), consumption_(std::move(consumption)) {
+}
+
+MappedLogSegment::~MappedLogSegment() {
+  if (munmap(data_, size_) != 0) {
+    LOG(DFATAL) << "Failed to unmap log segment: " << ErrnoToString(errno);
+  }
+}
+
+Result<std::shared_ptr<MappedLogSegment>> MappedLogSegment::Map(
+    const std::string& path, size_t size, ScopedTrackedConsumption consumption) {
+  int fd;
+  RETRY_ON_EINTR(fd, open(path.c_str(), O_CLOEXEC | O_RDONLY));
+  if (fd < 0) {
+    return STATUS_FORMAT(IOError, "Unable to open $0: $1", path, ErrnoToString(errno));
+  }
+  auto* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the descriptor is closed.
+  auto mmap_errno = errno;
+  close(fd);
+  if (data == MAP_FAILED) {
+    return STATUS_FORMAT(IOError, "Unable to mmap $0: $1", path, ErrnoToString(mmap_errno));
+  }
+  return std::shared_ptr<MappedLogSegment>(new MappedLogSegment(
+      static_cast<uint8_t*>(data), size, std::move(consumption)));
+}
+
+MappedLogSegmentSlot::~MappedLogSegmentSlot() {
+  if (std::atomic_load_explicit(&mapping_, std::memory_order_acquire)) {
+    MappedLogSegmentCache::Instance().Release(this);
+  }
+}
+
+MappedLogSegmentCache::MappedLogSegmentCache()
+    : mem_tracker_(MemTracker::FindOrCreateTracker(
+          FLAGS_log_segment_mmap_budget_mb * 1_MB, kMemTrackerId, MemTracker::GetRootTracker(),
+          // Mapped pages belong to the page cache, so don't add them to the process consumption.
+          AddToParent::kFalse)) {
+}
+
+MappedLogSegmentCache& MappedLogSegmentCache::Instance() {
+  static MappedLogSegmentCache instance;
+  return instance;
+}
+
+Result<std::shared_ptr<MappedLogSegment>> MappedLogSegmentCache::Get(
+    MappedLogSegmentSlot* slot, const std::string& path, size_t size) {
+  const auto now = CoarseMonoClock::Now().time_since_epoch().count();
+  auto mapping = std::atomic_load_explicit(&slot->mapping_, std::memory_order_acquire);
+  if (mapping) {
+    slot->last_access_.store(now, std::memory_order_relaxed);
+    return mapping;
+  }
+  if (slot->released_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Check again, since the segment could be mapped or released concurrently.
+  mapping = std::atomic_load_explicit(&slot->mapping_, std::memory_order_acquire);
+  if (mapping || slot->released_.load(std::memory_order_acquire)) {
+    return mapping;
+  }
+
+  while (!mem_tracker_->TryConsume(size)) {
+    if (mapped_slots_.empty()) {
+      VLOG(2) << "Not enough mmap budget for " << path << " of size " << size;
+      return nullptr;
+    }
+    // Memory of evicted mappings is released only when the last reader releases them, so budget
+    // could stay exhausted even after everything is evicted.
+    EvictUnlocked(*std::min_element(
+        mapped_slots_.begin(), mapped_slots_.end(), [](const auto* lhs, const auto* rhs) {
+      return lhs->last_access_.load(std::memory_order_relaxed) <
+             rhs->last_access_.load(std::memory_order_relaxed);
+    }));
+  }
+
+  mapping = VERIFY_RESULT(MappedLogSegment::Map(
+      path, size, ScopedTrackedConsumption(mem_tracker_, size, AlreadyConsumed::kTrue)));
+  slot->last_access_.store(now, std::memory_order_relaxed);
+  std::atomic_store_explicit(&slot->mapping_, mapping, std::memory_order_release);
+  mapped_slots_.insert(slot);
+  return mapping;
+}
+
+void MappedLogSegmentCache::Release(MappedLogSegmentSlot* slot) {
+  slot->released_.store(true, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (mapped_slots_.count(slot)) {
+    EvictUnlocked(slot);
+  }
+}
+
+void MappedLogSegmentCache::EvictUnlocked(MappedLogSegmentSlot* slot) {
+  mapped_slots_.erase(slot);
+  std::atomic_store_explicit(
+      &slot->mapping_, std::shared_ptr<MappedLogSegment>(), std::memory_order_release);
+}
+
+} // namespace log
+} // namespace yb
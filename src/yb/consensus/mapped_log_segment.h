@@ -0,0 +1,109 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "yb/util/mem_tracker.h"
+#include "yb/util/result.h"
+#include "yb/util/slice.h"
+
+namespace yb {
+namespace log {
+
+// Read only memory mapping of a closed (immutable) WAL segment file.
+// Entries read through the mapping point directly into it, so the mapping is kept alive by
+// shared_ptr for as long as any of those entries is referenced.
+class MappedLogSegment {
+ public:
+  static Result<std::shared_ptr<MappedLogSegment>> Map(
+      const std::string& path, size_t size, ScopedTrackedConsumption consumption);
+
+  MappedLogSegment(const MappedLogSegment&) = delete;
+  void operator=(const MappedLogSegment&) = delete;
+
+  ~MappedLogSegment();
+
+  Slice data() const {
+    return Slice(data_, size_);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  MappedLogSegment(uint8_t* data, size_t size, ScopedTrackedConsumption consumption);
+
+  uint8_t* const data_;
+  const size_t size_;
+  ScopedTrackedConsumption consumption_;
+};
+
+// Mapping state of a single segment object, embedded into the segment. Readers of a mapped
+// segment load the mapping without taking any global lock.
+class MappedLogSegmentSlot {
+ public:
+  MappedLogSegmentSlot() = default;
+  MappedLogSegmentSlot(const MappedLogSegmentSlot&) = delete;
+  void operator=(const MappedLogSegmentSlot&) = delete;
+
+  ~MappedLogSegmentSlot();
+
+ private:
+  friend class MappedLogSegmentCache;
+
+  std::shared_ptr<MappedLogSegment> mapping_;
+  // Coarse time of the last read through the mapping, used to pick the victim for eviction.
+  std::atomic<int64_t> last_access_{0};
+  // Set when the segment is deleted or destroyed, the segment should not be mapped anymore.
+  std::atomic<bool> released_{false};
+};
+
+// Server wide cache of mapped closed WAL segments.
+// Total size of mapped segments is bounded by log_segment_mmap_budget_mb and is accounted in the
+// "LogSegmentMmap" MemTracker. When the budget is exhausted, the least recently read mapping is
+// evicted. Evicted mappings are unmapped once the last reader releases them.
+class MappedLogSegmentCache {
+ public:
+  static MappedLogSegmentCache& Instance();
+
+  // Returns mapping of the segment file, mapping it if necessary.
+  // Returns nullptr when the segment does not fit into the budget or was released, in which case
+  // the caller should fall back to regular reads.
+  Result<std::shared_ptr<MappedLogSegment>> Get(
+      MappedLogSegmentSlot* slot, const std::string& path, size_t size);
+
+  // Drops mapping of the segment, and prevents it from being mapped again.
+  // Should be invoked when the segment file is deleted.
+  void Release(MappedLogSegmentSlot* slot);
+
+ private:
+  MappedLogSegmentCache();
+
+  void EvictUnlocked(MappedLogSegmentSlot* slot);
+
+  MemTrackerPtr mem_tracker_;
+
+  std::mutex mutex_;
+  // Slots that have mapping.
+  std::unordered_set<MappedLogSegmentSlot*> mapped_slots_;
+};
+
+} // namespace log
+} // namespace yb
@@ -17,11 +17,15 @@
 #include "yb/common/wire_protocol.h"
 
 #include "yb/consensus/consensus_meta.h"
+#include "yb/consensus/consensus.messages.h"
 #include "yb/consensus/consensus.proxy.h"
 
+#include "yb/rpc/messenger.h"
 #include "yb/rpc/periodic.h"
+#include "yb/rpc/scheduler.h"
 
 #include "yb/util/flags.h"
+#include "yb/util/memory/arena.h"
 
 using namespace std::literals;
 using namespace std::placeholders;
@@ -37,6 +41,21 @@ DEFINE_UNKNOWN_uint64(multi_raft_batch_size, 0,
               "Maximum batch size for a multi-Raft consensus payload. Ignored if set to zero.");
 TAG_FLAG(multi_raft_batch_size, advanced);
 
+DEFINE_RUNTIME_bool(enable_multi_raft_data_batching, false,
+    "If true, consensus update requests carrying operations are also batched across tablets "
+    "replicating to the same tserver. Requires enable_multi_raft_heartbeat_batcher.");
+TAG_FLAG(enable_multi_raft_data_batching, advanced);
+
+DEFINE_RUNTIME_uint64(multi_raft_data_batch_delay_us, 200,
+    "Maximum time a consensus update request carrying operations waits in the multi-Raft batch "
+    "before the batch is sent.");
+TAG_FLAG(multi_raft_data_batch_delay_us, advanced);
+
+DEFINE_RUNTIME_uint64(multi_raft_max_batched_request_bytes, 64 * 1024,
+    "Consensus update requests larger than this size are sent directly instead of being added to "
+    "the multi-Raft batch.");
+TAG_FLAG(multi_raft_max_batched_request_bytes, advanced);
+
 DECLARE_int32(consensus_rpc_timeout_ms);
 
 namespace yb {
@@ -46,17 +65,17 @@ using rpc::PeriodicTimer;
 
 namespace {
 
-// Tracks a single peers ConsensusResponsePB as well as its ProcessResponse callback.
+// Tracks a single peers ProcessResponse callback.
 struct ResponseCallbackData {
-  ConsensusResponsePB* resp;
   HeartbeatResponseCallback callback;
 };
 
 }
 
 struct MultiRaftHeartbeatBatcher::MultiRaftConsensusData {
-  MultiRaftConsensusRequestPB batch_req;
-  MultiRaftConsensusResponsePB batch_res;
+  ThreadSafeArena arena;
+  LWMultiRaftConsensusRequestPB batch_req{&arena};
+  LWMultiRaftConsensusResponsePB batch_res{&arena};
   rpc::RpcController controller;
   std::vector<ResponseCallbackData> response_callback_data;
 };
@@ -90,26 +109,57 @@ MultiRaftHeartbeatBatcher::~MultiRaftHeartbeatBatcher() {
       << "Not empty batch in ~MultiRaftHeartbeatBatcher";
 }
 
-void MultiRaftHeartbeatBatcher::AddRequestToBatch(ConsensusRequestPB* request,
-                                                  ConsensusResponsePB* response,
+void MultiRaftHeartbeatBatcher::AddRequestToBatch(LWConsensusRequestPB* request,
                                                   HeartbeatResponseCallback callback) {
+  DoAddRequestToBatch(request, std::move(callback), /* has_data= */ false);
+}
+
+void MultiRaftHeartbeatBatcher::AddDataRequestToBatch(LWConsensusRequestPB* request,
+                                                      HeartbeatResponseCallback callback) {
+  DoAddRequestToBatch(request, std::move(callback), /* has_data= */ true);
+}
+
+void MultiRaftHeartbeatBatcher::DoAddRequestToBatch(LWConsensusRequestPB* request,
+                                                    HeartbeatResponseCallback callback,
+                                                    bool has_data) {
   std::shared_ptr<MultiRaftConsensusData> data = nullptr;
+  bool schedule_flush = false;
   {
     std::lock_guard<std::mutex> lock(mutex_);
     current_batch_->response_callback_data.push_back({
-      .resp = response,
       .callback = std::move(callback)
     });
-    // Add a ConsensusRequestPB to the batch
-    current_batch_->batch_req.add_consensus_request()->Swap(request);
+    // Add a ConsensusRequestPB to the batch, it is serialized directly from the peer's request.
+    current_batch_->batch_req.mutable_consensus_request()->push_back_ref(request);
     if (FLAGS_multi_raft_batch_size > 0
         && current_batch_->response_callback_data.size() >= FLAGS_multi_raft_batch_size) {
       data = PrepareNextBatchRequest();
+    } else if (has_data && !data_flush_scheduled_) {
+      data_flush_scheduled_ = true;
+      schedule_flush = true;
     }
   }
+  if (schedule_flush) {
+    ScheduleDataBatchFlush();
+  }
   SendBatchRequest(data);
 }
 
+void MultiRaftHeartbeatBatcher::ScheduleDataBatchFlush() {
+  std::weak_ptr<MultiRaftHeartbeatBatcher> weak_self = shared_from_this();
+  messenger_->scheduler().Schedule(
+      [weak_self](const Status& status) {
+        // On failure the batch is still sent by the periodic timer or by shutdown.
+        if (!status.ok()) {
+          return;
+        }
+        if (auto self = weak_self.lock()) {
+          self->PrepareAndSendBatchRequest();
+        }
+      },
+      std::chrono::microseconds(FLAGS_multi_raft_data_batch_delay_us));
+}
+
 void MultiRaftHeartbeatBatcher::PrepareAndSendBatchRequest() {
   std::shared_ptr<MultiRaftConsensusData> data;
   {
@@ -121,7 +171,8 @@ void MultiRaftHeartbeatBatcher::PrepareAndSendBatchRequest() {
 
 std::shared_ptr<MultiRaftHeartbeatBatcher::MultiRaftConsensusData>
     MultiRaftHeartbeatBatcher::PrepareNextBatchRequest() {
-  if (!current_batch_ || current_batch_->batch_req.consensus_request_size() == 0) {
+  data_flush_scheduled_ = false;
+  if (!current_batch_ || current_batch_->batch_req.consensus_request().empty()) {
     return nullptr;
   }
   batch_sender_->Snooze();
@@ -139,16 +190,24 @@ void MultiRaftHeartbeatBatcher::SendBatchRequest(std::shared_ptr<MultiRaftConsen
 
   data->controller.Reset();
   data->controller.set_timeout(MonoDelta::FromMilliseconds(
-      FLAGS_consensus_rpc_timeout_ms * data->batch_req.consensus_request_size()));
+      FLAGS_consensus_rpc_timeout_ms * data->response_callback_data.size()));
   auto callback = [data, running_calls = running_calls_]() {
     --*running_calls;
     auto status = data->controller.status();
-    for (int i = 0; i < data->batch_req.consensus_request_size(); i++) {
-      auto callback_data = data->response_callback_data[i];
+    if (status.ok() &&
+        data->batch_res.consensus_response().size() != data->response_callback_data.size()) {
+      status = STATUS_FORMAT(
+          Corruption, "Wrong number of responses in batch: $0, expected: $1",
+          data->batch_res.consensus_response().size(), data->response_callback_data.size());
+    }
+    auto response_it = data->batch_res.mutable_consensus_response()->begin();
+    for (const auto& callback_data : data->response_callback_data) {
       if (status.ok()) {
-        callback_data.resp->Swap(data->batch_res.mutable_consensus_response(i));
+        callback_data.callback(status, &*response_it);
+        ++response_it;
+      } else {
+        callback_data.callback(status, nullptr);
       }
-      callback_data.callback(status);
     }
   };
   consensus_proxy_->MultiRaftUpdateConsensusAsync(
@@ -164,7 +223,7 @@ void MultiRaftHeartbeatBatcher::Shutdown() {
   }
   static const Status status = STATUS(Aborted, "MultiRaft shutdown");
   for (const auto& callback : batch->response_callback_data) {
-    callback.callback(status);
+    callback.callback(status, nullptr);
   }
 }
 
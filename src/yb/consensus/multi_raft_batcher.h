@@ -31,7 +31,9 @@ class PeriodicTimer;
 
 namespace consensus {
 
-using HeartbeatResponseCallback = std::function<void(const Status&)>;
+// Response is null when the batch failed, otherwise it points to the response of the request in
+// the batch, that is valid only during the callback.
+using HeartbeatResponseCallback = std::function<void(const Status&, LWConsensusResponsePB*)>;
 
 // - MultiRaftHeartbeatBatcher is responsible for the batching of heartbeats
 //   among peers that are communicating with remote peers at the same tserver
@@ -42,6 +44,9 @@ using HeartbeatResponseCallback = std::function<void(const Status&)>;
 //   FLAGS_multi_raft_batch_size
 // - To improve efficency multiple batches may be processed concurrently
 //   but only a single batch is being built at any given time
+// - Requests carrying operations could also be added with AddDataRequestToBatch, in this case
+//   the batch is sent after at most FLAGS_multi_raft_data_batch_delay_us, so update requests
+//   of different tablets replicating to the same tserver share a single RPC
 class MultiRaftHeartbeatBatcher : public std::enable_shared_from_this<MultiRaftHeartbeatBatcher> {
  public:
   MultiRaftHeartbeatBatcher(const HostPort& hostport,
@@ -54,14 +59,18 @@ class MultiRaftHeartbeatBatcher : public std::enable_shared_from_this<MultiRaftH
   // Required to start a periodic timer to send out batches.
   void Start();
 
-  // When called adds the request to a batch (request data will be swapped).
-  // If the batch executes sucessfully then the response is populated and the callback is executed.
-  // If the batch rpc call fails the response will NOT be populated and the callback will be
-  // executed with an error status.
-  void AddRequestToBatch(ConsensusRequestPB* request,
-                         ConsensusResponsePB* response,
+  // When called adds the request to a batch (request is referenced by the batch, so it should be
+  // kept alive until the callback is executed).
+  // If the batch executes sucessfully then the callback is executed with the response.
+  // If the batch rpc call fails the callback will be executed with an error status.
+  void AddRequestToBatch(LWConsensusRequestPB* request,
                          HeartbeatResponseCallback callback);
 
+  // Same as AddRequestToBatch, but for requests carrying operations. Batch containing such
+  // request is sent after short delay, instead of waiting for the heartbeat interval.
+  void AddDataRequestToBatch(LWConsensusRequestPB* request,
+                             HeartbeatResponseCallback callback);
+
   void Shutdown();
 
  private:
@@ -69,6 +78,12 @@ class MultiRaftHeartbeatBatcher : public std::enable_shared_from_this<MultiRaftH
   // ResponseCallbackData registered by each local peer with this batch in AddRequestToBatch().
   struct MultiRaftConsensusData;
 
+  void DoAddRequestToBatch(LWConsensusRequestPB* request,
+                           HeartbeatResponseCallback callback,
+                           bool has_data);
+
+  void ScheduleDataBatchFlush();
+
   void PrepareAndSendBatchRequest();
 
   // This method will return a nullptr if the current batch is empty.
@@ -89,6 +104,9 @@ class MultiRaftHeartbeatBatcher : public std::enable_shared_from_this<MultiRaftH
 
   std::shared_ptr<MultiRaftConsensusData> current_batch_ GUARDED_BY(mutex_);
 
+  // Whether sending of current batch was scheduled, because it contains request with operations.
+  bool data_flush_scheduled_ GUARDED_BY(mutex_) = false;
+
   std::atomic<int>* running_calls_;
 };
 
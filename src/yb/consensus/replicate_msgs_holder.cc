@@ -13,6 +13,8 @@
 
 #include "yb/consensus/replicate_msgs_holder.h"
 
+#include <utility>
+
 namespace yb {
 namespace consensus {
 
@@ -51,25 +53,29 @@ void ReplicateMsgsHolder::Reset() {
 }
 
 LWReplicateMsgsHolder::LWReplicateMsgsHolder(
-    ReplicateMsgs messages, ScopedTrackedConsumption consumption)
+    ReplicateMsgs messages, ScopedTrackedConsumption consumption, size_t messages_size)
     : messages_(std::move(messages)),
-      consumption_(std::move(consumption)) {
+      consumption_(std::move(consumption)),
+      messages_size_(messages_size) {
 }
 
 LWReplicateMsgsHolder::LWReplicateMsgsHolder(LWReplicateMsgsHolder&& rhs)
     : messages_(std::move(rhs.messages_)),
-      consumption_(std::move(rhs.consumption_)) {
+      consumption_(std::move(rhs.consumption_)),
+      messages_size_(std::exchange(rhs.messages_size_, 0)) {
 }
 
 void LWReplicateMsgsHolder::operator=(LWReplicateMsgsHolder&& rhs) {
   Reset();
   messages_ = std::move(rhs.messages_);
   consumption_ = std::move(rhs.consumption_);
+  messages_size_ = std::exchange(rhs.messages_size_, 0);
 }
 
 void LWReplicateMsgsHolder::Reset() {
   messages_.clear();
   consumption_ = ScopedTrackedConsumption();
+  messages_size_ = 0;
 }
 
 }  // namespace consensus
@@ -62,15 +62,24 @@ class LWReplicateMsgsHolder {
  public:
   LWReplicateMsgsHolder() = default;
 
-  explicit LWReplicateMsgsHolder(ReplicateMsgs messages, ScopedTrackedConsumption consumption);
+  explicit LWReplicateMsgsHolder(
+      ReplicateMsgs messages, ScopedTrackedConsumption consumption, size_t messages_size = 0);
   LWReplicateMsgsHolder(LWReplicateMsgsHolder&& rhs);
   void operator=(LWReplicateMsgsHolder&& rhs);
 
   void Reset();
+
+  // Number of bytes held messages occupy inside a ConsensusRequestPB.
+  size_t messages_size() const {
+    return messages_size_;
+  }
+
  private:
   ReplicateMsgs messages_;
 
   ScopedTrackedConsumption consumption_;
+
+  size_t messages_size_ = 0;
 };
 
 }  // namespace consensus
@@ -0,0 +1,419 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include <algorithm>
+#include <map>
+#include <optional>
+
+#include "yb/bfpg/tserver_opcodes.h"
+
+#include "yb/common/pgsql_protocol.pb.h"
+#include "yb/common/ql_value.h"
+#include "yb/common/schema.h"
+
+#include "yb/docdb/doc_read_context.h"
+#include "yb/docdb/docdb_test_base.h"
+#include "yb/docdb/pgsql_operation.h"
+#include "yb/docdb/ql_rocksdb_storage.h"
+
+#include "yb/util/size_literals.h"
+#include "yb/util/test_macros.h"
+
+#include "yb/yql/pggate/util/pg_doc_data.h"
+
+DECLARE_uint64(ysql_aggregate_group_table_limit_bytes);
+DECLARE_uint64(ysql_top_n_limit_bytes);
+
+namespace yb {
+namespace docdb {
+
+namespace {
+
+constexpr int kKeyColumn = 0;
+constexpr int kGroupColumn = 1;
+constexpr int kValueColumn = 2;
+constexpr int kTextColumn = 3;
+
+const HybridTime kWriteTime = HybridTime::FromMicros(1000);
+const HybridTime kReadTime = HybridTime::FromMicros(2000);
+
+struct ReadResult {
+  std::vector<std::vector<QLValuePB>> rows;
+  PgsqlResponsePB response;
+};
+
+void AddColumnRef(int column_id, PgsqlReadRequestPB* request) {
+  request->add_col_refs()->set_column_id(column_id);
+}
+
+void AddAggregate(bfpg::TSOpcode opcode, int column_id, PgsqlReadRequestPB* request) {
+  auto* tscall = request->add_targets()->mutable_tscall();
+  tscall->set_opcode(static_cast<int32_t>(opcode));
+  tscall->add_operands()->set_column_id(column_id);
+}
+
+// SELECT COUNT(k), <opcode>(column_id), g FROM t GROUP BY g.
+PgsqlReadRequestPB GroupByRequest(bfpg::TSOpcode opcode, int column_id) {
+  PgsqlReadRequestPB request;
+  AddColumnRef(kKeyColumn, &request);
+  AddColumnRef(kGroupColumn, &request);
+  AddColumnRef(column_id, &request);
+  AddAggregate(bfpg::TSOpcode::kCount, kKeyColumn, &request);
+  AddAggregate(opcode, column_id, &request);
+  request.add_group_by_exprs()->set_column_id(kGroupColumn);
+  request.set_is_aggregate(true);
+  return request;
+}
+
+struct OrderBy {
+  int column_id;
+  bool is_descending = false;
+  bool nulls_first = false;
+};
+
+// SELECT k, v FROM t ORDER BY <order_by> LIMIT limit.
+PgsqlReadRequestPB TopNRequest(const std::vector<OrderBy>& order_by, uint64_t limit) {
+  PgsqlReadRequestPB request;
+  AddColumnRef(kKeyColumn, &request);
+  AddColumnRef(kValueColumn, &request);
+  request.add_targets()->set_column_id(kKeyColumn);
+  request.add_targets()->set_column_id(kValueColumn);
+  for (const auto& entry : order_by) {
+    auto* order_by_pb = request.add_order_by();
+    order_by_pb->mutable_expr()->set_column_id(entry.column_id);
+    order_by_pb->set_is_descending(entry.is_descending);
+    order_by_pb->set_nulls_first(entry.nulls_first);
+  }
+  request.set_order_by_limit(limit);
+  return request;
+}
+
+// Converts rows of (k, v) to string, NULL v is shown as "-".
+std::string TopNRowsToString(const std::vector<std::vector<QLValuePB>>& rows) {
+  std::string result;
+  for (const auto& row : rows) {
+    if (!result.empty()) {
+      result += ", ";
+    }
+    result += Format(
+        "($0, $1)", row[0].int32_value(),
+        IsNull(row[1]) ? "-" : std::to_string(row[1].int32_value()));
+  }
+  return result;
+}
+
+} // namespace
+
+class PgsqlOperationTest : public DocDBTestBase {
+ protected:
+  void SetUp() override {
+    DocDBTestBase::SetUp();
+    doc_read_context_ = std::make_shared<DocReadContext>(
+        DocReadContext::TEST_Create(CreateSchema()));
+  }
+
+  // CREATE TABLE t (k INT PRIMARY KEY ASC, g INT, v INT, s TEXT).
+  static Schema CreateSchema() {
+    std::vector<ColumnSchema> columns = {
+      ColumnSchema("k", INT32, false, false),
+      ColumnSchema("g", INT32, true, false),
+      ColumnSchema("v", INT32, true, false),
+      ColumnSchema("s", STRING, true, false),
+    };
+    std::vector<ColumnId> ids;
+    for (size_t i = 0; i != columns.size(); ++i) {
+      ids.emplace_back(i);
+    }
+    return Schema(columns, ids, 1);
+  }
+
+  void WriteRow(int32_t k, int32_t g, std::optional<int32_t> v, const std::string& s) {
+    PgsqlWriteRequestPB request;
+    request.set_stmt_type(PgsqlWriteRequestPB::PGSQL_UPSERT);
+    // Schema version used by DocReadContext::TEST_Create.
+    request.set_schema_version(1);
+    request.add_range_column_values()->mutable_value()->set_int32_value(k);
+    auto add_column = [&request](int column_id) {
+      auto* column = request.add_column_values();
+      column->set_column_id(column_id);
+      return column->mutable_expr()->mutable_value();
+    };
+    add_column(kGroupColumn)->set_int32_value(g);
+    if (v) {
+      add_column(kValueColumn)->set_int32_value(*v);
+    }
+    add_column(kTextColumn)->set_string_value(s);
+
+    PgsqlWriteOperation write_op(
+        request, doc_read_context_, kNonTransactionalOperationContext, nullptr /* sidecars */);
+    PgsqlResponsePB response;
+    ASSERT_OK(write_op.Init(&response));
+    auto doc_write_batch = MakeDocWriteBatch();
+    HybridTime restart_read_ht;
+    ASSERT_OK(write_op.Apply(
+        {&doc_write_batch, CoarseTimePoint::max() /* deadline */, ReadHybridTime(),
+         &restart_read_ht}));
+    ASSERT_OK(WriteToRocksDB(doc_write_batch, kWriteTime));
+  }
+
+  // Executes the request and decodes returned rows, column types are specified by types.
+  Result<ReadResult> Read(const PgsqlReadRequestPB& request, const std::vector<DataType>& types) {
+    PgsqlReadOperation read_op(request, kNonTransactionalOperationContext);
+    QLRocksDBStorage ql_storage(doc_db());
+    WriteBuffer result_buffer(1_KB);
+    HybridTime restart_read_ht;
+    auto fetched_rows = VERIFY_RESULT(read_op.Execute(
+        ql_storage, CoarseTimePoint::max() /* deadline */, ReadHybridTime::SingleTime(kReadTime),
+        false /* is_explicit_request_read_time */, *doc_read_context_,
+        nullptr /* index_doc_read_context */, &result_buffer, &restart_read_ht));
+
+    ReadResult result;
+    result.response = read_op.response();
+    auto data = result_buffer.ToBuffer();
+    Slice cursor;
+    int64_t row_count;
+    pggate::PgDocData::LoadCache(data, &row_count, &cursor);
+    SCHECK_EQ(row_count, fetched_rows, IllegalState, "Wrong number of rows");
+    for (int64_t i = 0; i != row_count; ++i) {
+      auto& row = result.rows.emplace_back();
+      for (auto type : types) {
+        auto& value = row.emplace_back();
+        if (pggate::PgDocData::ReadDataHeader(&cursor).is_null()) {
+          continue;
+        }
+        switch (type) {
+          case INT32: {
+            int32_t number;
+            cursor.remove_prefix(pggate::PgWire::ReadNumber(&cursor, &number));
+            value.set_int32_value(number);
+            break;
+          }
+          case INT64: {
+            int64_t number;
+            cursor.remove_prefix(pggate::PgWire::ReadNumber(&cursor, &number));
+            value.set_int64_value(number);
+            break;
+          }
+          case STRING: {
+            int64_t length;
+            cursor.remove_prefix(pggate::PgWire::ReadNumber(&cursor, &length));
+            // Text is sent with the trailing zero.
+            value.set_string_value(cursor.cdata(), length - 1);
+            cursor.remove_prefix(length);
+            break;
+          }
+          default:
+            return STATUS_FORMAT(NotSupported, "Unexpected type: $0", type);
+        }
+      }
+    }
+    SCHECK(cursor.empty(), IllegalState, "Extra data after rows");
+    return result;
+  }
+
+  // Reads all pages of the request, returns rows of all pages and the number of pages.
+  Result<std::pair<std::vector<std::vector<QLValuePB>>, size_t>> ReadAllPages(
+      PgsqlReadRequestPB request, const std::vector<DataType>& types) {
+    request.set_return_paging_state(true);
+    std::vector<std::vector<QLValuePB>> rows;
+    size_t num_pages = 0;
+    for (;;) {
+      auto page = VERIFY_RESULT(Read(request, types));
+      ++num_pages;
+      for (auto& row : page.rows) {
+        rows.push_back(std::move(row));
+      }
+      if (!page.response.has_paging_state()) {
+        break;
+      }
+      *request.mutable_paging_state() = page.response.paging_state();
+    }
+    return std::make_pair(std::move(rows), num_pages);
+  }
+
+  // Rows k in [1, 20] with v = k % 7, and NULL instead of 6.
+  void WriteTopNRows() {
+    for (int k = 1; k <= 20; ++k) {
+      WriteRow(k, 0, k % 7 == 6 ? std::nullopt : std::optional<int32_t>(k % 7), "text");
+    }
+  }
+
+  std::shared_ptr<DocReadContext> doc_read_context_;
+};
+
+// Group table that exceeds the limit is returned before the end of the scan, and the scan is
+// resumed from the paging state. Partial aggregates of the same group from different pages are
+// combined by the client.
+TEST_F(PgsqlOperationTest, GroupTableLimitPaging) {
+  constexpr int kNumRows = 30;
+  constexpr int kNumGroups = 3;
+  for (int k = 0; k != kNumRows; ++k) {
+    WriteRow(k, k % kNumGroups, k, "text");
+  }
+
+  auto request = GroupByRequest(bfpg::TSOpcode::kSumInt32, kValueColumn);
+  const std::vector<DataType> types = {INT64, INT64, INT32};
+
+  // All groups fit into the default limit, so they are returned in a single page.
+  auto [rows, num_pages] = ASSERT_RESULT(ReadAllPages(request, types));
+  ASSERT_EQ(num_pages, 1);
+  ASSERT_EQ(rows.size(), kNumGroups);
+
+  // Group table is full after the first row.
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_ysql_aggregate_group_table_limit_bytes) = 1;
+  std::tie(rows, num_pages) = ASSERT_RESULT(ReadAllPages(request, types));
+  ASSERT_EQ(num_pages, kNumRows);
+
+  std::map<int32_t, std::pair<int64_t, int64_t>> groups;
+  for (const auto& row : rows) {
+    auto& group = groups[row[2].int32_value()];
+    group.first += row[0].int64_value();
+    group.second += row[1].int64_value();
+  }
+  ASSERT_EQ(groups.size(), kNumGroups);
+  for (const auto& [g, group] : groups) {
+    int64_t expected_sum = 0;
+    for (int k = g; k < kNumRows; k += kNumGroups) {
+      expected_sum += k;
+    }
+    ASSERT_EQ(group.first, kNumRows / kNumGroups) << "Group: " << g;
+    ASSERT_EQ(group.second, expected_sum) << "Group: " << g;
+  }
+}
+
+// Groups could not be returned before the end of the scan, when the request does not allow paging.
+TEST_F(PgsqlOperationTest, GroupTableLimitWithoutPaging) {
+  for (int k = 0; k != 10; ++k) {
+    WriteRow(k, k, k, "text");
+  }
+
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_ysql_aggregate_group_table_limit_bytes) = 1;
+  auto result = Read(GroupByRequest(bfpg::TSOpcode::kSumInt32, kValueColumn), {});
+  ASSERT_NOK(result);
+  ASSERT_TRUE(result.status().IsIllegalState()) << result.status();
+}
+
+// Growth of MAX state over text values is accounted, even though the number of groups does not
+// change.
+TEST_F(PgsqlOperationTest, GroupTableLimitStateGrowth) {
+  constexpr int kNumRows = 10;
+  constexpr size_t kTextStep = 1_KB;
+  for (int k = 0; k != kNumRows; ++k) {
+    WriteRow(k, 0, k, std::string((k + 1) * kTextStep, 'a' + k));
+  }
+
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_ysql_aggregate_group_table_limit_bytes) = 2 * kTextStep;
+  auto request = GroupByRequest(bfpg::TSOpcode::kMax, kTextColumn);
+  request.set_return_paging_state(true);
+  const std::vector<DataType> types = {INT64, STRING, INT32};
+
+  // The first row fits into the limit, the second row grows MAX state over the limit.
+  auto page = ASSERT_RESULT(Read(request, types));
+  ASSERT_TRUE(page.response.has_paging_state());
+  ASSERT_EQ(page.rows.size(), 1);
+  ASSERT_EQ(page.rows[0][0].int64_value(), 2);
+  ASSERT_EQ(page.rows[0][1].string_value(), std::string(2 * kTextStep, 'b'));
+
+  auto [rows, num_pages] = ASSERT_RESULT(ReadAllPages(request, types));
+  ASSERT_GT(num_pages, 1);
+  int64_t count = 0;
+  std::string max;
+  for (const auto& row : rows) {
+    count += row[0].int64_value();
+    max = std::max(max, row[1].string_value());
+  }
+  ASSERT_EQ(count, kNumRows);
+  ASSERT_EQ(max, std::string(kNumRows * kTextStep, 'a' + kNumRows - 1));
+}
+
+TEST_F(PgsqlOperationTest, TopN) {
+  WriteTopNRows();
+  const std::vector<DataType> types = {INT32, INT32};
+
+  auto page = ASSERT_RESULT(Read(
+      TopNRequest({{kValueColumn}, {kKeyColumn}}, 5), types));
+  ASSERT_EQ(TopNRowsToString(page.rows), "(7, 0), (14, 0), (1, 1), (8, 1), (15, 1)");
+
+  page = ASSERT_RESULT(Read(
+      TopNRequest({{kValueColumn, true /* is_descending */, true /* nulls_first */},
+                   {kKeyColumn}}, 5),
+      types));
+  ASSERT_EQ(TopNRowsToString(page.rows), "(6, -), (13, -), (20, -), (5, 5), (12, 5)");
+
+  page = ASSERT_RESULT(Read(
+      TopNRequest({{kValueColumn, true /* is_descending */}, {kKeyColumn}}, 4), types));
+  ASSERT_EQ(TopNRowsToString(page.rows), "(5, 5), (12, 5), (19, 5), (4, 4)");
+
+  // Limit above the number of rows.
+  page = ASSERT_RESULT(Read(TopNRequest({{kKeyColumn, true /* is_descending */}}, 100), types));
+  ASSERT_EQ(page.rows.size(), 20);
+  ASSERT_EQ(page.rows.front()[0].int32_value(), 20);
+  ASSERT_EQ(page.rows.back()[0].int32_value(), 1);
+}
+
+// Rows tied with the last kept row are not kept, any of them is a correct result.
+TEST_F(PgsqlOperationTest, TopNTies) {
+  WriteTopNRows();
+
+  auto page = ASSERT_RESULT(Read(TopNRequest({{kValueColumn}}, 4), {INT32, INT32}));
+  ASSERT_EQ(page.rows.size(), 4);
+  std::vector<int32_t> values;
+  for (const auto& row : page.rows) {
+    values.push_back(row[1].int32_value());
+    if (values.back() == 1) {
+      ASSERT_EQ(row[0].int32_value() % 7, 1) << TopNRowsToString(page.rows);
+    }
+  }
+  ASSERT_EQ(values, std::vector<int32_t>({0, 0, 1, 1}));
+}
+
+TEST_F(PgsqlOperationTest, TopNZeroLimit) {
+  WriteTopNRows();
+
+  auto result = Read(TopNRequest({{kValueColumn}}, 0), {INT32, INT32});
+  ASSERT_NOK(result);
+  ASSERT_TRUE(result.status().IsInvalidArgument()) << result.status();
+}
+
+// Rows kept over the memory limit are returned before the end of the scan, and the scan is resumed
+// from the paging state. The client sorts rows of all pages.
+TEST_F(PgsqlOperationTest, TopNLimitPaging) {
+  WriteTopNRows();
+  const std::vector<DataType> types = {INT32, INT32};
+  auto request = TopNRequest({{kValueColumn}, {kKeyColumn}}, 5);
+
+  auto [rows, num_pages] = ASSERT_RESULT(ReadAllPages(request, types));
+  ASSERT_EQ(num_pages, 1);
+  ASSERT_EQ(TopNRowsToString(rows), "(7, 0), (14, 0), (1, 1), (8, 1), (15, 1)");
+
+  // Kept rows exceed the limit after the first row of each page.
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_ysql_top_n_limit_bytes) = 1;
+  std::tie(rows, num_pages) = ASSERT_RESULT(ReadAllPages(request, types));
+  ASSERT_EQ(num_pages, 20);
+  ASSERT_EQ(rows.size(), 20);
+  std::sort(rows.begin(), rows.end(), [](const auto& lhs, const auto& rhs) {
+    auto lhs_key = std::make_pair(IsNull(lhs[1]), lhs[1].int32_value());
+    auto rhs_key = std::make_pair(IsNull(rhs[1]), rhs[1].int32_value());
+    return lhs_key != rhs_key ? lhs_key < rhs_key : lhs[0].int32_value() < rhs[0].int32_value();
+  });
+  rows.resize(5);
+  ASSERT_EQ(TopNRowsToString(rows), "(7, 0), (14, 0), (1, 1), (8, 1), (15, 1)");
+
+  // Kept rows could not be returned before the end of the scan without paging.
+  auto result = Read(request, types);
+  ASSERT_NOK(result);
+  ASSERT_TRUE(result.status().IsIllegalState()) << result.status();
+}
+
+}  // namespace docdb
+}  // namespace yb
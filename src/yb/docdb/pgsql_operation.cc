@@ -13,6 +13,7 @@
 
 #include "yb/docdb/pgsql_operation.h"
 
+#include <algorithm>
 #include <limits>
 #include <string>
 #include <unordered_set>
@@ -45,6 +46,7 @@
 #include "yb/util/flags.h"
 #include "yb/util/result.h"
 #include "yb/util/scope_exit.h"
+#include "yb/util/size_literals.h"
 #include "yb/util/status_format.h"
 #include "yb/util/trace.h"
 
@@ -87,6 +89,16 @@ DEFINE_UNKNOWN_uint64(
     ysql_packed_row_size_limit, 0,
     "Packed row size limit for YSQL in bytes. 0 to make this equal to SSTable block size.");
 
+DEFINE_RUNTIME_uint64(ysql_aggregate_group_table_limit_bytes, 16_MB,
+    "Approximate memory limit for the table of groups used by GROUP BY aggregate pushdown. When "
+    "the limit is reached, the scan is stopped and partial aggregates of the collected groups "
+    "are returned, along with the paging state to resume the scan.");
+
+DEFINE_RUNTIME_uint64(ysql_top_n_limit_bytes, 16_MB,
+    "Approximate memory limit for the rows kept by ORDER BY ... LIMIT pushdown. When the limit is "
+    "reached, the scan is stopped and the kept rows are returned, along with the paging state to "
+    "resume the scan.");
+
 DEFINE_test_flag(bool, ysql_suppress_ybctid_corruption_details, false,
                  "Whether to show less details on ybctid corruption error status message.  Useful "
                  "during tests that require consistent output.");
@@ -1148,6 +1160,9 @@ Result<size_t> PgsqlReadOperation::ExecuteScalar(const YQLStorageIf& ql_storage,
     }
     row_count_limit = request_.limit();
   }
+  // Without rows to keep, top-N would silently return nothing.
+  SCHECK(request_.order_by().empty() || request_.order_by_limit() > 0, InvalidArgument,
+         "ORDER BY pushdown requires positive limit");
 
   // Create the projection of regular columns selected by the row block plus any referenced in
   // the WHERE condition. When DocRowwiseIterator::NextRow() populates the value map, it uses this
@@ -1234,6 +1249,10 @@ Result<size_t> PgsqlReadOperation::ExecuteScalar(const YQLStorageIf& ql_storage,
   // Fetching data.
   int match_count = 0;
   QLTableRow table_row;
+  // Groups or top-N rows could be returned before the end of the scan, only if the scan could be
+  // resumed.
+  bool buffer_full = false;
+  WriteBuffer group_key_buffer(1_KB);
   YQLScanCallback callback = [&](const QLTableRow& row) -> Result<ContinueScan> {
     bool is_match = true;
 
@@ -1284,7 +1303,27 @@ Result<size_t> PgsqlReadOperation::ExecuteScalar(const YQLStorageIf& ql_storage,
 
     match_count++;
     if (request_.is_aggregate()) {
-      RETURN_NOT_OK(EvalAggregate(*row_ptr));
+      if (request_.group_by_exprs().empty()) {
+        RETURN_NOT_OK(EvalAggregate(*row_ptr));
+      } else if (!VERIFY_RESULT(EvalGroupedAggregate(*row_ptr, &group_key_buffer))) {
+        // Returning collected groups before the end of the scan is correct only when the client
+        // resumes the scan with the paging state.
+        SCHECK(request_.return_paging_state(), IllegalState,
+               Format("Group table exceeds ysql_aggregate_group_table_limit_bytes ($0), but "
+                      "the request does not allow paging",
+                      FLAGS_ysql_aggregate_group_table_limit_bytes));
+        buffer_full = true;
+      }
+    } else if (!request_.order_by().empty()) {
+      if (!VERIFY_RESULT(EvalTopN(*row_ptr))) {
+        // The client sorts rows of all pages, so kept rows could be returned before the end of
+        // the scan when it is resumed with the paging state.
+        SCHECK(request_.return_paging_state(), IllegalState,
+               Format("Top-N rows exceed ysql_top_n_limit_bytes ($0), but the request does not "
+                      "allow paging",
+                      FLAGS_ysql_top_n_limit_bytes));
+        buffer_full = true;
+      }
     } else {
       RETURN_NOT_OK(PopulateResultSet(*row_ptr, result_buffer));
       ++fetched_rows;
@@ -1293,8 +1332,8 @@ Result<size_t> PgsqlReadOperation::ExecuteScalar(const YQLStorageIf& ql_storage,
     // Check if we are running out of time
     scan_time_exceeded = CoarseMonoClock::now() >= stop_scan;
 
-    return (fetched_rows < row_count_limit && !scan_time_exceeded) ? ContinueScan::kTrue
-                                                                   : ContinueScan::kFalse;
+    return (fetched_rows < row_count_limit && !scan_time_exceeded && !buffer_full)
+        ? ContinueScan::kTrue : ContinueScan::kFalse;
   };
 
   RETURN_NOT_OK(iter->Iterate(std::move(callback)));
@@ -1305,8 +1344,17 @@ Result<size_t> PgsqlReadOperation::ExecuteScalar(const YQLStorageIf& ql_storage,
 
   // Output aggregate values accumulated while looping over rows
   if (request_.is_aggregate() && match_count > 0) {
-    RETURN_NOT_OK(PopulateAggregate(result_buffer));
-    ++fetched_rows;
+    if (request_.group_by_exprs().empty()) {
+      RETURN_NOT_OK(PopulateAggregate(result_buffer));
+      ++fetched_rows;
+    } else {
+      fetched_rows += VERIFY_RESULT(PopulateGroupedAggregates(result_buffer));
+    }
+  }
+
+  // Output rows kept by top-N
+  if (!request_.order_by().empty()) {
+    fetched_rows += VERIFY_RESULT(PopulateTopN(result_buffer));
   }
 
   if (PREDICT_FALSE(FLAGS_TEST_slowdown_pgsql_aggregate_read_ms > 0) && request_.is_aggregate()) {
@@ -1316,7 +1364,8 @@ Result<size_t> PgsqlReadOperation::ExecuteScalar(const YQLStorageIf& ql_storage,
 
   // Unless iterated to the end, pack current iterator position into response, so follow up request
   // can seek to correct position and continue
-  if (request_.return_paging_state() && (fetched_rows >= row_count_limit || scan_time_exceeded)) {
+  if (request_.return_paging_state() &&
+      (fetched_rows >= row_count_limit || scan_time_exceeded || buffer_full)) {
     RETURN_NOT_OK(SetPagingState(
         iter, request_.has_index_request() ? *index_schema : doc_schema, read_time,
         has_paging_state));
@@ -1449,6 +1498,64 @@ Status PgsqlReadOperation::EvalAggregate(const QLTableRow& table_row) {
   return Status::OK();
 }
 
+namespace {
+
+// Approximate memory used by the value. Cheap enough to be evaluated for each row, so growth of
+// variable length aggregate states, e.g. MIN and MAX of strings, could be accounted.
+size_t ValueMemoryUsage(const QLValuePB& value) {
+  switch (value.value_case()) {
+    case QLValuePB::kStringValue:
+      return sizeof(value) + value.string_value().capacity();
+    case QLValuePB::kBinaryValue:
+      return sizeof(value) + value.binary_value().capacity();
+    case QLValuePB::kDecimalValue:
+      return sizeof(value) + value.decimal_value().capacity();
+    default:
+      return sizeof(value);
+  }
+}
+
+} // namespace
+
+Result<bool> PgsqlReadOperation::EvalGroupedAggregate(
+    const QLTableRow& table_row, WriteBuffer* group_key_buffer) {
+  group_key_buffer->Reset();
+  QLExprResult value;
+  for (const PgsqlExpressionPB& expr : request_.group_by_exprs()) {
+    RETURN_NOT_OK(EvalExpr(expr, table_row, value.Writer()));
+    RETURN_NOT_OK(pggate::WriteColumn(value.Value(), group_key_buffer));
+  }
+  group_key_buffer->AssignTo(&group_key_);
+
+  auto [it, inserted] = groups_.try_emplace(group_key_);
+  auto& states = it->second;
+  if (inserted) {
+    states.resize(request_.targets().size() + request_.group_by_exprs().size());
+    groups_memory_usage_ += sizeof(*it) + it->first.capacity();
+  }
+  size_t state_index = 0;
+  for (const PgsqlExpressionPB& expr : request_.targets()) {
+    auto& state = states[state_index++];
+    // State could shrink, but the total usage stays non negative, so unsigned wrap around is fine.
+    groups_memory_usage_ -= inserted ? 0 : ValueMemoryUsage(state.Value());
+    RETURN_NOT_OK(EvalExpr(expr, table_row, state.Writer()));
+    groups_memory_usage_ += ValueMemoryUsage(state.Value());
+  }
+
+  if (inserted) {
+    // Values of grouping expressions are returned after aggregates. Existing values refer to the
+    // current row, so they are copied.
+    for (const PgsqlExpressionPB& expr : request_.group_by_exprs()) {
+      auto& group_value = states[state_index++];
+      RETURN_NOT_OK(EvalExpr(expr, table_row, group_value.Writer()));
+      group_value.ForceNewValue();
+      groups_memory_usage_ += ValueMemoryUsage(group_value.Value());
+    }
+  }
+
+  return groups_memory_usage_ < FLAGS_ysql_aggregate_group_table_limit_bytes;
+}
+
 Status PgsqlReadOperation::PopulateAggregate(WriteBuffer *result_buffer) {
   int column_count = request_.targets().size();
   for (int rscol_index = 0; rscol_index < column_count; rscol_index++) {
@@ -1457,6 +1564,104 @@ Status PgsqlReadOperation::PopulateAggregate(WriteBuffer *result_buffer) {
   return Status::OK();
 }
 
+Result<size_t> PgsqlReadOperation::PopulateGroupedAggregates(WriteBuffer *result_buffer) {
+  for (auto& [group_key, states] : groups_) {
+    for (auto& state : states) {
+      RETURN_NOT_OK(pggate::WriteColumn(state.Value(), result_buffer));
+    }
+  }
+  auto result = groups_.size();
+  groups_.clear();
+  groups_memory_usage_ = 0;
+  return result;
+}
+
+Result<bool> PgsqlReadOperation::EvalTopN(const QLTableRow& table_row) {
+  const auto limit = request_.order_by_limit();
+  top_n_keys_.resize(request_.order_by_size());
+  QLExprResult value;
+  size_t key_index = 0;
+  for (const PgsqlOrderByPB& order_by : request_.order_by()) {
+    RETURN_NOT_OK(EvalExpr(order_by.expr(), table_row, value.Writer()));
+    value.MoveTo(&top_n_keys_[key_index++]);
+  }
+
+  auto less = [this](const TopNRow& lhs, const TopNRow& rhs) {
+    return TopNKeysLess(lhs.keys, rhs.keys);
+  };
+  if (top_n_rows_.size() < limit) {
+    top_n_rows_.emplace_back();
+  } else {
+    // Replace the last kept row, if the new row comes before it. A row equal to the last kept row
+    // is skipped, any of the tied rows is a correct result.
+    if (!TopNKeysLess(top_n_keys_, top_n_rows_.front().keys)) {
+      return true;
+    }
+    std::pop_heap(top_n_rows_.begin(), top_n_rows_.end(), less);
+    top_n_memory_usage_ -= top_n_rows_.back().memory_usage;
+  }
+
+  auto& row = top_n_rows_.back();
+  row.keys.swap(top_n_keys_);
+  row.values.resize(request_.targets_size());
+  size_t value_index = 0;
+  for (const PgsqlExpressionPB& expr : request_.targets()) {
+    RETURN_NOT_OK(EvalExpr(expr, table_row, value.Writer()));
+    value.MoveTo(&row.values[value_index++]);
+  }
+  row.memory_usage = sizeof(row);
+  for (const auto* values : {&row.keys, &row.values}) {
+    for (const auto& row_value : *values) {
+      row.memory_usage += ValueMemoryUsage(row_value);
+    }
+  }
+  top_n_memory_usage_ += row.memory_usage;
+  std::push_heap(top_n_rows_.begin(), top_n_rows_.end(), less);
+  return top_n_memory_usage_ < FLAGS_ysql_top_n_limit_bytes;
+}
+
+Result<size_t> PgsqlReadOperation::PopulateTopN(WriteBuffer *result_buffer) {
+  std::sort_heap(
+      top_n_rows_.begin(), top_n_rows_.end(), [this](const TopNRow& lhs, const TopNRow& rhs) {
+    return TopNKeysLess(lhs.keys, rhs.keys);
+  });
+  for (const auto& row : top_n_rows_) {
+    for (const auto& value : row.values) {
+      RETURN_NOT_OK(pggate::WriteColumn(value, result_buffer));
+    }
+  }
+  auto result = top_n_rows_.size();
+  top_n_rows_.clear();
+  top_n_memory_usage_ = 0;
+  return result;
+}
+
+bool PgsqlReadOperation::TopNKeysLess(
+    const std::vector<QLValuePB>& lhs, const std::vector<QLValuePB>& rhs) const {
+  for (int i = 0; i != request_.order_by_size(); ++i) {
+    const auto& order_by = request_.order_by(i);
+    const auto lhs_null = IsNull(lhs[i]);
+    const auto rhs_null = IsNull(rhs[i]);
+    int cmp;
+    if (lhs_null || rhs_null) {
+      if (lhs_null == rhs_null) {
+        continue;
+      }
+      cmp = lhs_null == order_by.nulls_first() ? -1 : 1;
+    } else {
+      cmp = Compare(lhs[i], rhs[i]);
+      if (cmp == 0) {
+        continue;
+      }
+      if (order_by.is_descending()) {
+        cmp = -cmp;
+      }
+    }
+    return cmp < 0;
+  }
+  return false;
+}
+
 Status PgsqlReadOperation::GetIntents(const Schema& schema, LWKeyValueWriteBatchPB* out) {
   if (request_.batch_arguments_size() > 0) {
     for (const auto& batch_argument : request_.batch_arguments()) {
@@ -13,6 +13,8 @@
 
 #pragma once
 
+#include <unordered_map>
+
 #include "yb/common/pgsql_protocol.pb.h"
 
 #include "yb/docdb/doc_expr.h"
@@ -203,8 +205,27 @@ class PgsqlReadOperation : public DocExprExecutor {
 
   Status EvalAggregate(const QLTableRow& table_row);
 
+  // Accumulates aggregates of the row into the states of its group, identified by values of
+  // grouping expressions. Returns false when the group table exceeds its memory limit, so groups
+  // should be returned to the client before the scan is resumed.
+  Result<bool> EvalGroupedAggregate(const QLTableRow& table_row, WriteBuffer* group_key_buffer);
+
   Status PopulateAggregate(WriteBuffer *result_buffer);
 
+  // Writes a row for each group and clears the group table. Returns number of written rows.
+  Result<size_t> PopulateGroupedAggregates(WriteBuffer *result_buffer);
+
+  // Evaluates ORDER BY keys of the row, and keeps the row if it is among the first order_by_limit
+  // rows seen so far. Returns false when kept rows exceed their memory limit, so they should be
+  // returned to the client before the scan is resumed.
+  Result<bool> EvalTopN(const QLTableRow& table_row);
+
+  // Writes kept rows in the requested order. Returns number of written rows.
+  Result<size_t> PopulateTopN(WriteBuffer *result_buffer);
+
+  // Whether the row with lhs keys comes before the row with rhs keys in the requested order.
+  bool TopNKeysLess(const std::vector<QLValuePB>& lhs, const std::vector<QLValuePB>& rhs) const;
+
   // Checks whether we have processed enough rows for a page and sets the appropriate paging
   // state in the response object.
   Status SetPagingState(
@@ -219,6 +240,25 @@ class PgsqlReadOperation : public DocExprExecutor {
   PgsqlResponsePB response_;
   YQLRowwiseIteratorIf::UniPtr table_iter_;
   YQLRowwiseIteratorIf::UniPtr index_iter_;
+
+  // Aggregate states of groups, keyed by encoded values of grouping expressions. States are
+  // followed by values of grouping expressions.
+  std::unordered_map<std::string, std::vector<QLExprResult>> groups_;
+  // Approximate memory used by groups_.
+  size_t groups_memory_usage_ = 0;
+  std::string group_key_;
+
+  struct TopNRow {
+    std::vector<QLValuePB> keys;
+    std::vector<QLValuePB> values;
+    size_t memory_usage = 0;
+  };
+
+  // Heap of rows kept by top-N, the last of them in the requested order is at the top.
+  std::vector<TopNRow> top_n_rows_;
+  // Approximate memory used by top_n_rows_.
+  size_t top_n_memory_usage_ = 0;
+  std::vector<QLValuePB> top_n_keys_;
 };
 
 }  // namespace docdb
@@ -129,7 +129,16 @@ void GenerateMethodAssignments(
       printer(
           "    METRIC_$metric_prefix$$metric_name$_$rpc_full_name_plainchars$.Instantiate(entity)");
     }
-    printer((service_side ? ")" : std::string()) + "\n};\n\n");
+    if (service_side) {
+      printer(")");
+      if (IsInlineMethod(method)) {
+        printer(",\n  .inline_execution = true");
+      }
+      if (IsBackgroundMethod(method)) {
+        printer(",\n  .background = true");
+      }
+    }
+    printer("\n};\n\n");
   }
 }
 
@@ -93,6 +93,18 @@ bool IsTrivialMethod(const google::protobuf::MethodDescriptor* method) {
   return method->options().GetExtension(rpc::trivial);
 }
 
+bool IsHeapParamsMethod(const google::protobuf::MethodDescriptor* method) {
+  return method->options().GetExtension(rpc::heap_params);
+}
+
+bool IsInlineMethod(const google::protobuf::MethodDescriptor* method) {
+  return method->options().GetExtension(rpc::inline_execution);
+}
+
+bool IsBackgroundMethod(const google::protobuf::MethodDescriptor* method) {
+  return method->options().GetExtension(rpc::background);
+}
+
 bool HasLightweightMethod(const google::protobuf::ServiceDescriptor* service, rpc::RpcSides side) {
   for (int i = 0; i != service->method_count(); ++i) {
     if (IsLightweightMethod(service->method(i), side)) {
@@ -100,6 +100,8 @@ void ServiceGenerator::Header(YBPrinter printer, const google::protobuf::FileDes
           "const ::yb::rpc::RpcServicePtr& service, ::yb::rpc::RpcEndpointMap* map) override;\n"
       "  std::string service_name() const override;\n"
       "  static std::string static_service_name();\n"
+      "  bool IsInlineMethod(size_t method_index) const override;\n"
+      "  bool IsBackgroundMethod(size_t method_index) const override;\n"
       "\n"
       );
 
@@ -240,6 +242,12 @@ void ServiceGenerator::Source(YBPrinter printer, const google::protobuf::FileDes
         "std::string $service_name$If::static_service_name() {\n"
         "  return \"$full_service_name$\";\n"
         "}\n\n"
+        "bool $service_name$If::IsInlineMethod(size_t method_index) const {\n"
+        "  return methods_[method_index].inline_execution;\n"
+        "}\n\n"
+        "bool $service_name$If::IsBackgroundMethod(size_t method_index) const {\n"
+        "  return methods_[method_index].background;\n"
+        "}\n\n"
         "void $service_name$If::InitMethods(const scoped_refptr<MetricEntity>& entity) {\n"
     );
 
@@ -2014,6 +2014,63 @@ TEST_F(RaftConsensusITest, TestReplicaBehaviorViaRPC) {
   }
 }
 
+// Tests that requests of the same tablet in a single MultiRaftUpdateConsensus batch are applied
+// in the batch order.
+TEST_F(RaftConsensusITest, TestMultiRaftUpdatesOfSameTablet) {
+  FLAGS_num_tablet_servers = 3;
+  auto ts_flags = {
+    "--enable_leader_failure_detection=false"s,
+  };
+  auto master_flags = {
+    "--catalog_manager_wait_for_new_tablets_to_elect_leader=false"s,
+    "--use_create_table_leader_hint=false"s,
+  };
+  ASSERT_NO_FATALS(BuildAndStart(ts_flags, master_flags));
+
+  vector<TServerDetails*> tservers = TServerDetailsVector(tablet_servers_);
+  ASSERT_EQ(3, tservers.size());
+
+  // Elect server 2 as leader and wait for log index 1 to propagate to all servers.
+  ASSERT_OK(StartElection(tservers[2], tablet_id_, MonoDelta::FromSeconds(10)));
+  ASSERT_OK(WaitForServersToAgree(MonoDelta::FromSeconds(10), tablet_servers_, tablet_id_, 1));
+
+  TServerDetails* replica_ts = tservers[0];
+  cluster_->tablet_server_by_uuid(tservers[1]->uuid())->Shutdown();
+  cluster_->tablet_server_by_uuid(tservers[2]->uuid())->Shutdown();
+
+  ConsensusServiceProxy* c_proxy = CHECK_NOTNULL(replica_ts->consensus_proxy.get());
+
+  ThreadSafeArena arena;
+  consensus::LWMultiRaftConsensusRequestPB req(&arena);
+  consensus::LWMultiRaftConsensusResponsePB resp(&arena);
+  RpcController rpc;
+
+  // The second request of the batch continues after ops of the first one, so it is rejected if
+  // it is applied first.
+  OpId preceding_id(1, 1);
+  for (int64_t last_index : {3, 4}) {
+    auto* update = req.add_consensus_request();
+    update->ref_tablet_id(tablet_id_);
+    update->ref_dest_uuid(replica_ts->uuid());
+    update->ref_caller_uuid("fake_caller");
+    update->set_caller_term(2);
+    OpId(1, 1).ToPB(update->mutable_committed_op_id());
+    preceding_id.ToPB(update->mutable_preceding_id());
+    for (auto index = preceding_id.index + 1; index <= last_index; ++index) {
+      AddOp(OpId(2, index), update);
+    }
+    preceding_id = OpId(2, last_index);
+  }
+
+  ASSERT_OK(c_proxy->MultiRaftUpdateConsensus(req, &resp, &rpc));
+  ASSERT_EQ(resp.consensus_response().size(), 2);
+  for (const auto& update_resp : resp.consensus_response()) {
+    ASSERT_FALSE(update_resp.has_error()) << update_resp.ShortDebugString();
+    ASSERT_FALSE(update_resp.status().has_error()) << update_resp.ShortDebugString();
+  }
+  ASSERT_EQ(resp.consensus_response().back().status().last_received().index(), 4);
+}
+
 TEST_F(RaftConsensusITest, TestLeaderStepDown) {
   FLAGS_num_tablet_servers = 3;
 
@@ -0,0 +1,71 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include <gtest/gtest.h>
+
+#include "yb/rpc/admission_controller.h"
+
+#include "yb/util/test_util.h"
+
+using namespace std::literals;
+
+namespace yb {
+namespace rpc {
+
+constexpr auto kTarget = 5ms;
+constexpr auto kInterval = 100ms;
+
+class AdmissionControllerTest : public YBTest {
+ protected:
+  bool ShouldReject(CoarseDuration sojourn, bool background = false) {
+    return controller_.ShouldReject(now_, sojourn, background, kTarget, kInterval);
+  }
+
+  AdmissionController controller_;
+  CoarseTimePoint now_ = CoarseMonoClock::now();
+};
+
+TEST_F(AdmissionControllerTest, ShortQueue) {
+  for (int i = 0; i != 10; ++i) {
+    ASSERT_FALSE(ShouldReject(1ms));
+    ASSERT_FALSE(ShouldReject(50ms, /* background= */ true));
+    now_ += kInterval / 4;
+  }
+  ASSERT_FALSE(controller_.overloaded());
+}
+
+TEST_F(AdmissionControllerTest, StandingQueue) {
+  // Whole interval without a call below the target.
+  ASSERT_FALSE(ShouldReject(20ms));
+  now_ += kInterval / 2;
+  ASSERT_FALSE(ShouldReject(8ms));
+  now_ += kInterval;
+
+  // Interval is finished by the next call, so this call is already checked.
+  ASSERT_TRUE(ShouldReject(20ms));
+  ASSERT_TRUE(controller_.overloaded());
+  ASSERT_EQ(controller_.RetryAfter(), 8ms);
+
+  // Background calls are shed first.
+  ASSERT_FALSE(ShouldReject(7ms));
+  ASSERT_TRUE(ShouldReject(7ms, /* background= */ true));
+  ASSERT_FALSE(ShouldReject(3ms, /* background= */ true));
+
+  // Queue drained, so the controller exits overloaded state after the interval.
+  now_ += kInterval * 2;
+  ASSERT_FALSE(ShouldReject(20ms));
+  ASSERT_FALSE(controller_.overloaded());
+}
+
+} // namespace rpc
+} // namespace yb
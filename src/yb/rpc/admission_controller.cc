@@ -0,0 +1,62 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include "yb/rpc/admission_controller.h"
+
+namespace yb {
+namespace rpc {
+
+bool AdmissionController::ShouldReject(
+    CoarseTimePoint now, CoarseDuration sojourn, bool background, CoarseDuration target,
+    CoarseDuration interval) {
+  if (now.time_since_epoch() > interval_end_.load(std::memory_order_acquire)) {
+    StartInterval(now, target, interval);
+  }
+
+  auto min_sojourn = min_sojourn_.load(std::memory_order_acquire);
+  while (sojourn < min_sojourn) {
+    if (min_sojourn_.compare_exchange_weak(min_sojourn, sojourn, std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+
+  if (!overloaded_.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  return sojourn > (background ? target : target * 2);
+}
+
+void AdmissionController::StartInterval(
+    CoarseTimePoint now, CoarseDuration target, CoarseDuration interval) {
+  // Only one thread finishes the interval, others continue with the current state.
+  if (starting_interval_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+
+  if (now.time_since_epoch() > interval_end_.load(std::memory_order_acquire)) {
+    auto min_sojourn = min_sojourn_.exchange(CoarseDuration::max(), std::memory_order_acq_rel);
+    // No calls during the interval means that there is no standing queue.
+    if (min_sojourn == CoarseDuration::max()) {
+      min_sojourn = CoarseDuration::zero();
+    }
+    last_min_sojourn_.store(min_sojourn, std::memory_order_release);
+    overloaded_.store(min_sojourn > target, std::memory_order_release);
+    interval_end_.store((now + interval).time_since_epoch(), std::memory_order_release);
+  }
+
+  starting_interval_.store(false, std::memory_order_release);
+}
+
+} // namespace rpc
+} // namespace yb
@@ -0,0 +1,63 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#pragma once
+
+#include <atomic>
+
+#include "yb/util/monotime.h"
+
+namespace yb {
+namespace rpc {
+
+// CoDel style admission controller for the service queue.
+//
+// Tracks the minimal time that calls spent in the queue (sojourn time) during each interval.
+// If the minimal sojourn time of the last interval is above the target, then the queue is not
+// draining and the service is considered overloaded.
+// While overloaded, calls that waited in the queue too long are rejected before being handled:
+// background calls are rejected after target, foreground calls after twice the target.
+// So background traffic is shed first, and foreground calls have a bounded queueing delay.
+//
+// Thread safe, intended to be invoked by service threads when a call is taken from the queue.
+class AdmissionController {
+ public:
+  // Accounts a call with the specified sojourn time, that is about to be handled.
+  // Returns true if the call should be rejected.
+  bool ShouldReject(
+      CoarseTimePoint now, CoarseDuration sojourn, bool background, CoarseDuration target,
+      CoarseDuration interval);
+
+  // Time after which client could retry a rejected call. I.e. minimal sojourn time of the last
+  // interval, that is the time needed to drain the standing queue.
+  CoarseDuration RetryAfter() const {
+    return last_min_sojourn_.load(std::memory_order_acquire);
+  }
+
+  bool overloaded() const {
+    return overloaded_.load(std::memory_order_acquire);
+  }
+
+ private:
+  void StartInterval(CoarseTimePoint now, CoarseDuration target, CoarseDuration interval);
+
+  // Have to use CoarseDuration here, since CoarseTimePoint does not work with clang + libstdc++
+  std::atomic<CoarseDuration> interval_end_{CoarseDuration::zero()};
+  std::atomic<CoarseDuration> min_sojourn_{CoarseDuration::max()};
+  std::atomic<CoarseDuration> last_min_sojourn_{CoarseDuration::zero()};
+  std::atomic<bool> overloaded_{false};
+  std::atomic<bool> starting_interval_{false};
+};
+
+} // namespace rpc
+} // namespace yb
@@ -14,6 +14,7 @@
 #include "yb/rpc/compressed_stream.h"
 
 #include <lz4.h>
+#include <mutex>
 #include <snappy-sinksource.h>
 #include <snappy.h>
 #include <zlib.h>
@@ -24,6 +25,7 @@
 #include "yb/gutil/casts.h"
 
 #include "yb/rpc/circular_read_buffer.h"
+#include "yb/rpc/compression_dictionary.h"
 #include "yb/rpc/outbound_data.h"
 #include "yb/rpc/refined_stream.h"
 
@@ -36,7 +38,14 @@
 using namespace std::literals;
 
 DEFINE_UNKNOWN_int32(stream_compression_algo, 0, "Algorithm used for stream compression. "
-                                         "0 - no compression, 1 - gzip, 2 - snappy, 3 - lz4.");
+                                         "0 - no compression, 1 - gzip, 2 - snappy, 3 - lz4, "
+                                         "4 - lz4 with dictionary.");
+
+DEFINE_NON_RUNTIME_string(stream_compression_dictionary_file, "",
+    "File with the preset dictionary for the lz4 with dictionary stream compression. The same "
+    "dictionary should be deployed to all nodes before enabling this compression, since "
+    "connections that use a different dictionary are rejected. The dictionary could be trained "
+    "from captured traffic samples with yb-train-compression-dict.");
 
 namespace yb {
 namespace rpc {
@@ -62,6 +71,17 @@ class Compressor {
   // Connection header associated with this compressor.
   virtual OutboundDataPtr ConnectionHeader() = 0;
 
+  // Number of bytes that follow compressor signature in the connection header.
+  virtual size_t ConnectionHeaderExtraLen() const {
+    return 0;
+  }
+
+  // Validates bytes that follow compressor signature in the connection header received from the
+  // client.
+  virtual Status ProcessConnectionHeader(Slice extra) {
+    return Status::OK();
+  }
+
   virtual ~Compressor() = default;
 };
 
@@ -507,9 +527,10 @@ const size_t kLZ4BufferSize = 64_KB;
 
 class LZ4DecompressState {
  public:
-  LZ4DecompressState(char* input_buffer, char* output_buffer, Slice* prev_decompress_data_left)
+  LZ4DecompressState(
+      char* input_buffer, char* output_buffer, Slice* prev_decompress_data_left, Slice dictionary)
       : input_buffer_(input_buffer), output_buffer_(output_buffer),
-        prev_decompress_data_left_(prev_decompress_data_left) {}
+        prev_decompress_data_left_(prev_decompress_data_left), dictionary_(dictionary) {}
 
   Result<ReadBufferFull> Execute(StreamReadBuffer* inp, StreamReadBuffer* out) {
     outvecs_ = VERIFY_RESULT(out->PrepareAppend());
@@ -596,16 +617,24 @@ class LZ4DecompressState {
   }
 
  private:
+  int DecompressSafe(const Slice& input, char* output, size_t output_size) {
+    if (dictionary_.empty()) {
+      return LZ4_decompress_safe(
+          input.cdata(), output, narrow_cast<int>(input.size()), narrow_cast<int>(output_size));
+    }
+    return LZ4_decompress_safe_usingDict(
+        input.cdata(), output, narrow_cast<int>(input.size()), narrow_cast<int>(output_size),
+        dictionary_.cdata(), narrow_cast<int>(dictionary_.size()));
+  }
+
   Status DecompressChunk(const Slice& input) {
-    int res = LZ4_decompress_safe(
-        input.cdata(), static_cast<char*>(out_it_->iov_base), narrow_cast<int>(input.size()),
-        narrow_cast<int>(out_it_->iov_len));
+    int res = DecompressSafe(
+        input, static_cast<char*>(out_it_->iov_base), out_it_->iov_len);
     if (res <= 0) {
       // Unfortunately LZ4 does not provide information whether decryption failed because
       // of wrong data or it just does not fit into output buffer.
       // Try to decode to buffer that is big enough for max possible decompressed chunk.
-      res = LZ4_decompress_safe(
-          input.cdata(), output_buffer_, narrow_cast<int>(input.size()), kLZ4BufferSize);
+      res = DecompressSafe(input, output_buffer_, kLZ4BufferSize);
       if (res <= 0) {
         return STATUS_FORMAT(RuntimeError, "Decompress failed: $0", res);
       }
@@ -651,6 +680,8 @@ class LZ4DecompressState {
   char* input_buffer_;
   char* output_buffer_;
   Slice* prev_decompress_data_left_;
+  // Preset dictionary used to compress data, empty if data was compressed without dictionary.
+  Slice dictionary_;
 
   IoVecs outvecs_;
   IoVecs::iterator out_it_;
@@ -698,8 +729,7 @@ class LZ4Compressor : public Compressor {
         }
         input_slice.remove_prefix(chunk.size());
         RefCntBuffer output(kHeaderLen + LZ4_compressBound(narrow_cast<int>(chunk.size())));
-        int res = LZ4_compress(
-            chunk.cdata(), output.data() + kHeaderLen, narrow_cast<int>(chunk.size()));
+        int res = CompressChunk(chunk, output.data() + kHeaderLen, output.size() - kHeaderLen);
         if (res <= 0) {
           return STATUS_FORMAT(RuntimeError, "LZ4 compression failed: $0", res);
         }
@@ -718,10 +748,21 @@ class LZ4Compressor : public Compressor {
 
   Result<ReadBufferFull> Decompress(StreamReadBuffer* inp, StreamReadBuffer* out) override {
     LZ4DecompressState state(
-        decompress_input_buf_, decompress_output_buf_, &prev_decompress_data_left_);
+        decompress_input_buf_, decompress_output_buf_, &prev_decompress_data_left_, Dictionary());
     return state.Execute(inp, out);
   }
 
+ protected:
+  // Compresses chunk into output, returns compressed size, or non positive value in case of
+  // failure.
+  virtual int CompressChunk(const Slice& chunk, char* output, size_t output_size) {
+    return LZ4_compress(chunk.cdata(), output, narrow_cast<int>(chunk.size()));
+  }
+
+  virtual Slice Dictionary() const {
+    return Slice();
+  }
+
  private:
   char decompress_input_buf_[kLZ4BufferSize];
   char decompress_output_buf_[kLZ4BufferSize];
@@ -729,8 +770,99 @@ class LZ4Compressor : public Compressor {
   ScopedTrackedConsumption consumption_;
 };
 
+Result<CompressionDictionaryPtr> StreamCompressionDictionary() {
+  static std::mutex mutex;
+  static std::string loaded_path;
+  static CompressionDictionaryPtr dictionary;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  const auto& path = FLAGS_stream_compression_dictionary_file;
+  if (path.empty()) {
+    return STATUS(InvalidArgument, "Stream compression dictionary file is not specified");
+  }
+  if (!dictionary || loaded_path != path) {
+    dictionary = VERIFY_RESULT(CompressionDictionary::Load(path));
+    loaded_path = path;
+    LOG(INFO) << "Loaded stream compression dictionary " << path << ", size: "
+              << dictionary->data().size() << ", id: " << dictionary->id();
+  }
+  return dictionary;
+}
+
+// LZ4 with preset dictionary, so small messages are compressed well even though each chunk is
+// compressed independently. Connection header contains id of the dictionary, and the server
+// rejects the connection if it does not have the same dictionary.
+class LZ4DictCompressor : public LZ4Compressor {
+ public:
+  static constexpr char kId = 'D';
+  static constexpr int kIndex = 4;
+
+  explicit LZ4DictCompressor(MemTrackerPtr mem_tracker)
+      : LZ4Compressor(std::move(mem_tracker)) {
+  }
+
+  Status Init() override {
+    dictionary_ = VERIFY_RESULT(StreamCompressionDictionary());
+    std::string header = "YB"s + kId;
+    char id[sizeof(uint32_t)];
+    BigEndian::Store32(id, dictionary_->id());
+    header.append(id, sizeof(id));
+    connection_header_ = std::make_shared<StringOutboundData>(
+        std::move(header), "LZ4DictConnectionHeader");
+    // Hashing the dictionary is much more expensive than compressing a small chunk, so do it once
+    // and start compression of each chunk from the copy of the loaded state.
+    auto dictionary = Dictionary();
+    LZ4_resetStream(&dict_stream_);
+    LZ4_loadDict(&dict_stream_, dictionary.cdata(), narrow_cast<int>(dictionary.size()));
+    return Status::OK();
+  }
+
+  OutboundDataPtr ConnectionHeader() override {
+    return connection_header_;
+  }
+
+  size_t ConnectionHeaderExtraLen() const override {
+    return sizeof(uint32_t);
+  }
+
+  Status ProcessConnectionHeader(Slice extra) override {
+    auto id = BigEndian::Load32(extra.data());
+    if (id != dictionary_->id()) {
+      return STATUS_FORMAT(
+          NetworkError, "Stream compression dictionary mismatch, remote: $0, local: $1",
+          id, dictionary_->id());
+    }
+    return Status::OK();
+  }
+
+  std::string ToString() const override {
+    return "LZ4Dict";
+  }
+
+ protected:
+  int CompressChunk(const Slice& chunk, char* output, size_t output_size) override {
+    // Restoring the state right after the dictionary was loaded, so chunks are still compressed
+    // independently.
+    memcpy(&lz4_stream_, &dict_stream_, sizeof(lz4_stream_));
+    return LZ4_compress_fast_continue(
+        &lz4_stream_, chunk.cdata(), output, narrow_cast<int>(chunk.size()),
+        narrow_cast<int>(output_size), /* acceleration= */ 1);
+  }
+
+  Slice Dictionary() const override {
+    return dictionary_->data();
+  }
+
+ private:
+  CompressionDictionaryPtr dictionary_;
+  OutboundDataPtr connection_header_;
+  // State with loaded dictionary, dictionary_ should outlive it, since it refers to the data.
+  LZ4_stream_t dict_stream_;
+  LZ4_stream_t lz4_stream_;
+};
+
 #undef LZ4
-#define YB_COMPRESSION_ALGORITHMS (Zlib)(Snappy)(LZ4)
+#define YB_COMPRESSION_ALGORITHMS (Zlib)(Snappy)(LZ4)(LZ4Dict)
 
 #define YB_CREATE_COMPRESSOR_CASE(r, data, name) \
   case BOOST_PP_CAT(name, Compressor)::data: \
@@ -780,9 +912,17 @@ class CompressedRefiner : public StreamRefiner {
     if (bytes[0] == 'Y' && bytes[1] == 'B') {
       compressor_ = CreateCompressor(bytes[2], stream_->buffer_tracker());
       if (compressor_) {
+        auto header_len = kHeaderLen + compressor_->ConnectionHeaderExtraLen();
+        if (data[0].iov_len < header_len) {
+          // Wait for the rest of the header.
+          compressor_.reset();
+          return Status::OK();
+        }
         RETURN_NOT_OK(compressor_->Init());
+        RETURN_NOT_OK(compressor_->ProcessConnectionHeader(
+            Slice(bytes + kHeaderLen, header_len - kHeaderLen)));
         RETURN_NOT_OK(stream_->StartHandshake());
-        stream_->ReadBuffer().Consume(kHeaderLen, Slice());
+        stream_->ReadBuffer().Consume(header_len, Slice());
         return Status::OK();
       }
     }
@@ -0,0 +1,106 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include <lz4.h>
+
+#include <gtest/gtest.h>
+
+#include "yb/gutil/casts.h"
+
+#include "yb/rpc/compression_dictionary.h"
+
+#include "yb/util/env.h"
+#include "yb/util/format.h"
+#include "yb/util/path_util.h"
+#include "yb/util/random_util.h"
+#include "yb/util/test_util.h"
+
+using namespace std::literals;
+
+namespace yb {
+namespace rpc {
+
+namespace {
+
+// Sample message that looks like a typical small RPC: common field names with random values.
+std::string GenerateMessage() {
+  return Format(
+      "table_id: $0 tablet_id: $1 propagated_hybrid_time: $2 key: $3 value: $4",
+      RandomHumanReadableString(16), RandomHumanReadableString(32), RandomUniformInt<uint64_t>(),
+      RandomHumanReadableString(8), RandomHumanReadableString(24));
+}
+
+int CompressedSize(const std::string& input, Slice dictionary) {
+  std::string output(LZ4_compressBound(narrow_cast<int>(input.size())), 0);
+  LZ4_stream_t stream;
+  LZ4_loadDict(&stream, dictionary.cdata(), narrow_cast<int>(dictionary.size()));
+  auto result = LZ4_compress_fast_continue(
+      &stream, input.data(), output.data(), narrow_cast<int>(input.size()),
+      narrow_cast<int>(output.size()), 1);
+  EXPECT_GT(result, 0);
+
+  std::string decompressed(input.size(), 0);
+  EXPECT_EQ(LZ4_decompress_safe_usingDict(
+      output.data(), decompressed.data(), result, narrow_cast<int>(decompressed.size()),
+      dictionary.cdata(), narrow_cast<int>(dictionary.size())), narrow_cast<int>(input.size()));
+  EXPECT_EQ(input, decompressed);
+  return result;
+}
+
+} // namespace
+
+class CompressionDictionaryTest : public YBTest {
+};
+
+TEST_F(CompressionDictionaryTest, Train) {
+  constexpr size_t kNumSamples = 100;
+  constexpr size_t kMaxSize = 256;
+
+  std::vector<std::string> messages;
+  for (size_t i = 0; i != kNumSamples; ++i) {
+    messages.push_back(GenerateMessage());
+  }
+  std::vector<Slice> samples(messages.begin(), messages.end());
+
+  auto dictionary = TrainCompressionDictionary(samples, kMaxSize);
+  LOG(INFO) << "Dictionary: " << Slice(dictionary).ToDebugString();
+  ASSERT_LE(dictionary.size(), kMaxSize);
+  ASSERT_NE(dictionary.find(" tablet_id: "), std::string::npos);
+  ASSERT_NE(dictionary.find(" propagated_hybrid_time: "), std::string::npos);
+
+  auto message = GenerateMessage();
+  auto plain_size = CompressedSize(message, Slice());
+  auto dictionary_size = CompressedSize(message, dictionary);
+  LOG(INFO) << "Message size: " << message.size() << ", compressed: " << plain_size
+            << ", compressed with dictionary: " << dictionary_size;
+  ASSERT_LT(dictionary_size, plain_size);
+}
+
+TEST_F(CompressionDictionaryTest, NothingInCommon) {
+  ASSERT_EQ(TrainCompressionDictionary({"first sample"s, "second one"s}), "");
+}
+
+TEST_F(CompressionDictionaryTest, Load) {
+  auto path = JoinPathSegments(GetTestDataDirectory(), "dictionary");
+  ASSERT_OK(WriteStringToFile(Env::Default(), Slice(), path));
+  ASSERT_NOK(CompressionDictionary::Load(path));
+
+  ASSERT_OK(WriteStringToFile(Env::Default(), "tablet_id", path));
+  auto dictionary = ASSERT_RESULT(CompressionDictionary::Load(path));
+  ASSERT_EQ(dictionary->data(), Slice("tablet_id"));
+  ASSERT_EQ(dictionary->id(), CompressionDictionary("tablet_id").id());
+  ASSERT_NE(dictionary->id(), CompressionDictionary("table_id").id());
+}
+
+} // namespace rpc
+} // namespace yb
@@ -0,0 +1,133 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include "yb/rpc/compression_dictionary.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "yb/util/crc.h"
+#include "yb/util/env.h"
+#include "yb/util/faststring.h"
+#include "yb/util/status_format.h"
+
+namespace yb {
+namespace rpc {
+
+namespace {
+
+// Length of segments, that are counted when training dictionary.
+// Shorter matches are not useful for LZ4, that has min match length of 4 bytes.
+constexpr size_t kSegmentLen = 8;
+
+// Segment should be present in at least this number of samples to be included into dictionary.
+constexpr size_t kMinSamples = 2;
+
+} // namespace
+
+CompressionDictionary::CompressionDictionary(std::string data)
+    : data_(std::move(data)), id_(crc::Crc32c(data_.data(), data_.size())) {
+}
+
+Result<CompressionDictionaryPtr> CompressionDictionary::Load(const std::string& path) {
+  faststring data;
+  RETURN_NOT_OK(ReadFileToString(Env::Default(), path, &data));
+  if (data.size() == 0 || data.size() > kMaxSize) {
+    return STATUS_FORMAT(
+        InvalidArgument, "Compression dictionary $0 has wrong size: $1, max size: $2",
+        path, data.size(), kMaxSize);
+  }
+  return std::make_shared<CompressionDictionary>(data.ToString());
+}
+
+std::string TrainCompressionDictionary(const std::vector<Slice>& samples, size_t max_size) {
+  // Number of samples that contain each segment.
+  std::unordered_map<Slice, size_t, Slice::Hash> segment_samples;
+  {
+    std::unordered_map<Slice, size_t, Slice::Hash> last_sample;
+    for (size_t i = 0; i != samples.size(); ++i) {
+      const auto& sample = samples[i];
+      for (size_t pos = 0; pos + kSegmentLen <= sample.size(); ++pos) {
+        Slice segment(sample.data() + pos, kSegmentLen);
+        auto it = last_sample.emplace(segment, i);
+        if (it.second || it.first->second != i) {
+          it.first->second = i;
+          ++segment_samples[segment];
+        }
+      }
+    }
+  }
+
+  auto frequency = [&segment_samples](Slice segment) -> size_t {
+    auto it = segment_samples.find(segment);
+    return it == segment_samples.end() ? 0 : it->second;
+  };
+
+  // Candidates are maximal runs of frequent segments in samples, scored by the sum of frequencies
+  // of their segments.
+  std::unordered_map<Slice, size_t, Slice::Hash> candidates;
+  for (const auto& sample : samples) {
+    size_t run_start = 0;
+    size_t run_score = 0;
+    for (size_t pos = 0;; ++pos) {
+      size_t freq = pos + kSegmentLen <= sample.size()
+          ? frequency(Slice(sample.data() + pos, kSegmentLen)) : 0;
+      if (freq >= kMinSamples) {
+        if (run_score == 0) {
+          run_start = pos;
+        }
+        run_score += freq;
+        continue;
+      }
+      if (run_score != 0) {
+        Slice candidate(sample.data() + run_start, sample.data() + pos + kSegmentLen - 1);
+        auto& score = candidates[candidate];
+        score = std::max(score, run_score);
+        run_score = 0;
+      }
+      if (pos + kSegmentLen > sample.size()) {
+        break;
+      }
+    }
+  }
+
+  std::vector<std::pair<Slice, size_t>> sorted_candidates(candidates.begin(), candidates.end());
+  std::sort(
+      sorted_candidates.begin(), sorted_candidates.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first.compare(rhs.first) < 0;
+  });
+
+  std::vector<Slice> picked;
+  std::string content;
+  for (const auto& [candidate, score] : sorted_candidates) {
+    if (content.size() + candidate.size() > max_size) {
+      continue;
+    }
+    if (content.find(candidate.cdata(), 0, candidate.size()) != std::string::npos) {
+      continue;
+    }
+    picked.push_back(candidate);
+    content.append(candidate.cdata(), candidate.size());
+  }
+
+  // Place the most valuable candidates at the end of the dictionary.
+  std::string result;
+  result.reserve(content.size());
+  for (auto it = picked.rbegin(); it != picked.rend(); ++it) {
+    result.append(it->cdata(), it->size());
+  }
+  return result;
+}
+
+} // namespace rpc
+} // namespace yb
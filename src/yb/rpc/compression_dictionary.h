@@ -0,0 +1,60 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "yb/util/result.h"
+#include "yb/util/slice.h"
+
+namespace yb {
+namespace rpc {
+
+// Preset dictionary for stream compression.
+// Both sides of the connection should use the same dictionary, it is identified by the checksum
+// of its content, that is sent in the connection header.
+class CompressionDictionary {
+ public:
+  // LZ4 does not use dictionary content beyond this size.
+  static constexpr size_t kMaxSize = 64 * 1024;
+
+  explicit CompressionDictionary(std::string data);
+
+  static Result<std::shared_ptr<const CompressionDictionary>> Load(const std::string& path);
+
+  uint32_t id() const {
+    return id_;
+  }
+
+  Slice data() const {
+    return data_;
+  }
+
+ private:
+  std::string data_;
+  uint32_t id_;
+};
+
+using CompressionDictionaryPtr = std::shared_ptr<const CompressionDictionary>;
+
+// Builds dictionary of at most max_size bytes from the provided samples of traffic.
+// Substrings that are present in the most samples are picked. Most valuable ones are placed at the
+// end of the dictionary, since compressors encode closer matches with shorter offsets.
+std::string TrainCompressionDictionary(
+    const std::vector<Slice>& samples, size_t max_size = CompressionDictionary::kMaxSize);
+
+} // namespace rpc
+} // namespace yb
@@ -177,6 +177,12 @@ class InboundCall : public RpcCall, public MPSCQueueEntry<InboundCall> {
 //  virtual const std::string& service_name() const = 0;
   virtual void RespondFailure(ErrorStatusPB::RpcErrorCodePB error_code, const Status& status) = 0;
 
+  // Responds with ERROR_SERVER_TOO_BUSY. retry_after is the hint for the client on when the call
+  // could be retried, it is ignored by protocols that cannot pass it.
+  virtual void RespondServerTooBusy(const Status& status, MonoDelta retry_after) {
+    RespondFailure(ErrorStatusPB::ERROR_SERVER_TOO_BUSY, status);
+  }
+
   // Do appropriate actions when call is timed out.
   //
   // message contains human readable information on why call timed out.
@@ -0,0 +1,73 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include <gtest/gtest.h>
+
+#include "yb/gutil/endian.h"
+
+#include "yb/rpc/kernel_tls.h"
+
+#include "yb/util/test_util.h"
+
+namespace yb {
+namespace rpc {
+
+namespace {
+
+void AppendRecord(size_t size, std::string* out) {
+  char header[TlsRecordCounter::kHeaderSize] = {0x17, 0x03, 0x03};
+  BigEndian::Store16(header + 3, size);
+  out->append(header, sizeof(header));
+  out->append(size, 'x');
+}
+
+} // namespace
+
+class TlsRecordCounterTest : public YBTest {
+};
+
+TEST_F(TlsRecordCounterTest, Count) {
+  std::string handshake;
+  AppendRecord(100, &handshake);
+  AppendRecord(40, &handshake);
+  std::string traffic;
+  AppendRecord(0, &traffic);
+  AppendRecord(1000, &traffic);
+  AppendRecord(16384, &traffic);
+  auto stream = handshake + traffic;
+
+  // Feed stream by small pieces, so headers are split.
+  TlsRecordCounter counter;
+  for (size_t pos = 0; pos < stream.size(); pos += 3) {
+    counter.Feed(Slice(stream).WithoutPrefix(pos).Prefix(std::min<size_t>(3, stream.size() - pos)));
+    if (counter.offset() == handshake.size()) {
+      ASSERT_TRUE(counter.AtRecordBoundary());
+    }
+    if (counter.offset() == handshake.size() + TlsRecordCounter::kHeaderSize + 1) {
+      // Some records after the handshake were already fed, when handshake was finished.
+      counter.StartCounting(handshake.size());
+      ASSERT_EQ(counter.count(), 1U);
+      ASSERT_FALSE(counter.AtRecordBoundary());
+    }
+  }
+  ASSERT_TRUE(counter.AtRecordBoundary());
+  ASSERT_EQ(counter.offset(), stream.size());
+  ASSERT_EQ(counter.count(), 3U);
+
+  AppendRecord(10, &traffic);
+  counter.Feed(Slice(traffic).Suffix(TlsRecordCounter::kHeaderSize + 10));
+  ASSERT_EQ(counter.count(), 4U);
+}
+
+} // namespace rpc
+} // namespace yb
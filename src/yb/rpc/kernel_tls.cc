@@ -0,0 +1,299 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include "yb/rpc/kernel_tls.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__linux__) && __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#define YB_HAS_KERNEL_TLS 1
+#endif
+
+#include "yb/gutil/endian.h"
+
+#include "yb/util/errno.h"
+#include "yb/util/logging.h"
+#include "yb/util/result.h"
+#include "yb/util/net/socket.h"
+#include "yb/util/status_format.h"
+#include "yb/util/status_log.h"
+
+#if defined(YB_HAS_KERNEL_TLS)
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+#ifndef TLS_GET_RECORD_TYPE
+#define TLS_GET_RECORD_TYPE 2
+#endif
+
+#endif
+
+namespace yb {
+namespace rpc {
+
+namespace {
+
+#if defined(YB_HAS_KERNEL_TLS)
+
+std::atomic<bool> kernel_tls_unavailable[kKernelTlsDirectionMapSize];
+
+// Errors reported by the kernel that does not support kTLS at all, or the requested direction.
+bool IsKernelTlsUnavailableError(int err) {
+  return err == ENOENT || err == ENOPROTOOPT || err == EOPNOTSUPP;
+}
+
+Status MarkUnavailable(KernelTlsDirection direction, const char* operation, int err) {
+  if (IsKernelTlsUnavailableError(err) &&
+      !kernel_tls_unavailable[to_underlying(direction)].exchange(true)) {
+    LOG(WARNING) << "Kernel TLS is not available for " << direction << ": " << operation
+                 << " failed with " << ErrnoToString(err);
+  }
+  return STATUS(NotSupported, operation, Errno(err));
+}
+
+template <class CryptoInfo>
+Status InstallKeys(
+    int fd, KernelTlsDirection direction, const KernelTlsKeys& keys, int cipher_type,
+    CryptoInfo* info) {
+  if (keys.key.size() != sizeof(info->key) || keys.salt.size() != sizeof(info->salt) ||
+      keys.iv.size() != sizeof(info->iv)) {
+    return STATUS_FORMAT(
+        InvalidArgument, "Wrong kernel TLS key sizes: key $0, salt $1, iv $2",
+        keys.key.size(), keys.salt.size(), keys.iv.size());
+  }
+  info->info.version = keys.version;
+  info->info.cipher_type = cipher_type;
+  memcpy(info->key, keys.key.data(), sizeof(info->key));
+  memcpy(info->salt, keys.salt.data(), sizeof(info->salt));
+  memcpy(info->iv, keys.iv.data(), sizeof(info->iv));
+  BigEndian::Store64(info->rec_seq, keys.sequence_number);
+
+  auto option = direction == KernelTlsDirection::kSend ? TLS_TX : TLS_RX;
+  auto res = setsockopt(fd, SOL_TLS, option, info, sizeof(*info));
+  auto err = errno;
+  memset(info, 0, sizeof(*info));
+  if (res != 0) {
+    return MarkUnavailable(direction, "Install TLS keys", err);
+  }
+  return Status::OK();
+}
+
+// TLS record content types.
+constexpr uint8_t kTlsAlert = 21;
+constexpr uint8_t kTlsHandshake = 22;
+constexpr uint8_t kTlsApplicationData = 23;
+
+constexpr uint8_t kTlsAlertCloseNotify = 0;
+constexpr uint8_t kTlsHandshakeNewSessionTicket = 4;
+// Handshake message header consists of message type (1 byte) and length (3 bytes).
+constexpr size_t kTlsHandshakeHeaderSize = 4;
+
+// Processes content of a received record that is not application data.
+// Returns OK if the record could be ignored.
+Status ProcessControlRecord(uint8_t type, const iovec* iov, size_t iov_len, size_t len) {
+  std::vector<char> content;
+  content.reserve(len);
+  for (size_t i = 0; i != iov_len && content.size() < len; ++i) {
+    const auto* data = static_cast<const char*>(iov[i].iov_base);
+    content.insert(content.end(), data, data + std::min(iov[i].iov_len, len - content.size()));
+  }
+  switch (type) {
+    case kTlsAlert:
+      if (content.size() == 2 && content[1] == kTlsAlertCloseNotify) {
+        return STATUS(NetworkError, "TLS connection closed by remote", Slice(), Errno(ESHUTDOWN));
+      }
+      return STATUS_FORMAT(
+          NetworkError, "Received TLS alert: $0",
+          content.size() == 2 ? static_cast<int>(static_cast<uint8_t>(content[1])) : -1);
+    case kTlsHandshake: {
+      // Session tickets are not used by RPC connections, but peer could still send them, for
+      // instance when it does not use kernel TLS. Other post handshake messages, like key update,
+      // could not be handled after the keys were passed to the kernel.
+      // Messages are expected to be received entirely, since they are much smaller than read
+      // buffer.
+      Slice messages(content.data(), content.size());
+      while (!messages.empty()) {
+        if (messages.size() < kTlsHandshakeHeaderSize) {
+          return STATUS_FORMAT(
+              NetworkError, "Truncated TLS handshake message, size: $0", messages.size());
+        }
+        auto message_type = messages[0];
+        auto message_len =
+            kTlsHandshakeHeaderSize + (BigEndian::Load32(messages.data()) & 0xffffff);
+        if (message_type != kTlsHandshakeNewSessionTicket) {
+          return STATUS_FORMAT(
+              NotSupported, "TLS handshake message $0 is not supported with kernel TLS",
+              static_cast<int>(message_type));
+        }
+        if (messages.size() < message_len) {
+          return STATUS_FORMAT(
+              NetworkError, "Truncated TLS handshake message, size: $0", messages.size());
+        }
+        messages.remove_prefix(message_len);
+      }
+      return Status::OK();
+    }
+  }
+  return STATUS_FORMAT(NetworkError, "Unexpected TLS record type: $0", static_cast<int>(type));
+}
+
+#endif
+
+} // namespace
+
+void KernelTlsKeys::Clear() {
+  for (auto* str : {&key, &salt, &iv}) {
+    std::fill(str->begin(), str->end(), 0);
+    str->clear();
+  }
+}
+
+bool KernelTlsAvailable(KernelTlsDirection direction) {
+#if defined(YB_HAS_KERNEL_TLS)
+  return !kernel_tls_unavailable[to_underlying(direction)].load(std::memory_order_acquire);
+#else
+  return false;
+#endif
+}
+
+Status EnableKernelTls(Socket* socket, KernelTlsDirection direction, const KernelTlsKeys& keys) {
+#if defined(YB_HAS_KERNEL_TLS)
+  auto fd = socket->GetFd();
+  static const char kTlsUlp[] = "tls";
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, kTlsUlp, sizeof(kTlsUlp)) != 0 && errno != EEXIST) {
+    auto err = errno;
+    for (auto ulp_direction : KernelTlsDirectionList()) {
+      WARN_NOT_OK(MarkUnavailable(ulp_direction, "Set TLS ULP", err), "Kernel TLS");
+    }
+    return STATUS(NotSupported, "Set TLS ULP", Errno(err));
+  }
+
+  switch (keys.key.size()) {
+    case TLS_CIPHER_AES_GCM_128_KEY_SIZE: {
+      tls12_crypto_info_aes_gcm_128 info;
+      return InstallKeys(fd, direction, keys, TLS_CIPHER_AES_GCM_128, &info);
+    }
+#if defined(TLS_CIPHER_AES_GCM_256)
+    case TLS_CIPHER_AES_GCM_256_KEY_SIZE: {
+      tls12_crypto_info_aes_gcm_256 info;
+      return InstallKeys(fd, direction, keys, TLS_CIPHER_AES_GCM_256, &info);
+    }
+#endif
+  }
+  return STATUS_FORMAT(NotSupported, "Unsupported kernel TLS key size: $0", keys.key.size());
+#else
+  return STATUS(NotSupported, "Kernel TLS is not supported on this platform");
+#endif
+}
+
+Result<size_t> KernelTlsRecvv(Socket* socket, iovec* iov, size_t iov_len) {
+#if defined(YB_HAS_KERNEL_TLS)
+  for (;;) {
+    char control[CMSG_SPACE(sizeof(uint8_t))];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov_len;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    auto res = recvmsg(socket->GetFd(), &msg, MSG_NOSIGNAL);
+    if (PREDICT_FALSE(res <= 0)) {
+      if (res == 0) {
+        return STATUS(NetworkError, "recvmsg got EOF from remote", Slice(), Errno(ESHUTDOWN));
+      }
+      if (IsTemporarySocketError(errno)) {
+        static const Status try_recv_again = STATUS(TryAgain, "Recv not yet ready");
+        return try_recv_again;
+      }
+      return STATUS(NetworkError, "recvmsg error", Errno(errno));
+    }
+
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_TLS || cmsg->cmsg_type != TLS_GET_RECORD_TYPE) {
+      return res;
+    }
+    auto type = *CMSG_DATA(cmsg);
+    if (PREDICT_TRUE(type == kTlsApplicationData)) {
+      return res;
+    }
+    // Data of the control record was written to the buffer, but it is not reported as received,
+    // so it will be overwritten by the next read.
+    RETURN_NOT_OK(ProcessControlRecord(type, iov, iov_len, res));
+    VLOG(1) << "Ignored TLS record of type " << static_cast<int>(type) << ", size: " << res;
+  }
+#else
+  return STATUS(NotSupported, "Kernel TLS is not supported on this platform");
+#endif
+}
+
+void TlsRecordCounter::Feed(Slice data) {
+  while (!data.empty()) {
+    if (record_left_ == 0) {
+      auto len = std::min(kHeaderSize - header_size_, data.size());
+      memcpy(header_ + header_size_, data.data(), len);
+      header_size_ += len;
+      offset_ += len;
+      data.remove_prefix(len);
+      if (header_size_ < kHeaderSize) {
+        break;
+      }
+      // Header contains content type (1 byte), version (2 bytes) and length (2 bytes).
+      record_left_ = BigEndian::Load16(header_ + 3);
+      header_size_ = 0;
+      if (record_left_ == 0) {
+        RecordCompleted();
+      }
+      continue;
+    }
+    auto len = std::min(record_left_, data.size());
+    record_left_ -= len;
+    offset_ += len;
+    data.remove_prefix(len);
+    if (record_left_ == 0) {
+      RecordCompleted();
+    }
+  }
+}
+
+void TlsRecordCounter::RecordCompleted() {
+  if (counting_) {
+    ++count_;
+  } else {
+    record_ends_.push_back(offset_);
+  }
+}
+
+void TlsRecordCounter::StartCounting(uint64_t offset) {
+  counting_ = true;
+  count_ = std::count_if(record_ends_.begin(), record_ends_.end(), [offset](uint64_t end) {
+    return end > offset;
+  });
+  record_ends_.clear();
+  record_ends_.shrink_to_fit();
+}
+
+} // namespace rpc
+} // namespace yb
@@ -0,0 +1,109 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+// Kernel TLS (kTLS) support.
+// After the handshake is performed by OpenSSL, record protection of a direction could be offloaded
+// to the kernel. Since then data is written to (or read from) the socket in plain text, and the
+// kernel encrypts (or decrypts) TLS records.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "yb/util/enums.h"
+#include "yb/util/slice.h"
+#include "yb/util/status_fwd.h"
+
+struct iovec;
+
+namespace yb {
+
+class Socket;
+
+namespace rpc {
+
+YB_DEFINE_ENUM(KernelTlsDirection, (kSend)(kReceive));
+
+// Keys of one direction of the TLS connection. Only AES GCM ciphers are supported, so key size
+// determines the cipher.
+struct KernelTlsKeys {
+  // TLS protocol version, as in TLS records, i.e. 0x0303 for TLS 1.2 and 0x0304 for TLS 1.3.
+  uint16_t version = 0;
+  std::string key;
+  // Implicit part of the nonce.
+  std::string salt;
+  // Explicit part of the nonce.
+  std::string iv;
+  // Sequence number of the next record.
+  uint64_t sequence_number = 0;
+
+  // Erases key material.
+  void Clear();
+};
+
+// Returns false if it is already known that kTLS is not supported for the specified direction by
+// the kernel.
+bool KernelTlsAvailable(KernelTlsDirection direction);
+
+// Installs keys for the specified direction on the socket. Should be invoked only when there is no
+// unprocessed TLS data of this direction in user space.
+Status EnableKernelTls(Socket* socket, KernelTlsDirection direction, const KernelTlsKeys& keys);
+
+// Receives application data from the socket with offloaded receiving.
+// The kernel fails plain reads with EIO when the next record is not application data, so the record
+// type is requested for each read. Alerts and post handshake messages are processed here:
+// session tickets are ignored, close notify is reported as EOF, other records fail the read.
+Result<size_t> KernelTlsRecvv(Socket* socket, iovec* iov, size_t iov_len);
+
+// Tracks TLS records in a byte stream, to find out the sequence number of the next record.
+class TlsRecordCounter {
+ public:
+  static constexpr size_t kHeaderSize = 5;
+
+  // Processes next bytes of the stream.
+  void Feed(Slice data);
+
+  // Starts counting records that end after the specified offset from the start of the stream.
+  // offset should be at the record boundary, for instance the end of the handshake.
+  void StartCounting(uint64_t offset);
+
+  // Number of records that were completed after the offset passed to StartCounting.
+  uint64_t count() const {
+    return count_;
+  }
+
+  // Number of bytes fed to the counter.
+  uint64_t offset() const {
+    return offset_;
+  }
+
+  bool AtRecordBoundary() const {
+    return header_size_ == 0 && record_left_ == 0;
+  }
+
+ private:
+  void RecordCompleted();
+
+  char header_[kHeaderSize];
+  size_t header_size_ = 0;
+  size_t record_left_ = 0;
+  uint64_t offset_ = 0;
+  bool counting_ = false;
+  uint64_t count_ = 0;
+  // Ends of records completed before counting is started.
+  std::vector<uint64_t> record_ends_;
+};
+
+} // namespace rpc
+} // namespace yb
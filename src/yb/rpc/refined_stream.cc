@@ -85,6 +85,7 @@ Result<size_t> RefinedStream::Send(OutboundDataPtr data) {
     RETURN_NOT_OK(refiner_->Send(std::move(data)));
     return std::numeric_limits<size_t>::max();
   case RefinedStreamState::kDisabled:
+  case RefinedStreamState::kOffloaded:
     return lower_stream_->Send(std::move(data));
   }
 
@@ -117,7 +118,7 @@ std::string RefinedStream::ToString() const {
 }
 
 bool RefinedStream::Cancelled(size_t handle) {
-  if (state_ == RefinedStreamState::kDisabled) {
+  if (state_ == RefinedStreamState::kDisabled || state_ == RefinedStreamState::kOffloaded) {
     return lower_stream_->Cancelled(handle);
   }
   LOG_WITH_PREFIX(DFATAL) << "Cancel is not supported for proxy stream: " << handle;
@@ -125,7 +126,8 @@ bool RefinedStream::Cancelled(size_t handle) {
 }
 
 bool RefinedStream::IsConnected() {
-  return state_ == RefinedStreamState::kEnabled || state_ == RefinedStreamState::kDisabled;
+  return state_ == RefinedStreamState::kEnabled || state_ == RefinedStreamState::kDisabled ||
+         state_ == RefinedStreamState::kOffloaded;
 }
 
 const Protocol* RefinedStream::GetProtocol() {
@@ -133,7 +135,8 @@ const Protocol* RefinedStream::GetProtocol() {
 }
 
 StreamReadBuffer& RefinedStream::ReadBuffer() {
-  return state_ != RefinedStreamState::kDisabled ? read_buffer_ : context_->ReadBuffer();
+  return state_ != RefinedStreamState::kDisabled && state_ != RefinedStreamState::kOffloaded
+      ? read_buffer_ : context_->ReadBuffer();
 }
 
 Result<size_t> RefinedStream::ProcessReceived(ReadBufferFull read_buffer_full) {
@@ -148,6 +151,7 @@ Result<size_t> RefinedStream::ProcessReceived(ReadBufferFull read_buffer_full) {
     }
 
     case RefinedStreamState::kDisabled:
+    case RefinedStreamState::kOffloaded:
       return context_->ProcessReceived(read_buffer_full);
 
     case RefinedStreamState::kHandshake:
@@ -324,6 +328,13 @@ Result<size_t> RefinedStream::Read() {
     }
   }
 
+  if (refiner_->Offloaded() && read_buffer_.Empty() && upper_stream_bytes_to_skip_ == 0) {
+    // Since now lower stream reads directly to the upper stream buffer.
+    state_ = RefinedStreamState::kOffloaded;
+    ResetLogPrefix();
+    VLOG_WITH_PREFIX(1) << "Offloaded";
+  }
+
   return 0;
 }
 
@@ -21,7 +21,9 @@
 namespace yb {
 namespace rpc {
 
-YB_DEFINE_ENUM(RefinedStreamState, (kInitial)(kHandshake)(kEnabled)(kDisabled));
+// kOffloaded - data modification is performed by the lower layer (for instance by the kernel),
+// so data is passed through as in kDisabled state.
+YB_DEFINE_ENUM(RefinedStreamState, (kInitial)(kHandshake)(kEnabled)(kDisabled)(kOffloaded));
 YB_DEFINE_ENUM(LocalSide, (kClient)(kServer));
 
 // StreamRefiner is used by RefinedStream to perform actual stream data modification.
@@ -34,6 +36,12 @@ class StreamRefiner {
   virtual Result<ReadBufferFull> Read(StreamReadBuffer* out) = 0;
   virtual const Protocol* GetProtocol() = 0;
 
+  // Returns true when data modification in both directions was offloaded to the lower layer,
+  // so refiner is not needed anymore.
+  virtual bool Offloaded() const {
+    return false;
+  }
+
   virtual std::string ToString() const = 0;
 
   virtual ~StreamRefiner() = default;
@@ -92,6 +100,10 @@ class RefinedStream : public Stream, public StreamContext {
     return buffer_tracker_;
   }
 
+  Stream& lower_stream() const {
+    return *lower_stream_;
+  }
+
  private:
   Result<size_t> Handshake();
   Result<size_t> Read();
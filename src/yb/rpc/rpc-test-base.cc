@@ -383,6 +383,28 @@ class CalculatorService: public CalculatorServiceIf {
     context.RespondSuccess();
   }
 
+  void Attach(
+      const rpc_test::AttachRequestPB* req, rpc_test::AttachResponsePB* resp,
+      RpcContext context) override {
+    // The same pattern is used by ReadQuery, it would crash if the request was arena allocated.
+    EchoRequestPB echo;
+    echo.set_data("attached");
+    auto* mutable_req = const_cast<rpc_test::AttachRequestPB*>(req);
+    mutable_req->set_allocated_echo(&echo);
+    resp->set_data(req->echo().data());
+    mutable_req->release_echo();
+    resp->set_request_on_arena(req->GetArena() != nullptr);
+    context.RespondSuccess();
+  }
+
+  void ArenaInfo(
+      const rpc_test::AttachRequestPB* req, rpc_test::AttachResponsePB* resp,
+      RpcContext context) override {
+    resp->set_data(req->echo().data());
+    resp->set_request_on_arena(req->GetArena() != nullptr);
+    context.RespondSuccess();
+  }
+
   Result<rpc_test::TrivialResponsePB> Trivial(
       const rpc_test::TrivialRequestPB& req, CoarseTimePoint deadline) override {
     if (req.value() < 0) {
@@ -43,10 +43,13 @@
 
 #include <gtest/gtest.h>
 
+#include "yb/gutil/endian.h"
 #include "yb/gutil/map-util.h"
 #include "yb/gutil/strings/human_readable.h"
 
 #include "yb/rpc/compressed_stream.h"
+#include "yb/rpc/compression_dictionary.h"
+#include "yb/rpc/kernel_tls.h"
 #include "yb/rpc/network_error.h"
 #include "yb/rpc/proxy.h"
 #include "yb/rpc/rpc_controller.h"
@@ -61,6 +64,8 @@
 #include "yb/util/format.h"
 #include "yb/util/logging_test_util.h"
 #include "yb/util/net/net_util.h"
+#include "yb/util/net/socket.h"
+#include "yb/util/path_util.h"
 #include "yb/util/result.h"
 #include "yb/util/status_format.h"
 #include "yb/util/status_log.h"
@@ -75,6 +80,8 @@ METRIC_DECLARE_histogram(handler_latency_yb_rpc_test_CalculatorService_Sleep);
 METRIC_DECLARE_histogram(rpc_incoming_queue_time);
 METRIC_DECLARE_counter(tcp_bytes_sent);
 METRIC_DECLARE_counter(tcp_bytes_received);
+METRIC_DECLARE_histogram(tcp_bytes_per_write_syscall);
+METRIC_DECLARE_counter(tcp_kernel_tls_offloads);
 METRIC_DECLARE_counter(rpcs_timed_out_early_in_queue);
 
 DEFINE_UNKNOWN_int32(rpc_test_connection_keepalive_num_iterations, 1,
@@ -83,13 +90,19 @@ DEFINE_UNKNOWN_int32(rpc_test_connection_keepalive_num_iterations, 1,
 DECLARE_bool(TEST_pause_calculator_echo_request);
 DECLARE_bool(binary_call_parser_reject_on_mem_tracker_hard_limit);
 DECLARE_bool(enable_rpc_keepalive);
+DECLARE_bool(rpc_coalesce_outbound_writes);
+DECLARE_bool(rpc_cork_coalesced_writes);
+DECLARE_bool(use_kernel_tls);
 DECLARE_int32(num_connections_to_server);
 DECLARE_int64(rpc_throttle_threshold_bytes);
 DECLARE_int32(stream_compression_algo);
+DECLARE_string(ssl_protocols);
+DECLARE_string(stream_compression_dictionary_file);
 DECLARE_int64(memory_limit_hard_bytes);
 DECLARE_string(vmodule);
 DECLARE_uint64(rpc_connection_timeout_ms);
 DECLARE_uint64(rpc_read_buffer_size);
+DECLARE_uint64(rpc_zero_copy_send_threshold_bytes);
 
 using namespace std::chrono_literals;
 using std::string;
@@ -1212,6 +1225,29 @@ TEST_F(TestRpcSecure, ConcurrentOps) {
   RunSecureTest(&TestConcurrentOps);
 }
 
+TEST_F(TestRpc, CoalesceOutboundWrites) {
+  auto histogram = ASSERT_RESULT(GetHistogram(
+      metric_entity(), METRIC_tcp_bytes_per_write_syscall));
+
+  // Sends the same burst of concurrent calls, returns the number of write syscalls used for it.
+  auto count_syscalls = [this, &histogram](bool coalesce) {
+    ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_coalesce_outbound_writes) = coalesce;
+    ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_cork_coalesced_writes) = coalesce;
+    auto before = histogram->TotalCount();
+    RunPlainTest(&TestConcurrentOps);
+    return histogram->TotalCount() - before;
+  };
+
+  auto regular_syscalls = count_syscalls(false);
+  auto coalesced_syscalls = count_syscalls(true);
+  LOG(INFO) << "Write syscalls, regular: " << regular_syscalls
+            << ", coalesced: " << coalesced_syscalls;
+  ASSERT_GT(coalesced_syscalls, 0);
+  ASSERT_LT(coalesced_syscalls, regular_syscalls);
+
+  RunPlainTest(&TestBigOp);
+}
+
 TEST_F(TestRpcSecure, CantAllocateReadBuffer) {
   RunSecureTest(&TestCantAllocateReadBuffer, SetupServerForTestCantAllocateReadBuffer());
 }
@@ -1221,6 +1257,12 @@ class TestRpcCompression : public RpcTestBase, public testing::WithParamInterfac
   void SetUp() override {
     FLAGS_stream_compression_algo = GetParam();
     RpcTestBase::SetUp();
+    // Used by LZ4Dict only.
+    std::string sample(64, 'Y');
+    auto dictionary_file = JoinPathSegments(GetTestDataDirectory(), "compression.dict");
+    ASSERT_OK(WriteStringToFile(
+        Env::Default(), TrainCompressionDictionary({sample, sample}), dictionary_file));
+    FLAGS_stream_compression_dictionary_file = dictionary_file;
   }
 
  protected:
@@ -1315,11 +1357,97 @@ std::string CompressionName(const testing::TestParamInfo<int>& info) {
     case 1: return "Zlib";
     case 2: return "Snappy";
     case 3: return "LZ4";
+    case 4: return "LZ4Dict";
   }
   return Format("Unknown compression $0", info.param);
 }
 
-INSTANTIATE_TEST_CASE_P(, TestRpcCompression, testing::Range(1, 4), CompressionName);
+INSTANTIATE_TEST_CASE_P(, TestRpcCompression, testing::Range(1, 5), CompressionName);
+
+using TestRpcCompressionDictionary = TestRpcCompression;
+
+// Sends LZ4Dict connection header with the specified dictionary id, and returns status of reading
+// from the connection.
+Status SendDictionaryHeader(const HostPort& server_hostport, uint32_t id, MonoDelta timeout) {
+  auto endpoint = VERIFY_RESULT(ParseEndpoint(server_hostport.ToString(), 0));
+  Socket socket;
+  RETURN_NOT_OK(socket.Init(endpoint.address().is_v6() ? Socket::FLAG_IPV6 : 0));
+  RETURN_NOT_OK(socket.Connect(endpoint));
+  uint8_t header[7] = {'Y', 'B', 'D'};
+  BigEndian::Store32(header + 3, id);
+  RETURN_NOT_OK(socket.BlockingWrite(
+      header, sizeof(header), MonoTime::Now() + MonoDelta::FromSeconds(10)));
+  uint8_t buf[1];
+  return ResultToStatus(socket.BlockingRecv(buf, sizeof(buf), MonoTime::Now() + timeout));
+}
+
+TEST_P(TestRpcCompressionDictionary, Mismatch) {
+  HostPort server_hostport;
+  StartTestServerWithGeneratedCode(
+      CreateCompressedMessenger("TestServer", kDefaultServerMessengerOptions), &server_hostport);
+  auto dictionary = ASSERT_RESULT(CompressionDictionary::Load(
+      FLAGS_stream_compression_dictionary_file));
+
+  // Server keeps the connection with the same dictionary, waiting for the data.
+  auto status = SendDictionaryHeader(server_hostport, dictionary->id(), 500ms);
+  ASSERT_TRUE(status.IsTimedOut()) << status;
+
+  // And closes the connection with another dictionary.
+  status = SendDictionaryHeader(server_hostport, dictionary->id() ^ 1, 10s);
+  ASSERT_NOK(status);
+  ASSERT_FALSE(status.IsTimedOut()) << status;
+}
+
+INSTANTIATE_TEST_CASE_P(, TestRpcCompressionDictionary, testing::Values(4), CompressionName);
+
+class TestRpcKernelTls : public TestRpcSecure {
+ public:
+  void SetUp() override {
+    FLAGS_use_kernel_tls = true;
+    TestRpcSecure::SetUp();
+  }
+
+ protected:
+  // Connections fall back to OpenSSL when kernel TLS is not available, so the offload is checked
+  // only when the kernel supports it.
+  template <class F>
+  void RunKernelTlsTest(const F& f) {
+    RunSecureTest(f);
+
+    auto offloads = ASSERT_RESULT(GetCounter(metric_entity(), METRIC_tcp_kernel_tls_offloads));
+    if (!KernelTlsAvailable(KernelTlsDirection::kSend) ||
+        !KernelTlsAvailable(KernelTlsDirection::kReceive)) {
+      LOG(INFO) << "Kernel TLS is not available, offloads: " << offloads->value();
+      return;
+    }
+    // Both directions on both sides of the connection.
+    ASSERT_GE(offloads->value(), 4);
+  }
+};
+
+TEST_F(TestRpcKernelTls, BigOp) {
+  RunKernelTlsTest(&TestBigOp);
+}
+
+TEST_F(TestRpcKernelTls, ManyOps) {
+  RunKernelTlsTest(&TestManyOps);
+}
+
+TEST_F(TestRpcKernelTls, ConcurrentOps) {
+  RunKernelTlsTest(&TestConcurrentOps);
+}
+
+class TestRpcKernelTls12 : public TestRpcKernelTls {
+ public:
+  void SetUp() override {
+    FLAGS_ssl_protocols = "tls12";
+    TestRpcKernelTls::SetUp();
+  }
+};
+
+TEST_F(TestRpcKernelTls12, ManyOps) {
+  RunKernelTlsTest(&TestManyOps);
+}
 
 class TestRpcSecureCompression : public TestRpcSecure {
  public:
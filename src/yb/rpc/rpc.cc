@@ -106,7 +106,22 @@ bool RpcRetrier::HandleResponse(
     if (err &&
         err->has_code() &&
         err->code() == ErrorStatusPB::ERROR_SERVER_TOO_BUSY) {
-      auto status = DelayedRetry(rpc, controller_status, BackoffStrategy::kExponential);
+      Status status;
+      if (err->has_retry_after_ms()) {
+        // Server estimated when it could accept the call, so don't retry before that.
+        // But still double the delay when server keeps rejecting us, and spread retries of
+        // clients that were rejected at the same time.
+        auto retry_after = MonoDelta::FromMilliseconds(std::max<uint32_t>(
+            err->retry_after_ms(), 1));
+        retry_delay_ = std::min<MonoDelta>(
+            std::max(retry_delay_ * 2, retry_after),
+            1ms * (1ULL << FLAGS_max_backoff_ms_exponent));
+        retry_delay_ += MonoDelta::FromMicroseconds(
+            RandomUniformInt<int64_t>(0, retry_delay_.ToMicroseconds() / 2));
+        status = DoDelayedRetry(rpc, controller_status);
+      } else {
+        status = DelayedRetry(rpc, controller_status, BackoffStrategy::kExponential);
+      }
       if (!status.ok()) {
         *out_status = status;
         return false;
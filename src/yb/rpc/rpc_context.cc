@@ -46,6 +46,7 @@
 #include "yb/rpc/yb_rpc.h"
 
 #include "yb/util/debug/trace_event.h"
+#include "yb/util/flags.h"
 #include "yb/util/format.h"
 #include "yb/util/jsonwriter.h"
 #include "yb/util/pb_util.h"
@@ -54,6 +55,11 @@
 
 using google::protobuf::Message;
 
+DEFINE_RUNTIME_bool(rpc_use_arena_for_pb_params, false,
+    "Allocate request and response protobufs of inbound calls, with all nested messages, "
+    "from a per call arena that is released when the call completes.");
+TAG_FLAG(rpc_use_arena_for_pb_params, advanced);
+
 namespace yb {
 namespace rpc {
 
@@ -92,6 +98,14 @@ scoped_refptr<debug::ConvertableToTraceFormat> TracePb(const Message& msg) {
 
 }  // anonymous namespace
 
+google::protobuf::Arena* RpcCallPBParams::CreateArena() {
+  if (!FLAGS_rpc_use_arena_for_pb_params) {
+    return nullptr;
+  }
+  arena_.emplace();
+  return &*arena_;
+}
+
 Result<size_t> RpcCallPBParams::ParseRequest(Slice param, const RefCntBuffer& buffer) {
   google::protobuf::io::CodedInputStream in(param.data(), narrow_cast<int>(param.size()));
   SetupLimit(&in);
@@ -31,9 +31,11 @@
 //
 #pragma once
 
+#include <optional>
 #include <string>
 
 #include <boost/type_traits/is_detected.hpp>
+#include <google/protobuf/arena.h>
 
 #include "yb/rpc/rpc_header.pb.h"
 #include "yb/rpc/serialization.h"
@@ -82,29 +84,61 @@ class RpcCallPBParams : public RpcCallParams {
   static google::protobuf::Message* CastMessage(const AnyMessagePtr& msg);
 
   static const google::protobuf::Message* CastMessage(const AnyMessageConstPtr& msg);
+
+ protected:
+  // Creates arena for request and response of this call, if rpc_use_arena_for_pb_params is set.
+  // Returns nullptr otherwise, so request and response are allocated on the heap.
+  google::protobuf::Arena* CreateArena();
+
+  google::protobuf::Arena* arena() {
+    return arena_ ? &*arena_ : nullptr;
+  }
+
+ private:
+  std::optional<google::protobuf::Arena> arena_;
 };
 
-template <class Req, class Resp>
+template <class Req, class Resp, bool kAllowArena = true>
 class RpcCallPBParamsImpl : public RpcCallPBParams {
  public:
   using RequestType = Req;
   using ResponseType = Resp;
 
-  RpcCallPBParamsImpl() = default;
+  // When arena is used, all nested messages of request and response are allocated from it,
+  // and released at once when the call completes. Otherwise they are stored inline, as before.
+  RpcCallPBParamsImpl() {
+    auto* arena = kAllowArena ? CreateArena() : nullptr;
+    if (arena) {
+      req_ = google::protobuf::Arena::Create<Req>(arena);
+      resp_ = google::protobuf::Arena::Create<Resp>(arena);
+    } else {
+      req_ = &inline_req_.emplace();
+      resp_ = &inline_resp_.emplace();
+    }
+  }
 
   Req& request() override {
-    return req_;
+    return *req_;
   }
 
   Resp& response() override {
-    return resp_;
+    return *resp_;
   }
 
  private:
-  Req req_;
-  Resp resp_;
+  std::optional<Req> inline_req_;
+  std::optional<Resp> inline_resp_;
+  // Point either to inline messages or to messages allocated from the arena.
+  Req* req_;
+  Resp* resp_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcCallPBParamsImpl);
 };
 
+// Params of methods marked with the heap_params option.
+template <class Req, class Resp>
+using RpcCallHeapPBParamsImpl = RpcCallPBParamsImpl<Req, Resp, false>;
+
 class RpcCallLWParams : public RpcCallParams {
  public:
   Result<size_t> ParseRequest(Slice param, const RefCntBuffer& buffer) override;
@@ -32,6 +32,7 @@
 
 #include <condition_variable>
 #include <functional>
+#include <future>
 #include <thread>
 #include <vector>
 
@@ -40,11 +41,13 @@
 #include "yb/gutil/stl_util.h"
 
 #include "yb/rpc/proxy.h"
+#include "yb/rpc/rpc.h"
 #include "yb/rpc/rpc-test-base.h"
 #include "yb/rpc/rpc_controller.h"
 #include "yb/rpc/rpc_introspection.pb.h"
 #include "yb/rpc/rtest.proxy.h"
 #include "yb/rpc/rtest.service.h"
+#include "yb/rpc/service_pool.h"
 #include "yb/rpc/yb_rpc.h"
 
 #include "yb/util/countdown_latch.h"
@@ -61,7 +64,12 @@
 #include "yb/util/flags.h"
 
 DEFINE_UNKNOWN_bool(is_panic_test_child, false, "Used by TestRpcPanic");
+DECLARE_bool(rpc_enable_admission_control);
+DECLARE_bool(rpc_enable_inline_execution);
+DECLARE_bool(rpc_use_arena_for_pb_params);
 DECLARE_bool(socket_inject_short_recvs);
+DECLARE_int32(rpc_admission_control_interval_ms);
+DECLARE_int32(rpc_admission_control_target_ms);
 DECLARE_int32(rpc_slow_query_threshold_ms);
 DECLARE_int32(TEST_delay_connect_ms);
 
@@ -151,6 +159,46 @@ TEST_F(RpcStubTest, TestSimpleCall) {
   SendSimpleCall();
 }
 
+TEST_F(RpcStubTest, ArenaPBParams) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_use_arena_for_pb_params) = true;
+  SendSimpleCall();
+
+  CalculatorServiceProxy proxy(proxy_cache_.get(), server_hostport_);
+  RpcController controller;
+  controller.set_timeout(30s);
+  EchoRequestPB req;
+  req.set_data(RandomHumanReadableString(64_KB));
+  EchoResponsePB resp;
+  ASSERT_OK(proxy.Echo(req, &resp, &controller));
+  ASSERT_EQ(resp.data(), req.data());
+}
+
+TEST_F(RpcStubTest, HeapPBParams) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_use_arena_for_pb_params) = true;
+
+  CalculatorServiceProxy proxy(proxy_cache_.get(), server_hostport_);
+  rpc_test::AttachRequestPB req;
+  req.mutable_echo()->set_data("original");
+  rpc_test::AttachResponsePB resp;
+
+  RpcController controller;
+  controller.set_timeout(30s);
+  ASSERT_OK(proxy.ArenaInfo(req, &resp, &controller));
+  ASSERT_EQ(resp.data(), "original");
+  ASSERT_TRUE(resp.request_on_arena());
+
+  // Method with heap_params option gets heap allocated request, even when arena is enabled.
+  controller.Reset();
+  ASSERT_OK(proxy.Attach(req, &resp, &controller));
+  ASSERT_EQ(resp.data(), "attached");
+  ASSERT_FALSE(resp.request_on_arena());
+
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_use_arena_for_pb_params) = false;
+  controller.Reset();
+  ASSERT_OK(proxy.ArenaInfo(req, &resp, &controller));
+  ASSERT_FALSE(resp.request_on_arena());
+}
+
 TEST_F(RpcStubTest, ConnectTimeout) {
   FLAGS_TEST_delay_connect_ms = 5000;
   CalculatorServiceProxy p(proxy_cache_.get(), server_hostport_);
@@ -542,6 +590,106 @@ TEST_F(RpcStubTest, TestDontHandleTimedOutCalls) {
   ASSERT_EQ(1, timed_out_in_queue->value());
 }
 
+// Add call that is retried by RpcRetrier when the server is too busy.
+class RetryingAdd : public Rpc {
+ public:
+  RetryingAdd(CoarseTimePoint deadline, Messenger* messenger, ProxyCache* proxy_cache,
+              const HostPort& hostport)
+      : Rpc(deadline, messenger, proxy_cache), proxy_(proxy_cache, hostport) {
+    req_.set_x(10);
+    req_.set_y(20);
+  }
+
+  void SendRpc() override {
+    proxy_.AddAsync(req_, &resp_, PrepareController(), [this] { Finished(Status::OK()); });
+  }
+
+  std::string ToString() const override {
+    return "RetryingAdd";
+  }
+
+  void Finished(const Status& status) override {
+    Status new_status = status;
+    if (new_status.ok()) {
+      auto* err = retrier().controller().error_response();
+      if (err && err->has_retry_after_ms()) {
+        ++num_hints_;
+        min_retry_after_ms_ = std::min(min_retry_after_ms_, err->retry_after_ms());
+      }
+      if (mutable_retrier()->HandleResponse(this, &new_status)) {
+        return;
+      }
+    }
+    promise_.set_value(new_status.ok() ? Result<int32_t>(resp_.result())
+                                       : Result<int32_t>(new_status));
+  }
+
+  Result<int32_t> Wait() {
+    return promise_.get_future().get();
+  }
+
+  size_t num_hints() const {
+    return num_hints_;
+  }
+
+  uint32_t min_retry_after_ms() const {
+    return min_retry_after_ms_;
+  }
+
+ private:
+  CalculatorServiceProxy proxy_;
+  AddRequestPB req_;
+  AddResponsePB resp_;
+  size_t num_hints_ = 0;
+  uint32_t min_retry_after_ms_ = std::numeric_limits<uint32_t>::max();
+  std::promise<Result<int32_t>> promise_;
+};
+
+// Checks that calls shed by the service pool admission control carry a retry hint, and are
+// successfully retried by RpcRetrier.
+TEST_F(RpcStubTest, AdmissionControlRetry) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_enable_admission_control) = true;
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_admission_control_target_ms) = 1;
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_admission_control_interval_ms) = 10;
+
+  constexpr size_t kSleeps = 100;
+  constexpr size_t kAdds = 20;
+
+  // Build a standing queue of sleep calls, so the service becomes overloaded.
+  CalculatorServiceProxy p(proxy_cache_.get(), server_hostport_);
+  std::vector<std::unique_ptr<AsyncSleep>> sleeps;
+  CountDownLatch latch(kSleeps);
+  for (size_t i = 0; i != kSleeps; ++i) {
+    auto& sleep = *sleeps.emplace_back(std::make_unique<AsyncSleep>());
+    sleep.rpc.set_timeout(30s);
+    sleep.req.set_sleep_micros(20000);
+    p.SleepAsync(sleep.req, &sleep.resp, &sleep.rpc, [&latch] { latch.CountDown(); });
+  }
+
+  std::vector<std::shared_ptr<RetryingAdd>> adds;
+  for (size_t i = 0; i != kAdds; ++i) {
+    adds.push_back(std::make_shared<RetryingAdd>(
+        CoarseMonoClock::now() + 30s, client_messenger_.get(), proxy_cache_.get(),
+        server_hostport_));
+    adds.back()->SendRpc();
+  }
+
+  size_t retried = 0;
+  for (const auto& add : adds) {
+    ASSERT_EQ(ASSERT_RESULT(add->Wait()), 30);
+    if (add->num_hints()) {
+      ++retried;
+      ASSERT_GE(add->min_retry_after_ms(), 1);
+    }
+  }
+  latch.Wait();
+
+  LOG(INFO) << "Retried adds: " << retried;
+  ASSERT_GT(retried, 0);
+  ASSERT_GE(server().service_pool().RpcsShedByAdmissionControlMetric()->value(),
+            static_cast<int64_t>(retried));
+}
+
 TEST_F(RpcStubTest, TestDumpCallsInFlight) {
   CountDownLatch latch(1);
   CalculatorServiceProxy p(proxy_cache_.get(), server_hostport_);
@@ -1065,5 +1213,33 @@ TEST_F(RpcStubTest, Trivial) {
   ASSERT_EQ(resp.error().code(), Status::Code::kInvalidArgument);
 }
 
+TEST_F(RpcStubTest, InlineExecution) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_enable_inline_execution) = true;
+
+  CalculatorServiceProxy p(proxy_cache_.get(), server_hostport_);
+
+  // Send enough sleep calls to occupy the worker threads.
+  auto count = client_messenger_->max_concurrent_requests() * 4;
+  CountDownLatch latch(count);
+  std::vector<std::unique_ptr<AsyncSleep>> sleeps;
+  for (size_t i = 0; i < count; i++) {
+    auto& sleep = *sleeps.emplace_back(std::make_unique<AsyncSleep>());
+    sleep.rpc.set_timeout(30s);
+    sleep.req.set_sleep_micros(2 * 1000 * 1000);
+    p.SleepAsync(sleep.req, &sleep.resp, &sleep.rpc, [&latch]() { latch.CountDown(); });
+  }
+
+  // Ping is executed on the reactor thread, so it does not wait for the busy worker threads.
+  RpcController controller;
+  controller.set_timeout(1s * kTimeMultiplier);
+  PingRequestPB req;
+  PingResponsePB resp;
+  req.set_id(1);
+  ASSERT_OK(p.Ping(req, &resp, &controller));
+  ASSERT_EQ(server().service_pool().RpcsInlineOverBudgetMetric()->value(), 0);
+
+  latch.Wait();
+}
+
 } // namespace rpc
 } // namespace yb
@@ -14,6 +14,7 @@
 #include "yb/rpc/secure_stream.h"
 
 #include <openssl/err.h>
+#include <openssl/kdf.h>
 #include <openssl/ssl.h>
 #include <openssl/x509v3.h>
 
@@ -22,9 +23,13 @@
 #include "yb/encryption/encryption_util.h"
 
 #include "yb/gutil/casts.h"
+#include "yb/gutil/endian.h"
+#include "yb/gutil/strings/escaping.h"
 
+#include "yb/rpc/kernel_tls.h"
 #include "yb/rpc/outbound_data.h"
 #include "yb/rpc/refined_stream.h"
+#include "yb/rpc/rpc_util.h"
 
 #include "yb/util/enums.h"
 #include "yb/util/errno.h"
@@ -52,6 +57,13 @@ DEFINE_UNKNOWN_string(cipher_list, "",
 DEFINE_UNKNOWN_string(ciphersuites, "",
               "Define the available TLSv1.3 ciphersuites.");
 
+DEFINE_NON_RUNTIME_bool(use_kernel_tls, false,
+    "Offload record encryption and decryption of secure connections to the kernel (kTLS) after "
+    "the handshake, when supported by the kernel and the negotiated cipher (AES GCM). Falls back "
+    "to OpenSSL otherwise. Post handshake messages, such as TLS 1.3 session tickets, could not be "
+    "received after offloading, so this flag should be set on all nodes.");
+TAG_FLAG(use_kernel_tls, advanced);
+
 #define YB_RPC_SSL_TYPE(name) \
   struct BOOST_PP_CAT(name, Free) { \
     void operator()(name* value) const { \
@@ -72,6 +84,7 @@ typedef struct x509_st X509;
 
 YB_RPC_SSL_TYPE(BIO)
 YB_RPC_SSL_TYPE(EVP_PKEY)
+YB_RPC_SSL_TYPE(EVP_PKEY_CTX)
 YB_RPC_SSL_TYPE(SSL)
 YB_RPC_SSL_TYPE(SSL_CTX)
 YB_RPC_SSL_TYPE(X509)
@@ -275,6 +288,72 @@ class OpenSSLInitializer {
 
 YB_STRONGLY_TYPED_BOOL(UseCertificateKeyPair);
 
+void KernelTlsKeylogCallback(const SSL* ssl, const char* line);
+
+// Size of the implicit part of AES GCM nonce.
+constexpr size_t kAesGcmSaltSize = 4;
+// Size of the explicit part of AES GCM nonce.
+constexpr size_t kAesGcmIvSize = 8;
+
+// Derives key block from the master secret, RFC 5246 section 6.3.
+Result<std::string> Tls12KeyBlock(SSL* ssl, const EVP_MD* md, size_t size) {
+  unsigned char master_key[SSL_MAX_MASTER_KEY_LENGTH];
+  auto master_key_size = SSL_SESSION_get_master_key(
+      SSL_get_session(ssl), master_key, sizeof(master_key));
+  auto se = ScopeExit([&master_key] {
+    OPENSSL_cleanse(master_key, sizeof(master_key));
+  });
+  unsigned char client_random[SSL3_RANDOM_SIZE];
+  unsigned char server_random[SSL3_RANDOM_SIZE];
+  SSL_get_client_random(ssl, client_random, sizeof(client_random));
+  SSL_get_server_random(ssl, server_random, sizeof(server_random));
+
+  static const unsigned char kLabel[] = "key expansion";
+  EVP_PKEY_CTXPtr ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr));
+  std::string result(size, 0);
+  auto result_size = size;
+  if (!ctx || EVP_PKEY_derive_init(ctx.get()) <= 0 ||
+      EVP_PKEY_CTX_set_tls1_prf_md(ctx.get(), md) <= 0 ||
+      EVP_PKEY_CTX_set1_tls1_prf_secret(
+          ctx.get(), master_key, narrow_cast<int>(master_key_size)) <= 0 ||
+      EVP_PKEY_CTX_add1_tls1_prf_seed(ctx.get(), kLabel, sizeof(kLabel) - 1) <= 0 ||
+      EVP_PKEY_CTX_add1_tls1_prf_seed(ctx.get(), server_random, sizeof(server_random)) <= 0 ||
+      EVP_PKEY_CTX_add1_tls1_prf_seed(ctx.get(), client_random, sizeof(client_random)) <= 0 ||
+      EVP_PKEY_derive(ctx.get(), pointer_cast<unsigned char*>(result.data()), &result_size) <= 0 ||
+      result_size != size) {
+    return SSL_STATUS(InternalError, "Failed to derive TLS 1.2 key block: $0");
+  }
+  return result;
+}
+
+// HKDF-Expand-Label with empty context, RFC 8446 section 7.1.
+Result<std::string> HkdfExpandLabel(
+    const EVP_MD* md, Slice secret, const std::string& label, size_t size) {
+  auto full_label = "tls13 " + label;
+  std::string info;
+  info.push_back(static_cast<char>(size >> 8));
+  info.push_back(static_cast<char>(size & 0xff));
+  info.push_back(static_cast<char>(full_label.size()));
+  info += full_label;
+  info.push_back(0);
+
+  EVP_PKEY_CTXPtr ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr));
+  std::string result(size, 0);
+  auto result_size = size;
+  if (!ctx || EVP_PKEY_derive_init(ctx.get()) <= 0 ||
+      EVP_PKEY_CTX_hkdf_mode(ctx.get(), EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) <= 0 ||
+      EVP_PKEY_CTX_set_hkdf_md(ctx.get(), md) <= 0 ||
+      EVP_PKEY_CTX_set1_hkdf_key(ctx.get(), secret.data(), narrow_cast<int>(secret.size())) <= 0 ||
+      EVP_PKEY_CTX_add1_hkdf_info(
+          ctx.get(), pointer_cast<const unsigned char*>(info.data()),
+          narrow_cast<int>(info.size())) <= 0 ||
+      EVP_PKEY_derive(ctx.get(), pointer_cast<unsigned char*>(result.data()), &result_size) <= 0 ||
+      result_size != size) {
+    return SSL_STATUS(InternalError, "Failed to expand TLS 1.3 traffic secret: $0");
+  }
+  return result;
+}
+
 } // namespace
 
 namespace {
@@ -496,6 +575,13 @@ SecureContext::Impl::Impl(
   auto res = SSL_CTX_set_session_id_context(context_.get(), kContextId, sizeof(kContextId));
   LOG_IF(DFATAL, res != 1) << "Failed to set session id for SSL context: "
                            << SSLErrorMessage(ERR_get_error());
+
+  if (FLAGS_use_kernel_tls) {
+    // TLS 1.3 traffic secrets are available only through the key log callback.
+    SSL_CTX_set_keylog_callback(context_.get(), &KernelTlsKeylogCallback);
+    // Don't send session tickets, since the peer could not receive them after offloading.
+    SSL_CTX_set_num_tickets(context_.get(), 0);
+  }
 }
 
 Result<SSLPtr> SecureContext::Impl::Create(
@@ -657,6 +743,9 @@ class SecureRefiner : public StreamRefiner {
     : secure_context_(*context.impl_), remote_hostname_(data.remote_hostname) {
   }
 
+  // Invoked by OpenSSL with secrets negotiated during the handshake.
+  void ProcessKeylogLine(std::string_view line);
+
  private:
   void Start(RefinedStream* stream) override {
     stream_ = stream;
@@ -677,6 +766,11 @@ class SecureRefiner : public StreamRefiner {
     return SecureStreamProtocol();
   }
 
+  bool Offloaded() const override {
+    return KernelTls(KernelTlsDirection::kSend).enabled &&
+           KernelTls(KernelTlsDirection::kReceive).enabled;
+  }
+
   static int VerifyCallback(int preverified, X509_STORE_CTX* store_context);
   Status Verify(bool preverified, X509_STORE_CTX* store_context);
   bool MatchEndpoint(X509* cert, GENERAL_NAMES* gens);
@@ -684,11 +778,46 @@ class SecureRefiner : public StreamRefiner {
   bool MatchUidEntry(const Slice& value, const char* name);
   Result<bool> WriteEncrypted(OutboundDataPtr data);
   void DecryptReceived();
+  Status SendEncrypted(const RefCntBuffer& buffer, OutboundDataPtr data);
+
+  // Kernel TLS support.
+  struct KernelTlsState {
+    // Counts records of this direction, to find out sequence number of the next record.
+    TlsRecordCounter records;
+    // Traffic secret of this direction, used with TLS 1.3 only.
+    std::string traffic_secret;
+    bool enabled = false;
+    bool failed = false;
+  };
+
+  KernelTlsState& KernelTls(KernelTlsDirection direction) {
+    return kernel_tls_[to_underlying(direction)];
+  }
+
+  const KernelTlsState& KernelTls(KernelTlsDirection direction) const {
+    return kernel_tls_[to_underlying(direction)];
+  }
+
+  // Offloads directions to the kernel if there is no pending TLS data for them in user space.
+  void TryEnableKernelTls();
+  void EnableKernelTls(KernelTlsDirection direction);
+  Result<KernelTlsKeys> DeriveKernelTlsKeys(KernelTlsDirection direction);
+  // Passes data received in plain text after receiving was offloaded to the kernel.
+  Result<ReadBufferFull> ReadPlain(StreamReadBuffer* out);
 
   Status Established(RefinedStreamState state) {
     VLOG_WITH_PREFIX(4) << "Established with state: " << state << ", used cipher: "
                         << SSL_get_cipher_name(ssl_.get());
 
+    if (state == RefinedStreamState::kEnabled && use_kernel_tls_) {
+      // Received data that was not consumed by the handshake is already protected with traffic
+      // keys.
+      auto& received = KernelTls(KernelTlsDirection::kReceive).records;
+      received.StartCounting(received.offset() - BIO_ctrl_wpending(bio_.get()));
+      auto& sent = KernelTls(KernelTlsDirection::kSend).records;
+      sent.StartCounting(sent.offset());
+    }
+
     return stream_->Established(state);
   }
 
@@ -704,9 +833,174 @@ class SecureRefiner : public StreamRefiner {
   BIOPtr bio_;
   SSLPtr ssl_;
   Status verification_status_;
+
+  bool use_kernel_tls_ = false;
+  KernelTlsState kernel_tls_[kKernelTlsDirectionMapSize];
 };
 
+namespace {
+
+void KernelTlsKeylogCallback(const SSL* ssl, const char* line) {
+  auto refiner = static_cast<SecureRefiner*>(SSL_get_app_data(ssl));
+  if (refiner) {
+    refiner->ProcessKeylogLine(line);
+  }
+}
+
+} // namespace
+
+void SecureRefiner::ProcessKeylogLine(std::string_view line) {
+  // Line format: <label> <client random> <secret>, where client random and secret are in hex.
+  auto label = line.substr(0, line.find(' '));
+  bool client_secret;
+  if (label == "CLIENT_TRAFFIC_SECRET_0") {
+    client_secret = true;
+  } else if (label == "SERVER_TRAFFIC_SECRET_0") {
+    client_secret = false;
+  } else {
+    return;
+  }
+  auto direction = client_secret == (stream_->local_side() == LocalSide::kClient)
+      ? KernelTlsDirection::kSend : KernelTlsDirection::kReceive;
+  KernelTls(direction).traffic_secret = a2b_hex(line.substr(line.rfind(' ') + 1));
+}
+
+void SecureRefiner::TryEnableKernelTls() {
+  if (!use_kernel_tls_) {
+    return;
+  }
+
+  auto& send = KernelTls(KernelTlsDirection::kSend);
+  if (!send.enabled && !send.failed && send.records.AtRecordBoundary() &&
+      stream_->GetPendingWriteBytes() == 0 && BIO_ctrl_pending(bio_.get()) == 0) {
+    EnableKernelTls(KernelTlsDirection::kSend);
+  }
+
+  auto& receive = KernelTls(KernelTlsDirection::kReceive);
+  if (!receive.enabled && !receive.failed && receive.records.AtRecordBoundary() &&
+      stream_->ReadBuffer().Empty() && BIO_ctrl_wpending(bio_.get()) == 0 &&
+      !SSL_has_pending(ssl_.get())) {
+    EnableKernelTls(KernelTlsDirection::kReceive);
+  }
+
+  if (send.failed && receive.failed) {
+    use_kernel_tls_ = false;
+  }
+}
+
+void SecureRefiner::EnableKernelTls(KernelTlsDirection direction) {
+  auto& state = KernelTls(direction);
+  auto keys = DeriveKernelTlsKeys(direction);
+  auto status = keys.ok()
+      ? stream_->lower_stream().EnableKernelTls(direction, *keys) : keys.status();
+  if (keys.ok()) {
+    keys->Clear();
+  }
+  if (!status.ok()) {
+    VLOG_WITH_PREFIX(1) << "Failed to enable kernel TLS for " << direction << ": " << status;
+    state.failed = true;
+    return;
+  }
+  VLOG_WITH_PREFIX(1) << "Enabled kernel TLS for " << direction << " starting with record "
+                      << state.records.count();
+  OPENSSL_cleanse(state.traffic_secret.data(), state.traffic_secret.size());
+  state.traffic_secret.clear();
+  state.enabled = true;
+}
+
+Result<KernelTlsKeys> SecureRefiner::DeriveKernelTlsKeys(KernelTlsDirection direction) {
+  if (!KernelTlsAvailable(direction)) {
+    return STATUS(NotSupported, "Kernel TLS is not available");
+  }
+
+  const auto* cipher = SSL_get_current_cipher(ssl_.get());
+  size_t key_size;
+  switch (SSL_CIPHER_get_cipher_nid(cipher)) {
+    case NID_aes_128_gcm:
+      key_size = 16;
+      break;
+    case NID_aes_256_gcm:
+      key_size = 32;
+      break;
+    default:
+      return STATUS_FORMAT(
+          NotSupported, "Cipher is not supported by kernel TLS: $0", SSL_CIPHER_get_name(cipher));
+  }
+  const auto* md = SSL_CIPHER_get_handshake_digest(cipher);
+  auto& state = KernelTls(direction);
+  bool client_keys =
+      (direction == KernelTlsDirection::kSend) == (stream_->local_side() == LocalSide::kClient);
+
+  KernelTlsKeys result;
+  result.version = SSL_version(ssl_.get());
+  result.sequence_number = state.records.count();
+  switch (result.version) {
+    case TLS1_2_VERSION: {
+      // Finished message is the first record protected with the negotiated keys.
+      ++result.sequence_number;
+      // Key block consists of client key, server key, client salt and server salt, since there
+      // are no MAC keys for AEAD ciphers.
+      auto key_block = VERIFY_RESULT(Tls12KeyBlock(
+          ssl_.get(), md, 2 * (key_size + kAesGcmSaltSize)));
+      result.key = key_block.substr(client_keys ? 0 : key_size, key_size);
+      result.salt = key_block.substr(
+          2 * key_size + (client_keys ? 0 : kAesGcmSaltSize), kAesGcmSaltSize);
+      OPENSSL_cleanse(key_block.data(), key_block.size());
+      // Explicit part of the nonce is sent with each record, so the kernel could use the record
+      // sequence number for it, as OpenSSL does.
+      result.iv.resize(kAesGcmIvSize);
+      BigEndian::Store64(result.iv.data(), result.sequence_number);
+      break;
+    }
+    case TLS1_3_VERSION: {
+      if (state.traffic_secret.empty()) {
+        return STATUS(IllegalState, "Traffic secret is not known");
+      }
+      result.key = VERIFY_RESULT(HkdfExpandLabel(md, state.traffic_secret, "key", key_size));
+      auto iv = VERIFY_RESULT(HkdfExpandLabel(
+          md, state.traffic_secret, "iv", kAesGcmSaltSize + kAesGcmIvSize));
+      result.salt = iv.substr(0, kAesGcmSaltSize);
+      result.iv = iv.substr(kAesGcmSaltSize);
+      OPENSSL_cleanse(iv.data(), iv.size());
+      break;
+    }
+    default:
+      return STATUS_FORMAT(
+          NotSupported, "TLS version is not supported by kernel TLS: $0",
+          SSL_get_version(ssl_.get()));
+  }
+  return result;
+}
+
+Result<ReadBufferFull> SecureRefiner::ReadPlain(StreamReadBuffer* out) {
+  auto& inp = stream_->ReadBuffer();
+  auto dst = VERIFY_RESULT(out->PrepareAppend());
+  auto dst_it = dst.begin();
+  size_t total = 0;
+  for (auto src : inp.AppendedVecs()) {
+    while (src.iov_len != 0 && dst_it != dst.end()) {
+      if (dst_it->iov_len == 0) {
+        ++dst_it;
+        continue;
+      }
+      auto len = std::min(dst_it->iov_len, src.iov_len);
+      memcpy(dst_it->iov_base, src.iov_base, len);
+      IoVecRemovePrefix(len, &*dst_it);
+      IoVecRemovePrefix(len, &src);
+      total += len;
+    }
+  }
+  inp.Consume(total, Slice());
+  out->DataAppended(total);
+  return ReadBufferFull(out->Full());
+}
+
 Status SecureRefiner::Send(OutboundDataPtr data) {
+  TryEnableKernelTls();
+  if (KernelTls(KernelTlsDirection::kSend).enabled) {
+    return stream_->SendToLower(std::move(data));
+  }
+
   boost::container::small_vector<RefCntSlice, 10> queue;
   data->Serialize(&queue);
   for (const auto& buf : queue) {
@@ -747,11 +1041,17 @@ Result<bool> SecureRefiner::WriteEncrypted(OutboundDataPtr data) {
   LOG_IF_WITH_PREFIX(DFATAL, len != buf_size)
       << "BIO_read was not full: " << buf.size() << ", read: " << len;
   VLOG_WITH_PREFIX(4) << "Write encrypted: " << len << ", " << AsString(data);
-  RETURN_NOT_OK(stream_->SendToLower(std::make_shared<SingleBufferOutboundData>(
-      buf, std::move(data))));
+  RETURN_NOT_OK(SendEncrypted(buf, std::move(data)));
   return true;
 }
 
+Status SecureRefiner::SendEncrypted(const RefCntBuffer& buffer, OutboundDataPtr data) {
+  if (use_kernel_tls_) {
+    KernelTls(KernelTlsDirection::kSend).records.Feed(buffer.AsSlice());
+  }
+  return stream_->SendToLower(std::make_shared<SingleBufferOutboundData>(buffer, std::move(data)));
+}
+
 Status SecureRefiner::ProcessHeader() {
   auto data = stream_->ReadBuffer().AppendedVecs();
   if (data.empty() || data[0].iov_len < 2) {
@@ -777,6 +1077,11 @@ Status SecureRefiner::ProcessHeader() {
 // = 0 - in case of SSL_ERROR_WANT_READ.
 // Status with network error - in case of other errors.
 Result<ReadBufferFull> SecureRefiner::Read(StreamReadBuffer* out) {
+  if (KernelTls(KernelTlsDirection::kReceive).enabled) {
+    TryEnableKernelTls();
+    return ReadPlain(out);
+  }
+
   DecryptReceived();
   auto total = 0;
   auto iovecs = VERIFY_RESULT(out->PrepareAppend());
@@ -806,6 +1111,7 @@ Result<ReadBufferFull> SecureRefiner::Read(StreamReadBuffer* out) {
     }
   }
   out->DataAppended(total);
+  TryEnableKernelTls();
   return ReadBufferFull(out->Full());
 }
 
@@ -821,6 +1127,10 @@ void SecureRefiner::DecryptReceived() {
     if (res <= 0) {
       break;
     }
+    if (use_kernel_tls_) {
+      KernelTls(KernelTlsDirection::kReceive).records.Feed(
+          Slice(static_cast<const char*>(iov.iov_base), res));
+    }
     total += res;
     if (implicit_cast<size_t>(res) < iov.iov_len) {
       break;
@@ -864,8 +1174,7 @@ Status SecureRefiner::Handshake() {
       RefCntBuffer buffer(pending_after);
       int len = BIO_read(bio_.get(), buffer.data(), narrow_cast<int>(buffer.size()));
       DCHECK_EQ(len, pending_after);
-      RETURN_NOT_OK(stream_->SendToLower(
-          std::make_shared<SingleBufferOutboundData>(buffer, nullptr)));
+      RETURN_NOT_OK(SendEncrypted(buffer, nullptr));
       // If SSL_connect/SSL_accept returned positive result it means that TLS connection
       // was succesfully established. We just have to send last portion of data.
       if (result > 0) {
@@ -893,6 +1202,7 @@ Status SecureRefiner::Init() {
   SSL_set_mode(ssl_.get(), SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
   SSL_set_mode(ssl_.get(), SSL_MODE_RELEASE_BUFFERS);
   SSL_set_app_data(ssl_.get(), this);
+  use_kernel_tls_ = FLAGS_use_kernel_tls;
 
   BIO* int_bio = nullptr;
   BIO* temp_bio = nullptr;
@@ -69,6 +69,10 @@ struct RpcMethodDesc {
   RemoteMethod method;
   std::function<void(InboundCallPtr)> handler;
   RpcMethodMetrics metrics;
+  // Whether the handler could be executed on the reactor thread, see inline_execution option.
+  bool inline_execution = false;
+  // Whether the call is shed first when the service is overloaded, see background option.
+  bool background = false;
 };
 
 // Handles incoming messages that initiate an RPC.
@@ -80,6 +84,16 @@ class ServiceIf {
 
   virtual void Shutdown();
   virtual std::string service_name() const = 0;
+
+  // Returns true if method with specified index could be executed on the reactor thread.
+  virtual bool IsInlineMethod(size_t method_index) const {
+    return false;
+  }
+
+  // Returns true if method with specified index serves background traffic.
+  virtual bool IsBackgroundMethod(size_t method_index) const {
+    return false;
+  }
 };
 
 }  // namespace rpc
@@ -51,11 +51,13 @@
 #include "yb/gutil/ref_counted.h"
 #include "yb/gutil/strings/substitute.h"
 
+#include "yb/rpc/admission_controller.h"
 #include "yb/rpc/inbound_call.h"
 #include "yb/rpc/scheduler.h"
 #include "yb/rpc/service_if.h"
 
 #include "yb/util/countdown_latch.h"
+#include "yb/util/debug/long_operation_tracker.h"
 #include "yb/util/flags.h"
 #include "yb/util/lockfree.h"
 #include "yb/util/logging.h"
@@ -79,6 +81,25 @@ DEFINE_RUNTIME_int64(backpressure_recovery_period_ms, 600000,
     "Once we hit a backpressure/service-overflow we will consider dropping stale requests "
     "for this duration (in ms)");
 TAG_FLAG(backpressure_recovery_period_ms, advanced);
+DEFINE_RUNTIME_bool(rpc_enable_inline_execution, false,
+    "Execute handlers of methods marked with the inline_execution option directly on the reactor "
+    "thread that received the call, instead of passing them to the service thread pool.");
+DEFINE_RUNTIME_int32(rpc_inline_execution_budget_ms, 10,
+    "Time budget for a handler executed on the reactor thread. Handlers exceeding it are "
+    "reported to the log, with the stack trace if they are still running.");
+TAG_FLAG(rpc_inline_execution_budget_ms, advanced);
+DEFINE_RUNTIME_bool(rpc_enable_admission_control, false,
+    "Shed calls using the CoDel style admission control. When the minimal time calls spent in "
+    "the service queue during rpc_admission_control_interval_ms is above "
+    "rpc_admission_control_target_ms, the service is considered overloaded. While overloaded, "
+    "calls of background methods that waited longer than the target, and other calls that "
+    "waited longer than twice the target, are rejected with a retry after hint.");
+DEFINE_RUNTIME_int32(rpc_admission_control_target_ms, 5,
+    "Acceptable standing queue delay for rpc_enable_admission_control.");
+TAG_FLAG(rpc_admission_control_target_ms, advanced);
+DEFINE_RUNTIME_int32(rpc_admission_control_interval_ms, 100,
+    "Interval over which the minimal queue delay is tracked for rpc_enable_admission_control.");
+TAG_FLAG(rpc_admission_control_interval_ms, advanced);
 DEFINE_test_flag(bool, enable_backpressure_mode_for_testing, false,
             "For testing purposes. Enables the rpc's to be considered timed out in the queue even "
             "when we have not had any backpressure in the recent past.");
@@ -102,6 +123,18 @@ METRIC_DEFINE_counter(server, rpcs_timed_out_early_in_queue,
                       "in the service queue, and thus were not processed. "
                       "Timeout for those calls were detected before the calls tried to execute.");
 
+METRIC_DEFINE_counter(server, rpcs_inline_over_budget,
+                      "RPCs Inline Over Budget",
+                      yb::MetricUnit::kRequests,
+                      "Number of RPCs executed on the reactor thread, whose handler took longer "
+                      "than rpc_inline_execution_budget_ms.");
+
+METRIC_DEFINE_counter(server, rpcs_shed_by_admission_control,
+                      "RPCs Shed By Admission Control",
+                      yb::MetricUnit::kRequests,
+                      "Number of RPCs rejected because the service was overloaded and they "
+                      "waited in the queue longer than admission control allows.");
+
 METRIC_DEFINE_counter(server, rpcs_queue_overflow,
                       "RPC Queue Overflows",
                       yb::MetricUnit::kRequests,
@@ -134,6 +167,9 @@ class ServicePoolImpl final : public InboundCallHandler {
         rpcs_timed_out_early_in_queue_(
             METRIC_rpcs_timed_out_early_in_queue.Instantiate(entity)),
         rpcs_queue_overflow_(METRIC_rpcs_queue_overflow.Instantiate(entity)),
+        rpcs_inline_over_budget_(METRIC_rpcs_inline_over_budget.Instantiate(entity)),
+        rpcs_shed_by_admission_control_(
+            METRIC_rpcs_shed_by_admission_control.Instantiate(entity)),
         check_timeout_strand_(scheduler->io_service()),
         log_prefix_(Format("$0: ", service_->service_name())) {
 
@@ -189,6 +225,11 @@ class ServicePoolImpl final : public InboundCallHandler {
       return;
     }
 
+    if (FLAGS_rpc_enable_inline_execution && service_->IsInlineMethod(call->method_index())) {
+      ExecuteInline(*call, task);
+      return;
+    }
+
     auto call_deadline = call->GetClientDeadline();
     if (call_deadline != CoarseTimePoint::max()) {
       pre_check_timeout_queue_.push(call);
@@ -198,10 +239,36 @@ class ServicePoolImpl final : public InboundCallHandler {
     thread_pool_.Enqueue(task);
   }
 
+  // Executes the task on the current thread, which is usually the reactor thread that received
+  // the call. So there is no context switch to the service thread pool and back.
+  void ExecuteInline(const InboundCall& call, ThreadPoolTask* task) {
+    auto budget = FLAGS_rpc_inline_execution_budget_ms * 1ms;
+    auto start = CoarseMonoClock::now();
+    {
+      LongOperationTracker tracker("Inline RPC handler", budget);
+      task->Run();
+    }
+    if (CoarseMonoClock::now() - start > budget) {
+      rpcs_inline_over_budget_->Increment();
+      YB_LOG_EVERY_N_SECS(WARNING, 10)
+          << LogPrefix() << "Inline handler of " << call.method_name().ToBuffer()
+          << " exceeded budget of " << MonoDelta(budget);
+    }
+    task->Done(Status::OK());
+  }
+
+  const Counter* RpcsInlineOverBudgetMetric() const {
+    return rpcs_inline_over_budget_.get();
+  }
+
   const Counter* RpcsTimedOutInQueueMetricForTests() const {
     return rpcs_timed_out_early_in_queue_.get();
   }
 
+  const Counter* RpcsShedByAdmissionControlMetric() const {
+    return rpcs_shed_by_admission_control_.get();
+  }
+
   const Counter* RpcsQueueOverflowMetric() const {
     return rpcs_queue_overflow_.get();
   }
@@ -255,6 +322,9 @@ class ServicePoolImpl final : public InboundCallHandler {
     const char* error_message;
     if (PREDICT_FALSE(incoming->ClientTimedOut())) {
       error_message = kTimedOutInQueue;
+    } else if (PREDICT_FALSE(ShouldShed(*incoming))) {
+      Shed(incoming);
+      return;
     } else if (PREDICT_FALSE(ShouldDropRequestDuringHighLoad(incoming))) {
       error_message = "The server is overloaded. Call waited in the queue past max_time_in_queue.";
     } else {
@@ -281,6 +351,34 @@ class ServicePoolImpl final : public InboundCallHandler {
     }
   }
 
+  bool ShouldShed(const InboundCall& call) {
+    if (!FLAGS_rpc_enable_admission_control) {
+      return false;
+    }
+    return admission_controller_.ShouldReject(
+        CoarseMonoClock::now(), call.GetTimeInQueue().ToSteadyDuration(),
+        service_->IsBackgroundMethod(call.method_index()),
+        FLAGS_rpc_admission_control_target_ms * 1ms,
+        FLAGS_rpc_admission_control_interval_ms * 1ms);
+  }
+
+  void Shed(const InboundCallPtr& call) {
+    if (!call->TryStartProcessing()) {
+      return;
+    }
+
+    auto retry_after = MonoDelta(admission_controller_.RetryAfter());
+    const auto err_msg = Format(
+        "$0 request on $1 from $2 shed, since the service is overloaded. "
+            "Call waited in the queue for $3.",
+        call->method_name().ToBuffer(), service_->service_name(), call->remote_address(),
+        call->GetTimeInQueue());
+    YB_LOG_EVERY_N_SECS(WARNING, 3) << LogPrefix() << err_msg;
+    TRACE_TO(call->trace(), "Shed by admission control");
+    rpcs_shed_by_admission_control_->Increment();
+    call->RespondServerTooBusy(STATUS(ServiceUnavailable, err_msg), retry_after);
+  }
+
   bool ShouldDropRequestDuringHighLoad(const InboundCallPtr& incoming) {
     CoarseTimePoint last_backpressure_at(last_backpressure_at_.load(std::memory_order_acquire));
 
@@ -409,10 +507,13 @@ class ServicePoolImpl final : public InboundCallHandler {
   scoped_refptr<Counter> rpcs_timed_out_in_queue_;
   scoped_refptr<Counter> rpcs_timed_out_early_in_queue_;
   scoped_refptr<Counter> rpcs_queue_overflow_;
+  scoped_refptr<Counter> rpcs_inline_over_budget_;
+  scoped_refptr<Counter> rpcs_shed_by_admission_control_;
   scoped_refptr<AtomicGauge<int64_t>> rpcs_in_queue_;
   // Have to use CoarseDuration here, since CoarseTimePoint does not work with clang + libstdc++
   std::atomic<CoarseDuration> last_backpressure_at_{CoarseTimePoint().time_since_epoch()};
   std::atomic<int64_t> queued_calls_{0};
+  AdmissionController admission_controller_;
 
   // It is too expensive to update timeout priority queue when each call is received.
   // So we are doing the following trick.
@@ -491,10 +592,18 @@ const Counter* ServicePool::RpcsTimedOutInQueueMetricForTests() const {
   return impl_->RpcsTimedOutInQueueMetricForTests();
 }
 
+const Counter* ServicePool::RpcsShedByAdmissionControlMetric() const {
+  return impl_->RpcsShedByAdmissionControlMetric();
+}
+
 const Counter* ServicePool::RpcsQueueOverflowMetric() const {
   return impl_->RpcsQueueOverflowMetric();
 }
 
+const Counter* ServicePool::RpcsInlineOverBudgetMetric() const {
+  return impl_->RpcsInlineOverBudgetMetric();
+}
+
 std::string ServicePool::service_name() const {
   return impl_->service_name();
 }
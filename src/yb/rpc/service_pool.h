@@ -80,6 +80,8 @@ class ServicePool : public RpcService {
   void Handle(InboundCallPtr call) override;
   const Counter* RpcsTimedOutInQueueMetricForTests() const;
   const Counter* RpcsQueueOverflowMetric() const;
+  const Counter* RpcsInlineOverBudgetMetric() const;
+  const Counter* RpcsShedByAdmissionControlMetric() const;
   std::string service_name() const;
 
   ServiceIfPtr TEST_get_service() const;
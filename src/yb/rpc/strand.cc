@@ -56,7 +56,7 @@ void Strand::Enqueue(StrandTask* task) {
 
   bool expected = false;
   if (running_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
-    thread_pool_.Enqueue(this);
+    thread_pool_.Enqueue(this, last_worker_.load(std::memory_order_relaxed));
   }
 }
 
@@ -81,6 +81,7 @@ void Strand::Run() {
 }
 
 void Strand::Done(const Status& status) {
+  last_worker_.store(thread_pool_.CurrentWorkerIndex(), std::memory_order_relaxed);
   for (;;) {
     size_t tasks_fetched = 0;
     while (StrandTask *task = queue_.Pop()) {
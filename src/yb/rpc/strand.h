@@ -71,6 +71,9 @@ class Strand : public ThreadPoolTask {
   MPSCQueue<StrandTask> queue_;
   std::atomic<bool> running_{false};
   std::atomic<bool> closing_{false};
+  // Index of the thread pool worker that last executed this strand, used to enqueue the strand to
+  // the same worker, so it is executed with warm caches.
+  std::atomic<size_t> last_worker_{ThreadPool::kAnyWorker};
 };
 
 } // namespace rpc
@@ -14,6 +14,7 @@
 #include "yb/rpc/stream.h"
 
 #include "yb/util/format.h"
+#include "yb/util/status_format.h"
 
 namespace yb {
 namespace rpc {
@@ -22,5 +23,9 @@ std::string Stream::ToString() const {
   return Format("{ local: $0 remote: $1 }", Local(), Remote());
 }
 
+Status Stream::EnableKernelTls(KernelTlsDirection direction, const KernelTlsKeys& keys) {
+  return STATUS_FORMAT(NotSupported, "Kernel TLS is not supported by $0", GetProtocol()->id());
+}
+
 }  // namespace rpc
 }  // namespace yb
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include "yb/rpc/kernel_tls.h"
 #include "yb/rpc/rpc_fwd.h"
 
 #include "yb/util/status_fwd.h"
@@ -128,6 +129,10 @@ class Stream {
 
   virtual const Protocol* GetProtocol() = 0;
 
+  // Offloads TLS record protection of the specified direction to the kernel.
+  // Supported only by streams that write data to the socket as is.
+  virtual Status EnableKernelTls(KernelTlsDirection direction, const KernelTlsKeys& keys);
+
   virtual ~Stream() {}
 
  protected:
@@ -32,12 +32,44 @@ DECLARE_uint64(rpc_connection_timeout_ms);
 DEFINE_test_flag(int32, delay_connect_ms, 0,
                  "Delay connect in tests for specified amount of milliseconds.");
 
+DEFINE_RUNTIME_bool(tcp_stream_skip_syscall_after_short_io, true,
+    "Do not repeat recv/writev after it transferred less than requested. Such a call would "
+    "just return EAGAIN, and since socket events are level triggered the reactor is notified "
+    "again when the socket becomes ready.");
+TAG_FLAG(tcp_stream_skip_syscall_after_short_io, advanced);
+
+DEFINE_NON_RUNTIME_uint64(rpc_zero_copy_send_threshold_bytes, 0,
+    "If non zero, outbound TCP writes of at least this number of bytes are sent with "
+    "MSG_ZEROCOPY, so data is not copied to the kernel socket buffers. Data is kept alive until "
+    "the kernel reports completion of the send. 0 to disable zero copy sends.");
+TAG_FLAG(rpc_zero_copy_send_threshold_bytes, advanced);
+
+DEFINE_RUNTIME_bool(rpc_coalesce_outbound_writes, false,
+    "Instead of writing to the socket each time outbound data is queued, defer the write to the "
+    "end of the current reactor loop iteration, so data queued during the iteration is sent with "
+    "as few writev calls as possible.");
+TAG_FLAG(rpc_coalesce_outbound_writes, advanced);
+
+DEFINE_RUNTIME_bool(rpc_cork_coalesced_writes, false,
+    "Set TCP_CORK while flushing coalesced outbound data, that does not fit into a single writev "
+    "call, so the kernel does not send partial segments between calls. Used only when "
+    "rpc_coalesce_outbound_writes is set.");
+TAG_FLAG(rpc_cork_coalesced_writes, advanced);
+
 METRIC_DEFINE_simple_counter(
   server, tcp_bytes_sent, "Bytes sent over TCP connections", yb::MetricUnit::kBytes);
 
 METRIC_DEFINE_simple_counter(
   server, tcp_bytes_received, "Bytes received via TCP connections", yb::MetricUnit::kBytes);
 
+METRIC_DEFINE_counter(
+  server, tcp_kernel_tls_offloads, "TLS directions offloaded to the kernel", yb::MetricUnit::kUnits,
+  "Number of connection directions whose TLS record protection was offloaded to the kernel");
+
+METRIC_DEFINE_coarse_histogram(
+  server, tcp_bytes_per_write_syscall, "Bytes sent per TCP write system call",
+  yb::MetricUnit::kBytes, "Number of bytes passed to a single writev call on TCP connections");
+
 namespace yb {
 namespace rpc {
 
@@ -56,6 +88,9 @@ TcpStream::TcpStream(const StreamCreateData& data)
   if (data.metric_entity) {
     bytes_received_counter_ = METRIC_tcp_bytes_received.Instantiate(data.metric_entity);
     bytes_sent_counter_ = METRIC_tcp_bytes_sent.Instantiate(data.metric_entity);
+    bytes_per_write_syscall_ = METRIC_tcp_bytes_per_write_syscall.Instantiate(
+        data.metric_entity);
+    kernel_tls_offloads_ = METRIC_tcp_kernel_tls_offloads.Instantiate(data.metric_entity);
   }
 }
 
@@ -78,6 +113,11 @@ Status TcpStream::Start(bool connect, ev::loop_ref* loop, StreamContext* context
   // These timeouts don't affect non-blocking sockets:
   RETURN_NOT_OK(socket_.SetSendTimeout(FLAGS_rpc_connection_timeout_ms * 1ms));
   RETURN_NOT_OK(socket_.SetRecvTimeout(FLAGS_rpc_connection_timeout_ms * 1ms));
+  if (FLAGS_rpc_zero_copy_send_threshold_bytes > 0) {
+    auto status = socket_.SetZeroCopy(true);
+    zero_copy_enabled_ = status.ok();
+    YB_LOG_IF_EVERY_N(INFO, !status.ok(), 1000) << "Zero copy sends are disabled: " << status;
+  }
 
   if (connect && FLAGS_TEST_delay_connect_ms) {
     connect_delayer_.set(*loop);
@@ -90,6 +130,19 @@ Status TcpStream::Start(bool connect, ev::loop_ref* loop, StreamContext* context
   return DoStart(loop, connect);
 }
 
+Status TcpStream::EnableKernelTls(KernelTlsDirection direction, const KernelTlsKeys& keys) {
+  RETURN_NOT_OK(rpc::EnableKernelTls(&socket_, direction, keys));
+  if (direction == KernelTlsDirection::kSend && zero_copy_enabled_) {
+    // Kernel TLS does not accept MSG_ZEROCOPY sends.
+    zero_copy_enabled_ = false;
+  }
+  if (direction == KernelTlsDirection::kReceive) {
+    kernel_tls_receive_ = true;
+  }
+  IncrementCounter(kernel_tls_offloads_);
+  return Status::OK();
+}
+
 Status TcpStream::DoStart(ev::loop_ref* loop, bool connect) {
   if (connect) {
     auto status = socket_.Connect(remote_);
@@ -107,6 +160,9 @@ Status TcpStream::DoStart(ev::loop_ref* loop, bool connect) {
   int events = ev::READ | (!connected_ ? ev::WRITE : 0);
   io_.start(socket_.GetFd(), events);
 
+  flush_watcher_.set(*loop);
+  flush_watcher_.set<TcpStream, &TcpStream::FlushHandler>(this);
+
   DVLOG_WITH_PREFIX(3) << "Starting, listen events: " << events << ", fd: " << socket_.GetFd();
 
   is_epoll_registered_ = true;
@@ -146,14 +202,37 @@ void TcpStream::Shutdown(const Status& status) {
   }
 
   io_.stop();
+  flush_watcher_.stop();
+  flush_scheduled_ = false;
   is_epoll_registered_ = false;
 
   ReadBuffer().Reset();
 
+  if (!zero_copy_sends_.empty()) {
+    WARN_NOT_OK(ProcessZeroCopyCompletions(), "Failed to process zero copy completions");
+  }
+  if (!zero_copy_sends_.empty()) {
+    // The kernel still references data of these sends. After a regular close it would keep
+    // sending them in background, reading buffers that are released below. So drop unsent data
+    // and reset the connection, that is being shut down anyway.
+    VLOG_WITH_PREFIX(3) << "Aborting connection with " << zero_copy_sends_.size()
+                        << " incomplete zero copy sends";
+    WARN_NOT_OK(socket_.SetAbortOnClose(), "Failed to abort connection on close");
+  }
   WARN_NOT_OK(socket_.Close(), "Error closing socket");
+  zero_copy_sends_.clear();
 }
 
 Status TcpStream::TryWrite() {
+  if (FLAGS_rpc_coalesce_outbound_writes && connected_ && is_epoll_registered_) {
+    // When waiting for the write event, data is sent by the write handler.
+    if (!waiting_write_ready_ && !flush_scheduled_ && !sending_.empty()) {
+      flush_watcher_.start();
+      flush_scheduled_ = true;
+    }
+    return Status::OK();
+  }
+
   auto result = DoWrite();
   if (result.ok()) {
     UpdateEvents();
@@ -161,7 +240,36 @@ Status TcpStream::TryWrite() {
   return result;
 }
 
-TcpStream::FillIovResult TcpStream::FillIov(iovec* out) {
+void TcpStream::FlushHandler(ev::prepare& watcher, int revents) { // NOLINT
+  flush_watcher_.stop();
+  flush_scheduled_ = false;
+
+  // Cork only when the data does not fit into a single writev call.
+  bool cork = false;
+  if (FLAGS_rpc_cork_coalesced_writes) {
+    size_t num_slices = 0;
+    for (const auto& data : sending_) {
+      num_slices += data.bytes.size();
+    }
+    cork = num_slices > kMaxIov && socket_.SetCork(true).ok();
+  }
+
+  auto status = DoWrite();
+  if (cork) {
+    auto uncork_status = socket_.SetCork(false);
+    if (status.ok()) {
+      status = uncork_status;
+    }
+  }
+
+  if (status.ok()) {
+    UpdateEvents();
+  } else {
+    context_->Destroy(status);
+  }
+}
+
+TcpStream::FillIovResult TcpStream::FillIov(iovec* out, ZeroCopySend* zero_copy) {
   int index = 0;
   size_t offset = send_position_;
   bool only_heartbeats = true;
@@ -176,12 +284,18 @@ TcpStream::FillIovResult TcpStream::FillIov(iovec* out) {
       data.skipped = true;
       continue;
     }
+    if (zero_copy && wrapped_data && offset < data.bytes_size()) {
+      zero_copy->data.push_back(wrapped_data);
+    }
     for (const auto& bytes : data.bytes) {
       if (offset >= bytes.size()) {
         offset -= bytes.size();
         continue;
       }
 
+      if (zero_copy) {
+        zero_copy->bytes.push_back(bytes);
+      }
       out[index].iov_base = const_cast<char*>(bytes.data()) + offset;
       out[index].iov_len = bytes.size() - offset;
       offset = 0;
@@ -207,14 +321,20 @@ Status TcpStream::DoWrite() {
   // If we weren't waiting write to be ready, we could try to write data to socket.
   while (!sending_.empty()) {
     iovec iov[kMaxIov];
-    auto fill_result = FillIov(iov);
+    ZeroCopySend zero_copy_send;
+    auto fill_result = FillIov(iov, zero_copy_enabled_ ? &zero_copy_send : nullptr);
 
     if (!fill_result.only_heartbeats) {
       context_->UpdateLastActivity();
     }
 
+    size_t requested = 0;
+    for (int i = 0; i != fill_result.len; ++i) {
+      requested += iov[i].iov_len;
+    }
+    bool zero_copy = zero_copy_enabled_ && requested >= FLAGS_rpc_zero_copy_send_threshold_bytes;
     auto result = fill_result.len != 0
-        ? socket_.Writev(iov, fill_result.len)
+        ? socket_.Writev(iov, fill_result.len, zero_copy)
         : 0;
     DVLOG_WITH_PREFIX(4) << "Queued writes " << queued_bytes_to_send_ << " bytes. Result "
                          << result << ", sending_.size(): " << sending_.size();
@@ -232,6 +352,13 @@ Status TcpStream::DoWrite() {
     context_->UpdateLastWrite();
 
     IncrementCounterBy(bytes_sent_counter_, *result);
+    if (bytes_per_write_syscall_ && fill_result.len != 0) {
+      bytes_per_write_syscall_->Increment(static_cast<int64_t>(*result));
+    }
+    if (zero_copy && fill_result.len != 0) {
+      zero_copy_send.seq = next_zero_copy_seq_++;
+      zero_copy_sends_.push_back(std::move(zero_copy_send));
+    }
 
     send_position_ += *result;
     while (!sending_.empty()) {
@@ -251,11 +378,38 @@ Status TcpStream::DoWrite() {
         context_->Transferred(data, Status::OK());
       }
     }
+
+    // Short write means that the socket send buffer is full, wait for the write event.
+    if (*result < requested && FLAGS_tcp_stream_skip_syscall_after_short_io) {
+      break;
+    }
   }
 
   return Status::OK();
 }
 
+Status TcpStream::ProcessZeroCopyCompletions() {
+  uint32_t lo, hi;
+  bool copied;
+  while (VERIFY_RESULT(socket_.ReadZeroCopyCompletion(&lo, &hi, &copied))) {
+    if (copied && zero_copy_enabled_) {
+      // Kernel could not avoid copying, e.g. for loopback, so zero copy just adds overhead.
+      VLOG_WITH_PREFIX(1) << "Disable zero copy sends, since kernel copies data";
+      zero_copy_enabled_ = false;
+    }
+    // Completions could arrive out of order, so mark sends and release them from the front.
+    for (auto& send : zero_copy_sends_) {
+      if (send.seq - lo <= hi - lo) {
+        send.completed = true;
+      }
+    }
+    while (!zero_copy_sends_.empty() && zero_copy_sends_.front().completed) {
+      zero_copy_sends_.pop_front();
+    }
+  }
+  return Status::OK();
+}
+
 void TcpStream::PopSending() {
   queued_bytes_to_send_ -= sending_.front().bytes_size();
   sending_.pop_front();
@@ -270,6 +424,12 @@ void TcpStream::Handler(ev::io& watcher, int revents) {  // NOLINT
     VLOG_WITH_PREFIX(3) << status;
   }
 
+  // Completions of zero copy sends are reported via socket error queue, that wakes up the reactor
+  // as readable and writable.
+  if (status.ok() && !zero_copy_sends_.empty()) {
+    status = ProcessZeroCopyCompletions();
+  }
+
   if (status.ok() && (revents & ev::READ)) {
     status = ReadHandler();
     if (!status.ok()) {
@@ -314,7 +474,8 @@ Status TcpStream::ReadHandler() {
   context_->UpdateLastRead();
 
   for (;;) {
-    auto received = Receive();
+    bool drained = false;
+    auto received = Receive(&drained);
     if (PREDICT_FALSE(!received.ok())) {
       if (Errno(received.status()) == ESHUTDOWN) {
         VLOG_WITH_PREFIX(1) << "Shut down by remote end.";
@@ -333,13 +494,13 @@ Status TcpStream::ReadHandler() {
     if (!continue_receiving.ok()) {
       return continue_receiving.status();
     }
-    if (!continue_receiving.get()) {
+    if (!continue_receiving.get() || drained) {
       return Status::OK();
     }
   }
 }
 
-Result<bool> TcpStream::Receive() {
+Result<bool> TcpStream::Receive(bool* drained) {
   auto iov = ReadBuffer().PrepareAppend();
   if (!iov.ok()) {
     VLOG_WITH_PREFIX(3) << "ReadBuffer().PrepareAppend() error: " << iov.status();
@@ -355,7 +516,7 @@ Result<bool> TcpStream::Receive() {
     auto global_skip_buffer = GetGlobalSkipBuffer();
     do {
       VLOG_WITH_PREFIX(3) << "inbound_bytes_to_skip_: " << inbound_bytes_to_skip_;
-      auto nread = socket_.Recv(
+      auto nread = RecvToSkipBuffer(
           global_skip_buffer.mutable_data(),
           std::min(global_skip_buffer.size(), inbound_bytes_to_skip_));
       if (!nread.ok()) {
@@ -370,7 +531,8 @@ Result<bool> TcpStream::Receive() {
     } while (inbound_bytes_to_skip_ > 0);
   }
 
-  auto nread = socket_.Recvv(iov.get_ptr());
+  auto nread = kernel_tls_receive_
+      ? KernelTlsRecvv(&socket_, iov->data(), iov->size()) : socket_.Recvv(iov.get_ptr());
   if (!nread.ok()) {
     DVLOG_WITH_PREFIX(3) << "socket_.Recvv() error: " << nread.status();
     if (nread.status().IsTryAgain()) {
@@ -382,9 +544,19 @@ Result<bool> TcpStream::Receive() {
 
   IncrementCounterBy(bytes_received_counter_, *nread);
   ReadBuffer().DataAppended(*nread);
+  // Short read means that all available data was consumed from the socket.
+  *drained = FLAGS_tcp_stream_skip_syscall_after_short_io && *nread < IoVecsFullSize(*iov);
   return *nread != 0;
 }
 
+Result<size_t> TcpStream::RecvToSkipBuffer(uint8_t* buf, size_t len) {
+  if (kernel_tls_receive_) {
+    iovec iov = {buf, len};
+    return KernelTlsRecvv(&socket_, &iov, 1);
+  }
+  return socket_.Recv(buf, len);
+}
+
 void TcpStream::ParseReceived() {
   auto result = TryProcessReceived();
   if (!result.ok()) {
@@ -24,6 +24,7 @@
 namespace yb {
 
 class Counter;
+class Histogram;
 
 namespace rpc {
 
@@ -71,6 +72,14 @@ class TcpStream : public Stream {
     bool only_heartbeats;
   };
 
+  // Data sent with MSG_ZEROCOPY, that should be kept alive until the kernel reports completion.
+  struct ZeroCopySend {
+    uint32_t seq;
+    bool completed = false;
+    TcpStreamSendingData::SendingBytes bytes;
+    std::vector<OutboundDataPtr> data;
+  };
+
   Status Start(bool connect, ev::loop_ref* loop, StreamContext* context) override;
   void Close() override;
   void Shutdown(const Status& status) override;
@@ -89,9 +98,13 @@ class TcpStream : public Stream {
     return StaticProtocol();
   }
 
+  Status EnableKernelTls(KernelTlsDirection direction, const KernelTlsKeys& keys) override;
+
   void ParseReceived() override;
 
   Status DoWrite();
+  // Writes data queued during the current reactor loop iteration, invoked before the loop blocks.
+  void FlushHandler(ev::prepare& watcher, int revents); // NOLINT
   void HandleOutcome(const Status& status, bool enqueue);
   void ClearSending(const Status& status);
 
@@ -99,14 +112,21 @@ class TcpStream : public Stream {
   Status ReadHandler();
   Status WriteHandler(bool just_connected);
 
-  Result<bool> Receive();
+  // Returns true if some data was received. Sets `drained` when it is known that there is no more
+  // data available in the socket, so next read could be skipped.
+  Result<bool> Receive(bool* drained);
+  Result<size_t> RecvToSkipBuffer(uint8_t* buf, size_t len);
   // Try to parse received data and process it.
   Result<bool> TryProcessReceived();
 
   // Updates listening events.
   void UpdateEvents();
 
-  FillIovResult FillIov(iovec* out);
+  // When `zero_copy` is specified, references to the data referenced by `out` are added to it.
+  FillIovResult FillIov(iovec* out, ZeroCopySend* zero_copy = nullptr);
+
+  // Releases data of zero copy sends, completion of which was reported by the kernel.
+  Status ProcessZeroCopyCompletions();
 
   void DelayConnectHandler(ev::timer& watcher, int revents); // NOLINT
 
@@ -134,6 +154,10 @@ class TcpStream : public Stream {
 
   ev::timer connect_delayer_;
 
+  // Started when outbound write coalescing is enabled and there is data to flush.
+  ev::prepare flush_watcher_;
+  bool flush_scheduled_ = false;
+
   // Set to true when the connection is registered on a loop.
   // This is used for a sanity check in the destructor that we are properly
   // un-registered before shutting down.
@@ -149,9 +173,21 @@ class TcpStream : public Stream {
   size_t queued_bytes_to_send_ = 0;
   size_t inbound_bytes_to_skip_ = 0;
   bool waiting_write_ready_ = false;
+
+  // Whether SO_ZEROCOPY is enabled on the socket and it is worth to use it.
+  bool zero_copy_enabled_ = false;
+  // Whether the kernel decrypts received TLS records.
+  bool kernel_tls_receive_ = false;
+  // Sequence number that kernel will assign to the next zero copy send.
+  uint32_t next_zero_copy_seq_ = 0;
+  // Zero copy sends that were not completed yet, ordered by sequence number.
+  std::deque<ZeroCopySend> zero_copy_sends_;
+
   MemTrackerPtr mem_tracker_;
   scoped_refptr<Counter> bytes_sent_counter_;
   scoped_refptr<Counter> bytes_received_counter_;
+  scoped_refptr<Histogram> bytes_per_write_syscall_;
+  scoped_refptr<Counter> kernel_tls_offloads_;
 };
 
 } // namespace rpc
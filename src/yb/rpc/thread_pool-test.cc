@@ -14,6 +14,8 @@
 //
 
 #include <atomic>
+#include <mutex>
+#include <set>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -27,6 +29,7 @@
 #include "yb/util/thread.h"
 #include "yb/util/tsan_util.h"
 
+DECLARE_bool(rpc_thread_pool_work_stealing);
 DECLARE_int32(TEST_strand_done_inject_delay_ms);
 
 using namespace std::literals;
@@ -234,6 +237,101 @@ TEST_F(ThreadPoolTest, TestShutdown) {
   }
 }
 
+// Each task enqueues its children from the worker thread, so with work stealing they are put to
+// the queue of this worker, and should be stolen by other workers.
+class FanOutTask : public ThreadPoolTask {
+ public:
+  FanOutTask(ThreadPool* pool, size_t depth, CountDownLatch* latch, std::atomic<size_t>* executed)
+      : pool_(*pool), depth_(depth), latch_(*latch), executed_(*executed) {}
+
+  static size_t TotalTasks(size_t depth) {
+    return (1ULL << (depth + 1)) - 1;
+  }
+
+ private:
+  void Run() override {
+    executed_.fetch_add(1, std::memory_order_relaxed);
+    if (depth_ == 0) {
+      return;
+    }
+    for (int i = 0; i != 2; ++i) {
+      pool_.Enqueue(new FanOutTask(&pool_, depth_ - 1, &latch_, &executed_));
+    }
+  }
+
+  void Done(const Status& status) override {
+    latch_.CountDown();
+    delete this;
+  }
+
+  ThreadPool& pool_;
+  const size_t depth_;
+  CountDownLatch& latch_;
+  std::atomic<size_t>& executed_;
+};
+
+void RunFanOut(size_t depth, size_t num_workers) {
+  ThreadPool pool(ThreadPoolOptions {
+    .name = "test",
+    .max_workers = num_workers,
+  });
+
+  const auto total_tasks = FanOutTask::TotalTasks(depth);
+  CountDownLatch latch(total_tasks);
+  std::atomic<size_t> executed(0);
+  auto start = MonoTime::Now();
+  pool.Enqueue(new FanOutTask(&pool, depth, &latch, &executed));
+  latch.Wait();
+  auto passed = MonoTime::Now() - start;
+  ASSERT_EQ(executed.load(), total_tasks);
+  LOG(INFO) << "Work stealing: " << FLAGS_rpc_thread_pool_work_stealing << ", tasks: "
+            << total_tasks << ", time: " << passed << ", tasks/s: "
+            << total_tasks / passed.ToSeconds();
+}
+
+TEST_F(ThreadPoolTest, WorkStealing) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_thread_pool_work_stealing) = true;
+  ASSERT_NO_FATALS(RunFanOut(12, 4));
+}
+
+TEST_F(ThreadPoolTest, WorkStealingShutdown) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_thread_pool_work_stealing) = true;
+  constexpr size_t kTotalTasks = 10000;
+  constexpr size_t kTotalWorkers = 4;
+  ThreadPool pool(ThreadPoolOptions {
+    .name = "test",
+    .max_workers = kTotalWorkers,
+  });
+
+  CountDownLatch latch(kTotalTasks);
+  std::vector<TestTask> tasks(kTotalTasks);
+  CountDownLatch enqueued(1);
+  // Enqueue from the worker thread, so tasks are put to the local queue of this worker.
+  pool.EnqueueFunctor([&pool, &latch, &tasks, &enqueued] {
+    ASSERT_NE(pool.CurrentWorkerIndex(), ThreadPool::kAnyWorker);
+    for (auto& task : tasks) {
+      task.SetLatch(&latch);
+      pool.Enqueue(&task);
+    }
+    enqueued.CountDown();
+  });
+  enqueued.Wait();
+  pool.Shutdown();
+  latch.Wait();
+  for (auto& task : tasks) {
+    ASSERT_TRUE(task.IsDone());
+  }
+}
+
+TEST_F(ThreadPoolTest, WorkStealingBenchmark) {
+  constexpr size_t kDepth = RegularBuildVsSanitizers(18, 14);
+  constexpr size_t kWorkers = 16;
+  for (auto work_stealing : {false, true}) {
+    ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_thread_pool_work_stealing) = work_stealing;
+    ASSERT_NO_FATALS(RunFanOut(kDepth, kWorkers));
+  }
+}
+
 TEST_F(ThreadPoolTest, TestOwns) {
   class TestTask : public ThreadPoolTask {
    public:
@@ -304,6 +402,39 @@ TEST_F(ThreadPoolTest, Strand) {
   strand.Shutdown();
 }
 
+TEST_F(ThreadPoolTest, StrandWorkStealing) {
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_rpc_thread_pool_work_stealing) = true;
+  ThreadPool pool(ThreadPoolOptions {
+    .name = "test",
+    .max_workers = kPoolTotalWorkers,
+  });
+  Strand strand(&pool);
+
+  ASSERT_EQ(pool.CurrentWorkerIndex(), ThreadPool::kAnyWorker);
+  CountDownLatch latch(kPoolMaxTasks);
+  std::atomic<int> counter(0);
+  std::mutex mutex;
+  std::set<size_t> workers;
+  for (auto i = 0; i != kPoolMaxTasks; ++i) {
+    strand.EnqueueFunctor([&pool, &counter, &latch, &mutex, &workers] {
+      ASSERT_EQ(++counter, 1);
+      auto worker = pool.CurrentWorkerIndex();
+      ASSERT_NE(worker, ThreadPool::kAnyWorker);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        workers.insert(worker);
+      }
+      std::this_thread::sleep_for(1ms);
+      ASSERT_EQ(--counter, 0);
+      latch.CountDown();
+    });
+  }
+
+  latch.Wait();
+  strand.Shutdown();
+  LOG(INFO) << "Strand executed by workers: " << AsString(workers);
+}
+
 TEST_F(ThreadPoolTest, StrandShutdown) {
   ThreadPool pool(ThreadPoolOptions {
     .name = "test",
@@ -15,16 +15,39 @@
 
 #include "yb/rpc/thread_pool.h"
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <mutex>
+#include <sstream>
 
 #include <cds/container/basket_queue.h>
 #include <cds/gc/dhp.h>
 
+#include "yb/util/errno.h"
+#include "yb/util/flags.h"
+#include "yb/util/locks.h"
+#include "yb/util/random_util.h"
 #include "yb/util/scope_exit.h"
 #include "yb/util/status_format.h"
 #include "yb/util/thread.h"
 
+DEFINE_NON_RUNTIME_bool(rpc_thread_pool_work_stealing, false,
+    "Use per worker task queues with work stealing in RPC thread pools. Tasks enqueued by a "
+    "worker, or for a strand last executed by a worker, are put to the queue of this worker. "
+    "Idle workers steal tasks from the queues of other workers.");
+TAG_FLAG(rpc_thread_pool_work_stealing, advanced);
+
+DEFINE_NON_RUNTIME_bool(rpc_thread_pool_numa_aware, false,
+    "Bind RPC thread pool workers to NUMA nodes in round robin order, and steal tasks from "
+    "workers of the same NUMA node first. Used only with rpc_thread_pool_work_stealing.");
+TAG_FLAG(rpc_thread_pool_numa_aware, advanced);
+
 namespace yb {
 namespace rpc {
 
@@ -40,16 +63,112 @@ struct ThreadPoolShare {
   TaskQueue task_queue;
   WaitingWorkers waiting_workers;
 
+  const bool work_stealing = FLAGS_rpc_thread_pool_work_stealing;
+  // Workers by index, used to steal tasks. Filled only when work stealing is enabled.
+  std::vector<std::atomic<Worker*>> workers;
+  std::atomic<size_t> num_workers{0};
+
   explicit ThreadPoolShare(ThreadPoolOptions o)
-      : options(std::move(o)) {}
+      : options(std::move(o)),
+        workers(work_stealing ? options.max_workers : 0) {}
 };
 
 namespace {
 
 const std::string kRpcThreadCategory = "rpc_thread_pool";
 
+thread_local Worker* current_worker = nullptr;
+
+// Parses list of CPUs in the format of /sys/devices/system/node/node<N>/cpulist, i.e. "0-3,8-11".
+std::vector<int> ParseCpuList(const std::string& input) {
+  std::vector<int> result;
+  std::istringstream in(input);
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    int first = 0;
+    int last = 0;
+    auto parsed = sscanf(range.c_str(), "%d-%d", &first, &last);
+    if (parsed < 1) {
+      continue;
+    }
+    if (parsed == 1) {
+      last = first;
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      result.push_back(cpu);
+    }
+  }
+  return result;
+}
+
+// Returns CPUs of each NUMA node of the machine. Empty if there is only one node.
+const std::vector<std::vector<int>>& NumaNodes() {
+  static const std::vector<std::vector<int>> result = [] {
+    std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+    for (;;) {
+      std::ifstream in(Format("/sys/devices/system/node/node$0/cpulist", nodes.size()));
+      std::string cpu_list;
+      if (!in || !std::getline(in, cpu_list)) {
+        break;
+      }
+      nodes.push_back(ParseCpuList(cpu_list));
+    }
+#endif
+    if (nodes.size() < 2) {
+      nodes.clear();
+    }
+    return nodes;
+  }();
+  return result;
+}
+
 } // namespace
 
+// Tasks of a worker, when work stealing is enabled. Both the owner and thieves take tasks in FIFO
+// order, so a worker that keeps enqueueing tasks to itself does not starve older tasks.
+class LocalTaskQueue {
+ public:
+  void Push(ThreadPoolTask* task) {
+    std::lock_guard<simple_spinlock> lock(mutex_);
+    tasks_.push_back(task);
+    size_.fetch_add(1);
+  }
+
+  bool Pop(ThreadPoolTask** task) {
+    // Thieves probe queues of all workers, so check for emptiness w/o taking the lock.
+    // Sequentially consistent, because pusher checks waiting workers after incrementing size,
+    // while waiting worker checks size after adding itself to waiting workers.
+    if (size_.load() == 0) {
+      return false;
+    }
+    std::lock_guard<simple_spinlock> lock(mutex_);
+    if (tasks_.empty()) {
+      return false;
+    }
+    *task = tasks_.front();
+    tasks_.pop_front();
+    size_.fetch_sub(1);
+    return true;
+  }
+
+ private:
+  simple_spinlock mutex_;
+  std::deque<ThreadPoolTask*> tasks_;
+  std::atomic<size_t> size_{0};
+};
+
+// How a worker looks for tasks in queues of other workers.
+enum class StealMode {
+  // Probe a few random workers, to keep stealing cheap on large pools.
+  kRandomProbes,
+  // Check all workers. Used before waiting, so no queued task is missed.
+  kAllWorkers,
+};
+
+// Number of random victims probed per pass in StealMode::kRandomProbes.
+constexpr size_t kStealProbes = 4;
+
 class Worker {
  public:
   explicit Worker(ThreadPoolShare* share)
@@ -57,14 +176,55 @@ class Worker {
   }
 
   Status Start(size_t index) {
+    index_ = index;
+    const auto& numa_nodes = NumaNodes();
+    if (share_->work_stealing && FLAGS_rpc_thread_pool_numa_aware && !numa_nodes.empty()) {
+      numa_node_ = static_cast<int>(index % numa_nodes.size());
+    }
     auto name = strings::Substitute("rpc_tp_$0_$1", share_->options.name, index);
     return yb::Thread::Create(kRpcThreadCategory, name, &Worker::Execute, this, &thread_);
   }
 
   ~Worker() {
+    Join();
+  }
+
+  void Join() {
     if (thread_) {
       thread_->Join();
+      thread_ = nullptr;
+    }
+  }
+
+  ThreadPoolShare* share() const {
+    return share_;
+  }
+
+  size_t index() const {
+    return index_;
+  }
+
+  void PushLocal(ThreadPoolTask* task) {
+    local_queue_.Push(task);
+  }
+
+  // Should be invoked after the worker thread is joined.
+  void AbortLocalTasks(const Status& status) {
+    ThreadPoolTask* task = nullptr;
+    while (local_queue_.Pop(&task)) {
+      task->Done(status);
+    }
+  }
+
+  // Wakes up the worker if it is waiting for a task. Unlike Notify, the worker is left in the
+  // waiting workers queue, so it will be notified again when popped from there.
+  bool NotifyIfWaiting() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!waiting_task_) {
+      return false;
     }
+    cond_.notify_one();
+    return true;
   }
 
   Worker(const Worker& worker) = delete;
@@ -98,6 +258,10 @@ class Worker {
   // does not have free hands (worker queue empty)
   void Execute() {
     Thread::current_thread()->SetUserData(share_);
+    current_worker = this;
+    if (numa_node_ >= 0) {
+      BindToNumaNode();
+    }
     while (!stop_requested_) {
       ThreadPoolTask* task = nullptr;
       if (PopTask(&task)) {
@@ -110,7 +274,7 @@ class Worker {
   bool PopTask(ThreadPoolTask** task) {
     // First of all we try to get already queued task, w/o locking.
     // If there is no task, so we could go to waiting state.
-    if (share_->task_queue.pop(*task)) {
+    if (TryGetTask(task)) {
       return true;
     }
     std::unique_lock<std::mutex> lock(mutex_);
@@ -126,7 +290,8 @@ class Worker {
       // the worker queue. So worker queue could be empty in this case, and nobody was notified
       // about new task. So we check there for this case. This technique is similar to
       // double check.
-      if (share_->task_queue.pop(*task)) {
+      // All workers are checked here, so a task in the queue of a busy worker is not left behind.
+      if (TryGetTask(task, StealMode::kAllWorkers)) {
         return true;
       }
 
@@ -134,13 +299,73 @@ class Worker {
 
       // Sometimes another worker could steal task before we wake up. In this case we will
       // just enqueue ourselves back.
-      if (share_->task_queue.pop(*task)) {
+      if (TryGetTask(task)) {
         return true;
       }
     }
     return false;
   }
 
+  bool TryGetTask(ThreadPoolTask** task, StealMode steal_mode = StealMode::kRandomProbes) {
+    if (!share_->work_stealing) {
+      return share_->task_queue.pop(*task);
+    }
+    return local_queue_.Pop(task) || share_->task_queue.pop(*task) || Steal(task, steal_mode);
+  }
+
+  bool Steal(ThreadPoolTask** task, StealMode steal_mode) {
+    auto num_workers = share_->num_workers.load(std::memory_order_acquire);
+    if (num_workers < 2) {
+      return false;
+    }
+    // When NUMA aware, the first pass checks workers of the same node, the second pass the others.
+    for (int pass = 0; pass != 2; ++pass) {
+      if (steal_mode == StealMode::kAllWorkers) {
+        for (size_t i = 1; i < num_workers; ++i) {
+          if (TrySteal((index_ + i) % num_workers, pass, task)) {
+            return true;
+          }
+        }
+      } else {
+        for (size_t probe = 0; probe != kStealProbes; ++probe) {
+          auto offset = RandomUniformInt<size_t>(1, num_workers - 1);
+          if (TrySteal((index_ + offset) % num_workers, pass, task)) {
+            return true;
+          }
+        }
+      }
+      if (numa_node_ < 0) {
+        break;
+      }
+    }
+    return false;
+  }
+
+  bool TrySteal(size_t victim_index, int pass, ThreadPoolTask** task) {
+    auto* victim = share_->workers[victim_index].load(std::memory_order_acquire);
+    if (!victim) {
+      return false;
+    }
+    if (numa_node_ >= 0 && (victim->numa_node_ == numa_node_) != (pass == 0)) {
+      return false;
+    }
+    return victim->local_queue_.Pop(task);
+  }
+
+  void BindToNumaNode() {
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (auto cpu : NumaNodes()[numa_node_]) {
+      CPU_SET(cpu, &cpu_set);
+    }
+    int res = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    LOG_IF(WARNING, res != 0)
+        << "Failed to bind " << Thread::current_thread()->name() << " to NUMA node "
+        << numa_node_ << ": " << ErrnoToString(res);
+#endif
+  }
+
   void AddToWaitingWorkers() {
     if (!added_to_waiting_workers_) {
       auto pushed = share_->waiting_workers.push(this);
@@ -150,6 +375,10 @@ class Worker {
   }
 
   ThreadPoolShare* share_;
+  size_t index_ = 0;
+  // NUMA node this worker is bound to, -1 if not bound.
+  int numa_node_ = -1;
+  LocalTaskQueue local_queue_;
   scoped_refptr<yb::Thread> thread_;
   std::mutex mutex_;
   std::condition_variable cond_;
@@ -172,16 +401,38 @@ class ThreadPool::Impl {
     return share_.options;
   }
 
-  bool Enqueue(ThreadPoolTask* task) {
+  size_t CurrentWorkerIndex() const {
+    auto* worker = current_worker;
+    return worker && worker->share() == &share_ ? worker->index() : ThreadPool::kAnyWorker;
+  }
+
+  bool Enqueue(ThreadPoolTask* task, size_t preferred_worker = ThreadPool::kAnyWorker) {
     ++adding_;
     if (closing_) {
       --adding_;
       task->Done(shutdown_status_);
       return false;
     }
-    bool added = share_.task_queue.push(task);
-    DCHECK(added); // BasketQueue always succeed.
     Worker* worker = nullptr;
+    if (share_.work_stealing) {
+      if (preferred_worker < share_.num_workers.load(std::memory_order_acquire)) {
+        worker = share_.workers[preferred_worker].load(std::memory_order_acquire);
+      } else if (current_worker && current_worker->share() == &share_) {
+        worker = current_worker;
+      }
+    }
+    if (worker) {
+      worker->PushLocal(task);
+      // Prefer waking up the worker that owns the queue, so the task is executed by it.
+      if (worker != current_worker && worker->NotifyIfWaiting()) {
+        --adding_;
+        return true;
+      }
+    } else {
+      bool added = share_.task_queue.push(task);
+      DCHECK(added); // BasketQueue always succeed.
+    }
+    // Wake up an idle worker, that would take the task from the shared queue or steal it.
     while (share_.waiting_workers.pop(worker)) {
       if (worker->Notify()) {
         --adding_;
@@ -198,8 +449,15 @@ class ThreadPool::Impl {
       std::lock_guard<std::mutex> lock(mutex_);
       if (!closing_) {
         auto new_worker = std::make_unique<Worker>(&share_);
-        auto status = new_worker->Start(workers_.size());
+        auto new_index = workers_.size();
+        if (share_.work_stealing) {
+          share_.workers[new_index].store(new_worker.get(), std::memory_order_release);
+        }
+        auto status = new_worker->Start(new_index);
         if (status.ok()) {
+          if (share_.work_stealing) {
+            share_.num_workers.store(new_index + 1, std::memory_order_release);
+          }
           workers_.push_back(std::move(new_worker));
         } else if (workers_.empty()) {
           LOG(FATAL) << "Unable to start first worker: " << status;
@@ -236,6 +494,15 @@ class ThreadPool::Impl {
     while (adding_ != 0) {
       std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
+    for (auto& worker : workers_) {
+      worker->Join();
+    }
+    for (auto& worker : share_.workers) {
+      worker.store(nullptr, std::memory_order_release);
+    }
+    for (auto& worker : workers_) {
+      worker->AbortLocalTasks(shutdown_status_);
+    }
     workers_.clear();
     ThreadPoolTask* task = nullptr;
     while (share_.task_queue.pop(task)) {
@@ -285,6 +552,14 @@ bool ThreadPool::Enqueue(ThreadPoolTask* task) {
   return impl_->Enqueue(task);
 }
 
+bool ThreadPool::Enqueue(ThreadPoolTask* task, size_t preferred_worker) {
+  return impl_->Enqueue(task, preferred_worker);
+}
+
+size_t ThreadPool::CurrentWorkerIndex() const {
+  return impl_->CurrentWorkerIndex();
+}
+
 void ThreadPool::Shutdown() {
   impl_->Shutdown();
 }
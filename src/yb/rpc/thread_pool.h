@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -82,6 +83,8 @@ struct ThreadPoolOptions {
 
 class ThreadPool {
  public:
+  static constexpr size_t kAnyWorker = std::numeric_limits<size_t>::max();
+
   explicit ThreadPool(ThreadPoolOptions options);
 
   template <class... Args>
@@ -99,6 +102,15 @@ class ThreadPool {
 
   bool Enqueue(ThreadPoolTask* task);
 
+  // Enqueues task preferring the worker with the specified index, see CurrentWorkerIndex.
+  // Preference is taken into account only when work stealing is enabled, and the task could still
+  // be stolen by another worker.
+  bool Enqueue(ThreadPoolTask* task, size_t preferred_worker);
+
+  // Returns index of the worker of this pool that runs the current thread, kAnyWorker if the
+  // current thread does not belong to this pool.
+  size_t CurrentWorkerIndex() const;
+
   template <class F>
   void EnqueueFunctor(const F& f) {
     Enqueue(MakeFunctorThreadPoolTask(f));
@@ -397,6 +397,21 @@ void YBInboundCall::RespondFailure(ErrorStatusPB::RpcErrorCodePB error_code,
   Respond(AnyMessageConstPtr(&err), false);
 }
 
+void YBInboundCall::RespondServerTooBusy(const Status& status, MonoDelta retry_after) {
+  TRACE_EVENT0("rpc", "InboundCall::RespondServerTooBusy");
+  ErrorStatusPB err;
+  err.set_message(status.ToString());
+  err.set_code(ErrorStatusPB::ERROR_SERVER_TOO_BUSY);
+  if (retry_after > MonoDelta::kZero) {
+    // Round up, so sub millisecond hint does not turn into immediate retry.
+    auto retry_after_ms = std::max<int64_t>(1, (retry_after.ToMicroseconds() + 999) / 1000);
+    err.set_retry_after_ms(narrow_cast<uint32_t>(
+        std::min<int64_t>(retry_after_ms, std::numeric_limits<uint32_t>::max())));
+  }
+
+  Respond(AnyMessageConstPtr(&err), false);
+}
+
 void YBInboundCall::RespondApplicationError(int error_ext_id, const std::string& message,
                                             const MessageLite& app_error_pb) {
   ErrorStatusPB err;
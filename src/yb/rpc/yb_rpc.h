@@ -161,6 +161,8 @@ class YBInboundCall : public InboundCall {
   void RespondFailure(ErrorStatusPB::RpcErrorCodePB error_code,
                       const Status &status) override;
 
+  void RespondServerTooBusy(const Status& status, MonoDelta retry_after) override;
+
   void RespondApplicationError(int error_ext_id, const std::string& message,
                                const google::protobuf::MessageLite& app_error_pb);
 
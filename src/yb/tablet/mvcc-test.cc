@@ -133,6 +133,21 @@ TEST_F(MvccTest, SafeHybridTimeToReadAt) {
   ASSERT_STR_CONTAINS(mvcc_trace, "9. SafeTime");
 }
 
+TEST_F(MvccTest, PropagatedSafeTimeReceivedAt) {
+  ASSERT_EQ(CoarseTimePoint(), manager_.PropagatedSafeTimeReceivedAt());
+
+  auto ht = clock_->Now();
+  auto before = CoarseMonoClock::now();
+  manager_.SetPropagatedSafeTimeOnFollower(ht);
+  auto received_at = manager_.PropagatedSafeTimeReceivedAt();
+  ASSERT_GE(received_at, before);
+  ASSERT_LE(received_at, CoarseMonoClock::now());
+
+  // Safe time going backwards, after leader change, does not extend the lease.
+  manager_.SetPropagatedSafeTimeOnFollower(ht.Decremented());
+  ASSERT_EQ(received_at, manager_.PropagatedSafeTimeReceivedAt());
+}
+
 TEST_F(MvccTest, Abort) {
   constexpr size_t kTotalEntries = 10;
   vector<HybridTime> hts(kTotalEntries);
@@ -431,6 +431,7 @@ void MvccManager::SetPropagatedSafeTimeOnFollower(HybridTime ht) {
     }
     if (ht >= propagated_safe_time_) {
       propagated_safe_time_ = ht;
+      propagated_safe_time_received_at_ = CoarseMonoClock::now();
     } else {
       LOG_WITH_PREFIX(WARNING)
           << "Received propagated safe time " << ht << " less than the old value: "
@@ -490,6 +491,11 @@ void MvccManager::SetLeaderOnlyMode(bool leader_only) {
   leader_only_mode_ = leader_only;
 }
 
+CoarseTimePoint MvccManager::PropagatedSafeTimeReceivedAt() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return propagated_safe_time_received_at_;
+}
+
 // NO_THREAD_SAFETY_ANALYSIS because this analysis does not work with unique_lock.
 HybridTime MvccManager::SafeTimeForFollower(
     HybridTime min_allowed, CoarseTimePoint deadline) const NO_THREAD_SAFETY_ANALYSIS {
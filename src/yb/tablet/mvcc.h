@@ -146,6 +146,13 @@ class MvccManager {
   // Returns time of last replicated operation.
   HybridTime LastReplicatedHybridTime() const EXCLUDES(mutex_);
 
+  // Returns local monotonic time when the follower last advanced its propagated safe time, i.e.
+  // received from the leader safe time that is not less than the previous one. Returns default
+  // constructed time point if safe time was never received.
+  // Time elapsed since this point is measured by the local clock only, so it is not affected by
+  // clock skew. It does not include the lag between the leader safe time and the leader clock.
+  CoarseTimePoint PropagatedSafeTimeReceivedAt() const EXCLUDES(mutex_);
+
   class MvccOpTrace;
 
   void TEST_DumpTrace(std::ostream* out);
@@ -204,6 +211,8 @@ class MvccManager {
   // leader, this is a safe time that gets updated every time the majority-replicated watermarks
   // change.
   HybridTime propagated_safe_time_ = HybridTime::kMin;
+  // Time when propagated_safe_time_ was last received from the leader, used on followers only.
+  CoarseTimePoint propagated_safe_time_received_at_;
   // Special flag for RF==1 mode when propagated_safe_time_ can be not up-to-date.
   bool leader_only_mode_ = false;
 
@@ -43,6 +43,8 @@ DEFINE_UNKNOWN_double(estimated_replicate_msg_size_percentage, 0.95,
 
 DEFINE_test_flag(int32, preparer_batch_inject_latency_ms, 0,
                  "Inject latency before replicating batch.");
+DEFINE_test_flag(bool, pause_preparer_before_replicate, false,
+                 "Pause before replicating batch while the flag is set.");
 
 DECLARE_int32(protobuf_message_total_bytes_limit);
 DECLARE_uint64(rpc_max_message_size);
@@ -374,6 +376,7 @@ void PreparerImpl::ReplicateSubBatch(
   }
 
   AtomicFlagSleepMs(&FLAGS_TEST_preparer_batch_inject_latency_ms);
+  TEST_PAUSE_IF_FLAG(TEST_pause_preparer_before_replicate);
   // Have to save this value before calling replicate batch.
   // Because the following scenario is legal:
   // Operation successfully processed by ReplicateBatch, but ReplicateBatch did not return yet.
@@ -0,0 +1,83 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+// Trains preset dictionary for the stream compression (--stream_compression_algo=4) from samples
+// of RPC traffic, for instance serialized requests of the service that dominates the traffic.
+// Each input file is used as a separate sample.
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "yb/rpc/compression_dictionary.h"
+
+#include "yb/util/env.h"
+#include "yb/util/faststring.h"
+#include "yb/util/flags.h"
+#include "yb/util/logging.h"
+#include "yb/util/status.h"
+
+using std::cerr;
+using std::endl;
+
+DEFINE_NON_RUNTIME_string(output, "", "File to write the trained dictionary to.");
+DEFINE_NON_RUNTIME_uint64(max_dict_size, yb::rpc::CompressionDictionary::kMaxSize,
+                          "Max size of the trained dictionary.");
+
+namespace yb {
+namespace rpc {
+
+Status TrainDictionary(const std::vector<std::string>& sample_files) {
+  if (FLAGS_output.empty()) {
+    return STATUS(InvalidArgument, "--output is not specified");
+  }
+
+  std::vector<faststring> contents(sample_files.size());
+  std::vector<Slice> samples;
+  for (size_t i = 0; i != sample_files.size(); ++i) {
+    RETURN_NOT_OK(ReadFileToString(Env::Default(), sample_files[i], &contents[i]));
+    samples.emplace_back(contents[i].data(), contents[i].size());
+  }
+
+  auto dictionary = TrainCompressionDictionary(
+      samples, std::min<size_t>(FLAGS_max_dict_size, CompressionDictionary::kMaxSize));
+  if (dictionary.empty()) {
+    return STATUS(IllegalState, "Samples don't have common content");
+  }
+  RETURN_NOT_OK(WriteStringToFile(Env::Default(), dictionary, FLAGS_output));
+  LOG(INFO) << "Written dictionary of " << dictionary.size() << " bytes to " << FLAGS_output
+            << ", id: " << CompressionDictionary(dictionary).id();
+  return Status::OK();
+}
+
+} // namespace rpc
+} // namespace yb
+
+int main(int argc, char **argv) {
+  yb::ParseCommandLineFlags(&argc, &argv, true);
+  yb::InitGoogleLoggingSafe(argv[0]);
+  if (argc < 3) {
+    cerr << "usage: " << argv[0] << " --output=<dictionary file> <sample file> <sample file>..."
+         << endl;
+    return 2;
+  }
+
+  Status s = yb::rpc::TrainDictionary(std::vector<std::string>(argv + 1, argv + argc));
+  if (s.ok()) {
+    return 0;
+  } else {
+    cerr << s.ToString() << endl;
+    return 1;
+  }
+}
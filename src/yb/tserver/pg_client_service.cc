@@ -13,8 +13,17 @@
 
 #include "yb/tserver/pg_client_service.h"
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 #include <mutex>
 #include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
@@ -32,25 +41,38 @@
 #include "yb/common/pg_types.h"
 #include "yb/common/wire_protocol.h"
 
+#include "yb/gutil/casts.h"
+
 #include "yb/master/master_admin.proxy.h"
 
+#include "yb/rpc/constants.h"
+#include "yb/rpc/proxy.h"
+#include "yb/rpc/remote_method.h"
 #include "yb/rpc/rpc_context.h"
 #include "yb/rpc/rpc_controller.h"
+#include "yb/rpc/rpc_header.pb.h"
 #include "yb/rpc/scheduler.h"
+#include "yb/rpc/serialization.h"
+#include "yb/rpc/sidecars.h"
 
+#include "yb/tserver/pg_client.proxy.h"
 #include "yb/tserver/pg_client_session.h"
 #include "yb/tserver/pg_create_table.h"
 #include "yb/tserver/pg_response_cache.h"
 #include "yb/tserver/pg_table_cache.h"
 #include "yb/tserver/tablet_server_interface.h"
 #include "yb/tserver/tserver_service.pb.h"
+#include "yb/tserver/tserver_shared_mem.h"
 
+#include "yb/util/errno.h"
 #include "yb/util/net/net_util.h"
+#include "yb/util/random_util.h"
 #include "yb/util/result.h"
 #include "yb/util/shared_lock.h"
 #include "yb/util/status_format.h"
 #include "yb/util/status_log.h"
 #include "yb/util/status.h"
+#include "yb/util/thread.h"
 #include "yb/util/flags.h"
 
 using namespace std::literals;
@@ -58,6 +80,8 @@ using namespace std::literals;
 DEFINE_UNKNOWN_uint64(pg_client_session_expiration_ms, 60000,
               "Pg client session expiration time in milliseconds.");
 
+DECLARE_bool(pg_client_use_shared_memory);
+
 namespace yb {
 namespace tserver {
 
@@ -109,6 +133,381 @@ using LockablePgClientSession = Lockable<PgClientSession>;
 using PgClientSessionLocker = Locker<PgClientSession>;
 using LockablePgClientSessionPtr = std::shared_ptr<LockablePgClientSession>;
 
+#ifdef __linux__
+
+// Serves Perform requests that postgres backends send through shared memory exchanges.
+// A single thread waits for notifications of all exchanges with epoll, and also receives new
+// exchanges over the unix socket. Requests are executed asynchronously as local calls of the
+// PgClientService, so they are handled exactly like requests received over the network.
+// The response is written to the exchange in the same format as it would be sent over the network,
+// so the backend could parse it using the regular RPC code.
+class PgSharedExchangeDispatcher {
+ public:
+  explicit PgSharedExchangeDispatcher(rpc::ProxyCache* proxy_cache)
+      : proxy_(proxy_cache, HostPort()),
+        socket_name_(Format(
+            "yb-pg-exchange-$0-$1", getpid(), RandomHumanReadableString(16))) {
+  }
+
+  ~PgSharedExchangeDispatcher() {
+    Shutdown();
+  }
+
+  Status Start() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == -1) {
+      return STATUS_FROM_ERRNO("epoll_create1", errno);
+    }
+    stop_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_fd_ == -1) {
+      return STATUS_FROM_ERRNO("eventfd", errno);
+    }
+    listen_fd_ = VERIFY_RESULT(ListenSharedExchange(socket_name_));
+    RETURN_NOT_OK(AddToEpoll(stop_fd_, Tag(EventKind::kStop, 0)));
+    RETURN_NOT_OK(AddToEpoll(listen_fd_, Tag(EventKind::kListen, 0)));
+    return Thread::Create(
+        "pg_client", "shared_exchange", &PgSharedExchangeDispatcher::Run, this, &thread_);
+  }
+
+  void Shutdown() {
+    if (thread_) {
+      if (eventfd_write(stop_fd_, 1) == -1) {
+        LOG(DFATAL) << "Failed to stop shared exchange dispatcher: " << ErrnoToString(errno);
+      }
+      WARN_NOT_OK(ThreadJoiner(thread_.get()).Join(), "Join shared exchange thread failed");
+      thread_ = nullptr;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto& [id, session] : sessions_) {
+        if (session.exchange) {
+          session.exchange->exchange.SignalStop();
+        }
+      }
+      sessions_.clear();
+    }
+    for (auto fd : connections_) {
+      close(fd);
+    }
+    connections_.clear();
+    for (auto* fd : {&listen_fd_, &stop_fd_, &epoll_fd_}) {
+      if (*fd != -1) {
+        close(*fd);
+        *fd = -1;
+      }
+    }
+  }
+
+  const std::string& socket_name() const {
+    return socket_name_;
+  }
+
+  // Allows the process with the specified pid to pass the exchange of the specified session.
+  void Expect(uint64_t session_id, pid_t pid, size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sessions_.emplace(session_id, Session {
+      .pid = pid,
+      .capacity = capacity,
+      .exchange = nullptr,
+    });
+  }
+
+  void Remove(uint64_t session_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(session_id);
+    if (it == sessions_.end()) {
+      return;
+    }
+    if (it->second.exchange) {
+      auto& exchange = it->second.exchange->exchange;
+      if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, exchange.notify_fd(), nullptr) == -1) {
+        LOG(WARNING) << "Failed to remove shared exchange from epoll: " << ErrnoToString(errno);
+      }
+      exchange.SignalStop();
+    }
+    sessions_.erase(it);
+  }
+
+ private:
+  enum class EventKind : uint64_t {
+    kStop,
+    kListen,
+    kConnection,
+    kSession,
+  };
+
+  static constexpr int kEventKindShift = 62;
+
+  struct Exchange {
+    explicit Exchange(SharedExchange&& exchange_) : exchange(std::move(exchange_)) {}
+
+    SharedExchange exchange;
+    // Whether the request of this exchange is being executed.
+    std::atomic<bool> busy{false};
+  };
+
+  using ExchangePtr = std::shared_ptr<Exchange>;
+
+  struct Session {
+    pid_t pid;
+    size_t capacity;
+    // Null until the exchange is received from the client.
+    ExchangePtr exchange;
+  };
+
+  struct Call {
+    explicit Call(ExchangePtr exchange_) : exchange(std::move(exchange_)) {}
+
+    ExchangePtr exchange;
+    PgPerformRequestPB req;
+    PgPerformResponsePB resp;
+    rpc::RpcController controller;
+  };
+
+  static uint64_t Tag(EventKind kind, uint64_t value) {
+    return (static_cast<uint64_t>(kind) << kEventKindShift) | value;
+  }
+
+  Status AddToEpoll(int fd, uint64_t tag) {
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = tag;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1) {
+      return STATUS_FROM_ERRNO("epoll_ctl", errno);
+    }
+    return Status::OK();
+  }
+
+  void Run() {
+    constexpr int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+    for (;;) {
+      int num_events;
+      RETRY_ON_EINTR(num_events, epoll_wait(epoll_fd_, events, kMaxEvents, -1));
+      if (num_events == -1) {
+        LOG(DFATAL) << "Shared exchange epoll_wait failed: " << ErrnoToString(errno);
+        return;
+      }
+      for (int i = 0; i != num_events; ++i) {
+        auto tag = events[i].data.u64;
+        auto value = tag & ((1ULL << kEventKindShift) - 1);
+        switch (static_cast<EventKind>(tag >> kEventKindShift)) {
+          case EventKind::kStop:
+            return;
+          case EventKind::kListen:
+            AcceptConnections();
+            break;
+          case EventKind::kConnection:
+            HandleConnection(narrow_cast<int>(value));
+            break;
+          case EventKind::kSession:
+            HandleNotification(value);
+            break;
+        }
+      }
+    }
+  }
+
+  void AcceptConnections() {
+    for (;;) {
+      int fd;
+      RETRY_ON_EINTR(fd, accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC));
+      if (fd == -1) {
+        LOG_IF(WARNING, errno != EAGAIN && errno != EWOULDBLOCK)
+            << "Failed to accept shared exchange connection: " << ErrnoToString(errno);
+        return;
+      }
+      auto status = AddToEpoll(fd, Tag(EventKind::kConnection, fd));
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to register shared exchange connection: " << status;
+        close(fd);
+        continue;
+      }
+      connections_.insert(fd);
+    }
+  }
+
+  void HandleConnection(int fd) {
+    auto received = ReceiveSharedExchange(fd);
+    if (!received.ok() && received.status().IsTryAgain()) {
+      return;
+    }
+    auto status = received.ok() ? AcceptExchange(std::move(*received)) : received.status();
+    LOG_IF(WARNING, !status.ok()) << "Rejected shared exchange: " << status;
+    WARN_NOT_OK(ReplySharedExchange(fd, status.ok()), "Failed to reply to shared exchange");
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(fd);
+  }
+
+  Status AcceptExchange(ReceivedSharedExchange received) {
+    if (received.uid != geteuid()) {
+      return STATUS_FORMAT(
+          NotAuthorized, "Shared exchange sent by user $0, while tserver runs as $1",
+          received.uid, geteuid());
+    }
+    size_t capacity;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& session = VERIFY_RESULT_REF(FindSession(received));
+      capacity = session.capacity;
+    }
+    int fd = received.fd;
+    int notify_fd = received.notify_fd;
+    received.Release();
+    auto exchange = std::make_shared<Exchange>(
+        VERIFY_RESULT(SharedExchange::Open(fd, notify_fd, capacity)));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Session could be removed or receive the exchange while it was being mapped.
+    auto& session = VERIFY_RESULT_REF(FindSession(received));
+    RETURN_NOT_OK(AddToEpoll(notify_fd, Tag(EventKind::kSession, received.session_id)));
+    session.exchange = std::move(exchange);
+    return Status::OK();
+  }
+
+  Result<Session&> FindSession(const ReceivedSharedExchange& received) REQUIRES(mutex_) {
+    auto it = sessions_.find(received.session_id);
+    if (it == sessions_.end()) {
+      return STATUS_FORMAT(NotFound, "Unknown session: $0", received.session_id);
+    }
+    if (it->second.pid != received.pid) {
+      return STATUS_FORMAT(
+          NotAuthorized, "Session $0 was created by pid $1, but exchange was sent by pid $2",
+          received.session_id, it->second.pid, received.pid);
+    }
+    if (it->second.exchange) {
+      return STATUS_FORMAT(AlreadyPresent, "Session $0 already has exchange", received.session_id);
+    }
+    return it->second;
+  }
+
+  void HandleNotification(uint64_t session_id) {
+    ExchangePtr exchange;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = sessions_.find(session_id);
+      if (it == sessions_.end() || !it->second.exchange) {
+        return;
+      }
+      exchange = it->second.exchange;
+    }
+    if (exchange->busy.exchange(true, std::memory_order_acq_rel)) {
+      return;
+    }
+    auto request = exchange->exchange.TryPoll();
+    if (!request) {
+      exchange->busy.store(false, std::memory_order_release);
+      return;
+    }
+    Execute(std::move(exchange), *request);
+  }
+
+  void Execute(ExchangePtr exchange, Slice request) {
+    static rpc::RemoteMethod method(PgClientServiceIf::static_service_name(), "Perform");
+
+    auto call = std::make_shared<Call>(std::move(exchange));
+    if (!call->req.ParseFromArray(request.data(), narrow_cast<int>(request.size()))) {
+      Complete(
+          call.get(), STATUS(Corruption, "Failed to parse Perform request from shared exchange"));
+      return;
+    }
+    call->controller.set_deadline(call->exchange->exchange.request_deadline());
+    proxy_.proxy().AsyncRequest(
+        &method, nullptr, call->req, &call->resp, &call->controller, [call] {
+      Complete(call.get(), call->controller.status());
+    });
+  }
+
+  static void Complete(Call* call, Status status) {
+    auto& exchange = call->exchange->exchange;
+    rpc::Sidecars sidecars;
+    if (status.ok()) {
+      call->controller.TransferSidecars(&sidecars);
+    }
+    // Client could send the next request as soon as it receives the response, so the exchange
+    // should be marked as ready to accept the next request before responding.
+    call->exchange->busy.store(false, std::memory_order_release);
+    if (status.ok()) {
+      status = Respond(&exchange, &call->resp, &sidecars);
+      if (status.ok()) {
+        return;
+      }
+      call->resp.Clear();
+      sidecars.Reset();
+    }
+    StatusToPB(status, call->resp.mutable_status());
+    auto respond_status = Respond(&exchange, &call->resp, &sidecars);
+    if (!respond_status.ok()) {
+      // Even the error does not fit into the exchange. Stop it, so the client fails the request
+      // and sends the next requests over the network.
+      LOG(WARNING) << "Failed to respond with " << status << " to shared exchange: "
+                   << respond_status;
+      exchange.SignalStop();
+    }
+  }
+
+  static Status Respond(
+      SharedExchange* exchange, PgPerformResponsePB* resp, rpc::Sidecars* sidecars) {
+    auto body_size = resp->ByteSizeLong();
+    rpc::ResponseHeader header;
+    header.set_call_id(0);
+    sidecars->MoveOffsetsTo(body_size, header.mutable_sidecar_offsets());
+    auto buffer = VERIFY_RESULT(rpc::SerializeRequest(
+        body_size, sidecars->size(), header, rpc::AnyMessageConstPtr(resp)));
+    // The message length prefix is not used by the parser, so it is not passed to the client.
+    Slice message(
+        buffer.udata() + rpc::kMsgLengthPrefixLength,
+        buffer.size() - rpc::kMsgLengthPrefixLength);
+    auto response_size = message.size() + sidecars->size();
+    auto* out = exchange->ResponseBuffer(response_size);
+    if (!out) {
+      return STATUS_FORMAT(
+          InvalidArgument, "Response size $0 exceeds shared exchange capacity $1",
+          response_size, exchange->capacity());
+    }
+    memcpy(out, message.data(), message.size());
+    sidecars->CopyTo(out + message.size());
+    exchange->Respond(response_size);
+    return Status::OK();
+  }
+
+  PgClientServiceProxy proxy_;
+  const std::string socket_name_;
+  int epoll_fd_ = -1;
+  int stop_fd_ = -1;
+  int listen_fd_ = -1;
+  scoped_refptr<Thread> thread_;
+
+  // Accepted connections that did not send the exchange yet. Accessed by the dispatcher thread.
+  std::unordered_set<int> connections_;
+
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, Session> sessions_ GUARDED_BY(mutex_);
+};
+
+#else
+
+class PgSharedExchangeDispatcher {
+ public:
+  explicit PgSharedExchangeDispatcher(rpc::ProxyCache* proxy_cache) {}
+
+  Status Start() {
+    return STATUS(NotSupported, "Shared exchange is supported only on Linux");
+  }
+
+  const std::string& socket_name() const {
+    static const std::string kEmpty;
+    return kEmpty;
+  }
+
+  void Expect(uint64_t session_id, pid_t pid, size_t capacity) {}
+
+  void Remove(uint64_t session_id) {}
+};
+
+#endif
+
 } // namespace
 
 template <class T>
@@ -172,7 +571,8 @@ class PgClientServiceImpl::Impl {
       TransactionPoolProvider transaction_pool_provider,
       rpc::Scheduler* scheduler,
       const XClusterSafeTimeMap* xcluster_safe_time_map,
-      MetricEntity* metric_entity)
+      MetricEntity* metric_entity,
+      rpc::ProxyCache* proxy_cache)
       : tablet_server_(tablet_server.get()),
         client_future_(client_future),
         clock_(clock),
@@ -180,7 +580,8 @@ class PgClientServiceImpl::Impl {
         table_cache_(client_future),
         check_expired_sessions_(scheduler),
         xcluster_safe_time_map_(xcluster_safe_time_map),
-        response_cache_(metric_entity) {
+        response_cache_(metric_entity, tablet_server.get().mem_tracker(), scheduler),
+        shared_exchange_dispatcher_(StartSharedExchangeDispatcher(proxy_cache)) {
     ScheduleCheckExpiredSessions(CoarseMonoClock::now());
   }
 
@@ -200,6 +601,12 @@ class PgClientServiceImpl::Impl {
         xcluster_safe_time_map_, &response_cache_);
     resp->set_session_id(session_id);
 
+    if (req.pid() && shared_exchange_dispatcher_) {
+      // The exchange itself is received by the dispatcher, that accepts it only from this pid.
+      shared_exchange_dispatcher_->Expect(session_id, req.pid(), req.shared_exchange_capacity());
+      resp->set_shared_exchange_socket(shared_exchange_dispatcher_->socket_name());
+    }
+
     std::lock_guard<rw_spinlock> lock(mutex_);
     auto it = sessions_.emplace(
         FLAGS_pg_client_session_expiration_ms * 1ms, std::move(session)).first;
@@ -450,7 +857,20 @@ class PgClientServiceImpl::Impl {
 
   void CheckExpiredSessions() {
     auto now = CoarseMonoClock::now();
-    std::lock_guard<rw_spinlock> lock(mutex_);
+    std::vector<uint64_t> expired_sessions;
+    {
+      std::lock_guard<rw_spinlock> lock(mutex_);
+      DoCheckExpiredSessions(now, &expired_sessions);
+    }
+    if (shared_exchange_dispatcher_) {
+      for (auto id : expired_sessions) {
+        shared_exchange_dispatcher_->Remove(id);
+      }
+    }
+  }
+
+  void DoCheckExpiredSessions(CoarseTimePoint now, std::vector<uint64_t>* expired_sessions)
+      REQUIRES(mutex_) {
     while (!session_expiration_queue_.empty()) {
       auto& top = session_expiration_queue_.top();
       if (top.first > now) {
@@ -465,12 +885,27 @@ class PgClientServiceImpl::Impl {
           session_expiration_queue_.push({current_expiration, id});
         } else {
           sessions_.erase(it);
+          expired_sessions->push_back(id);
         }
       }
     }
     ScheduleCheckExpiredSessions(now);
   }
 
+  static std::unique_ptr<PgSharedExchangeDispatcher> StartSharedExchangeDispatcher(
+      rpc::ProxyCache* proxy_cache) {
+    if (!proxy_cache || !FLAGS_pg_client_use_shared_memory) {
+      return nullptr;
+    }
+    auto result = std::make_unique<PgSharedExchangeDispatcher>(proxy_cache);
+    auto status = result->Start();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to start shared exchange dispatcher: " << status;
+      return nullptr;
+    }
+    return result;
+  }
+
   Status DoPerform(PgPerformRequestPB* req, PgPerformResponsePB* resp, rpc::RpcContext* context) {
     return VERIFY_RESULT(GetSession(*req))->Perform(req, resp, context);
   }
@@ -515,6 +950,8 @@ class PgClientServiceImpl::Impl {
   const XClusterSafeTimeMap* xcluster_safe_time_map_;
 
   PgResponseCache response_cache_;
+
+  std::unique_ptr<PgSharedExchangeDispatcher> shared_exchange_dispatcher_;
 };
 
 PgClientServiceImpl::PgClientServiceImpl(
@@ -524,11 +961,12 @@ PgClientServiceImpl::PgClientServiceImpl(
     TransactionPoolProvider transaction_pool_provider,
     const scoped_refptr<MetricEntity>& entity,
     rpc::Scheduler* scheduler,
-    const XClusterSafeTimeMap* xcluster_safe_time_map)
+    const XClusterSafeTimeMap* xcluster_safe_time_map,
+    rpc::ProxyCache* proxy_cache)
     : PgClientServiceIf(entity),
       impl_(new Impl(
           tablet_server, client_future, clock, std::move(transaction_pool_provider), scheduler,
-          xcluster_safe_time_map, entity.get())) {}
+          xcluster_safe_time_map, entity.get(), proxy_cache)) {}
 
 PgClientServiceImpl::~PgClientServiceImpl() = default;
 
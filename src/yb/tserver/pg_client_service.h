@@ -72,7 +72,8 @@ class PgClientServiceImpl : public PgClientServiceIf {
       TransactionPoolProvider transaction_pool_provider,
       const scoped_refptr<MetricEntity>& entity,
       rpc::Scheduler* scheduler,
-      const XClusterSafeTimeMap* xcluster_safe_time_map);
+      const XClusterSafeTimeMap* xcluster_safe_time_map,
+      rpc::ProxyCache* proxy_cache = nullptr);
 
   ~PgClientServiceImpl();
 
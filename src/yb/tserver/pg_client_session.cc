@@ -722,8 +722,9 @@ Status PgClientSession::Perform(
   PgResponseCache::Setter setter;
   auto& options = *req->mutable_options();
   if (options.has_caching_info()) {
+    auto& caching_info = *options.mutable_caching_info();
     setter = response_cache_.Get(
-        std::move(*options.mutable_caching_info()->mutable_key()), resp, context);
+        std::move(*caching_info.mutable_key()), caching_info.version(), resp, context);
     if (!setter) {
       return Status::OK();
     }
@@ -0,0 +1,233 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "yb/rpc/io_thread_pool.h"
+#include "yb/rpc/scheduler.h"
+
+#include "yb/tserver/pg_client.pb.h"
+#include "yb/tserver/pg_response_cache.h"
+
+#include "yb/util/flags.h"
+#include "yb/util/mem_tracker.h"
+#include "yb/util/metrics.h"
+#include "yb/util/test_macros.h"
+#include "yb/util/test_util.h"
+
+using namespace std::literals;
+
+METRIC_DECLARE_entity(server);
+METRIC_DECLARE_counter(pg_response_cache_queries);
+METRIC_DECLARE_counter(pg_response_cache_hits);
+METRIC_DECLARE_counter(pg_response_cache_coalesced_queries);
+METRIC_DECLARE_counter(pg_response_cache_stale_queries);
+METRIC_DECLARE_counter(pg_response_cache_evictions);
+
+DECLARE_uint64(pg_response_cache_size_bytes);
+
+namespace yb {
+namespace tserver {
+
+namespace {
+
+const std::string kKey = "key";
+
+using Results = std::vector<std::string>;
+
+PgResponseCache::Response MakeResponse(uint64_t marker) {
+  PgPerformResponsePB response;
+  response.mutable_catalog_read_time()->set_read_ht(marker);
+  return PgResponseCache::Response(std::move(response), {});
+}
+
+// Collects results passed to callbacks of the cache. Response is represented by its marker, and
+// error by its status code.
+class Receiver {
+ public:
+  PgResponseCache::CallbackFactory Factory() {
+    return [this] {
+      return [this](Result<const PgResponseCache::Response&> result) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result.ok()) {
+          results_.push_back(std::to_string(result->response.catalog_read_time().read_ht()));
+        } else {
+          results_.push_back(result.status().CodeAsString());
+        }
+      };
+    };
+  }
+
+  std::vector<std::string> results() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return results_;
+  }
+
+  size_t size() {
+    return results().size();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::string> results_;
+};
+
+} // namespace
+
+class PgResponseCacheTest : public YBTest {
+ protected:
+  void SetUp() override {
+    YBTest::SetUp();
+    pool_.emplace("test", 1);
+    scheduler_.emplace(&pool_->io_service());
+    metric_entity_ = METRIC_ENTITY_server.Instantiate(&metric_registry_, "test");
+    cache_.emplace(metric_entity_.get(), MemTracker::GetRootTracker(), &*scheduler_);
+  }
+
+  void TearDown() override {
+    cache_.reset();
+    scheduler_->Shutdown();
+    pool_->Shutdown();
+    pool_->Join();
+    YBTest::TearDown();
+  }
+
+  PgResponseCache::Setter Get(
+      uint64_t version, Receiver* receiver,
+      CoarseTimePoint deadline = CoarseTimePoint::max()) {
+    return cache_->Get(std::string(kKey), version, deadline, receiver->Factory());
+  }
+
+  int64_t CounterValue(const CounterPrototype& prototype) {
+    return prototype.Instantiate(metric_entity_)->value();
+  }
+
+  boost::optional<rpc::IoThreadPool> pool_;
+  boost::optional<rpc::Scheduler> scheduler_;
+  MetricRegistry metric_registry_;
+  scoped_refptr<MetricEntity> metric_entity_;
+  boost::optional<PgResponseCache> cache_;
+};
+
+// Identical requests that arrive while the entry is loading wait for the response of the loading
+// request.
+TEST_F(PgResponseCacheTest, Coalescing) {
+  constexpr int kWaiters = 3;
+  Receiver loader;
+  auto setter = Get(1, &loader);
+  ASSERT_TRUE(setter);
+
+  Receiver waiters;
+  for (int i = 0; i != kWaiters; ++i) {
+    ASSERT_FALSE(Get(1, &waiters));
+  }
+  ASSERT_EQ(waiters.size(), 0);
+
+  setter(MakeResponse(42), IsFailure::kFalse);
+  ASSERT_EQ(waiters.results(), Results(kWaiters, "42"));
+  ASSERT_EQ(loader.size(), 0);
+
+  // Loaded entry is served immediately.
+  Receiver hit;
+  ASSERT_FALSE(Get(1, &hit));
+  ASSERT_EQ(hit.results(), Results({"42"}));
+
+  ASSERT_EQ(CounterValue(METRIC_pg_response_cache_queries), kWaiters + 2);
+  ASSERT_EQ(CounterValue(METRIC_pg_response_cache_hits), 1);
+  ASSERT_EQ(CounterValue(METRIC_pg_response_cache_coalesced_queries), kWaiters);
+}
+
+// Request for the older catalog version is executed without caching, and does not replace the entry
+// of the newer version. Request for the newer version replaces the entry.
+TEST_F(PgResponseCacheTest, StaleVersion) {
+  Receiver receiver;
+  auto setter = Get(2, &receiver);
+  ASSERT_TRUE(setter);
+  setter(MakeResponse(2), IsFailure::kFalse);
+
+  setter = Get(1, &receiver);
+  ASSERT_TRUE(setter);
+  setter(MakeResponse(1), IsFailure::kFalse);
+  ASSERT_EQ(CounterValue(METRIC_pg_response_cache_stale_queries), 1);
+
+  ASSERT_FALSE(Get(2, &receiver));
+  ASSERT_EQ(receiver.results(), Results({"2"}));
+
+  setter = Get(3, &receiver);
+  ASSERT_TRUE(setter);
+  setter(MakeResponse(3), IsFailure::kFalse);
+  ASSERT_FALSE(Get(3, &receiver));
+  ASSERT_EQ(receiver.results(), Results({"2", "3"}));
+
+  // The newer version replaced the entry, so requests for the version 2 are stale now.
+  ASSERT_TRUE(Get(2, &receiver));
+  ASSERT_EQ(CounterValue(METRIC_pg_response_cache_stale_queries), 2);
+}
+
+// Waiters receive Aborted status when the loading request fails before producing the response, and
+// the next request loads the entry again.
+TEST_F(PgResponseCacheTest, Abort) {
+  Receiver receiver;
+  auto setter = Get(1, &receiver);
+  ASSERT_TRUE(setter);
+  ASSERT_FALSE(Get(1, &receiver));
+
+  setter = nullptr;
+  ASSERT_EQ(receiver.results(), Results({"Aborted"}));
+
+  setter = Get(1, &receiver);
+  ASSERT_TRUE(setter);
+  setter(MakeResponse(1), IsFailure::kFalse);
+  ASSERT_EQ(receiver.size(), 1);
+}
+
+// Waiter is responded at its own deadline, even though the entry is still loading.
+TEST_F(PgResponseCacheTest, WaiterDeadline) {
+  Receiver loader;
+  auto setter = Get(1, &loader);
+  ASSERT_TRUE(setter);
+
+  Receiver short_waiter;
+  auto start = CoarseMonoClock::Now();
+  ASSERT_FALSE(Get(1, &short_waiter, start + 200ms));
+  Receiver long_waiter;
+  ASSERT_FALSE(Get(1, &long_waiter, start + 1h));
+
+  ASSERT_OK(WaitFor([&short_waiter] { return short_waiter.size() != 0; }, 10s, "Waiter timeout"));
+  ASSERT_EQ(short_waiter.results(), Results({"Timed out"}));
+  ASSERT_EQ(long_waiter.size(), 0);
+
+  setter(MakeResponse(1), IsFailure::kFalse);
+  ASSERT_EQ(long_waiter.results(), Results({"1"}));
+  ASSERT_EQ(short_waiter.size(), 1);
+}
+
+// Entry that exceeds the size limit is evicted as soon as it is loaded, not at the next lookup.
+TEST_F(PgResponseCacheTest, EvictOnLoad) {
+  FLAGS_pg_response_cache_size_bytes = 1;
+  Receiver receiver;
+  auto setter = Get(1, &receiver);
+  ASSERT_TRUE(setter);
+  setter(MakeResponse(1), IsFailure::kFalse);
+  ASSERT_EQ(CounterValue(METRIC_pg_response_cache_evictions), 1);
+
+  ASSERT_TRUE(Get(1, &receiver));
+  ASSERT_EQ(CounterValue(METRIC_pg_response_cache_hits), 0);
+}
+
+}  // namespace tserver
+}  // namespace yb
@@ -13,9 +13,9 @@
 
 #include "yb/tserver/pg_response_cache.h"
 
-#include <atomic>
+#include <algorithm>
 #include <mutex>
-#include <future>
+#include <optional>
 #include <utility>
 
 #include <boost/multi_index/member.hpp>
@@ -28,6 +28,7 @@
 #include "yb/gutil/ref_counted.h"
 
 #include "yb/rpc/rpc_context.h"
+#include "yb/rpc/scheduler.h"
 #include "yb/rpc/sidecars.h"
 
 #include "yb/tserver/pg_client.pb.h"
@@ -36,6 +37,7 @@
 #include "yb/util/flags/flag_tags.h"
 #include "yb/util/logging.h"
 #include "yb/util/lru_cache.h"
+#include "yb/util/mem_tracker.h"
 #include "yb/util/metrics.h"
 #include "yb/util/write_buffer.h"
 
@@ -47,8 +49,28 @@ METRIC_DEFINE_counter(server, pg_response_cache_queries,
                       "PgClientService Response Cache QUeries",
                       yb::MetricUnit::kCacheQueries,
                       "Total number of queries to PgClientService response cache");
+METRIC_DEFINE_counter(server, pg_response_cache_coalesced_queries,
+                      "PgClientService Response Cache Coalesced Queries",
+                      yb::MetricUnit::kCacheQueries,
+                      "Total number of queries to PgClientService response cache that waited "
+                      "for the response being loaded by another query");
+METRIC_DEFINE_counter(server, pg_response_cache_stale_queries,
+                      "PgClientService Response Cache Stale Queries",
+                      yb::MetricUnit::kCacheQueries,
+                      "Total number of queries to PgClientService response cache that were "
+                      "executed without caching because of outdated catalog version");
+METRIC_DEFINE_counter(server, pg_response_cache_evictions,
+                      "PgClientService Response Cache Evictions",
+                      yb::MetricUnit::kEntries,
+                      "Total number of entries evicted from PgClientService response cache");
 DEFINE_NON_RUNTIME_uint64(
     pg_response_cache_capacity, 1024, "PgClientService response cache capacity.");
+DEFINE_RUNTIME_uint64(pg_response_cache_size_bytes, 0,
+    "Max size of responses stored in PgClientService response cache. Least recently used entries "
+    "are evicted when exceeded. 0 means that the cache is limited by the number of entries only.");
+DEFINE_RUNTIME_uint64(pg_response_cache_max_wait_ms, 5000,
+    "Max time since the start of loading of the PgClientService response cache entry, during "
+    "which identical queries wait for its result. Later queries load the entry again.");
 
 namespace yb {
 namespace tserver {
@@ -57,45 +79,198 @@ namespace {
 
 YB_DEFINE_ENUM(DataState, (kInitializing)(kInitialized)(kFailed));
 
-class Data {
+void FillResponse(PgPerformResponsePB* response,
+                  rpc::RpcContext* context,
+                  Result<const PgResponseCache::Response&> result) {
+  if (!result.ok()) {
+    StatusToPB(result.status(), response->mutable_status());
+    context->RespondSuccess();
+    return;
+  }
+  const auto& value = *result;
+  *response = value.response;
+  auto rows_data_it = value.rows_data.begin();
+  auto& sidecars = context->sidecars();
+  for (auto& op : *response->mutable_responses()) {
+    if (op.has_rows_data_sidecar()) {
+      sidecars.Start().Append(rows_data_it->AsSlice());
+      op.set_rows_data_sidecar(narrow_cast<int>(sidecars.Complete()));
+    }
+    ++rows_data_it;
+  }
+  context->RespondSuccess();
+}
+
+size_t ResponseSize(const PgResponseCache::Response& value) {
+  auto result = value.response.SpaceUsedLong();
+  for (const auto& rows_data : value.rows_data) {
+    result += rows_data.size();
+  }
+  return result;
+}
+
+class Data : public std::enable_shared_from_this<Data> {
  public:
-  explicit Data(const CoarseTimePoint& deadline)
-      : state_(DataState::kInitializing),
-        deadline_(deadline),
-        future_(promise_.get_future()) {}
+  Data(uint64_t version, const CoarseTimePoint& deadline, const MemTrackerPtr& mem_tracker,
+       rpc::Scheduler* scheduler)
+      : version_(version),
+        wait_deadline_(std::min(
+            deadline,
+            CoarseMonoClock::Now() +
+                std::chrono::milliseconds(FLAGS_pg_response_cache_max_wait_ms))),
+        mem_tracker_(mem_tracker),
+        scheduler_(scheduler) {}
 
-  const PgResponseCache::Response& Get() const {
-    return future_.get();
+  uint64_t version() const {
+    return version_;
   }
 
   void Set(PgResponseCache::Response&& value, IsFailure is_failure) {
-    auto expected = DataState::kInitializing;
-    auto exchanged = state_.compare_exchange_strong(
-        expected,
-        is_failure ? DataState::kFailed : DataState::kInitialized,
-        std::memory_order_acq_rel);
-    if (!exchanged) {
-      LOG(DFATAL) << "Unexpected state " << expected;
-      return;
+    decltype(waiters_) waiters;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (state_ != DataState::kInitializing) {
+        LOG(DFATAL) << "Unexpected state " << state_;
+        return;
+      }
+      consumption_ = ScopedTrackedConsumption(mem_tracker_, ResponseSize(value));
+      value_.emplace(std::move(value));
+      state_ = is_failure ? DataState::kFailed : DataState::kInitialized;
+      waiters.swap(waiters_);
+    }
+    for (auto& waiter : waiters) {
+      AbortTimeout(waiter);
+      waiter.callback(*value_);
+    }
+  }
+
+  // Invoked when the request that is loading the entry has failed before producing the response.
+  void Abort() {
+    decltype(waiters_) waiters;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (state_ != DataState::kInitializing) {
+        return;
+      }
+      state_ = DataState::kFailed;
+      waiters.swap(waiters_);
+    }
+    for (auto& waiter : waiters) {
+      AbortTimeout(waiter);
+      waiter.callback(AbortedStatus());
     }
-    promise_.set_value(std::move(value));
   }
 
   bool IsValid() const {
-    const auto state = state_.load(std::memory_order_acquire);
-    switch (state) {
-      case DataState::kInitializing: return CoarseMonoClock::Now() < deadline_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    switch (state_) {
+      case DataState::kInitializing: return CoarseMonoClock::Now() < wait_deadline_;
       case DataState::kInitialized: return true;
       case DataState::kFailed: return false;
     }
-    FATAL_INVALID_ENUM_VALUE(DataState, state);
+    FATAL_INVALID_ENUM_VALUE(DataState, state_);
+  }
+
+  // Passes the loaded value to the callback. If the value is not loaded yet, the callback is
+  // attached to the entry and invoked when the value is set, or when the deadline passes.
+  // Returns true in the latter case.
+  bool Respond(CoarseTimePoint deadline, const PgResponseCache::CallbackFactory& callback_factory) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (state_ == DataState::kInitializing) {
+        auto& waiter = waiters_.emplace_back(Waiter {
+          .callback = callback_factory(),
+        });
+        if (deadline != CoarseTimePoint::max()) {
+          // Scheduled task is never run synchronously, so it is safe to schedule under the lock.
+          waiter.timeout_task_id = scheduler_->Schedule(
+              [weak_self = weak_from_this()](rpc::ScheduledTaskId task_id, const Status& status) {
+                auto self = weak_self.lock();
+                if (self && status.ok()) {
+                  self->WaiterTimedOut(task_id);
+                }
+              },
+              ToSteady(deadline));
+        }
+        return true;
+      }
+    }
+    auto callback = callback_factory();
+    if (value_) {
+      callback(*value_);
+    } else {
+      callback(AbortedStatus());
+    }
+    return false;
   }
 
  private:
-  std::atomic<DataState> state_;
-  const CoarseTimePoint deadline_;
-  std::promise<PgResponseCache::Response> promise_;
-  std::shared_future<PgResponseCache::Response> future_;
+  struct Waiter {
+    PgResponseCache::Callback callback;
+    rpc::ScheduledTaskId timeout_task_id = rpc::kInvalidTaskId;
+  };
+
+  static Status AbortedStatus() {
+    return STATUS(Aborted, "Loading of the response cache entry was aborted");
+  }
+
+  void AbortTimeout(const Waiter& waiter) {
+    if (waiter.timeout_task_id != rpc::kInvalidTaskId) {
+      scheduler_->Abort(waiter.timeout_task_id);
+    }
+  }
+
+  void WaiterTimedOut(rpc::ScheduledTaskId task_id) {
+    PgResponseCache::Callback callback;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = std::find_if(waiters_.begin(), waiters_.end(), [task_id](const auto& waiter) {
+        return waiter.timeout_task_id == task_id;
+      });
+      if (it == waiters_.end()) {
+        // Already responded with the loaded value.
+        return;
+      }
+      callback = std::move(it->callback);
+      waiters_.erase(it);
+    }
+    callback(STATUS(TimedOut, "Timed out waiting for the response cache entry to be loaded"));
+  }
+
+  const uint64_t version_;
+  const CoarseTimePoint wait_deadline_;
+  const MemTrackerPtr mem_tracker_;
+  rpc::Scheduler* const scheduler_;
+  mutable std::mutex mutex_;
+  DataState state_ GUARDED_BY(mutex_) = DataState::kInitializing;
+  std::vector<Waiter> waiters_ GUARDED_BY(mutex_);
+  // Modified only once, while state is changed from kInitializing.
+  std::optional<PgResponseCache::Response> value_;
+  ScopedTrackedConsumption consumption_;
+};
+
+// Passes response to the data, or aborts loading if the response was not provided.
+class DataSetter {
+ public:
+  explicit DataSetter(std::shared_ptr<Data> data) : data_(std::move(data)) {}
+
+  ~DataSetter() {
+    if (data_) {
+      data_->Abort();
+    }
+  }
+
+  void Set(PgResponseCache::Response&& value, IsFailure is_failure) {
+    if (data_) {
+      data_->Set(std::move(value), is_failure);
+      data_.reset();
+    }
+  }
+
+ private:
+  std::shared_ptr<Data> data_;
+
+  DISALLOW_COPY_AND_ASSIGN(DataSetter);
 };
 
 struct Entry {
@@ -106,58 +281,81 @@ struct Entry {
   std::shared_ptr<Data> data;
 };
 
-void FillResponse(PgPerformResponsePB* response,
-                  rpc::RpcContext* context,
-                  const PgResponseCache::Response& value) {
-  *response = value.response;
-  auto rows_data_it = value.rows_data.begin();
-  auto& sidecars = context->sidecars();
-  for (auto& op : *response->mutable_responses()) {
-    if (op.has_rows_data_sidecar()) {
-      sidecars.Start().Append(rows_data_it->AsSlice());
-      op.set_rows_data_sidecar(narrow_cast<int>(sidecars.Complete()));
-    }
-    ++rows_data_it;
-  }
-  context->RespondSuccess();
-}
-
 } // namespace
 
 class PgResponseCache::Impl {
-  auto DoGetEntry(std::string&& key, const CoarseTimePoint& deadline) {
+  // Returns entry data and flag whether the data should be loaded by the caller.
+  // Null data is returned when the cached entry has higher version than requested.
+  auto DoGetEntry(std::string&& key, uint64_t version, const CoarseTimePoint& deadline) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto& entry = *entries_.emplace(std::move(key));
+    EvictExcessiveEntries();
+    const auto size_before = entries_.size();
+    auto& entry = const_cast<Entry&>(*entries_.emplace(std::move(key)));
+    if (!entry.data && entries_.size() == size_before) {
+      // New entry was added to the full cache, so the least recently used one was evicted.
+      IncrementCounter(evictions_);
+    }
+    if (entry.data && entry.data->version() > version) {
+      return std::make_pair(std::shared_ptr<Data>(), false);
+    }
     bool loading_required = false;
-    if (!entry.data || !entry.data->IsValid()) {
-      const_cast<Entry&>(entry).data = std::make_shared<Data>(deadline);
+    if (!entry.data || entry.data->version() < version || !entry.data->IsValid()) {
+      entry.data = std::make_shared<Data>(version, deadline, mem_tracker_, scheduler_);
       loading_required = true;
     }
     return std::make_pair(entry.data, loading_required);
   }
 
+  void EvictExcessiveEntries() REQUIRES(mutex_) {
+    const auto limit = FLAGS_pg_response_cache_size_bytes;
+    if (!limit) {
+      return;
+    }
+    while (!entries_.empty() && static_cast<uint64_t>(mem_tracker_->consumption()) > limit) {
+      entries_.pop_back();
+      IncrementCounter(evictions_);
+    }
+  }
+
  public:
-  explicit Impl(MetricEntity* metric_entity)
-      : entries_(FLAGS_pg_response_cache_capacity),
+  Impl(MetricEntity* metric_entity, const MemTrackerPtr& parent_mem_tracker,
+       rpc::Scheduler* scheduler)
+      : mem_tracker_(MemTracker::FindOrCreateTracker("PgResponseCache", parent_mem_tracker)),
+        scheduler_(scheduler),
+        entries_(FLAGS_pg_response_cache_capacity),
         queries_(METRIC_pg_response_cache_queries.Instantiate(metric_entity)),
-        hits_(METRIC_pg_response_cache_hits.Instantiate(metric_entity)) {
+        hits_(METRIC_pg_response_cache_hits.Instantiate(metric_entity)),
+        coalesced_queries_(METRIC_pg_response_cache_coalesced_queries.Instantiate(metric_entity)),
+        stale_queries_(METRIC_pg_response_cache_stale_queries.Instantiate(metric_entity)),
+        evictions_(METRIC_pg_response_cache_evictions.Instantiate(metric_entity)) {
   }
 
   PgResponseCache::Setter Get(
-      std::string&& cache_key, PgPerformResponsePB* response, rpc::RpcContext* context) {
-    auto[data, loading_required] = DoGetEntry(std::move(cache_key), context->GetClientDeadline());
+      std::string&& cache_key, uint64_t version, CoarseTimePoint deadline,
+      const CallbackFactory& callback_factory) {
+    auto[data, loading_required] = DoGetEntry(std::move(cache_key), version, deadline);
     IncrementCounter(queries_);
+    if (!data) {
+      // Response for the outdated catalog version should not replace the newer one.
+      IncrementCounter(stale_queries_);
+      return [](Response&&, IsFailure) {};
+    }
     if (!loading_required) {
-      IncrementCounter(hits_);
-      FillResponse(response, context, data->Get());
+      IncrementCounter(data->Respond(deadline, callback_factory) ? coalesced_queries_ : hits_);
       return PgResponseCache::Setter();
     }
-    return [empty_data = std::move(data)](Response&& response, IsFailure is_failure) {
-      empty_data->Set(std::move(response), is_failure);
+    return [this, setter = std::make_shared<DataSetter>(std::move(data))](
+        Response&& response, IsFailure is_failure) {
+      setter->Set(std::move(response), is_failure);
+      // Size of the entry is known only now, so the limit could be exceeded.
+      std::lock_guard<std::mutex> lock(mutex_);
+      EvictExcessiveEntries();
     };
   }
 
  private:
+  const MemTrackerPtr mem_tracker_;
+  rpc::Scheduler* const scheduler_;
   std::mutex mutex_;
   LRUCache<
       Entry,
@@ -165,17 +363,35 @@ class PgResponseCache::Impl {
   > entries_ GUARDED_BY(mutex_);
   scoped_refptr<Counter> queries_;
   scoped_refptr<Counter> hits_;
+  scoped_refptr<Counter> coalesced_queries_;
+  scoped_refptr<Counter> stale_queries_;
+  scoped_refptr<Counter> evictions_;
 };
 
-PgResponseCache::PgResponseCache(MetricEntity* metric_entity)
-    : impl_(new Impl(metric_entity)) {
+PgResponseCache::PgResponseCache(
+    MetricEntity* metric_entity, const MemTrackerPtr& parent_mem_tracker,
+    rpc::Scheduler* scheduler)
+    : impl_(new Impl(metric_entity, parent_mem_tracker, scheduler)) {
 }
 
 PgResponseCache::~PgResponseCache() = default;
 
 PgResponseCache::Setter PgResponseCache::Get(
-    std::string&& cache_key, PgPerformResponsePB* response, rpc::RpcContext* context) {
-  return impl_->Get(std::move(cache_key), response, context);
+    std::string&& cache_key, uint64_t version, CoarseTimePoint deadline,
+    const CallbackFactory& callback_factory) {
+  return impl_->Get(std::move(cache_key), version, deadline, callback_factory);
+}
+
+PgResponseCache::Setter PgResponseCache::Get(
+    std::string&& cache_key, uint64_t version, PgPerformResponsePB* response,
+    rpc::RpcContext* context) {
+  return impl_->Get(
+      std::move(cache_key), version, context->GetClientDeadline(), [response, context] {
+    return [response, context = std::make_shared<rpc::RpcContext>(std::move(*context))](
+        Result<const Response&> result) {
+      FillResponse(response, context.get(), result);
+    };
+  });
 }
 
 } // namespace tserver
@@ -26,12 +26,13 @@
 #include "yb/tserver/pg_client_session.h"
 #include "yb/tserver/tserver_fwd.h"
 
-#include "yb/util/ref_cnt_buffer.h"
-
 #include "yb/util/monotime.h"
+#include "yb/util/ref_cnt_buffer.h"
+#include "yb/util/result.h"
 
 namespace yb {
 
+class MemTracker;
 class MetricEntity;
 
 namespace tserver {
@@ -40,7 +41,9 @@ YB_STRONGLY_TYPED_BOOL(IsFailure);
 
 class PgResponseCache {
  public:
-  explicit PgResponseCache(MetricEntity* metric_entity);
+  PgResponseCache(
+      MetricEntity* metric_entity, const std::shared_ptr<MemTracker>& parent_mem_tracker,
+      rpc::Scheduler* scheduler);
   ~PgResponseCache();
 
   struct Response {
@@ -55,7 +58,28 @@ class PgResponseCache {
 
   using Setter = std::function<void(Response&&, IsFailure)>;
 
-  Setter Get(std::string&& cache_key, PgPerformResponsePB* response, rpc::RpcContext* context);
+  // Receives the cached response, or the error when the loading of the entry was aborted, or the
+  // request deadline passed before the entry was loaded.
+  using Callback = std::function<void(Result<const Response&>)>;
+  using CallbackFactory = std::function<Callback()>;
+
+  // Looks up the response for the request identified by cache_key, that was built for the
+  // specified catalog version.
+  // Returns empty setter when the response was served from the cache, or when the request was
+  // attached to the loading of the same entry initiated by another request. In these cases the
+  // callback obtained from callback_factory is invoked with the response, in the latter case not
+  // later than the deadline.
+  // Otherwise callback_factory is not invoked, the request should be executed and its response
+  // passed to the returned setter.
+  Setter Get(
+      std::string&& cache_key, uint64_t version, CoarseTimePoint deadline,
+      const CallbackFactory& callback_factory);
+
+  // The same as above, but responds to the RPC. The context is moved when the request is served
+  // by the cache.
+  Setter Get(
+      std::string&& cache_key, uint64_t version, PgPerformResponsePB* response,
+      rpc::RpcContext* context);
 
  private:
   class Impl;
@@ -44,6 +44,12 @@ DEFINE_RUNTIME_uint64(max_stale_read_bound_time_ms, 60000,
     "far behind this follower is.");
 TAG_FLAG(max_stale_read_bound_time_ms, evolving);
 
+DEFINE_RUNTIME_uint64(follower_read_safe_time_lease_ms, 0,
+    "If non zero, a follower serves reads only if it received safe time from the leader within "
+    "this interval. Staleness is measured with the local monotonic clock, so the bound holds "
+    "regardless of clock skew between the leader and the follower.");
+TAG_FLAG(follower_read_safe_time_lease_ms, evolving);
+
 DEFINE_RUNTIME_uint64(sst_files_soft_limit, 24,
     "When majority SST files number is greater that this limit, we will start rejecting "
     "part of write requests. The higher the number of SST files, the higher probability "
@@ -341,6 +347,19 @@ Result<std::shared_ptr<tablet::AbstractTablet>> GetTablet(
     // Peer is not the leader, so check that the time since it last heard from the leader is less
     // than FLAGS_max_stale_read_bound_time_ms.
     if (PREDICT_FALSE(!s.ok())) {
+      if (FLAGS_follower_read_safe_time_lease_ms > 0) {
+        auto tablet = VERIFY_RESULT(tablet_peer->shared_tablet_safe());
+        auto since_safe_time_received =
+            CoarseMonoClock::now() - tablet->mvcc_manager()->PropagatedSafeTimeReceivedAt();
+        if (since_safe_time_received >
+                std::chrono::milliseconds(FLAGS_follower_read_safe_time_lease_ms)) {
+          VLOG(1) << "Rejecting follower read, safe time was not received for "
+                  << MonoDelta(since_safe_time_received);
+          return STATUS(
+              IllegalState, "Follower safe time lease expired",
+              TabletServerError(TabletServerErrorPB::STALE_FOLLOWER));
+        }
+      }
       if (FLAGS_max_stale_read_bound_time_ms > 0) {
         auto consensus = tablet_peer->shared_consensus();
         // TODO(hector): This safe time could be reused by the read operation.
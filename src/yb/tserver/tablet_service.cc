@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <glog/logging.h>
@@ -110,6 +111,7 @@
 #include "yb/util/status_fwd.h"
 #include "yb/util/status_log.h"
 #include "yb/util/string_util.h"
+#include "yb/util/threadpool.h"
 #include "yb/util/trace.h"
 #include "yb/util/write_buffer.h"
 
@@ -1843,9 +1845,11 @@ void TabletServiceImpl::Read(const ReadRequestPB* req,
 }
 
 ConsensusServiceImpl::ConsensusServiceImpl(const scoped_refptr<MetricEntity>& metric_entity,
-                                           TabletPeerLookupIf* tablet_manager)
+                                           TabletPeerLookupIf* tablet_manager,
+                                           ThreadPool* update_pool)
     : ConsensusServiceIf(metric_entity),
-      tablet_manager_(tablet_manager) {
+      tablet_manager_(tablet_manager),
+      update_pool_(update_pool) {
 }
 
 ConsensusServiceImpl::~ConsensusServiceImpl() {
@@ -1862,60 +1866,91 @@ void ConsensusServiceImpl::CompleteUpdateConsensusResponse(
 }
 
 void ConsensusServiceImpl::MultiRaftUpdateConsensus(
-      const consensus::MultiRaftConsensusRequestPB *req,
-      consensus::MultiRaftConsensusResponsePB *resp,
-      rpc::RpcContext context) {
-    DVLOG(3) << "Received Batch Consensus Update RPC: " << req->ShortDebugString();
-    // Effectively performs ConsensusServiceImpl::UpdateConsensus for
-    // each ConsensusRequestPB in the batch but does not fail the entire
-    // batch if a single request fails.
-    for (int i = 0; i < req->consensus_request_size(); i++) {
-      // Unfortunately, we have to use const_cast here,
-      // because the protobuf-generated interface only gives us a const request
-      // but we need to be able to move messages out of the request for efficiency.
-      auto consensus_req = const_cast<ConsensusRequestPB*>(&req->consensus_request(i));
-      auto consensus_resp = resp->add_consensus_response();;
-
-      auto uuid_match_res = CheckUuidMatch(tablet_manager_, "UpdateConsensus", consensus_req,
-                                           context.requestor_string());
-      if (!uuid_match_res.ok()) {
-        SetupError(consensus_resp->mutable_error(), uuid_match_res.status());
-        continue;
+    const consensus::LWMultiRaftConsensusRequestPB* req,
+    consensus::LWMultiRaftConsensusResponsePB* resp,
+    rpc::RpcContext context) {
+  DVLOG(3) << "Received Batch Consensus Update RPC: " << req->ShortDebugString();
+  // Effectively performs ConsensusServiceImpl::UpdateConsensus for each ConsensusRequestPB in the
+  // batch but does not fail the entire batch if a single request fails.
+  // Requests of different tablets are applied in parallel, so a tablet that is slow to append its
+  // operations does not delay other tablets of the batch. Requests of the same tablet are applied
+  // one by one in the batch order, otherwise they could be reordered.
+  using Update = std::pair<consensus::LWConsensusRequestPB*, consensus::LWConsensusResponsePB*>;
+  std::vector<std::vector<Update>> tablet_updates;
+  std::unordered_map<Slice, size_t, Slice::Hash> tablet_idx;
+  for (const auto& consensus_req : req->consensus_request()) {
+    auto it = tablet_idx.emplace(consensus_req.tablet_id(), tablet_updates.size()).first;
+    if (it->second == tablet_updates.size()) {
+      tablet_updates.emplace_back();
+    }
+    // Unfortunately, we have to use const_cast here, because the protobuf-generated interface only
+    // gives us a const request, but we need to be able to move messages out of the request for
+    // efficiency.
+    tablet_updates[it->second].emplace_back(
+        const_cast<consensus::LWConsensusRequestPB*>(&consensus_req),
+        resp->add_consensus_response());
+  }
+
+  auto shared_context = std::make_shared<rpc::RpcContext>(std::move(context));
+  // The service thread holds one extra reference, so response is sent after all tasks are at least
+  // submitted.
+  auto pending = std::make_shared<std::atomic<size_t>>(tablet_updates.size() + 1);
+  auto complete = [shared_context, pending] {
+    if (pending->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      shared_context->RespondSuccess();
+    }
+  };
+  for (size_t i = 0; i != tablet_updates.size(); ++i) {
+    auto task = [this, updates = std::move(tablet_updates[i]), shared_context, complete] {
+      for (const auto& update : updates) {
+        UpdateConsensusInBatch(update.first, update.second, *shared_context);
       }
+      complete();
+    };
+    // Requests of the last tablet are applied by the service thread itself.
+    if (!update_pool_ || i + 1 == tablet_updates.size() || !update_pool_->SubmitFunc(task).ok()) {
+      task();
+    }
+  }
+  complete();
+}
 
-      auto peer_tablet_res = LookupTabletPeer(tablet_manager_, consensus_req->tablet_id());
-      if (!peer_tablet_res.ok()) {
-        SetupError(consensus_resp->mutable_error(), peer_tablet_res.status());
-        continue;
-      }
-      auto tablet_peer = peer_tablet_res.get().tablet_peer;
+void ConsensusServiceImpl::UpdateConsensusInBatch(
+    consensus::LWConsensusRequestPB* req, consensus::LWConsensusResponsePB* resp,
+    const rpc::RpcContext& context) {
+  auto uuid_match_res = CheckUuidMatch(
+      tablet_manager_, "UpdateConsensus", req, context.requestor_string());
+  if (!uuid_match_res.ok()) {
+    SetupError(resp->mutable_error(), uuid_match_res.status());
+    return;
+  }
 
-      // Submit the update directly to the TabletPeer's Consensus instance.
-      auto consensus_res = GetConsensus(tablet_peer);
-      if (!consensus_res.ok()) {
-        SetupError(consensus_resp->mutable_error(), consensus_res.status());
-        continue;
-      }
-      auto consensus = *consensus_res;
-
-      // TODO(lw_uc) effective update for multiraft.
-      auto temp_resp = rpc::MakeSharedMessage<consensus::LWConsensusResponsePB>();
-      Status s = consensus->Update(
-         rpc::CopySharedMessage(*consensus_req),
-         temp_resp.get(), context.GetClientDeadline());
-      if (PREDICT_FALSE(!s.ok())) {
-        // Clear the response first, since a partially-filled response could
-        // result in confusing a caller, or in having missing required fields
-        // in embedded optional messages.
-        consensus_resp->Clear();
-        SetupError(consensus_resp->mutable_error(), s);
-        continue;
-      }
+  auto peer_tablet_res = LookupTabletPeer(tablet_manager_, req->tablet_id());
+  if (!peer_tablet_res.ok()) {
+    SetupError(resp->mutable_error(), peer_tablet_res.status());
+    return;
+  }
+  auto tablet_peer = peer_tablet_res->tablet_peer;
 
-      CompleteUpdateConsensusResponse(tablet_peer, temp_resp.get());
-      temp_resp->ToGoogleProtobuf(consensus_resp);
-    }
-    context.RespondSuccess();
+  // Submit the update directly to the TabletPeer's Consensus instance.
+  auto consensus_res = GetConsensus(tablet_peer);
+  if (!consensus_res.ok()) {
+    SetupError(resp->mutable_error(), consensus_res.status());
+    return;
+  }
+
+  Status s = (**consensus_res).Update(
+      rpc::SharedField(context.shared_params(), req), resp, context.GetClientDeadline());
+  if (PREDICT_FALSE(!s.ok())) {
+    // Clear the response first, since a partially-filled response could
+    // result in confusing a caller, or in having missing required fields
+    // in embedded optional messages.
+    resp->Clear();
+    SetupError(resp->mutable_error(), s);
+    return;
+  }
+
+  CompleteUpdateConsensusResponse(tablet_peer, resp);
 }
 
 void ConsensusServiceImpl::UpdateConsensus(const consensus::LWConsensusRequestPB* req,
@@ -61,6 +61,7 @@ namespace yb {
 class Schema;
 class Status;
 class HybridTime;
+class ThreadPool;
 
 namespace tserver {
 
@@ -288,8 +289,11 @@ class TabletServiceAdminImpl : public TabletServerAdminServiceIf {
 
 class ConsensusServiceImpl : public consensus::ConsensusServiceIf {
  public:
+  // Requests of different tablets in MultiRaftUpdateConsensus are applied in parallel using
+  // update_pool. When it is null, they are applied one by one.
   ConsensusServiceImpl(const scoped_refptr<MetricEntity>& metric_entity,
-                       TabletPeerLookupIf* tablet_manager_);
+                       TabletPeerLookupIf* tablet_manager_,
+                       ThreadPool* update_pool = nullptr);
 
   virtual ~ConsensusServiceImpl();
 
@@ -297,8 +301,8 @@ class ConsensusServiceImpl : public consensus::ConsensusServiceIf {
                        consensus::LWConsensusResponsePB *resp,
                        rpc::RpcContext context) override;
 
-  void MultiRaftUpdateConsensus(const consensus::MultiRaftConsensusRequestPB *req,
-                                consensus::MultiRaftConsensusResponsePB *resp,
+  void MultiRaftUpdateConsensus(const consensus::LWMultiRaftConsensusRequestPB *req,
+                                consensus::LWMultiRaftConsensusResponsePB *resp,
                                 rpc::RpcContext context) override;
 
   void RequestConsensusVote(const consensus::VoteRequestPB* req,
@@ -344,7 +348,14 @@ class ConsensusServiceImpl : public consensus::ConsensusServiceIf {
  private:
   void CompleteUpdateConsensusResponse(std::shared_ptr<tablet::TabletPeer> tablet_peer,
                                        consensus::LWConsensusResponsePB* resp);
+
+  // Applies single request of MultiRaftUpdateConsensus batch.
+  void UpdateConsensusInBatch(consensus::LWConsensusRequestPB* req,
+                              consensus::LWConsensusResponsePB* resp,
+                              const rpc::RpcContext& context);
+
   TabletPeerLookupIf* tablet_manager_;
+  ThreadPool* update_pool_;
 };
 
 }  // namespace tserver
@@ -407,6 +407,12 @@ TSTabletManager::TSTabletManager(FsManager* fs_manager,
                .set_min_threads(1)
                .unlimited_threads()
                .Build(&raft_pool_));
+  // Applies requests of different tablets from a single MultiRaftUpdateConsensus batch. Separate
+  // from raft_pool_, since consensus updates block and would delay tasks of the leader peers.
+  CHECK_OK(ThreadPoolBuilder("multi-raft-update")
+               .set_min_threads(1)
+               .unlimited_threads()
+               .Build(&multi_raft_update_pool_));
   CHECK_OK(ThreadPoolBuilder("log-sync")
                .set_min_threads(1)
                .unlimited_threads()
@@ -1745,6 +1751,9 @@ void TSTabletManager::CompleteShutdown() {
   if (raft_pool_) {
     raft_pool_->Shutdown();
   }
+  if (multi_raft_update_pool_) {
+    multi_raft_update_pool_->Shutdown();
+  }
   if (log_sync_pool_) {
     log_sync_pool_->Shutdown();
   }
@@ -0,0 +1,215 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "yb/tserver/tserver_shared_mem.h"
+
+#include "yb/util/random_util.h"
+#include "yb/util/result.h"
+#include "yb/util/scope_exit.h"
+#include "yb/util/status_log.h"
+#include "yb/util/test_macros.h"
+#include "yb/util/test_util.h"
+
+using namespace std::literals;
+
+namespace yb {
+namespace tserver {
+
+namespace {
+
+constexpr uint64_t kSessionId = 42;
+
+Status WaitReadable(int fd) {
+  pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+  if (poll(&pfd, 1, 10000) != 1) {
+    return STATUS(TimedOut, "Timed out waiting for socket");
+  }
+  return Status::OK();
+}
+
+Result<ReceivedSharedExchange> ReceiveOnListeningSocket(int listen_fd) {
+  RETURN_NOT_OK(WaitReadable(listen_fd));
+  int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  SCHECK_NE(fd, -1, IOError, "Accept failed");
+  auto se = ScopeExit([fd] {
+    close(fd);
+  });
+  RETURN_NOT_OK(WaitReadable(fd));
+  auto result = VERIFY_RESULT(ReceiveSharedExchange(fd));
+  RETURN_NOT_OK(ReplySharedExchange(fd, true));
+  return result;
+}
+
+// Passes the client exchange through the unix socket, as pggate does, and returns the exchange
+// received on the other side.
+Result<SharedExchange> TransferExchange(
+    const SharedExchange& client, size_t capacity, ReceivedSharedExchange* info = nullptr) {
+  auto name = "yb-test-exchange-" + RandomHumanReadableString(16);
+  int listen_fd = VERIFY_RESULT(ListenSharedExchange(name));
+  auto se = ScopeExit([listen_fd] {
+    close(listen_fd);
+  });
+
+  Status send_status;
+  std::thread sender([&name, &client, &send_status] {
+    send_status = SendSharedExchange(name, kSessionId, client, CoarseMonoClock::now() + 10s);
+  });
+
+  auto received = ReceiveOnListeningSocket(listen_fd);
+  sender.join();
+  RETURN_NOT_OK(send_status);
+  RETURN_NOT_OK(received);
+  if (info) {
+    info->session_id = received->session_id;
+    info->pid = received->pid;
+    info->uid = received->uid;
+  }
+  int exchange_fd = received->fd;
+  int notify_fd = received->notify_fd;
+  received->Release();
+  return SharedExchange::Open(exchange_fd, notify_fd, capacity);
+}
+
+} // namespace
+
+class SharedExchangeTest : public YBTest {};
+
+TEST_F(SharedExchangeTest, Handshake) {
+  auto client = ASSERT_RESULT(SharedExchange::Create(16));
+  ReceivedSharedExchange info;
+  auto server = ASSERT_RESULT(TransferExchange(client, 16, &info));
+  ASSERT_EQ(info.session_id, kSessionId);
+  // Credentials are provided by the kernel.
+  ASSERT_EQ(info.pid, getpid());
+  ASSERT_EQ(info.uid, geteuid());
+  ASSERT_NE(server.fd(), client.fd());
+}
+
+TEST_F(SharedExchangeTest, OpenValidatesSize) {
+  auto client = ASSERT_RESULT(SharedExchange::Create(16));
+  // Capacity claimed by the client exceeds the actual size of the shared memory file.
+  auto result = SharedExchange::Open(dup(client.fd()), dup(client.notify_fd()), 1024 * 1024);
+  ASSERT_NOK(result);
+  ASSERT_TRUE(result.status().IsInvalidArgument()) << result.status();
+  ASSERT_RESULT(SharedExchange::Open(dup(client.fd()), dup(client.notify_fd()), 16));
+}
+
+TEST_F(SharedExchangeTest, TryPoll) {
+  auto client = ASSERT_RESULT(SharedExchange::Create(16));
+  auto server = ASSERT_RESULT(TransferExchange(client, 16));
+  ASSERT_FALSE(server.TryPoll());
+
+  auto* out = client.Obtain(3);
+  ASSERT_NE(out, nullptr);
+  memcpy(out, "abc", 3);
+  client.SendRequest(3, CoarseMonoClock::now() + 10s);
+  // The server is notified through the eventfd, so it does not have to wait on the futex.
+  ASSERT_OK(WaitReadable(server.notify_fd()));
+  auto request = server.TryPoll();
+  ASSERT_TRUE(request);
+  ASSERT_EQ(request->ToBuffer(), "abc");
+
+  // The response to the pending request was not fetched yet.
+  ASSERT_EQ(client.Obtain(1), nullptr);
+  server.Respond(0);
+  ASSERT_OK(client.FetchResponse(CoarseMonoClock::now() + 10s));
+  ASSERT_NE(client.Obtain(1), nullptr);
+}
+
+TEST_F(SharedExchangeTest, RequestResponse) {
+  constexpr size_t kCapacity = 1024;
+  constexpr int kNumRequests = 100;
+
+  auto client = ASSERT_RESULT(SharedExchange::Create(kCapacity));
+  auto server = ASSERT_RESULT(TransferExchange(client, kCapacity));
+
+  std::thread server_thread([&server] {
+    for (;;) {
+      auto request = server.Poll();
+      if (!request.ok()) {
+        ASSERT_TRUE(request.status().IsShutdownInProgress()) << request.status();
+        break;
+      }
+      // Respond with the reversed request.
+      std::string response(request->cdata(), request->size());
+      std::reverse(response.begin(), response.end());
+      auto* out = server.ResponseBuffer(response.size());
+      ASSERT_NE(out, nullptr);
+      memcpy(out, response.data(), response.size());
+      server.Respond(response.size());
+    }
+  });
+
+  for (int i = 0; i != kNumRequests; ++i) {
+    auto request = Format("request_$0", i);
+    auto* out = client.Obtain(request.size());
+    ASSERT_NE(out, nullptr);
+    memcpy(out, request.data(), request.size());
+    client.SendRequest(request.size(), CoarseMonoClock::now() + 10s);
+    auto response = ASSERT_RESULT(client.FetchResponse(CoarseMonoClock::now() + 10s));
+    std::reverse(request.begin(), request.end());
+    ASSERT_EQ(response.ToBuffer(), request);
+  }
+
+  ASSERT_EQ(client.Obtain(kCapacity + 1), nullptr);
+
+  server.SignalStop();
+  server_thread.join();
+  ASSERT_EQ(client.Obtain(1), nullptr);
+  ASSERT_EQ(client.state(), SharedExchangeState::kShutdown);
+}
+
+TEST_F(SharedExchangeTest, Timeout) {
+  auto client = ASSERT_RESULT(SharedExchange::Create(16));
+  auto server = ASSERT_RESULT(TransferExchange(client, 16));
+
+  ASSERT_NE(client.Obtain(1), nullptr);
+  auto deadline = CoarseMonoClock::now() + 50ms;
+  client.SendRequest(1, deadline);
+  auto response = client.FetchResponse(deadline);
+  ASSERT_TRUE(response.status().IsTimedOut()) << response.status();
+
+  // Exchange could not be used until the server responds to the pending request.
+  ASSERT_EQ(client.Obtain(1), nullptr);
+  ASSERT_RESULT(server.Poll());
+  ASSERT_EQ(server.request_deadline(), deadline);
+  server.Respond(0);
+  ASSERT_NE(client.Obtain(1), nullptr);
+}
+
+TEST_F(SharedExchangeTest, DropResponse) {
+  auto client = ASSERT_RESULT(SharedExchange::Create(16));
+  auto server = ASSERT_RESULT(TransferExchange(client, 16));
+
+  ASSERT_NE(client.Obtain(1), nullptr);
+  client.SendRequest(1, CoarseMonoClock::now() + 10s);
+  client.DropResponse();
+
+  // Exchange could not be used until the server responds to the dropped request.
+  ASSERT_EQ(client.Obtain(1), nullptr);
+  ASSERT_RESULT(server.Poll());
+  server.Respond(0);
+  ASSERT_NE(client.Obtain(1), nullptr);
+}
+
+} // namespace tserver
+} // namespace yb
@@ -0,0 +1,481 @@
+// Copyright (c) YugaByte, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except
+// in compliance with the License.  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.  See the License for the specific language governing permissions and limitations
+// under the License.
+//
+
+#include "yb/tserver/tserver_shared_mem.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#endif
+
+#include <thread>
+#include <vector>
+
+#include "yb/gutil/casts.h"
+#include "yb/gutil/linux_syscall_support.h"
+
+#include "yb/util/cast.h"
+#include "yb/util/errno.h"
+#include "yb/util/scope_exit.h"
+#include "yb/util/status_format.h"
+
+using namespace std::literals;
+
+namespace yb {
+namespace tserver {
+
+struct SharedExchange::Header {
+  std::atomic<uint32_t> state{to_underlying(SharedExchangeState::kIdle)};
+  uint64_t data_size = 0;
+  // Both processes run on the same host, so the monotonic clock is shared between them.
+  CoarseTimePoint::rep deadline = 0;
+};
+
+SharedExchange::SharedExchange(SharedMemorySegment&& segment, int notify_fd, size_t capacity)
+    : segment_(std::move(segment)), notify_fd_(notify_fd), capacity_(capacity) {
+}
+
+SharedExchange::SharedExchange(SharedExchange&& rhs)
+    : segment_(std::move(rhs.segment_)), notify_fd_(rhs.notify_fd_), capacity_(rhs.capacity_),
+      awaiting_response_(rhs.awaiting_response_) {
+  rhs.notify_fd_ = -1;
+}
+
+SharedExchange::~SharedExchange() {
+  if (notify_fd_ != -1) {
+    close(notify_fd_);
+  }
+}
+
+Result<SharedExchange> SharedExchange::Create(size_t capacity) {
+  int notify_fd = -1;
+#ifdef __linux__
+  notify_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (notify_fd == -1) {
+    return STATUS_FROM_ERRNO("eventfd", errno);
+  }
+#endif
+  auto segment = SharedMemorySegment::Create(sizeof(Header) + capacity);
+  if (!segment.ok()) {
+    if (notify_fd != -1) {
+      close(notify_fd);
+    }
+    return segment.status();
+  }
+  SharedExchange result(std::move(*segment), notify_fd, capacity);
+  auto* header = new (DCHECK_NOTNULL(result.segment_.GetAddress())) Header;
+  LOG_IF(FATAL, !IsAcceptableAtomicImpl(header->state))
+      << "Shared memory atomics must be lock-free";
+  return result;
+}
+
+Result<SharedExchange> SharedExchange::Open(int fd, int notify_fd, size_t capacity) {
+  bool auto_close_fds = true;
+  auto se = ScopeExit([fd, notify_fd, &auto_close_fds] {
+    if (auto_close_fds) {
+      close(fd);
+      close(notify_fd);
+    }
+  });
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    return STATUS_FROM_ERRNO("fstat", errno);
+  }
+  // The capacity is provided by the client, so check that the file is actually big enough.
+  // Otherwise access to the pages beyond the end of the file would raise SIGBUS.
+  auto required_size = sizeof(Header) + capacity;
+  if (!S_ISREG(st.st_mode) || static_cast<uint64_t>(st.st_size) < required_size) {
+    return STATUS_FORMAT(
+        InvalidArgument, "Shared exchange file size $0 is less than required $1",
+        st.st_size, required_size);
+  }
+  auto segment = VERIFY_RESULT(SharedMemorySegment::Open(
+      fd, SharedMemorySegment::AccessMode::kReadWrite, required_size));
+  auto_close_fds = false;
+  return SharedExchange(std::move(segment), notify_fd, capacity);
+}
+
+SharedExchange::Header& SharedExchange::header() const {
+  return *static_cast<Header*>(segment_.GetAddress());
+}
+
+std::byte* SharedExchange::data() const {
+  return static_cast<std::byte*>(segment_.GetAddress()) + sizeof(Header);
+}
+
+SharedExchangeState SharedExchange::state() const {
+  return static_cast<SharedExchangeState>(header().state.load(std::memory_order_acquire));
+}
+
+void SharedExchange::SetState(SharedExchangeState state) {
+  header().state.store(to_underlying(state), std::memory_order_release);
+  WakeUp();
+}
+
+void SharedExchange::WakeUp() {
+#ifdef __linux__
+  // The peer lives in a different process, so FUTEX_PRIVATE_FLAG could not be used here.
+  sys_futex(reinterpret_cast<int32_t*>(&header().state),
+            FUTEX_WAKE,
+            INT_MAX, // wake all
+            nullptr, nullptr,
+            0 /* ignored */);
+#endif
+}
+
+SharedExchangeState SharedExchange::WaitStateChange(
+    SharedExchangeState state, CoarseTimePoint deadline) {
+  auto& header = this->header();
+  for (;;) {
+    auto current = this->state();
+    if (current != state) {
+      return current;
+    }
+    struct timespec ts;
+    struct timespec* timeout = nullptr;
+    if (deadline != CoarseTimePoint::max()) {
+      auto now = CoarseMonoClock::now();
+      if (now >= deadline) {
+        return current;
+      }
+      MonoDelta(deadline - now).ToTimeSpec(&ts);
+      timeout = &ts;
+    }
+#ifdef __linux__
+    sys_futex(reinterpret_cast<int32_t*>(&header.state),
+              FUTEX_WAIT,
+              to_underlying(state), // wait if value is still the same
+              reinterpret_cast<struct kernel_timespec*>(timeout), nullptr, 0);
+#else
+    (void)header;
+    (void)timeout;
+    std::this_thread::sleep_for(50us);
+#endif
+  }
+}
+
+std::byte* SharedExchange::Obtain(size_t required_size) {
+  if (required_size > capacity_ || awaiting_response_) {
+    return nullptr;
+  }
+  // kResponseSent is also acceptable here, the response to a timed out request is just dropped.
+  auto current = state();
+  if (current != SharedExchangeState::kIdle && current != SharedExchangeState::kResponseSent) {
+    return nullptr;
+  }
+  return data();
+}
+
+void SharedExchange::SendRequest(size_t size, CoarseTimePoint deadline) {
+  DCHECK_LE(size, capacity_);
+  header().data_size = size;
+  header().deadline = deadline.time_since_epoch().count();
+  awaiting_response_ = true;
+  SetState(SharedExchangeState::kRequestSent);
+#ifdef __linux__
+  if (notify_fd_ != -1 && eventfd_write(notify_fd_, 1) == -1) {
+    // The counter could overflow only if the server does not read it for a very long time.
+    LOG(DFATAL) << "Failed to signal shared exchange: " << ErrnoToString(errno);
+  }
+#endif
+}
+
+Result<Slice> SharedExchange::FetchResponse(CoarseTimePoint deadline) {
+  awaiting_response_ = false;
+  auto current = WaitStateChange(SharedExchangeState::kRequestSent, deadline);
+  switch (current) {
+    case SharedExchangeState::kResponseSent:
+      return Slice(data(), header().data_size);
+    case SharedExchangeState::kRequestSent:
+      return STATUS(TimedOut, "Timed out waiting for response from shared exchange");
+    case SharedExchangeState::kShutdown:
+      return STATUS(ShutdownInProgress, "Shared exchange stopped");
+    case SharedExchangeState::kIdle:
+      break;
+  }
+  return STATUS_FORMAT(IllegalState, "Unexpected shared exchange state: $0", current);
+}
+
+void SharedExchange::DropResponse() {
+  awaiting_response_ = false;
+}
+
+Result<Slice> SharedExchange::Poll() {
+  auto current = state();
+  while (current == SharedExchangeState::kIdle ||
+         current == SharedExchangeState::kResponseSent) {
+    current = WaitStateChange(current, CoarseTimePoint::max());
+  }
+  if (current == SharedExchangeState::kShutdown) {
+    return STATUS(ShutdownInProgress, "Shared exchange stopped");
+  }
+  return Slice(data(), header().data_size);
+}
+
+std::optional<Slice> SharedExchange::TryPoll() {
+#ifdef __linux__
+  eventfd_t value;
+  if (notify_fd_ != -1 && eventfd_read(notify_fd_, &value) == -1 && errno != EAGAIN) {
+    LOG(WARNING) << "Failed to read shared exchange notification: " << ErrnoToString(errno);
+  }
+#endif
+  if (state() != SharedExchangeState::kRequestSent) {
+    return std::nullopt;
+  }
+  auto size = header().data_size;
+  // The header is writable by the client, so do not trust the size.
+  if (size > capacity_) {
+    return std::nullopt;
+  }
+  return Slice(data(), size);
+}
+
+CoarseTimePoint SharedExchange::request_deadline() const {
+  return CoarseTimePoint(CoarseDuration(header().deadline));
+}
+
+std::byte* SharedExchange::ResponseBuffer(size_t required_size) {
+  return required_size <= capacity_ ? data() : nullptr;
+}
+
+void SharedExchange::Respond(size_t size) {
+  DCHECK_LE(size, capacity_);
+  header().data_size = size;
+  // Client could stop the exchange while we were processing the request, keep it stopped then.
+  uint32_t expected = to_underlying(SharedExchangeState::kRequestSent);
+  if (header().state.compare_exchange_strong(
+          expected, to_underlying(SharedExchangeState::kResponseSent),
+          std::memory_order_acq_rel)) {
+    WakeUp();
+  }
+}
+
+void SharedExchange::SignalStop() {
+  SetState(SharedExchangeState::kShutdown);
+}
+
+ReceivedSharedExchange::ReceivedSharedExchange(ReceivedSharedExchange&& rhs)
+    : session_id(rhs.session_id), pid(rhs.pid), uid(rhs.uid), fd(rhs.fd),
+      notify_fd(rhs.notify_fd) {
+  rhs.Release();
+}
+
+ReceivedSharedExchange::~ReceivedSharedExchange() {
+  if (fd != -1) {
+    close(fd);
+  }
+  if (notify_fd != -1) {
+    close(notify_fd);
+  }
+}
+
+void ReceivedSharedExchange::Release() {
+  fd = -1;
+  notify_fd = -1;
+}
+
+#ifdef __linux__
+
+namespace {
+
+Status FillAbstractAddress(const std::string& name, sockaddr_un* addr, socklen_t* len) {
+  if (name.empty() || name.size() + 1 > sizeof(addr->sun_path)) {
+    return STATUS_FORMAT(InvalidArgument, "Bad shared exchange socket name: $0", name);
+  }
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  // Leading zero byte places the socket into the abstract namespace, so no file is created.
+  memcpy(addr->sun_path + 1, name.data(), name.size());
+  *len = narrow_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + name.size());
+  return Status::OK();
+}
+
+} // namespace
+
+Status SendSharedExchange(
+    const std::string& socket_name, uint64_t session_id, const SharedExchange& exchange,
+    CoarseTimePoint deadline) {
+  sockaddr_un addr;
+  socklen_t addr_len;
+  RETURN_NOT_OK(FillAbstractAddress(socket_name, &addr, &addr_len));
+
+  int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (sock == -1) {
+    return STATUS_FROM_ERRNO("socket", errno);
+  }
+  auto se = ScopeExit([sock] {
+    close(sock);
+  });
+
+  int res;
+  RETRY_ON_EINTR(res, connect(sock, pointer_cast<sockaddr*>(&addr), addr_len));
+  if (res == -1) {
+    return STATUS_FROM_ERRNO("connect", errno);
+  }
+
+  int fds[] = {exchange.fd(), exchange.notify_fd()};
+  iovec iov = {.iov_base = &session_id, .iov_len = sizeof(session_id)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+  ssize_t sent;
+  RETRY_ON_EINTR(sent, sendmsg(sock, &msg, MSG_NOSIGNAL));
+  if (sent == -1) {
+    return STATUS_FROM_ERRNO("sendmsg", errno);
+  }
+
+  auto timeout = MonoDelta(deadline - CoarseMonoClock::now());
+  if (timeout <= MonoDelta::kZero) {
+    return STATUS(TimedOut, "Timed out sending shared exchange");
+  }
+  timeval tv;
+  timeout.ToTimeVal(&tv);
+  if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == -1) {
+    return STATUS_FROM_ERRNO("setsockopt", errno);
+  }
+  char accepted = 0;
+  ssize_t received;
+  RETRY_ON_EINTR(received, recv(sock, &accepted, sizeof(accepted), 0));
+  if (received == -1) {
+    return STATUS_FROM_ERRNO("recv", errno);
+  }
+  if (received != sizeof(accepted) || !accepted) {
+    return STATUS(NotAuthorized, "Shared exchange rejected by tserver");
+  }
+  return Status::OK();
+}
+
+Result<int> ListenSharedExchange(const std::string& socket_name) {
+  sockaddr_un addr;
+  socklen_t addr_len;
+  RETURN_NOT_OK(FillAbstractAddress(socket_name, &addr, &addr_len));
+
+  int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (sock == -1) {
+    return STATUS_FROM_ERRNO("socket", errno);
+  }
+  if (bind(sock, pointer_cast<sockaddr*>(&addr), addr_len) == -1 ||
+      listen(sock, SOMAXCONN) == -1) {
+    auto status = STATUS_FROM_ERRNO(Format("Listen $0", socket_name), errno);
+    close(sock);
+    return status;
+  }
+  return sock;
+}
+
+Result<ReceivedSharedExchange> ReceiveSharedExchange(int socket) {
+  ReceivedSharedExchange result;
+
+  // Credentials are filled by the kernel when the client connects, so they could not be faked.
+  ucred cred;
+  socklen_t cred_len = sizeof(cred);
+  if (getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == -1) {
+    return STATUS_FROM_ERRNO("getsockopt(SO_PEERCRED)", errno);
+  }
+  result.pid = cred.pid;
+  result.uid = cred.uid;
+
+  iovec iov = {.iov_base = &result.session_id, .iov_len = sizeof(result.session_id)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 2)] = {};
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t received;
+  RETRY_ON_EINTR(received, recvmsg(socket, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC));
+  if (received == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return STATUS(TryAgain, "Shared exchange was not received yet");
+    }
+    return STATUS_FROM_ERRNO("recvmsg", errno);
+  }
+
+  std::vector<int> fds;
+  for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (size_t i = 0; i != count; ++i) {
+      int fd;
+      memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+      fds.push_back(fd);
+    }
+  }
+  if (fds.size() == 2) {
+    result.fd = fds[0];
+    result.notify_fd = fds[1];
+  } else {
+    for (auto fd : fds) {
+      close(fd);
+    }
+  }
+
+  if (received != sizeof(result.session_id) || result.fd == -1 ||
+      (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+    return STATUS_FORMAT(
+        Corruption, "Malformed shared exchange message from pid $0: size: $1, fds: $2",
+        result.pid, received, fds.size());
+  }
+  return result;
+}
+
+Status ReplySharedExchange(int socket, bool accepted) {
+  char reply = accepted;
+  ssize_t sent;
+  RETRY_ON_EINTR(sent, send(socket, &reply, sizeof(reply), MSG_NOSIGNAL | MSG_DONTWAIT));
+  if (sent == -1) {
+    return STATUS_FROM_ERRNO("send", errno);
+  }
+  return Status::OK();
+}
+
+#else
+
+Status SendSharedExchange(
+    const std::string& socket_name, uint64_t session_id, const SharedExchange& exchange,
+    CoarseTimePoint deadline) {
+  return STATUS(NotSupported, "Shared exchange is supported only on Linux");
+}
+
+Result<int> ListenSharedExchange(const std::string& socket_name) {
+  return STATUS(NotSupported, "Shared exchange is supported only on Linux");
+}
+
+Result<ReceivedSharedExchange> ReceiveSharedExchange(int socket) {
+  return STATUS(NotSupported, "Shared exchange is supported only on Linux");
+}
+
+Status ReplySharedExchange(int socket, bool accepted) {
+  return STATUS(NotSupported, "Shared exchange is supported only on Linux");
+}
+
+#endif
+
+}  // namespace tserver
+}  // namespace yb
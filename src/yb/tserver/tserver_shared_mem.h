@@ -13,14 +13,21 @@
 
 #pragma once
 
+#include <sys/types.h>
+
 #include <atomic>
+#include <optional>
+#include <string>
 
 #include <boost/asio/ip/tcp.hpp>
 
 #include "yb/tserver/tserver_util_fwd.h"
 
 #include "yb/util/atomic.h"
+#include "yb/util/enums.h"
+#include "yb/util/monotime.h"
 #include "yb/util/net/net_fwd.h"
+#include "yb/util/shared_mem.h"
 #include "yb/util/slice.h"
 
 #include "yb/yql/pggate/ybc_pg_typedefs.h"
@@ -96,5 +103,132 @@ class TServerSharedData {
   std::atomic<uint64_t> db_catalog_versions_[kMaxNumDbCatalogVersions] = {0};
 };
 
+YB_DEFINE_ENUM(SharedExchangeState, (kIdle)(kRequestSent)(kResponseSent)(kShutdown));
+
+// Shared memory buffer used to pass requests from a postgres backend to the local tserver and
+// responses back, without copying them through the kernel.
+// The exchange holds a single request or response at a time: the client writes a request and
+// signals the server through an eventfd, the server writes the response in place and wakes up the
+// client through a futex.
+class SharedExchange {
+ public:
+  SharedExchange(SharedExchange&& rhs);
+  ~SharedExchange();
+
+  // Creates a new exchange with a data buffer of the specified size. Used by the client.
+  static Result<SharedExchange> Create(size_t capacity);
+
+  // Opens the exchange using the file descriptors received from the client, see
+  // ReceiveSharedExchange. Takes ownership of both descriptors, also in case of failure.
+  // Fails if the shared memory file is smaller than required for the specified capacity.
+  static Result<SharedExchange> Open(int fd, int notify_fd, size_t capacity);
+
+  int fd() const {
+    return segment_.GetFd();
+  }
+
+  // Descriptor of the eventfd that is signaled when the client sends a request.
+  int notify_fd() const {
+    return notify_fd_;
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  SharedExchangeState state() const;
+
+  // Returns buffer to write a request of the specified size to, or nullptr if the exchange could
+  // not be used for this request, i.e. the request is too big, the response to the previous request
+  // was not fetched yet, or the exchange was stopped.
+  std::byte* Obtain(size_t required_size);
+
+  // Notifies the server that a request of the specified size was written to the buffer.
+  // The deadline is passed to the server along with the request.
+  void SendRequest(size_t size, CoarseTimePoint deadline);
+
+  // Waits for the response to the sent request. The returned slice points into the exchange buffer
+  // and is valid until the next call to Obtain.
+  // After a timeout the exchange remains unusable until the server responds to the request.
+  Result<Slice> FetchResponse(CoarseTimePoint deadline);
+
+  // Forgets the sent request, when its response will not be fetched. The exchange could be used
+  // again as soon as the server responds to that request.
+  void DropResponse();
+
+  // Waits for the next request from the client. Returns ShutdownInProgress after SignalStop.
+  // The returned slice is valid until the call to Respond.
+  Result<Slice> Poll();
+
+  // Returns the pending request without waiting, or nullopt if there is no such request.
+  // Drains the notification eventfd. The returned slice is valid until the call to Respond.
+  std::optional<Slice> TryPoll();
+
+  // Deadline of the request returned by the last Poll.
+  CoarseTimePoint request_deadline() const;
+
+  // Returns buffer to write a response of the specified size to, or nullptr if it is too big.
+  std::byte* ResponseBuffer(size_t required_size);
+
+  // Notifies the client that a response of the specified size was written to the buffer.
+  void Respond(size_t size);
+
+  // Stops the exchange, waking up both sides.
+  void SignalStop();
+
+ private:
+  struct Header;
+
+  SharedExchange(SharedMemorySegment&& segment, int notify_fd, size_t capacity);
+
+  Header& header() const;
+  std::byte* data() const;
+
+  void SetState(SharedExchangeState state);
+  void WakeUp();
+
+  // Waits while the state is equal to `state`, or until the deadline is reached.
+  // Returns the last observed state.
+  SharedExchangeState WaitStateChange(SharedExchangeState state, CoarseTimePoint deadline);
+
+  SharedMemorySegment segment_;
+  int notify_fd_;
+  size_t capacity_;
+  // Whether the client sent a request and did not try to fetch the response yet. Client side only.
+  bool awaiting_response_ = false;
+};
+
+// Passes the exchange of the specified session to the tserver listening on the abstract unix
+// socket with the specified name. The tserver authenticates the sender using the peer credentials
+// of the connection, and accepts the exchange only from the process that created the session.
+Status SendSharedExchange(
+    const std::string& socket_name, uint64_t session_id, const SharedExchange& exchange,
+    CoarseTimePoint deadline);
+
+// Exchange descriptors received by the tserver, along with the credentials of the sender.
+struct ReceivedSharedExchange {
+  uint64_t session_id = 0;
+  pid_t pid = 0;
+  uid_t uid = 0;
+  int fd = -1;
+  int notify_fd = -1;
+
+  ReceivedSharedExchange() = default;
+  ReceivedSharedExchange(ReceivedSharedExchange&& rhs);
+  ~ReceivedSharedExchange();
+
+  // Releases ownership of the received descriptors.
+  void Release();
+};
+
+// Creates a listening abstract unix socket with the specified name, used to receive exchanges.
+Result<int> ListenSharedExchange(const std::string& socket_name);
+
+// Receives the exchange sent with SendSharedExchange from the connected socket.
+Result<ReceivedSharedExchange> ReceiveSharedExchange(int socket);
+
+// Tells the client whether the exchange sent over the specified socket was accepted.
+Status ReplySharedExchange(int socket, bool accepted);
+
 }  // namespace tserver
 }  // namespace yb
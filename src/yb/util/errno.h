@@ -96,4 +96,10 @@ Status StatusFromErrnoIfNonZero(const std::string& context, int rv, const char*
 #define RETURN_ON_ERRNO_RV_FN_CALL(...) \
     RETURN_NOT_OK(STATUS_FROM_ERRNO_RV_FN_CALL(__VA_ARGS__))
 
+// Assigns the result of expr, that returns -1 and sets errno on failure, to ret. Repeats the
+// evaluation while it is interrupted by a signal.
+#define RETRY_ON_EINTR(ret, expr) do { \
+  ret = expr; \
+} while ((ret == -1) && (errno == EINTR))
+
 } // namespace yb
@@ -29,4 +29,18 @@ TEST(LRUCacheTest, Simple) {
   ASSERT_EQ(AsString(cache), "[2]");
 }
 
+TEST(LRUCacheTest, PopBack) {
+  LRUCache<int> cache(3);
+  cache.insert(1);
+  cache.insert(2);
+  cache.insert(3);
+  cache.insert(1);
+  ASSERT_EQ(cache.size(), 3);
+  cache.pop_back();
+  ASSERT_EQ(AsString(cache), "[1, 3]");
+  cache.pop_back();
+  cache.pop_back();
+  ASSERT_TRUE(cache.empty());
+}
+
 } // namespace yb
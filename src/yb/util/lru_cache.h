@@ -73,6 +73,19 @@ class LRUCache {
     return erase(key);
   }
 
+  // Erase the least recently used entry.
+  void pop_back() {
+    impl_.pop_back();
+  }
+
+  size_t size() const {
+    return impl_.size();
+  }
+
+  bool empty() const {
+    return impl_.empty();
+  }
+
   const_iterator begin() const {
     return impl_.begin();
   }
@@ -38,6 +38,9 @@
 #include "yb/gutil/strings/join.h"
 #include "yb/gutil/strings/util.h"
 
+#include "yb/gutil/casts.h"
+
+#include "yb/util/backoff_waiter.h"
 #include "yb/util/net/net_util.h"
 #include "yb/util/net/sockaddr.h"
 #include "yb/util/net/socket.h"
@@ -49,6 +52,8 @@
 using std::string;
 using std::vector;
 
+using namespace std::literals;
+
 namespace yb {
 
 class NetUtilTest : public YBTest {
@@ -215,6 +220,55 @@ TEST_F(NetUtilTest, TestLsof) {
   ASSERT_STR_CONTAINS(lsof_lines[2], "net_util-test");
 }
 
+// Tests that completion of MSG_ZEROCOPY send is reported through the socket error queue.
+TEST_F(NetUtilTest, ZeroCopySend) {
+  Socket listener;
+  ASSERT_OK(listener.Init(0));
+  ASSERT_OK(listener.BindAndListen(Endpoint(boost::asio::ip::address_v4::loopback(), 0), 1));
+  Endpoint addr;
+  ASSERT_OK(listener.GetSocketAddress(&addr));
+
+  Socket client;
+  ASSERT_OK(client.Init(0));
+  auto status = client.SetZeroCopy(true);
+  if (status.IsNotSupported()) {
+    LOG(INFO) << "Zero copy is not supported: " << status;
+    return;
+  }
+  ASSERT_OK(status);
+  ASSERT_OK(client.Connect(addr));
+
+  Socket server;
+  Endpoint remote;
+  ASSERT_OK(listener.Accept(&server, &remote, 0));
+
+  uint32_t lo, hi;
+  bool copied;
+  ASSERT_FALSE(ASSERT_RESULT(client.ReadZeroCopyCompletion(&lo, &hi, &copied)));
+
+  std::string data(64 * 1024, 'x');
+  iovec iov = { .iov_base = data.data(), .iov_len = data.size() };
+  auto written = ASSERT_RESULT(client.Writev(&iov, 1, /* zero_copy= */ true));
+  ASSERT_GT(written, 0);
+
+  std::string received(written, 0);
+  ASSERT_EQ(written, ASSERT_RESULT(server.BlockingRecv(
+      pointer_cast<uint8_t*>(received.data()), written, MonoTime::Now() + 10s)));
+  ASSERT_EQ(data.substr(0, written), received);
+
+  ASSERT_OK(WaitFor([&client, &lo, &hi, &copied]() {
+    return client.ReadZeroCopyCompletion(&lo, &hi, &copied);
+  }, 10s, "Zero copy completion"));
+  // The kernel numbers zero copy sends starting from 0.
+  ASSERT_EQ(0, lo);
+  ASSERT_EQ(0, hi);
+  LOG(INFO) << "Copied: " << copied;
+  ASSERT_FALSE(ASSERT_RESULT(client.ReadZeroCopyCompletion(&lo, &hi, &copied)));
+
+  ASSERT_OK(client.SetAbortOnClose());
+  ASSERT_OK(client.Close());
+}
+
 TEST_F(NetUtilTest, TestGetFQDN) {
   string fqdn;
   ASSERT_OK(GetFQDN(&fqdn));
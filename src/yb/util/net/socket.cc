@@ -33,8 +33,13 @@
 #include "yb/util/net/socket.h"
 
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/types.h>
 
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#endif
+
 #include <limits>
 #include <string>
 
@@ -212,6 +217,40 @@ Status Socket::SetNoDelay(bool enabled) {
   return Status::OK();
 }
 
+Status Socket::SetCork(bool enabled) {
+#if defined(TCP_CORK)
+  int flag = enabled ? 1 : 0;
+  if (setsockopt(fd_, IPPROTO_TCP, TCP_CORK, &flag, sizeof(flag)) == -1) {
+    return STATUS(NetworkError, "Failed to set TCP_CORK", Errno(errno));
+  }
+  return Status::OK();
+#else
+  return STATUS(NotSupported, "TCP_CORK is not supported");
+#endif
+}
+
+Status Socket::SetZeroCopy(bool enabled) {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  int flag = enabled ? 1 : 0;
+  if (setsockopt(fd_, SOL_SOCKET, SO_ZEROCOPY, &flag, sizeof(flag)) == -1) {
+    return STATUS(NetworkError, "Failed to set SO_ZEROCOPY", Errno(errno));
+  }
+  return Status::OK();
+#else
+  return STATUS(NotSupported, "SO_ZEROCOPY is not supported");
+#endif
+}
+
+Status Socket::SetAbortOnClose() {
+  struct linger linger;
+  linger.l_onoff = 1;
+  linger.l_linger = 0;
+  if (setsockopt(fd_, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger)) == -1) {
+    return STATUS(NetworkError, "Failed to set SO_LINGER", Errno(errno));
+  }
+  return Status::OK();
+}
+
 Status Socket::SetNonBlocking(bool enabled) {
   int curflags = ::fcntl(fd_, F_GETFL, 0);
   if (curflags == -1) {
@@ -426,7 +465,7 @@ Result<size_t> Socket::Write(const uint8_t *buf, ssize_t amt) {
   return res;
 }
 
-Result<size_t> Socket::Writev(const struct ::iovec *iov, int iov_len) {
+Result<size_t> Socket::Writev(const struct ::iovec *iov, int iov_len, bool zero_copy) {
   if (PREDICT_FALSE(iov_len <= 0)) {
     return STATUS(NetworkError,
                   StringPrintf("Writev: invalid io vector length of %d", iov_len),
@@ -438,7 +477,13 @@ Result<size_t> Socket::Writev(const struct ::iovec *iov, int iov_len) {
   memset(&msg, 0, sizeof(struct msghdr));
   msg.msg_iov = const_cast<iovec *>(iov);
   msg.msg_iovlen = iov_len;
-  auto res = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+  int flags = MSG_NOSIGNAL;
+#if defined(MSG_ZEROCOPY)
+  if (zero_copy) {
+    flags |= MSG_ZEROCOPY;
+  }
+#endif
+  auto res = ::sendmsg(fd_, &msg, flags);
   if (PREDICT_FALSE(res < 0)) {
     if (IsTemporarySocketError(errno)) {
       static const Status try_write_again = STATUS(TryAgain, "Write not yet ready");
@@ -450,6 +495,54 @@ Result<size_t> Socket::Writev(const struct ::iovec *iov, int iov_len) {
   return res;
 }
 
+Result<bool> Socket::ReadZeroCopyCompletion(uint32_t* lo, uint32_t* hi, bool* copied) {
+#if defined(SO_EE_ORIGIN_ZEROCOPY)
+  for (;;) {
+    char control[128];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    auto res = recvmsg(fd_, &msg, MSG_ERRQUEUE);
+    if (res < 0) {
+      if (IsTemporarySocketError(errno)) {
+        return false;
+      }
+      return STATUS(NetworkError, "recvmsg error queue error", Errno(errno));
+    }
+    for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+          !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+        LOG(WARNING) << "Unexpected message in socket error queue, level: " << cmsg->cmsg_level
+                     << ", type: " << cmsg->cmsg_type;
+        continue;
+      }
+      auto* err = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cmsg));
+      if (err->ee_errno == 0 && err->ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+        *lo = err->ee_info;
+        *hi = err->ee_data;
+        *copied = (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+        return true;
+      }
+      if (err->ee_errno != 0) {
+        // E.g. ICMP error for this connection.
+        return STATUS(NetworkError,
+                      Format("Socket error queue, origin: $0, type: $1, code: $2",
+                             static_cast<int>(err->ee_origin), static_cast<int>(err->ee_type),
+                             static_cast<int>(err->ee_code)),
+                      Errno(err->ee_errno));
+      }
+      LOG(WARNING) << "Unexpected entry in socket error queue, origin: "
+                   << static_cast<int>(err->ee_origin) << ", type: "
+                   << static_cast<int>(err->ee_type) << ", code: "
+                   << static_cast<int>(err->ee_code);
+    }
+  }
+#else
+  return false;
+#endif
+}
+
 // Mostly follows writen() from Stevens (2004) or Kerrisk (2010).
 Status Socket::BlockingWrite(const uint8_t *buf, size_t buflen, const MonoTime& deadline) {
   DCHECK_LE(buflen, std::numeric_limits<int32_t>::max()) << "Writes > INT32_MAX not supported";
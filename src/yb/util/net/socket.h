@@ -50,6 +50,9 @@ class MonoTime;
 typedef boost::container::small_vector<::iovec, 4> IoVecs;
 
 size_t IoVecsFullSize(const IoVecs& io_vecs);
+
+// Returns true if the socket operation failed with the specified errno could be retried later.
+bool IsTemporarySocketError(int err);
 // begin and end are positions in concatenated io_vecs.
 void IoVecsToBuffer(const IoVecs& io_vecs, size_t begin, size_t end, std::vector<char>* result);
 void IoVecsToBuffer(const IoVecs& io_vecs, size_t begin, size_t end, char* result);
@@ -98,6 +101,17 @@ class Socket {
   // Set or clear TCP_NODELAY
   Status SetNoDelay(bool enabled);
 
+  // Set or clear TCP_CORK, returns NotSupported if the platform does not have it.
+  // While corked, the kernel sends only full segments. Clearing it flushes pending data.
+  Status SetCork(bool enabled);
+
+  // Set or clear SO_ZEROCOPY, returns NotSupported if the platform does not have it.
+  Status SetZeroCopy(bool enabled);
+
+  // Sets SO_LINGER with zero timeout, so Close() drops data that was not sent yet and resets the
+  // connection, instead of sending that data in background.
+  Status SetAbortOnClose();
+
   // Set or clear O_NONBLOCK
   Status SetNonBlocking(bool enabled);
   Status IsNonBlocking(bool* is_nonblock) const;
@@ -144,7 +158,16 @@ class Socket {
 
   Result<size_t> Write(const uint8_t *buf, ssize_t amt);
 
-  Result<size_t> Writev(const struct ::iovec *iov, int iov_len);
+  // `zero_copy` - send with MSG_ZEROCOPY, so data should not be modified or freed until
+  // completion of this send is returned by ReadZeroCopyCompletion.
+  Result<size_t> Writev(const struct ::iovec *iov, int iov_len, bool zero_copy = false);
+
+  // Reads notification from the socket error queue about completed MSG_ZEROCOPY sends.
+  // Returns false if there are no pending notifications. Otherwise fills [lo, hi] with the range
+  // of completed send sequence numbers, the kernel numbers zero copy sends starting from 0.
+  // `copied` is set when the kernel had to copy the data anyway, e.g. for loopback connections.
+  // Other errors queued on the socket are returned as NetworkError.
+  Result<bool> ReadZeroCopyCompletion(uint32_t* lo, uint32_t* hi, bool* copied);
 
   // Blocking Write call, returns IOError unless full buffer is sent.
   // Underlying Socket expected to be in blocking mode. Fails if any Write() sends 0 bytes.
@@ -13,6 +13,8 @@
 
 #include "yb/yql/pggate/pg_client.h"
 
+#include <future>
+
 #include "yb/client/client-internal.h"
 #include "yb/client/table.h"
 #include "yb/client/table_info.h"
@@ -21,6 +23,7 @@
 
 #include "yb/gutil/casts.h"
 
+#include "yb/rpc/outbound_call.h"
 #include "yb/rpc/poller.h"
 #include "yb/rpc/rpc_controller.h"
 
@@ -47,7 +50,12 @@ DECLARE_int32(yb_client_admin_operation_timeout_sec);
 DEFINE_UNKNOWN_uint64(pg_client_heartbeat_interval_ms, 10000,
     "Pg client heartbeat interval in ms.");
 
+DEFINE_NON_RUNTIME_uint64(pg_client_shared_exchange_capacity, 16 * 1024 * 1024,
+    "Size of the shared memory buffer used to exchange Perform requests and responses with the "
+    "local tserver. Responses that do not fit into it fail the operation.");
+
 DECLARE_bool(TEST_index_read_multiple_partitions);
+DECLARE_bool(pg_client_use_shared_memory);
 DECLARE_bool(TEST_enable_db_catalog_version_mode);
 
 using namespace std::literals;
@@ -65,11 +73,27 @@ struct PerformData {
   PgsqlOps operations;
   tserver::LWPgPerformResponsePB resp;
   rpc::RpcController controller;
-  PerformCallback callback;
+  std::promise<PerformResult> promise;
 
   explicit PerformData(ThreadSafeArena* arena) : resp(arena) {
   }
 
+  PerformResult Complete(const Status& status, rpc::CallResponsePtr response) {
+    PerformResult result;
+    result.status = status;
+    result.response = std::move(response);
+    if (result.status.ok()) {
+      result.status = ResponseStatus(resp);
+    }
+    if (result.status.ok()) {
+      result.status = Process();
+    }
+    if (result.status.ok() && resp.has_catalog_read_time()) {
+      result.catalog_read_time = ReadHybridTime::FromPB(resp.catalog_read_time());
+    }
+    return result;
+  }
+
   Status Process() {
     auto& responses = *resp.mutable_responses();
     SCHECK_EQ(implicit_cast<size_t>(responses.size()), operations.size(), RuntimeError,
@@ -90,6 +114,43 @@ struct PerformData {
   }
 };
 
+// Fetches the response to the request sent through the shared exchange. If the response is never
+// fetched, e.g. because the future waiting for it was dropped, the exchange is released on
+// destruction, otherwise it would stay busy and all following requests would go through TCP.
+class SharedExchangeResponseFetcher {
+ public:
+  SharedExchangeResponseFetcher(
+      std::shared_ptr<tserver::SharedExchange> exchange, CoarseTimePoint deadline)
+      : exchange_(std::move(exchange)), deadline_(deadline) {}
+
+  SharedExchangeResponseFetcher(SharedExchangeResponseFetcher&& rhs) = default;
+  SharedExchangeResponseFetcher& operator=(SharedExchangeResponseFetcher&& rhs) = delete;
+
+  ~SharedExchangeResponseFetcher() {
+    if (exchange_) {
+      exchange_->DropResponse();
+    }
+  }
+
+  Status Fetch(tserver::LWPgPerformResponsePB* resp, rpc::CallResponsePtr* response) {
+    auto exchange = std::move(exchange_);
+    auto data = VERIFY_RESULT(exchange->FetchResponse(deadline_));
+    // The response is copied out of the exchange, so it could be reused by the next request
+    // while this response is still referenced.
+    rpc::CallData call_data(data.size());
+    memcpy(call_data.data(), data.data(), data.size());
+    auto result = std::make_shared<rpc::CallResponse>();
+    RETURN_NOT_OK(result->ParseFrom(&call_data));
+    RETURN_NOT_OK(resp->ParseFromSlice(result->serialized_response()));
+    *response = std::move(result);
+    return Status::OK();
+  }
+
+ private:
+  std::shared_ptr<tserver::SharedExchange> exchange_;
+  CoarseTimePoint deadline_;
+};
+
 std::string PrettyFunctionName(const char* name) {
   std::string result;
   for (const char* ch = name; *ch; ++ch) {
@@ -129,9 +190,30 @@ class PgClient::Impl {
     proxy_ = std::make_unique<tserver::PgClientServiceProxy>(
         proxy_cache, host_port, nullptr /* protocol */, resolve_cache_timeout);
 
+    if (FLAGS_pg_client_use_shared_memory) {
+      auto shared_exchange = tserver::SharedExchange::Create(
+          FLAGS_pg_client_shared_exchange_capacity);
+      if (shared_exchange.ok()) {
+        shared_exchange_ = std::make_shared<tserver::SharedExchange>(std::move(*shared_exchange));
+      } else {
+        LOG(WARNING) << "Failed to create shared exchange: " << shared_exchange.status();
+      }
+    }
+
     auto future = create_session_promise_.get_future();
     Heartbeat(true);
     session_id_ = VERIFY_RESULT(future.get());
+    if (shared_exchange_) {
+      auto status = heartbeat_resp_.shared_exchange_socket().empty()
+          ? STATUS(NotSupported, "Shared exchange is not supported by tserver")
+          : tserver::SendSharedExchange(
+                heartbeat_resp_.shared_exchange_socket(), session_id_, *shared_exchange_,
+                CoarseMonoClock::now() + timeout_);
+      LOG_WITH_PREFIX(INFO) << "Shared exchange enabled: " << status;
+      if (!status.ok()) {
+        shared_exchange_.reset();
+      }
+    }
     LOG_WITH_PREFIX(INFO) << "Session id acquired. Postgres backend pid: " << getpid();
     heartbeat_poller_.Start(scheduler, FLAGS_pg_client_heartbeat_interval_ms * 1ms);
     return Status::OK();
@@ -139,6 +221,10 @@ class PgClient::Impl {
 
   void Shutdown() {
     heartbeat_poller_.Shutdown();
+    if (shared_exchange_) {
+      shared_exchange_->SignalStop();
+      shared_exchange_.reset();
+    }
     proxy_ = nullptr;
   }
 
@@ -153,6 +239,9 @@ class PgClient::Impl {
     tserver::PgHeartbeatRequestPB req;
     if (!create) {
       req.set_session_id(session_id_);
+    } else if (shared_exchange_) {
+      req.set_pid(getpid());
+      req.set_shared_exchange_capacity(shared_exchange_->capacity());
     }
     proxy_->HeartbeatAsync(
         req, &heartbeat_resp_, PrepareHeartbeatController(),
@@ -368,10 +457,9 @@ class PgClient::Impl {
     return ResponseStatus(resp);
   }
 
-  void PerformAsync(
+  PerformResultFuture PerformAsync(
       tserver::PgPerformOptionsPB* options,
-      PgsqlOps* operations,
-      const PerformCallback& callback) {
+      PgsqlOps* operations) {
     auto& arena = operations->front()->arena();
     tserver::LWPgPerformRequestPB req(&arena);
     req.set_session_id(session_id_);
@@ -380,23 +468,42 @@ class PgClient::Impl {
 
     auto data = std::make_shared<PerformData>(&arena);
     data->operations = std::move(*operations);
-    data->callback = callback;
     data->controller.set_invoke_callback_mode(rpc::InvokeCallbackMode::kReactorThread);
 
-    proxy_->PerformAsync(req, &data->resp, SetupController(&data->controller), [data] {
-      PerformResult result;
-      result.status = data->controller.status();
-      result.response = data->controller.response();
-      if (result.status.ok()) {
-        result.status = ResponseStatus(data->resp);
-      }
-      if (result.status.ok()) {
-        result.status = data->Process();
+    if (shared_exchange_) {
+      auto future = TryPerformViaSharedExchange(req, data);
+      if (future.valid()) {
+        return future;
       }
-      if (result.status.ok() && data->resp.has_catalog_read_time()) {
-        result.catalog_read_time = ReadHybridTime::FromPB(data->resp.catalog_read_time());
-      }
-      data->callback(result);
+    }
+
+    auto result = data->promise.get_future();
+    proxy_->PerformAsync(req, &data->resp, SetupController(&data->controller), [data] {
+      data->promise.set_value(
+          data->Complete(data->controller.status(), data->controller.response()));
+    });
+    return result;
+  }
+
+  // Sends request through the shared memory exchange. The returned future waits for the response
+  // when its result is requested, so the backend could continue while the tserver executes the
+  // request. Returns invalid future if the exchange could not be used for this request.
+  PerformResultFuture TryPerformViaSharedExchange(
+      const tserver::LWPgPerformRequestPB& req, const std::shared_ptr<PerformData>& data) {
+    auto size = req.SerializedSize();
+    auto* out = shared_exchange_->Obtain(size);
+    if (!out) {
+      return PerformResultFuture();
+    }
+    req.SerializeToArray(pointer_cast<uint8_t*>(out));
+    auto deadline = CoarseMonoClock::now() + timeout_;
+    shared_exchange_->SendRequest(size, deadline);
+    return std::async(
+        std::launch::deferred,
+        [data, fetcher = SharedExchangeResponseFetcher(shared_exchange_, deadline)]() mutable {
+      rpc::CallResponsePtr response;
+      auto status = fetcher.Fetch(&data->resp, &response);
+      return data->Complete(status, std::move(response));
     });
   }
 
@@ -603,6 +710,8 @@ class PgClient::Impl {
   }
 
   std::unique_ptr<tserver::PgClientServiceProxy> proxy_;
+  // Shared with the futures of the requests sent through it.
+  std::shared_ptr<tserver::SharedExchange> shared_exchange_;
   rpc::RpcController controller_;
   uint64_t session_id_ = 0;
 
@@ -741,11 +850,10 @@ Status PgClient::DeleteDBSequences(int64_t db_oid) {
   return impl_->DeleteDBSequences(db_oid);
 }
 
-void PgClient::PerformAsync(
+PerformResultFuture PgClient::PerformAsync(
     tserver::PgPerformOptionsPB* options,
-    PgsqlOps* operations,
-    const PerformCallback& callback) {
-  impl_->PerformAsync(options, operations, callback);
+    PgsqlOps* operations) {
+  return impl_->PerformAsync(options, operations);
 }
 
 Result<bool> PgClient::CheckIfPitrActive() {
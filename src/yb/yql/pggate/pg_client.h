@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
 #include <optional>
 #include <string>
@@ -66,7 +67,7 @@ struct PerformResult {
   }
 };
 
-using PerformCallback = std::function<void(const PerformResult&)>;
+using PerformResultFuture = std::future<PerformResult>;
 
 class PgClient {
  public:
@@ -137,10 +138,9 @@ class PgClient {
 
   Status DeleteDBSequences(int64_t db_oid);
 
-  void PerformAsync(
+  PerformResultFuture PerformAsync(
       tserver::PgPerformOptionsPB* options,
-      PgsqlOps* operations,
-      const PerformCallback& callback);
+      PgsqlOps* operations);
 
   Result<bool> CheckIfPitrActive();
 
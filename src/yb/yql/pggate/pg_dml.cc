@@ -454,7 +454,7 @@ Result<bool> PgDml::GetNextRow(PgTuple *pg_tuple) {
       if (rowset.NextRowOrder() <= current_row_order_) {
         // Write row to postgres tuple.
         int64_t row_order = -1;
-        RETURN_NOT_OK(rowset.WritePgTuple(targets_, pg_tuple, &row_order));
+        RETURN_NOT_OK(rowset.WritePgTuple(targets_, group_by_, pg_tuple, &row_order));
         SCHECK(row_order == -1 || row_order == current_row_order_, InternalError,
                "The resulting row are not arranged in indexing order");
 
@@ -196,6 +196,10 @@ class PgDml : public PgStatement {
   PgTable target_;
   std::vector<PgExpr*> targets_;
 
+  // Grouping expressions of SELECT with aggregate targets. Their values follow values of the
+  // targets in fetched rows.
+  std::vector<PgExpr*> group_by_;
+
   // Qual is a where clause condition pushed to the DocDB to filter scanned rows
   // Qual supports PgExprs holding serialized Postgres expressions, and require the column
   // references used in these Quals to be explicitly added with AppendColumnRef()
@@ -23,6 +23,7 @@
 
 #include "yb/common/partition.h"
 #include "yb/common/pg_system_attr.h"
+#include "yb/common/ql_value.h"
 #include "yb/common/ql_datatype.h"
 #include "yb/common/row_mark.h"
 #include "yb/common/schema.h"
@@ -40,6 +41,7 @@
 #include "yb/yql/pggate/pg_select_index.h"
 #include "yb/yql/pggate/pg_table.h"
 #include "yb/yql/pggate/pg_tabledesc.h"
+#include "yb/yql/pggate/pggate_flags.h"
 #include "yb/yql/pggate/ybc_pg_typedefs.h"
 
 #include "yb/util/status_format.h"
@@ -143,6 +145,28 @@ LWPgsqlExpressionPB *PgDmlRead::AllocColumnAssignPB(PgColumn *col) {
   return nullptr;
 }
 
+Status PgDmlRead::AppendGroupBy(PgExpr *group_by) {
+  group_by_.push_back(group_by);
+  auto* expr_pb = read_req_->add_group_by_exprs();
+  RETURN_NOT_OK(group_by->PrepareForRead(this, expr_pb));
+  expr_binds_[expr_pb] = group_by;
+  return Status::OK();
+}
+
+Status PgDmlRead::AppendOrderBy(PgExpr *order_by, bool is_descending, bool nulls_first) {
+  auto* order_by_pb = read_req_->add_order_by();
+  order_by_pb->set_is_descending(is_descending);
+  order_by_pb->set_nulls_first(nulls_first);
+  auto* expr_pb = order_by_pb->mutable_expr();
+  RETURN_NOT_OK(order_by->PrepareForRead(this, expr_pb));
+  expr_binds_[expr_pb] = order_by;
+  return Status::OK();
+}
+
+void PgDmlRead::SetOrderByLimit(uint64_t limit) {
+  read_req_->set_order_by_limit(limit);
+}
+
 LWPgsqlExpressionPB *PgDmlRead::AllocTargetPB() {
   return read_req_->add_targets();
 }
@@ -302,8 +326,8 @@ Status PgDmlRead::Exec(const PgExecParameters *exec_params) {
   const auto row_mark_type = GetRowMarkType(exec_params);
   if (has_doc_op() &&
       !secondary_index_query_ &&
-      IsValidRowMarkType(row_mark_type) &&
-      CanBuildYbctidsFromPrimaryBinds()) {
+      ((IsValidRowMarkType(row_mark_type) && CanBuildYbctidsFromPrimaryBinds()) ||
+       CanBuildYbctidsFromHashInBinds())) {
     RETURN_NOT_OK(SubstitutePrimaryBindsWithYbctids(exec_params));
   } else {
     RETURN_NOT_OK(ProcessEmptyPrimaryBinds());
@@ -667,52 +691,97 @@ Status PgDmlRead::SubstitutePrimaryBindsWithYbctids(const PgExecParameters* exec
 }
 
 // Function builds vector of ybctids from primary key binds.
-// Required precondition that one and only one range key component has IN clause and all
-// other key components are set must be checked by caller code.
+// Required precondition that all key components are set by equalities or IN clauses must be checked
+// by caller code. IN clause with tuple on the left side sets several key components at once, it is
+// bound to one of them, and other components of the tuple have no bound value.
 Result<std::vector<std::string>> PgDmlRead::BuildYbctidsFromPrimaryBinds() {
-  auto hashed_values = arena().AllocateArray<LWQLValuePB*>(bind_->num_hash_key_columns());
-  vector<docdb::KeyEntryValue> hashed_components, range_components;
-  hashed_components.reserve(bind_->num_hash_key_columns());
-  range_components.reserve(bind_->num_key_columns() - bind_->num_hash_key_columns());
-  for (size_t i = 0; i < bind_->num_hash_key_columns(); ++i) {
-    auto& col = bind_.ColumnForIndex(i);
-    hashed_components.push_back(VERIFY_RESULT(
-        BuildKeyColumnValue(col, *col.bind_pb(), hashed_values + i)));
-  }
-
-  DocKeyBuilder dockey_builder;
-  RETURN_NOT_OK(dockey_builder.Prepare(
-      hashed_components, hashed_values, bind_->partition_schema()));
-
-  for (size_t i = bind_->num_hash_key_columns(); i < bind_->num_key_columns(); ++i) {
-    auto& col = bind_.ColumnForIndex(i);
-    auto& expr = *col.bind_pb();
+  // Key components set by the same equality or IN clause, and their alternative values.
+  struct KeyComponentsValues {
+    std::vector<size_t> indexes;
+    std::vector<std::vector<const LWQLValuePB*>> values;
+  };
+
+  const auto num_key_columns = bind_->num_key_columns();
+  const auto num_hash_key_columns = bind_->num_hash_key_columns();
+  std::vector<KeyComponentsValues> components_values;
+  size_t num_permutations = 1;
+  for (size_t i = 0; i < num_key_columns; ++i) {
+    const auto& col = bind_.ColumnForIndex(i);
+    const auto& expr = *col.bind_pb();
     // For IN clause expr->has_condition() returns 'true'.
-    if (expr.has_condition()) {
-      const auto prefix_len = range_components.size();
-      // Form ybctid for each value in IN clause.
-      std::vector<std::string> ybctids;
-      auto it = expr.condition().operands().begin();
-      ++it;
-      for (const auto& in_exp : it->condition().operands()) {
-        range_components.push_back(VERIFY_RESULT(BuildKeyColumnValue(col, in_exp)));
-        // Range key component has one and only one IN clause,
-        // all remains components has explicit values. Add them as is.
-        for (size_t j = i + 1; j < bind_->num_key_columns(); ++j) {
-          auto& suffix_col = bind_.ColumnForIndex(j);
-          range_components.push_back(VERIFY_RESULT(
-              BuildKeyColumnValue(suffix_col, *suffix_col.bind_pb())));
-        }
-        const auto doc_key = dockey_builder(range_components);
-        ybctids.push_back(doc_key.Encode().ToStringBuffer());
-        range_components.resize(prefix_len);
+    if (!expr.has_condition()) {
+      if (expr_binds_.find(&expr) != expr_binds_.end()) {
+        components_values.push_back(KeyComponentsValues {
+          .indexes = {i},
+          .values = {{VERIFY_RESULT(GetBoundValue(col, expr))}},
+        });
+      }
+      continue;
+    }
+    auto& current = components_values.emplace_back();
+    auto it = expr.condition().operands().begin();
+    const auto is_tuple = it->has_tuple();
+    if (is_tuple) {
+      for (const auto& elem : it->tuple().elems()) {
+        current.indexes.push_back(elem.column_id() - bind_->schema().first_column_id());
       }
-      return ybctids;
     } else {
-      range_components.push_back(VERIFY_RESULT(BuildKeyColumnValue(col, expr)));
+      current.indexes.push_back(i);
+    }
+    ++it;
+    for (const auto& in_exp : it->condition().operands()) {
+      // Value of the tuple is evaluated only once, because it is appended to the tuple value.
+      const auto* value = VERIFY_RESULT(GetBoundValue(col, in_exp));
+      auto& values = current.values.emplace_back();
+      if (is_tuple) {
+        if (value) {
+          for (const auto& elem_value : value->tuple_value().elems()) {
+            values.push_back(&elem_value);
+          }
+        }
+        values.resize(current.indexes.size());
+      } else {
+        values.push_back(value);
+      }
+    }
+    num_permutations *= current.values.size();
+  }
+
+  std::vector<const LWQLValuePB*> values(num_key_columns);
+  vector<docdb::KeyEntryValue> hashed_components, range_components;
+  hashed_components.reserve(num_hash_key_columns);
+  range_components.reserve(num_key_columns - num_hash_key_columns);
+  std::vector<std::string> ybctids;
+  ybctids.reserve(num_permutations);
+  for (size_t permutation = 0; permutation != num_permutations; ++permutation) {
+    auto pos = permutation;
+    for (const auto& current : components_values) {
+      const auto& current_values = current.values[pos % current.values.size()];
+      pos /= current.values.size();
+      for (size_t j = 0; j != current.indexes.size(); ++j) {
+        values[current.indexes[j]] = current_values[j];
+      }
+    }
+    if (std::any_of(values.begin(), values.end(), [](const auto* value) {
+          return !value || IsNull(*value);
+        })) {
+      // NULL never matches the key, so there is no row to read for this permutation.
+      continue;
+    }
+
+    hashed_components.clear();
+    range_components.clear();
+    for (size_t i = 0; i < num_key_columns; ++i) {
+      auto& components = i < num_hash_key_columns ? hashed_components : range_components;
+      components.push_back(docdb::KeyEntryValue::FromQLValuePB(
+          *values[i], bind_.ColumnForIndex(i).desc().sorting_type()));
     }
+    DocKeyBuilder dockey_builder;
+    RETURN_NOT_OK(dockey_builder.Prepare(
+        hashed_components, values.data(), bind_->partition_schema()));
+    ybctids.push_back(dockey_builder(range_components).Encode().ToStringBuffer());
   }
-  return STATUS(IllegalState, "Can't build ybctids, bad preconditions");
+  return ybctids;
 }
 
 bool PgDmlRead::IsAllPrimaryKeysBound(size_t num_range_components_in_expected) {
@@ -745,6 +814,68 @@ bool PgDmlRead::CanBuildYbctidsFromPrimaryBinds() {
   return IsAllPrimaryKeysBound(1 /* num_range_components_in_expected */);
 }
 
+// Function checks that all key components are set by equalities or IN clauses, and at least one
+// hash key component is set by IN clause. Such binds are produced for the inner side of the batched
+// nested loop join, that zips clauses of the multicolumn join into the tuple IN clause. Reading
+// them by ybctids sends one request per tablet, instead of one request per hash key permutation.
+// The number of ybctids is limited by ysql_request_limit, larger permutation sets are read in
+// several rounds of hash permutation requests.
+bool PgDmlRead::CanBuildYbctidsFromHashInBinds() {
+  if (!FLAGS_ysql_enable_hash_key_ybctid_batching || !bind_) {
+    return false;
+  }
+
+  // Batched ybctid read evaluates neither aggregates and ordering, nor condition_expr.
+  const auto& req = *read_req_;
+  if (req.is_aggregate() || !req.group_by_exprs().empty() || !req.order_by().empty() ||
+      req.has_condition_expr()) {
+    return false;
+  }
+
+  const auto num_key_columns = bind_->num_key_columns();
+  const auto num_hash_key_columns = bind_->num_hash_key_columns();
+  // Tuple IN clause is bound to one of its key components, so components are checked after all
+  // binds are processed.
+  std::vector<bool> bound_components(num_key_columns);
+  bool has_hash_in_clause = false;
+  size_t num_ybctids = 1;
+  for (size_t i = 0; i < num_key_columns; ++i) {
+    const auto* expr = bind_.ColumnForIndex(i).bind_pb();
+    if (!expr) {
+      continue;
+    }
+    // For IN clause expr->has_condition() returns 'true'.
+    if (!expr->has_condition()) {
+      bound_components[i] = expr_binds_.find(expr) != expr_binds_.end();
+      continue;
+    }
+    auto it = expr->condition().operands().begin();
+    if (it->has_tuple()) {
+      for (const auto& elem : it->tuple().elems()) {
+        const size_t index = elem.column_id() - bind_->schema().first_column_id();
+        if (index >= num_key_columns) {
+          // Tuple contains non key column.
+          return false;
+        }
+        bound_components[index] = true;
+        has_hash_in_clause = has_hash_in_clause || index < num_hash_key_columns;
+      }
+    } else {
+      bound_components[i] = true;
+      has_hash_in_clause = has_hash_in_clause || i < num_hash_key_columns;
+    }
+    ++it;
+    num_ybctids *= it->condition().operands().size();
+    if (num_ybctids > static_cast<size_t>(FLAGS_ysql_request_limit)) {
+      return false;
+    }
+  }
+  return has_hash_in_clause &&
+         std::all_of(bound_components.begin(), bound_components.end(), [](bool bound) {
+           return bound;
+         });
+}
+
 // Moves IN operator bound for range key component into 'condition_expr' field
 Status PgDmlRead::MoveBoundKeyInOperator(PgColumn* col, const LWPgsqlConditionPB& in_operator) {
   auto* condition_expr_pb = AllocColumnBindConditionExprPB(col);
@@ -73,6 +73,15 @@ class PgDmlRead : public PgDml {
   // Set forward (or backward) scan.
   void SetForwardScan(const bool is_forward_scan);
 
+  // Append a grouping expression of aggregate targets.
+  Status AppendGroupBy(PgExpr *group_by);
+
+  // Append a sort key, tablets return only first rows in the order of the sort keys.
+  Status AppendOrderBy(PgExpr *order_by, bool is_descending, bool nulls_first);
+
+  // Set the number of rows returned by each tablet when sort keys are specified.
+  void SetOrderByLimit(uint64_t limit);
+
   // Bind a range column with a BETWEEN condition.
   Status BindColumnCondBetween(int attr_num, PgExpr *attr_value,
                                bool start_inclusive,
@@ -142,6 +151,7 @@ class PgDmlRead : public PgDml {
   Status ProcessEmptyPrimaryBinds();
   bool IsAllPrimaryKeysBound(size_t num_range_components_in_expected);
   bool CanBuildYbctidsFromPrimaryBinds();
+  bool CanBuildYbctidsFromHashInBinds();
   Result<std::vector<std::string>> BuildYbctidsFromPrimaryBinds();
   Status SubstitutePrimaryBindsWithYbctids(const PgExecParameters* exec_params);
   Result<docdb::DocKey> EncodeRowKeyForBound(
@@ -130,7 +130,9 @@ int64_t PgDocResult::NextRowOrder() {
   return current_row_order_ != row_orders_.end() ? *current_row_order_ : -1;
 }
 
-Status PgDocResult::WritePgTuple(const std::vector<PgExpr*>& targets, PgTuple *pg_tuple,
+Status PgDocResult::WritePgTuple(const std::vector<PgExpr*>& targets,
+                                 const std::vector<PgExpr*>& group_by,
+                                 PgTuple *pg_tuple,
                                  int64_t *row_order) {
   int attr_num = 0;
   for (const PgExpr *target : targets) {
@@ -148,6 +150,12 @@ Status PgDocResult::WritePgTuple(const std::vector<PgExpr*>& targets, PgTuple *p
     target->TranslateData(&row_iterator_, header, attr_num - 1, pg_tuple);
   }
 
+  // Values of grouping expressions follow aggregate values.
+  for (const PgExpr *expr : group_by) {
+    PgWireDataHeader header = PgDocData::ReadDataHeader(&row_iterator_);
+    expr->TranslateData(&row_iterator_, header, attr_num++, pg_tuple);
+  }
+
   *row_order = current_row_order_ != row_orders_.end() ? *current_row_order_++ : -1;
   return Status::OK();
 }
@@ -494,7 +502,8 @@ Result<bool> PgDocReadOp::DoCreateRequests() {
   // parallel execution of requests with aggregates, but this implicit criteria is not reliable.
   // TODO(GHI 13737): as explained above, explicitly indicate, if operation should return ordered
   // results.
-  } else if (req.is_aggregate() ||
+  // Rows of the top-N request are sorted by the caller anyway.
+  } else if (req.is_aggregate() || !req.order_by().empty() ||
              (!table_->IsRangePartitioned() && !req.where_clauses().empty())) {
     return PopulateParallelSelectOps();
 
@@ -56,7 +56,9 @@ class PgDocResult {
   }
 
   // Get the postgres tuple from this batch.
-  Status WritePgTuple(const std::vector<PgExpr*>& targets, PgTuple* pg_tuple, int64_t* row_order);
+  Status WritePgTuple(
+      const std::vector<PgExpr*>& targets, const std::vector<PgExpr*>& group_by,
+      PgTuple* pg_tuple, int64_t* row_order);
 
   // Get system columns' values from this batch.
   // Currently, we only have ybctids, but there could be more.
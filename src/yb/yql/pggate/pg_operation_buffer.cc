@@ -13,8 +13,10 @@
 
 #include "yb/yql/pggate/pg_operation_buffer.h"
 
+#include <algorithm>
 #include <string>
 #include <ostream>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -148,6 +150,8 @@ using RowKeys = std::unordered_set<RowIdentifier, boost::hash<RowIdentifier>>;
 
 struct InFlightOperation {
   RowKeys keys;
+  // Tables used by keys.
+  std::unordered_set<PgObjectId, PgObjectIdHash> tables;
   PerformFuture future;
 
   explicit InFlightOperation(PerformFuture future_)
@@ -157,14 +161,43 @@ struct InFlightOperation {
 using InFlightOps = boost::circular_buffer_space_optimized<InFlightOperation,
                                                            std::allocator<InFlightOperation>>;
 
-void EnsureCapacity(InFlightOps* in_flight_ops, BufferingSettings buffering_settings) {
+// Destination tablet of buffered operations.
+struct TabletBatchId {
+  PgObjectId table_id;
+  size_t partition;
+  bool transactional;
+
+  bool operator==(const TabletBatchId& rhs) const {
+    return table_id == rhs.table_id && partition == rhs.partition &&
+           transactional == rhs.transactional;
+  }
+
+  friend size_t hash_value(const TabletBatchId& id) {
+    size_t hash = 0;
+    boost::hash_combine(hash, id.table_id);
+    boost::hash_combine(hash, id.partition);
+    boost::hash_combine(hash, id.transactional);
+    return hash;
+  }
+};
+
+struct TabletBatch {
+  BufferableOperations ops;
+  RowKeys keys;
+};
+
+using TabletBatches = std::unordered_map<TabletBatchId, TabletBatch, boost::hash<TabletBatchId>>;
+
+// With per tablet batching the number of in-flight RPCs is limited by the number of tablets rather
+// than by max_batch_size, because each of them could receive a partial batch.
+void EnsureCapacity(
+    InFlightOps* in_flight_ops, BufferingSettings buffering_settings, size_t num_tablets) {
   size_t capacity = in_flight_ops->capacity();
-  size_t num_buffers_needed =
-    (buffering_settings.max_in_flight_operations / buffering_settings.max_batch_size) + 1;
-  // Change the capacity of the buffer if needed. This will only be different when
-  // buffering_settings_ is changed in StartOperationsBuffering(), or right after construction
-  // of the buffer. As such, we don't have to worry about set_capacity() dropping any
-  // InFlightOperations, since there are guaranteed to be none.
+  size_t num_buffers_needed = std::max(
+      buffering_settings.max_in_flight_operations / buffering_settings.max_batch_size,
+      num_tablets) + 1;
+  // Change the capacity of the buffer if needed. Increasing of the capacity keeps the
+  // InFlightOperations, and it is never decreased, so set_capacity() doesn't drop any of them.
   if (capacity < num_buffers_needed) {
     in_flight_ops->set_capacity(num_buffers_needed);
   }
@@ -215,6 +248,10 @@ class PgOperationBuffer::Impl {
     return ClearOnError(DoFlush());
   }
 
+  Status FlushFor(const PgTableDesc& table, const PgsqlOp& op) {
+    return ClearOnError(DoFlushFor(table, op));
+  }
+
   Result<BufferableOperations> FlushTake(
       const PgTableDesc& table, const PgsqlOp& op, bool transactional) {
     return ClearOnError(DoFlushTake(table, op, transactional));
@@ -228,6 +265,7 @@ class PgOperationBuffer::Impl {
     VLOG_IF(1, !keys_.empty()) << "Dropping " << keys_.size() << " pending operations";
     ops_.Clear();
     txn_ops_.Clear();
+    tablet_batches_.clear();
     keys_.clear();
     // Clearing of in_flight_ops_ might get blocked on future::get()
     // (see PerformFuture::~PerformFuture() for details). And due to the #12884 issue
@@ -277,6 +315,9 @@ class PgOperationBuffer::Impl {
         }
       }
     }
+    if (buffering_settings_.batch_per_tablet) {
+      return AddToTabletBatch(table, std::move(op), transactional, std::move(row_id));
+    }
     auto& target = (transactional ? txn_ops_ : ops_);
     if (target.empty()) {
       target.Reserve(buffering_settings_.max_batch_size);
@@ -287,11 +328,72 @@ class PgOperationBuffer::Impl {
       : Status::OK();
   }
 
+  // Operations are grouped by destination tablet, and the group is sent as a separate RPC when it
+  // reaches max_batch_size. So each tablet receives full sized batches, and batches for different
+  // tablets complete independently. The total number of buffered operations is limited by
+  // max_in_flight_operations, the largest group is sent when the limit is reached.
+  Status AddToTabletBatch(
+      const PgTableDesc& table, PgsqlWriteOpPtr op, bool transactional, RowIdentifier row_id) {
+    const auto partition = VERIFY_RESULT(table.FindPartitionIndex(row_id.ybctid()));
+    auto it = tablet_batches_.try_emplace(
+        TabletBatchId{table.id(), partition, transactional}).first;
+    num_batched_tablets_ = std::max(num_batched_tablets_, tablet_batches_.size());
+    auto& batch = it->second;
+    if (batch.ops.empty()) {
+      batch.ops.Reserve(buffering_settings_.max_batch_size);
+    }
+    batch.ops.Add(std::move(op), table.id());
+    batch.keys.insert(std::move(row_id));
+    if (batch.keys.size() >= buffering_settings_.max_batch_size) {
+      return SendTabletBatch(it);
+    }
+    const auto max_buffered_operations = std::max(
+        buffering_settings_.max_in_flight_operations, buffering_settings_.max_batch_size);
+    if (keys_.size() < max_buffered_operations) {
+      return Status::OK();
+    }
+    return SendTabletBatch(std::max_element(
+        tablet_batches_.begin(), tablet_batches_.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.second.keys.size() < rhs.second.keys.size();
+    }));
+  }
+
+  Status SendTabletBatch(TabletBatches::iterator it) {
+    const auto transactional = it->first.transactional;
+    auto batch = std::move(it->second);
+    tablet_batches_.erase(it);
+    for (const auto& key : batch.keys) {
+      keys_.erase(key);
+    }
+    const auto ops_count = batch.keys.size();
+    if (VERIFY_RESULT(SendOperations(
+            nullptr /* interceptor */, std::move(batch.ops), transactional, ops_count))) {
+      SetInFlightKeys(std::move(batch.keys));
+    }
+    return Status::OK();
+  }
+
+  // Moves operations of all tablet batches to the common buffers, to send them together.
+  void MergeTabletBatches() {
+    for (auto& [id, batch] : tablet_batches_) {
+      auto& target = (id.transactional ? txn_ops_ : ops_);
+      for (size_t i = 0; i != batch.ops.size(); ++i) {
+        target.Add(std::move(batch.ops.operations[i]), batch.ops.relations[i]);
+      }
+    }
+    tablet_batches_.clear();
+  }
+
   Status DoFlush() {
     RETURN_NOT_OK(SendBuffer());
     return EnsureAllCompleted();
   }
 
+  Status DoFlushFor(const PgTableDesc& table, const PgsqlOp& op) {
+    RETURN_NOT_OK(SendBuffer());
+    return EnsureDependenciesCompleted(table, op);
+  }
+
   Result<BufferableOperations> DoFlushTake(
       const PgTableDesc& table, const PgsqlOp& op, bool transactional) {
     BufferableOperations result;
@@ -306,7 +408,7 @@ class PgOperationBuffer::Impl {
             }
             return false;
           })));
-      RETURN_NOT_OK(EnsureAllCompleted());
+      RETURN_NOT_OK(EnsureDependenciesCompleted(table, op));
     }
     return result;
   }
@@ -323,6 +425,35 @@ class PgOperationBuffer::Impl {
     return EnsureCompleted(in_flight_ops_.size());
   }
 
+  // Waits for the latest in-flight operation the op depends on, and all preceding ones.
+  // In-flight operations are not reordered, so the errors are reported in the order of operations.
+  Status EnsureDependenciesCompleted(const PgTableDesc& table, const PgsqlOp& op) {
+    if (!buffering_settings_.flush_dependent_ops_only) {
+      return EnsureAllCompleted();
+    }
+    for (auto i = in_flight_ops_.size(); i > 0; --i) {
+      if (IsDependentOn(table, op, in_flight_ops_[i - 1])) {
+        return EnsureCompleted(i);
+      }
+    }
+    return Status::OK();
+  }
+
+  static bool IsDependentOn(
+      const PgTableDesc& table, const PgsqlOp& op, const InFlightOperation& in_flight_op) {
+    if (op.is_read()) {
+      const auto& request = down_cast<const PgsqlReadOp&>(op).read_request();
+      for (const auto& table_id : in_flight_op.tables) {
+        if (IsTableUsedByRequest(request, table_id.GetYbTableId())) {
+          return true;
+        }
+      }
+      return false;
+    }
+    return in_flight_op.keys.count(RowIdentifier(
+        table.id(), table.schema(), down_cast<const PgsqlWriteOp&>(op).write_request())) != 0;
+  }
+
   Status EnsureCompleted(size_t count) {
     for(; count && !in_flight_ops_.empty(); --count) {
       RETURN_NOT_OK(in_flight_ops_.front().future.Get(&rpc_wait_time_));
@@ -346,6 +477,7 @@ class PgOperationBuffer::Impl {
     if (keys_.empty()) {
       return Status::OK();
     }
+    MergeTabletBatches();
     BufferableOperations ops;
     BufferableOperations txn_ops;
     RowKeys keys;
@@ -360,17 +492,25 @@ class PgOperationBuffer::Impl {
       interceptor, std::move(ops),
       false /* transactional */, ops_sent ? 0 : ops_count)) || ops_sent;
     if (ops_sent) {
-      in_flight_ops_.back().keys = std::move(keys);
+      SetInFlightKeys(std::move(keys));
     }
     return Status::OK();
   }
 
+  void SetInFlightKeys(RowKeys keys) {
+    auto& in_flight_op = in_flight_ops_.back();
+    for (const auto& key : keys) {
+      in_flight_op.tables.insert(key.table_id());
+    }
+    in_flight_op.keys = std::move(keys);
+  }
+
   Result<bool> SendOperations(const SendInterceptor* interceptor,
                               BufferableOperations ops,
                               bool transactional,
                               size_t ops_count) {
     if (!ops.empty() && !(interceptor && (*interceptor)(&ops, transactional))) {
-      EnsureCapacity(&in_flight_ops_, buffering_settings_);
+      EnsureCapacity(&in_flight_ops_, buffering_settings_, num_batched_tablets_);
       // In case max_in_flight_operations < max_batch_size, the number of in-flight operations will
       // be equal to max_batch_size after sending single buffer. So use max of these values for
       // actual_max_in_flight_operations.
@@ -378,8 +518,11 @@ class PgOperationBuffer::Impl {
           buffering_settings_.max_in_flight_operations,
           buffering_settings_.max_batch_size);
       int64_t space_required = (InFlightOpsCount() + ops_count) - actual_max_in_flight_operations;
+      // Tablet batches could be smaller than max_batch_size. Capacity of in_flight_ops_ covers all
+      // batched tablets, but wait for the oldest operation in case it is full anyway.
       while (!in_flight_ops_.empty() &&
-             (space_required > 0 || in_flight_ops_.front().future.Ready())) {
+             (space_required > 0 || in_flight_ops_.full() ||
+              in_flight_ops_.front().future.Ready())) {
         space_required -= in_flight_ops_.front().keys.size();
         RETURN_NOT_OK(EnsureCompleted(1));
       }
@@ -411,8 +554,11 @@ class PgOperationBuffer::Impl {
   const BufferingSettings& buffering_settings_;
   BufferableOperations ops_;
   BufferableOperations txn_ops_;
+  TabletBatches tablet_batches_;
   RowKeys keys_;
   InFlightOps in_flight_ops_;
+  // The max number of tablets with simultaneously buffered operations.
+  size_t num_batched_tablets_ = 0;
   uint64_t rpc_count_ = 0;
   MonoDelta rpc_wait_time_ = MonoDelta::FromNanoseconds(0);
 };
@@ -432,6 +578,10 @@ Status PgOperationBuffer::Flush() {
     return impl_->Flush();
 }
 
+Status PgOperationBuffer::FlushFor(const PgTableDesc& table, const PgsqlOp& op) {
+  return impl_->FlushFor(table, op);
+}
+
 Result<BufferableOperations> PgOperationBuffer::FlushTake(
     const PgTableDesc& table, const PgsqlOp& op, bool transactional) {
   return impl_->FlushTake(table, op, transactional);
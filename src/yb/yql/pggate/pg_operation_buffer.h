@@ -31,6 +31,10 @@ namespace pggate {
 struct BufferingSettings {
   size_t max_batch_size;
   size_t max_in_flight_operations;
+  // Non bufferable operation waits only for in-flight operations it depends on.
+  bool flush_dependent_ops_only;
+  // Buffered operations are grouped by destination tablet, and each group is sent separately.
+  bool batch_per_tablet;
 };
 
 struct BufferableOperations {
@@ -53,6 +57,9 @@ class PgOperationBuffer {
   ~PgOperationBuffer();
   Status Add(const PgTableDesc& table, PgsqlWriteOpPtr op, bool transactional);
   Status Flush();
+  // Sends buffered operations, and waits for in-flight operations the op depends on.
+  // All of them are waited for in case flush_dependent_ops_only is not set.
+  Status FlushFor(const PgTableDesc& table, const PgsqlOp& op);
   Result<BufferableOperations> FlushTake(
       const PgTableDesc& table, const PgsqlOp& op, bool transactional);
   size_t Size() const;
@@ -151,6 +151,8 @@ void Update(BufferingSettings* buffering_settings) {
     ? FLAGS_ysql_session_max_batch_size
     : static_cast<uint64_t>(ysql_session_max_batch_size);
   buffering_settings->max_in_flight_operations = static_cast<uint64_t>(ysql_max_in_flight_ops);
+  buffering_settings->flush_dependent_ops_only = FLAGS_ysql_flush_dependent_ops_only;
+  buffering_settings->batch_per_tablet = FLAGS_ysql_enable_per_tablet_write_batching;
 }
 
 RowMarkType GetRowMarkType(const PgsqlOp& op) {
@@ -202,8 +204,10 @@ class PgSession::RunHelper {
       // Buffered operations must be flushed independently in this case.
       // Also operations for catalog session can be combined with buffered operations
       // as catalog session is used for read-only operations.
-      if ((IsTransactional() && in_txn_limit && *in_txn_limit) || IsCatalog()) {
+      if (IsCatalog()) {
         RETURN_NOT_OK(buffer.Flush());
+      } else if (IsTransactional() && in_txn_limit && *in_txn_limit) {
+        RETURN_NOT_OK(buffer.FlushFor(table, *op));
       } else {
         operations_ = VERIFY_RESULT(buffer.FlushTake(table, *op, IsTransactional()));
         read_only = read_only && operations_.empty();
@@ -232,7 +236,7 @@ class PgSession::RunHelper {
         read_only, txn_priority_requirement, in_txn_limit);
   }
 
-  Result<PerformFuture> Flush(std::string&& cache_key) {
+  Result<PerformFuture> Flush(CacheOptions&& cache_options) {
     if (operations_.empty()) {
       // All operations were buffered, no need to flush.
       return PerformFuture();
@@ -240,7 +244,7 @@ class PgSession::RunHelper {
 
     return pg_session_.Perform(
         std::move(operations_),
-        {.use_catalog_session = IsCatalog(), .cache_key = std::move(cache_key)});
+        {.use_catalog_session = IsCatalog(), .cache_options = std::move(cache_options)});
   }
 
  private:
@@ -552,8 +556,6 @@ Result<PerformFuture> PgSession::Perform(BufferableOperations&& ops, PerformOpti
       yb_xcluster_consistency_level == XCLUSTER_CONSISTENCY_DATABASE &&
       !(ops_options.use_catalog_session || pg_txn_manager_->IsDdlMode()));
 
-  auto promise = std::make_shared<std::promise<PerformResult>>();
-
   // If all operations belong to the same database then set the namespace.
   // System database template1 is ignored as we may read global system catalog like tablespaces
   // in the same batch.
@@ -581,14 +583,14 @@ Result<PerformFuture> PgSession::Perform(BufferableOperations&& ops, PerformOpti
     }
   }
 
-  if (!ops_options.cache_key.empty()) {
-    options.mutable_caching_info()->set_key(std::move(ops_options.cache_key));
+  if (!ops_options.cache_options.key.empty()) {
+    auto& caching_info = *options.mutable_caching_info();
+    caching_info.set_key(std::move(ops_options.cache_options.key));
+    caching_info.set_version(ops_options.cache_options.version);
   }
 
-  pg_client_.PerformAsync(&options, &ops.operations, [promise](const PerformResult& result) {
-    promise->set_value(result);
-  });
-  return PerformFuture(promise->get_future(), this, std::move(ops.relations));
+  return PerformFuture(
+      pg_client_.PerformAsync(&options, &ops.operations), this, std::move(ops.relations));
 }
 
 void PgSession::ProcessPerformOnTxnSerialNo(
@@ -770,7 +772,7 @@ Status PgSession::ValidatePlacement(const std::string& placement_info) {
 template<class Generator>
 Result<PerformFuture> PgSession::DoRunAsync(
     const Generator& generator, uint64_t* in_txn_limit,
-    ForceNonBufferable force_non_bufferable, std::string&& cache_key) {
+    ForceNonBufferable force_non_bufferable, CacheOptions&& cache_options) {
   auto table_op = generator();
   SCHECK(!table_op.IsEmpty(), IllegalState, "Operation list must not be empty");
   const auto* table = table_op.table;
@@ -790,30 +792,31 @@ Result<PerformFuture> PgSession::DoRunAsync(
     has_write_ops_in_ddl_mode_ = has_write_ops_in_ddl_mode_ || (ddl_mode && !IsReadOnly(**op));
     RETURN_NOT_OK(runner.Apply(*table, *op, in_txn_limit, force_non_bufferable));
   }
-  return runner.Flush(std::move(cache_key));
+  return runner.Flush(std::move(cache_options));
 }
 
 Result<PerformFuture> PgSession::RunAsync(const OperationGenerator& generator,
                                           uint64_t* in_txn_limit,
                                           ForceNonBufferable force_non_bufferable) {
   return DoRunAsync(
-      generator, in_txn_limit, force_non_bufferable, std::string() /* cache_key */);
+      generator, in_txn_limit, force_non_bufferable, CacheOptions());
 }
 
 Result<PerformFuture> PgSession::RunAsync(const ReadOperationGenerator& generator,
                                           uint64_t* in_txn_limit,
                                           ForceNonBufferable force_non_bufferable) {
   return DoRunAsync(
-      generator, in_txn_limit, force_non_bufferable, std::string() /* cache_key */);
+      generator, in_txn_limit, force_non_bufferable, CacheOptions());
 }
 
 Result<PerformFuture> PgSession::RunAsyncCacheable(
-    const ReadOperationGenerator& generator, uint64_t* in_txn_limit, std::string&& cache_key) {
-  SCHECK(!cache_key.empty(), InvalidArgument, "Cache key can't be empty");
+    const ReadOperationGenerator& generator, uint64_t* in_txn_limit,
+    CacheOptions&& cache_options) {
+  SCHECK(!cache_options.key.empty(), InvalidArgument, "Cache key can't be empty");
   // Ensure no buffered requests will be added to cached request.
   RETURN_NOT_OK(buffer_.Flush());
   return DoRunAsync(
-      generator, in_txn_limit, ForceNonBufferable::kFalse, std::move(cache_key));
+      generator, in_txn_limit, ForceNonBufferable::kFalse, std::move(cache_options));
 }
 
 Result<bool> PgSession::CheckIfPitrActive() {
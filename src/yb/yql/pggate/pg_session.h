@@ -56,6 +56,14 @@ YB_STRONGLY_TYPED_BOOL(ForceNonBufferable);
 class PgTxnManager;
 class PgSession;
 
+// Identifies the response of a read request in the t-server response cache.
+// The key is a fingerprint of the request, version is the catalog version the request was built
+// for. Empty key means that the response should not be cached.
+struct CacheOptions {
+  std::string key;
+  uint64_t version = 0;
+};
+
 struct LightweightTableYbctid {
   LightweightTableYbctid(PgOid table_id_, const std::string_view& ybctid_)
       : table_id(table_id_), ybctid(ybctid_) {}
@@ -245,7 +253,8 @@ class PgSession : public RefCountedThreadSafe<PgSession> {
       const ReadOperationGenerator& generator, uint64_t* in_txn_limit,
       ForceNonBufferable force_non_bufferable = ForceNonBufferable::kFalse);
   Result<PerformFuture> RunAsyncCacheable(
-      const ReadOperationGenerator& generator, uint64_t* in_txn_limit, std::string&& cache_key);
+      const ReadOperationGenerator& generator, uint64_t* in_txn_limit,
+      CacheOptions&& cache_options);
 
   // Smart driver functions.
   // -------------
@@ -340,7 +349,7 @@ class PgSession : public RefCountedThreadSafe<PgSession> {
   struct PerformOptions {
     UseCatalogSession use_catalog_session = UseCatalogSession::kFalse;
     EnsureReadTimeIsSet ensure_read_time_is_set = EnsureReadTimeIsSet::kFalse;
-    std::string cache_key = std::string();
+    CacheOptions cache_options = CacheOptions();
   };
 
   Result<PerformFuture> Perform(BufferableOperations&& ops, PerformOptions&& options);
@@ -353,7 +362,7 @@ class PgSession : public RefCountedThreadSafe<PgSession> {
   template<class Generator>
   Result<PerformFuture> DoRunAsync(
       const Generator& generator, uint64_t* in_txn_limit,
-      ForceNonBufferable force_non_bufferable, std::string&& cache_key);
+      ForceNonBufferable force_non_bufferable, CacheOptions&& cache_options);
 
   struct TxnSerialNoPerformInfo {
     TxnSerialNoPerformInfo() : TxnSerialNoPerformInfo(0, ReadHybridTime()) {}
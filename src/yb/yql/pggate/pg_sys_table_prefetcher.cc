@@ -18,7 +18,9 @@
 #include <algorithm>
 #include <functional>
 #include <limits>
+#include <optional>
 #include <ostream>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -32,11 +34,21 @@
 
 #include "yb/rpc/outbound_call.h"
 
+#include "yb/util/coding.h"
+#include "yb/util/crc.h"
+#include "yb/util/env.h"
+#include "yb/util/faststring.h"
 #include "yb/util/flags/flag_tags.h"
 #include "yb/util/format.h"
 #include "yb/util/logging.h"
+#include "yb/util/path_util.h"
+#include "yb/util/ref_cnt_buffer.h"
+#include "yb/util/scope_exit.h"
 #include "yb/util/status.h"
+#include "yb/util/status_format.h"
 #include "yb/util/status_fwd.h"
+#include "yb/util/status_log.h"
+#include "yb/util/stol_utils.h"
 
 #include "yb/yql/pggate/pg_column.h"
 #include "yb/yql/pggate/pg_op.h"
@@ -227,21 +239,23 @@ void SetupPaging(LWPgsqlReadRequestPB* req) {
   req->set_limit(FLAGS_ysql_prefetch_limit);
 }
 
-std::string BuildCacheKey(
-    const std::vector<OperationInfo>& ops, uint64_t latest_known_ysql_catalog_version) {
+// Builds the fingerprint of the requests. Statement id differs between otherwise identical requests
+// from different backends, so it is excluded. Read time of the paging state is kept, so follow up
+// pages are served only from the load that returned the previous page, and rows of the scan are
+// read at the same time. Catalog version is not the part of the key, it is passed along with the
+// key as the entry version.
+std::string BuildCacheKey(const std::vector<OperationInfo>& ops) {
   using google::protobuf::io::CodedOutputStream;
   const auto kMaxFieldSize =
       CodedOutputStream::StaticVarintSize32<std::numeric_limits<uint32_t>::max()>::value;
-  auto total_size =
-      CodedOutputStream::VarintSize64(latest_known_ysql_catalog_version) +
-      ops.size() * kMaxFieldSize;
+  auto total_size = ops.size() * kMaxFieldSize;
   for (const auto& o : ops) {
     total_size += o.operation->read_request().SerializedSize();
   }
   std::string result;
   result.resize(total_size);
   auto* start = pointer_cast<uint8_t*>(result.data());
-  auto* out = CodedOutputStream::WriteVarint64ToArray(latest_known_ysql_catalog_version, start);
+  auto* out = start;
   for (const auto& o : ops) {
     auto& req = o.operation->read_request();
     std::optional<uint64_t> stmt_id;
@@ -281,7 +295,8 @@ Result<rpc::CallResponsePtr> Run(
   auto response = VERIFY_RESULT(PREDICT_FALSE(FLAGS_ysql_enable_read_request_caching)
       ? session->RunAsyncCacheable(
             make_lw_function(MakeGenerator(ops)), nullptr /* in_txn_limit */,
-            BuildCacheKey(ops, latest_known_ysql_catalog_version))
+            CacheOptions{.key = BuildCacheKey(ops),
+                         .version = latest_known_ysql_catalog_version})
       : session->RunAsync(make_lw_function(MakeGenerator(ops)), nullptr /* in_txn_limit */));
   return response.Get();
 }
@@ -370,6 +385,224 @@ class Loader {
   const uint64_t latest_known_ysql_catalog_version_;
 };
 
+using RegisteredTables = std::unordered_map<PgObjectId, PgObjectId, PgObjectIdHash>;
+
+// Snapshot of the prefetched sys tables data, stored in a file in the catalog snapshot directory.
+// The file is named after the set of loaded tables and the catalog version it was built for. So a
+// snapshot becomes outdated as soon as the catalog version is changed, and the snapshot for the new
+// version is written by the first backend that loads the same tables from the master.
+// File layout (all numbers are little endian fixed size):
+//   magic, crc32c of the rest of the file,
+//   catalog version, key,
+//   number of tables, and for each table:
+//     table id, targets, index id, index targets, number of rows data chunks, chunks.
+class CatalogSnapshot {
+ public:
+  static constexpr uint32_t kMagic = 0x53434259; // "YBCS"
+  static constexpr size_t kHeaderSize = 2 * sizeof(uint32_t);
+
+  CatalogSnapshot(const std::string& dir, uint64_t catalog_version, const RegisteredTables& tables)
+      : dir_(dir), catalog_version_(catalog_version) {
+    std::vector<std::pair<PgObjectId, PgObjectId>> sorted_tables(tables.begin(), tables.end());
+    std::sort(sorted_tables.begin(), sorted_tables.end(), [](const auto& lhs, const auto& rhs) {
+      return std::tie(lhs.first.database_oid, lhs.first.object_oid) <
+             std::tie(rhs.first.database_oid, rhs.first.object_oid);
+    });
+    for (const auto& [table_id, index_id] : sorted_tables) {
+      PutObjectId(&key_, table_id);
+      PutObjectId(&key_, index_id);
+    }
+    name_prefix_ = Format("$0.", crc::Crc32c(key_.data(), key_.size()));
+    path_ = JoinPathSegments(dir_, Format("$0$1$2", name_prefix_, catalog_version_, kSuffix));
+  }
+
+  // Loads data from the snapshot into the container.
+  // Returns false if there is no snapshot for the current catalog version.
+  Result<bool> Load(DataContainer* container) const {
+    auto* env = Env::Default();
+    if (!env->FileExists(path_)) {
+      return false;
+    }
+    auto result = DoLoad(env, container);
+    if (!result.ok() && result.status().IsCorruption()) {
+      // Remove corrupted snapshot, so it is rewritten by the backend that reads the master.
+      WARN_NOT_OK(env->DeleteFile(path_), "Failed to remove corrupted catalog snapshot");
+    }
+    return result;
+  }
+
+  // Writes data of the container to the snapshot, unless it was already written by another
+  // backend. Writers of the same set of tables are serialized by the lock file, and a backend that
+  // fails to acquire the lock does not wait for it and skips writing. The file is replaced
+  // atomically, so concurrent readers never see a partially written snapshot.
+  Status Save(const DataContainer& container) const {
+    auto* env = Env::Default();
+    RETURN_NOT_OK(env->CreateDirs(dir_));
+    FileLock* lock = nullptr;
+    if (!env->LockFile(SiblingPath(kLockName), &lock, false /* recursive_lock_ok */).ok()) {
+      VLOG(1) << "Catalog snapshot " << path_ << " is being written by another backend";
+      return Status::OK();
+    }
+    auto unlock = ScopeExit([env, lock] {
+      WARN_NOT_OK(env->UnlockFile(lock), "Failed to unlock catalog snapshot");
+    });
+    if (!env->FileExists(path_)) {
+      const auto tmp_path = SiblingPath(kTmpName);
+      auto status = Write(env, container, tmp_path);
+      if (!status.ok()) {
+        WARN_NOT_OK(env->DeleteFile(tmp_path), "Failed to remove catalog snapshot temp file");
+        return status;
+      }
+    }
+    return RemoveObsoleteFiles(env);
+  }
+
+ private:
+  static constexpr const char* kSuffix = ".snapshot";
+  static constexpr const char* kLockName = "lock";
+  static constexpr const char* kTmpName = "tmp";
+
+  std::string SiblingPath(const char* name) const {
+    return JoinPathSegments(dir_, name_prefix_ + name);
+  }
+
+  Result<bool> DoLoad(Env* env, DataContainer* container) const {
+    faststring content;
+    RETURN_NOT_OK(ReadFileToString(env, path_, &content));
+    RefCntBuffer buffer(content);
+    Slice data(buffer.AsSlice());
+    SCHECK_GE(data.size(), kHeaderSize, Corruption, "Catalog snapshot $0 is too short", path_);
+    SCHECK_EQ(
+        DecodeFixed32(data.data()), kMagic, Corruption, "Wrong catalog snapshot $0 magic", path_);
+    const auto crc = DecodeFixed32(data.data() + sizeof(uint32_t));
+    data.remove_prefix(kHeaderSize);
+    SCHECK_EQ(
+        crc::Crc32c(data.data(), data.size()), crc, Corruption,
+        "Wrong catalog snapshot $0 checksum", path_);
+
+    if (VERIFY_RESULT(ReadFixed64(&data)) != catalog_version_ ||
+        VERIFY_RESULT(ReadBytes(&data)) != Slice(key_)) {
+      return false;
+    }
+    DataContainer result;
+    for (auto num_tables = VERIFY_RESULT(ReadFixed32(&data)); num_tables-- > 0;) {
+      const auto table_id = VERIFY_RESULT(ReadObjectId(&data));
+      auto& info = result[table_id];
+      info.targets = VERIFY_RESULT(ReadColumns(&data));
+      info.index_id = VERIFY_RESULT(ReadObjectId(&data));
+      info.index_targets = VERIFY_RESULT(ReadColumns(&data));
+      info.data = std::make_shared<DataHolder::element_type>();
+      for (auto num_chunks = VERIFY_RESULT(ReadFixed32(&data)); num_chunks-- > 0;) {
+        info.data->emplace_back(buffer, VERIFY_RESULT(ReadBytes(&data)));
+      }
+    }
+    SCHECK(data.empty(), Corruption, "Extra data in catalog snapshot $0", path_);
+    container->merge(result);
+    return true;
+  }
+
+  Status Write(Env* env, const DataContainer& container, const std::string& tmp_path) const {
+    faststring content;
+    PutFixed64(&content, catalog_version_);
+    PutFixed32LengthPrefixedSlice(&content, key_);
+    PutFixed32(&content, narrow_cast<uint32_t>(container.size()));
+    for (const auto& [table_id, info] : container) {
+      PutObjectId(&content, table_id);
+      PutColumns(&content, info.targets);
+      PutObjectId(&content, info.index_id);
+      PutColumns(&content, info.index_targets);
+      PutFixed32(&content, narrow_cast<uint32_t>(info.data->size()));
+      for (const auto& chunk : *info.data) {
+        PutFixed32LengthPrefixedSlice(&content, chunk.second);
+      }
+    }
+    faststring header;
+    PutFixed32(&header, kMagic);
+    PutFixed32(&header, crc::Crc32c(content.data(), content.size()));
+    header.append(content.data(), content.size());
+
+    RETURN_NOT_OK(WriteStringToFile(env, Slice(header.data(), header.size()), tmp_path));
+    return env->RenameFile(tmp_path, path_);
+  }
+
+  // Removes snapshots of the same tables for older catalog versions, and temp files left by
+  // writers that were interrupted. Should be called while holding the lock.
+  Status RemoveObsoleteFiles(Env* env) const {
+    const auto lock_name = name_prefix_ + kLockName;
+    for (const auto& name : VERIFY_RESULT(env->GetChildren(dir_, ExcludeDots::kTrue))) {
+      Slice name_slice(name);
+      if (!name_slice.starts_with(name_prefix_) || name == lock_name) {
+        continue;
+      }
+      name_slice.remove_prefix(name_prefix_.size());
+      if (name_slice.ends_with(kSuffix)) {
+        name_slice.remove_suffix(strlen(kSuffix));
+        auto version = CheckedStoull(name_slice);
+        if (version.ok() && *version >= catalog_version_) {
+          continue;
+        }
+      }
+      WARN_NOT_OK(
+          env->DeleteFile(JoinPathSegments(dir_, name)),
+          "Failed to remove obsolete catalog snapshot file");
+    }
+    return Status::OK();
+  }
+
+  static void PutObjectId(faststring* out, const PgObjectId& id) {
+    PutFixed32(out, id.database_oid);
+    PutFixed32(out, id.object_oid);
+  }
+
+  static void PutColumns(faststring* out, const ColumnIdsContainer& columns) {
+    PutFixed32(out, narrow_cast<uint32_t>(columns.size()));
+    for (auto column : columns) {
+      PutFixed32(out, static_cast<uint32_t>(column));
+    }
+  }
+
+  static Result<uint32_t> ReadFixed32(Slice* data) {
+    SCHECK_GE(data->size(), sizeof(uint32_t), Corruption, "Unexpected end of catalog snapshot");
+    auto result = DecodeFixed32(data->data());
+    data->remove_prefix(sizeof(uint32_t));
+    return result;
+  }
+
+  static Result<uint64_t> ReadFixed64(Slice* data) {
+    SCHECK_GE(data->size(), sizeof(uint64_t), Corruption, "Unexpected end of catalog snapshot");
+    auto result = DecodeFixed64(data->data());
+    data->remove_prefix(sizeof(uint64_t));
+    return result;
+  }
+
+  static Result<Slice> ReadBytes(Slice* data) {
+    const auto size = VERIFY_RESULT(ReadFixed32(data));
+    SCHECK_GE(data->size(), size, Corruption, "Unexpected end of catalog snapshot");
+    Slice result(data->data(), size);
+    data->remove_prefix(size);
+    return result;
+  }
+
+  static Result<PgObjectId> ReadObjectId(Slice* data) {
+    const auto database_oid = VERIFY_RESULT(ReadFixed32(data));
+    return PgObjectId(database_oid, VERIFY_RESULT(ReadFixed32(data)));
+  }
+
+  static Result<ColumnIdsContainer> ReadColumns(Slice* data) {
+    ColumnIdsContainer result(VERIFY_RESULT(ReadFixed32(data)));
+    for (auto& column : result) {
+      column = static_cast<int>(VERIFY_RESULT(ReadFixed32(data)));
+    }
+    return result;
+  }
+
+  const std::string dir_;
+  const uint64_t catalog_version_;
+  faststring key_;
+  std::string name_prefix_;
+  std::string path_;
+};
+
 } // namespace
 
 class PgSysTablePrefetcher::Impl {
@@ -403,12 +636,7 @@ class PgSysTablePrefetcher::Impl {
                                         [](const auto& item) { return item.first; });
       return PrefetchedDataHolder();
     }
-    Loader loader(session, registered_for_loading_.size(), latest_known_ysql_catalog_version_);
-    for (const auto& t : registered_for_loading_) {
-      RETURN_NOT_OK(loader.Apply(t.first, t.second));
-    }
-    registered_for_loading_.clear();
-    RETURN_NOT_OK(loader.Load(&data_));
+    RETURN_NOT_OK(LoadRegistered(session));
     return GetDataWithTargetsCheck(table_id, data_[table_id], read_req, index_check_required);
   }
 
@@ -417,7 +645,38 @@ class PgSysTablePrefetcher::Impl {
   }
 
  private:
-  std::unordered_map<PgObjectId, PgObjectId, PgObjectIdHash> registered_for_loading_;
+  Status LoadRegistered(PgSession* session) {
+    std::optional<CatalogSnapshot> snapshot;
+    // Catalog snapshot is used only when the catalog version was confirmed by the master.
+    if (FLAGS_ysql_enable_catalog_snapshot && !FLAGS_ysql_catalog_snapshot_dir.empty() &&
+        latest_known_ysql_catalog_version_) {
+      snapshot.emplace(
+          FLAGS_ysql_catalog_snapshot_dir, latest_known_ysql_catalog_version_,
+          registered_for_loading_);
+      auto loaded = snapshot->Load(&data_);
+      if (!loaded.ok()) {
+        LOG(WARNING) << "Failed to load catalog snapshot: " << loaded.status();
+      } else if (*loaded) {
+        VLOG(1) << "Loaded " << registered_for_loading_.size() << " tables from catalog snapshot";
+        registered_for_loading_.clear();
+        return Status::OK();
+      }
+    }
+    Loader loader(session, registered_for_loading_.size(), latest_known_ysql_catalog_version_);
+    for (const auto& t : registered_for_loading_) {
+      RETURN_NOT_OK(loader.Apply(t.first, t.second));
+    }
+    registered_for_loading_.clear();
+    DataContainer loaded_data;
+    RETURN_NOT_OK(loader.Load(&loaded_data));
+    if (snapshot) {
+      WARN_NOT_OK(snapshot->Save(loaded_data), "Failed to save catalog snapshot");
+    }
+    data_.merge(loaded_data);
+    return Status::OK();
+  }
+
+  RegisteredTables registered_for_loading_;
   DataContainer data_;
   const uint64_t latest_known_ysql_catalog_version_;
 };
@@ -1091,6 +1091,20 @@ Status PgApiImpl::DmlAppendTarget(PgStatement *handle, PgExpr *target) {
   return down_cast<PgDml*>(handle)->AppendTarget(target);
 }
 
+Status PgApiImpl::DmlAppendGroupBy(PgStatement *handle, PgExpr *group_by) {
+  return down_cast<PgDmlRead*>(handle)->AppendGroupBy(group_by);
+}
+
+Status PgApiImpl::DmlAppendOrderBy(
+    PgStatement *handle, PgExpr *order_by, bool is_descending, bool nulls_first) {
+  return down_cast<PgDmlRead*>(handle)->AppendOrderBy(order_by, is_descending, nulls_first);
+}
+
+Status PgApiImpl::DmlSetOrderByLimit(PgStatement *handle, uint64_t limit) {
+  down_cast<PgDmlRead*>(handle)->SetOrderByLimit(limit);
+  return Status::OK();
+}
+
 Status PgApiImpl::DmlAppendQual(PgStatement *handle, PgExpr *qual, bool is_primary) {
   return down_cast<PgDml*>(handle)->AppendQual(qual, is_primary);
 }
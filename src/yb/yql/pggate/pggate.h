@@ -372,6 +372,12 @@ class PgApiImpl {
   // All DML statements
   Status DmlAppendTarget(PgStatement *handle, PgExpr *expr);
 
+  Status DmlAppendGroupBy(PgStatement *handle, PgExpr *expr);
+
+  Status DmlAppendOrderBy(PgStatement *handle, PgExpr *expr, bool is_descending, bool nulls_first);
+
+  Status DmlSetOrderByLimit(PgStatement *handle, uint64_t limit);
+
   Status DmlAppendQual(PgStatement *handle, PgExpr *expr, bool is_primary);
 
   Status DmlAppendColumnRef(PgStatement *handle, PgExpr *colref, bool is_primary);
@@ -47,11 +47,26 @@ DEFINE_UNKNOWN_uint64(ysql_prefetch_limit, 1024,
 
 DEPRECATE_FLAG(double, ysql_backward_prefetch_scale_factor, "11_2022");
 
+DEFINE_RUNTIME_bool(ysql_enable_hash_key_ybctid_batching, false,
+    "Read rows by primary key with IN clauses on hash key columns, as produced by batched nested "
+    "loop joins, using ybctid batches. So one request per tablet is sent instead of one request "
+    "per hash key permutation.");
+
 DEFINE_UNKNOWN_uint64(ysql_session_max_batch_size, 3072,
               "Use session variable ysql_session_max_batch_size instead. "
               "Maximum batch size for buffered writes between PostgreSQL server and YugaByte DocDB "
               "services");
 
+DEFINE_RUNTIME_bool(ysql_flush_dependent_ops_only, false,
+    "When an operation that can't be buffered is performed, wait only for the in-flight buffered "
+    "writes it depends on, i.e. writes into the tables it reads or into the row it writes. Errors "
+    "of other in-flight writes are reported at the end of the statement or at commit.");
+
+DEFINE_RUNTIME_bool(ysql_enable_per_tablet_write_batching, false,
+    "Group buffered writes by destination tablet, and send each group as a separate request once "
+    "it reaches ysql_session_max_batch_size. Speeds up bulk loads such as COPY into tables with "
+    "many tablets. Increase ysql_max_in_flight_ops to allow larger batches in this case.");
+
 DEFINE_UNKNOWN_bool(ysql_non_txn_copy, false,
             "Execute COPY inserts non-transactionally.");
 
@@ -147,3 +162,17 @@ DEFINE_int32(ysql_num_databases_reserved_in_db_catalog_version_mode, 10,
              "fail the create database statement.");
 TAG_FLAG(ysql_num_databases_reserved_in_db_catalog_version_mode, advanced);
 TAG_FLAG(ysql_num_databases_reserved_in_db_catalog_version_mode, hidden);
+
+// Defined here, so the tserver, which links these flags, uses the same value to decide whether
+// to serve shared memory exchanges.
+DEFINE_NON_RUNTIME_bool(pg_client_use_shared_memory, false,
+    "Send Perform requests to the local tserver through shared memory instead of TCP.");
+
+DEFINE_NON_RUNTIME_bool(ysql_enable_catalog_snapshot, false,
+    "Store prefetched sys tables data in a file stamped with the catalog version, so new backends "
+    "could load it from the local disk instead of reading sys tables from the master.");
+
+DEFINE_NON_RUNTIME_string(ysql_catalog_snapshot_dir, "",
+    "Directory of the catalog snapshot files. The tserver passes the yb_catalog_snapshot "
+    "subdirectory of the postgres data directory to backends, unless it is specified explicitly. "
+    "Catalog snapshot is not used when the directory is not known.");
@@ -22,8 +22,11 @@ DECLARE_string(pggate_master_addresses);
 DECLARE_int32(pggate_tserver_shm_fd);
 DECLARE_int32(ysql_request_limit);
 DECLARE_uint64(ysql_prefetch_limit);
+DECLARE_bool(ysql_enable_hash_key_ybctid_batching);
 DECLARE_double(ysql_backward_prefetch_scale_factor);
 DECLARE_uint64(ysql_session_max_batch_size);
+DECLARE_bool(ysql_flush_dependent_ops_only);
+DECLARE_bool(ysql_enable_per_tablet_write_batching);
 DECLARE_bool(ysql_non_txn_copy);
 DECLARE_int32(ysql_max_read_restart_attempts);
 DECLARE_bool(TEST_ysql_disable_transparent_cache_refresh_retry);
@@ -47,3 +50,6 @@ DECLARE_bool(ysql_disable_portal_run_context);
 DECLARE_bool(TEST_yb_lwlock_crash_after_acquire_pg_stat_statements_reset);
 DECLARE_bool(TEST_yb_test_fail_matview_refresh_after_creation);
 DECLARE_bool(ysql_enable_read_request_caching);
+DECLARE_bool(ysql_enable_catalog_snapshot);
+DECLARE_bool(pg_client_use_shared_memory);
+DECLARE_string(ysql_catalog_snapshot_dir);
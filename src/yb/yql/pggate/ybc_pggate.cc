@@ -789,6 +789,19 @@ YBCStatus YBCPgDmlAppendTarget(YBCPgStatement handle, YBCPgExpr target) {
   return ToYBCStatus(pgapi->DmlAppendTarget(handle, target));
 }
 
+YBCStatus YBCPgDmlAppendGroupBy(YBCPgStatement handle, YBCPgExpr group_by) {
+  return ToYBCStatus(pgapi->DmlAppendGroupBy(handle, group_by));
+}
+
+YBCStatus YBCPgDmlAppendOrderBy(YBCPgStatement handle, YBCPgExpr order_by, bool is_descending,
+                                bool nulls_first) {
+  return ToYBCStatus(pgapi->DmlAppendOrderBy(handle, order_by, is_descending, nulls_first));
+}
+
+YBCStatus YBCPgDmlSetOrderByLimit(YBCPgStatement handle, uint64_t limit) {
+  return ToYBCStatus(pgapi->DmlSetOrderByLimit(handle, limit));
+}
+
 YBCStatus YbPgDmlAppendQual(YBCPgStatement handle, YBCPgExpr qual, bool is_primary) {
   return ToYBCStatus(pgapi->DmlAppendQual(handle, qual, is_primary));
 }
@@ -1334,6 +1347,7 @@ const YBCPgGFlagsAccessor* YBCGetGFlags() {
       .ysql_colocate_database_by_default       = &FLAGS_ysql_colocate_database_by_default,
       .ysql_ddl_rollback_enabled               = &FLAGS_ysql_ddl_rollback_enabled,
       .ysql_enable_read_request_caching        = &FLAGS_ysql_enable_read_request_caching,
+      .ysql_enable_catalog_snapshot            = &FLAGS_ysql_enable_catalog_snapshot,
       .ysql_enable_profile                     = &FLAGS_ysql_enable_profile
   };
   return &accessor;
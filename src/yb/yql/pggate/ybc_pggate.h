@@ -332,6 +332,20 @@ YBCStatus YBCPgBackfillIndex(
 // - INSERT / UPDATE / DELETE ... RETURNING target_expr1, target_expr2, ...
 YBCStatus YBCPgDmlAppendTarget(YBCPgStatement handle, YBCPgExpr target);
 
+// Add a grouping expression to the SELECT statement with aggregate targets.
+// - SELECT aggregate_expr1, ... FROM ... GROUP BY group_expr1, ...
+// Fetched rows contain values of grouping expressions after the targets.
+YBCStatus YBCPgDmlAppendGroupBy(YBCPgStatement handle, YBCPgExpr group_by);
+
+// Add a sort key to the SELECT statement, that has to return only first rows in the sort order.
+// - SELECT ... FROM ... ORDER BY order_by_expr1 [DESC] [NULLS FIRST], ... LIMIT n
+// Each tablet returns its first n rows, sorted. The caller is responsible for merging them.
+YBCStatus YBCPgDmlAppendOrderBy(YBCPgStatement handle, YBCPgExpr order_by, bool is_descending,
+                                bool nulls_first);
+
+// Set the number of rows each tablet should return for the statement with sort keys.
+YBCStatus YBCPgDmlSetOrderByLimit(YBCPgStatement handle, uint64_t limit);
+
 // Add a WHERE clause condition to the statement.
 // Currently only SELECT statement supports WHERE clause conditions.
 // Only serialized Postgres expressions are allowed.
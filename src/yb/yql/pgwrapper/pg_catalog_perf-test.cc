@@ -10,12 +10,15 @@
 // or implied.  See the License for the specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <thread>
 #include <unordered_map>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <gflags/gflags.h>
 
 #include "yb/master/master.h"
@@ -24,7 +27,10 @@
 #include "yb/tserver/tablet_server.h"
 #include "yb/tserver/mini_tablet_server.h"
 
+#include "yb/util/env.h"
+#include "yb/util/faststring.h"
 #include "yb/util/metrics.h"
+#include "yb/util/path_util.h"
 #include "yb/util/result.h"
 #include "yb/util/status.h"
 #include "yb/util/test_macros.h"
@@ -36,7 +42,11 @@
 METRIC_DECLARE_histogram(handler_latency_yb_tserver_TabletServerService_Read);
 METRIC_DECLARE_counter(pg_response_cache_queries);
 METRIC_DECLARE_counter(pg_response_cache_hits);
+METRIC_DECLARE_counter(pg_response_cache_evictions);
 DECLARE_bool(ysql_enable_read_request_caching);
+DECLARE_bool(ysql_enable_catalog_snapshot);
+DECLARE_string(ysql_catalog_snapshot_dir);
+DECLARE_uint64(pg_response_cache_size_bytes);
 
 namespace yb {
 namespace pgwrapper {
@@ -60,6 +70,8 @@ class ConfigurablePgCatalogPerfTest : public PgMiniTestBase {
         tserver, METRIC_pg_response_cache_queries);
     response_cache_hits_ = std::make_unique<MetricWatcher>(
         tserver, METRIC_pg_response_cache_hits);
+    response_cache_evictions_ = std::make_unique<MetricWatcher>(
+        tserver, METRIC_pg_response_cache_evictions);
   }
 
   size_t NumTabletServers() override {
@@ -115,11 +127,61 @@ class ConfigurablePgCatalogPerfTest : public PgMiniTestBase {
   std::unique_ptr<MetricWatcher> read_rpc_watcher_;
   std::unique_ptr<MetricWatcher> response_cache_queries_;
   std::unique_ptr<MetricWatcher> response_cache_hits_;
+  std::unique_ptr<MetricWatcher> response_cache_evictions_;
 };
 
 using PgCatalogPerfTest = ConfigurablePgCatalogPerfTest<false>;
 using PgCatalogWithCachePerfTest = ConfigurablePgCatalogPerfTest<true>;
 
+class PgCatalogWithSnapshotPerfTest : public PgCatalogPerfTest {
+ protected:
+  void SetUp() override {
+    FLAGS_ysql_enable_catalog_snapshot = true;
+    FLAGS_ysql_catalog_snapshot_dir = JoinPathSegments(GetTestDataDirectory(), "catalog_snapshot");
+    PgCatalogPerfTest::SetUp();
+  }
+
+  Result<uint64_t> ConnectRPCCount() {
+    return read_rpc_watcher_->Delta([this]() -> Status {
+      RETURN_NOT_OK(Connect());
+      return Status::OK();
+    });
+  }
+
+  Result<std::vector<std::string>> SnapshotFiles() {
+    const auto& dir = FLAGS_ysql_catalog_snapshot_dir;
+    std::vector<std::string> result;
+    for (const auto& name : VERIFY_RESULT(Env::Default()->GetChildren(dir, ExcludeDots::kTrue))) {
+      if (boost::ends_with(name, ".snapshot")) {
+        result.push_back(JoinPathSegments(dir, name));
+      }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  // Checks that the snapshot files damaged by the mutator are rejected, and then rewritten by the
+  // backend that reads sys tables from the master.
+  void TestDamagedSnapshot(const std::function<void(std::string*)>& mutator) {
+    const auto first_rpc_count = ASSERT_RESULT(ConnectRPCCount());
+    const auto cached_rpc_count = ASSERT_RESULT(ConnectRPCCount());
+    ASSERT_LT(cached_rpc_count, first_rpc_count);
+    const auto files = ASSERT_RESULT(SnapshotFiles());
+    ASSERT_FALSE(files.empty());
+    auto* env = Env::Default();
+    for (const auto& path : files) {
+      faststring content;
+      ASSERT_OK(ReadFileToString(env, path, &content));
+      auto data = content.ToString();
+      mutator(&data);
+      ASSERT_OK(WriteStringToFile(env, data, path));
+    }
+    ASSERT_GT(ASSERT_RESULT(ConnectRPCCount()), cached_rpc_count);
+    ASSERT_EQ(ASSERT_RESULT(SnapshotFiles()), files);
+    ASSERT_EQ(ASSERT_RESULT(ConnectRPCCount()), cached_rpc_count);
+  }
+};
+
 } // namespace
 
 // Test checks the number of RPC for very first and subsequent connection to same t-server.
@@ -236,5 +298,102 @@ TEST_F_EX(PgCatalogPerfTest,
   ASSERT_LE(read_rpc_counter, 720);
 }
 
+// The test checks that entries of the response cache are evicted when the size of cached responses
+// exceeds the limit.
+TEST_F_EX(PgCatalogPerfTest,
+          YB_DISABLE_TEST_IN_TSAN(ResponseCacheMemoryLimit),
+          PgCatalogWithCachePerfTest) {
+  auto conn = ASSERT_RESULT(Connect());
+  ASSERT_OK(conn.Execute("CREATE TABLE t (r INT PRIMARY KEY)"));
+  std::vector<PGConn> conns;
+  constexpr size_t kConnectionCount = 3;
+  for (size_t i = 0; i < kConnectionCount; ++i) {
+    conns.push_back(ASSERT_RESULT(Connect()));
+    ASSERT_RESULT(conns.back().Fetch("SELECT * FROM t"));
+  }
+  ANNOTATE_UNPROTECTED_WRITE(FLAGS_pg_response_cache_size_bytes) = 1;
+  std::pair<uint64_t, uint64_t> cache_counters;
+  const auto evictions = ASSERT_RESULT(response_cache_evictions_->Delta(
+      [this, &conn, &conns, &cache_counters]() -> Status {
+        cache_counters = VERIFY_RESULT(ResponseCacheCountersDelta([&conn, &conns]() -> Status {
+          RETURN_NOT_OK(conn.Execute("ALTER TABLE t ADD COLUMN v INT"));
+          size_t idx = 0;
+          for (auto& c : conns) {
+            RETURN_NOT_OK(c.ExecuteFormat("INSERT INTO t VALUES($0)", ++idx));
+          }
+          return Status::OK();
+        }));
+        return Status::OK();
+      }));
+  // Each response is evicted as soon as it is loaded, so nothing is served from the cache.
+  ASSERT_GT(cache_counters.first, 0);
+  ASSERT_EQ(cache_counters.second, 0);
+  ASSERT_GT(evictions, 0);
+}
+
+// The test checks that a new connection, which refreshes its catalog cache on start, loads sys
+// tables from the catalog snapshot written by the previous connection instead of reading them
+// from the master.
+TEST_F_EX(PgCatalogPerfTest,
+          YB_DISABLE_TEST_IN_TSAN(CatalogSnapshot),
+          PgCatalogWithSnapshotPerfTest) {
+  const auto connector = [this]() -> Status {
+    RETURN_NOT_OK(Connect());
+    return Status::OK();
+  };
+  auto conn = ASSERT_RESULT(Connect());
+  ASSERT_OK(conn.Execute("CREATE TABLE cache_refresh_trigger (k INT)"));
+  // Force version increment, so the snapshot written before becomes outdated.
+  ASSERT_OK(conn.Execute("ALTER TABLE cache_refresh_trigger ADD COLUMN v INT"));
+  const auto first_connect_rpc_count = ASSERT_RESULT(read_rpc_watcher_->Delta(connector));
+  const auto subsequent_connect_rpc_count = ASSERT_RESULT(read_rpc_watcher_->Delta(connector));
+  ASSERT_LT(subsequent_connect_rpc_count, first_connect_rpc_count);
+}
+
+// The test checks that the snapshot written for the previous catalog version is not used after
+// DDL, and is replaced by the snapshot for the new version.
+TEST_F_EX(PgCatalogPerfTest,
+          YB_DISABLE_TEST_IN_TSAN(CatalogSnapshotInvalidatedByDdl),
+          PgCatalogWithSnapshotPerfTest) {
+  auto conn = ASSERT_RESULT(Connect());
+  ASSERT_OK(conn.Execute("CREATE TABLE t (k INT)"));
+  const auto first_rpc_count = ASSERT_RESULT(ConnectRPCCount());
+  const auto cached_rpc_count = ASSERT_RESULT(ConnectRPCCount());
+  ASSERT_LT(cached_rpc_count, first_rpc_count);
+  const auto files = ASSERT_RESULT(SnapshotFiles());
+  ASSERT_FALSE(files.empty());
+
+  ASSERT_OK(conn.Execute("ALTER TABLE t ADD COLUMN v INT"));
+  const auto after_ddl_rpc_count = ASSERT_RESULT(ConnectRPCCount());
+  ASSERT_GT(after_ddl_rpc_count, cached_rpc_count);
+  auto new_files = ASSERT_RESULT(SnapshotFiles());
+  ASSERT_EQ(new_files.size(), files.size());
+  for (const auto& path : files) {
+    ASSERT_FALSE(Env::Default()->FileExists(path)) << path;
+  }
+
+  // Connection that uses the new snapshot sees the result of DDL.
+  auto new_conn = ASSERT_RESULT(Connect());
+  ASSERT_OK(new_conn.Execute("INSERT INTO t (k, v) VALUES (1, 2)"));
+  ASSERT_EQ(ASSERT_RESULT(new_conn.FetchValue<int32_t>("SELECT v FROM t WHERE k = 1")), 2);
+  ASSERT_LT(ASSERT_RESULT(ConnectRPCCount()), after_ddl_rpc_count);
+}
+
+TEST_F_EX(PgCatalogPerfTest,
+          YB_DISABLE_TEST_IN_TSAN(CorruptedCatalogSnapshot),
+          PgCatalogWithSnapshotPerfTest) {
+  TestDamagedSnapshot([](std::string* data) {
+    (*data)[data->size() / 2] ^= 1;
+  });
+}
+
+TEST_F_EX(PgCatalogPerfTest,
+          YB_DISABLE_TEST_IN_TSAN(TruncatedCatalogSnapshot),
+          PgCatalogWithSnapshotPerfTest) {
+  TestDamagedSnapshot([](std::string* data) {
+    data->resize(data->size() / 2);
+  });
+}
+
 } // namespace pgwrapper
 } // namespace yb
@@ -43,6 +43,9 @@
 
 #include "yb/tools/tools_test_utils.h"
 
+#include "yb/tserver/mini_tablet_server.h"
+#include "yb/tserver/tablet_server.h"
+
 #include "yb/util/atomic.h"
 #include "yb/util/backoff_waiter.h"
 #include "yb/util/debug-util.h"
@@ -97,6 +100,8 @@ DECLARE_uint64(max_clock_skew_usec);
 DECLARE_bool(ysql_enable_packed_row);
 DECLARE_bool(ysql_enable_packed_row_for_colocated_table);
 
+METRIC_DECLARE_histogram(handler_latency_yb_tserver_TabletServerService_Read);
+
 namespace yb {
 namespace pgwrapper {
 namespace {
@@ -1986,6 +1991,152 @@ TEST_F_EX(PgMiniTest, YB_DISABLE_TEST_IN_TSAN(SingleRowScan), PgMiniRPCTest) {
   Run(kRows, kBlockSize, kReads);
 }
 
+// Results of pushed down aggregates and top-N match results computed by Postgres.
+TEST_F(PgMiniTest, YB_DISABLE_TEST_IN_TSAN(PushdownResults)) {
+  constexpr int kRows = 1000;
+
+  auto conn = ASSERT_RESULT(Connect());
+  ASSERT_OK(conn.Execute(
+      "CREATE TABLE t (k INT PRIMARY KEY, i INT, b BIGINT, d DOUBLE PRECISION, s TEXT) "
+      "SPLIT INTO 3 TABLETS"));
+  ASSERT_OK(conn.Execute("CREATE INDEX ON t (i)"));
+  // Every fifth row contains NULLs.
+  ASSERT_OK(conn.ExecuteFormat(
+      "INSERT INTO t SELECT k, NULLIF(k % 5, 0) * 10, NULLIF(k % 5, 0) * 1000000000000, "
+      "NULLIF(k % 5, 0) / 3.0, CASE WHEN k % 5 = 0 THEN NULL ELSE repeat('x', k % 7) END "
+      "FROM generate_series(1, $0) k", kRows));
+  // Temporary table is not stored in DocDB, so it is used to get expected results.
+  ASSERT_OK(conn.Execute("CREATE TEMP TABLE expected AS SELECT * FROM t"));
+  ASSERT_OK(conn.Execute("SET yb_enable_group_by_pushdown = on"));
+  ASSERT_OK(conn.Execute("SET yb_enable_top_n_pushdown = on"));
+
+  for (const auto* query : {
+      "SELECT * FROM $0 ORDER BY k",
+      "SELECT count(*), count(i), sum(b), max(s), min(d) FROM $0",
+      "SELECT i, count(*), sum(b), max(s) FROM $0 GROUP BY i ORDER BY i",
+      "SELECT k, s FROM $0 ORDER BY d DESC, k LIMIT 10",
+      "SELECT k, s FROM $0 WHERE i = 20 ORDER BY k"}) {
+    auto result = ASSERT_RESULT(conn.FetchAllAsString(Format(query, "t")));
+    ASSERT_EQ(result, ASSERT_RESULT(conn.FetchAllAsString(Format(query, "expected")))) << query;
+  }
+}
+
+class PgMiniSharedMemoryTest : public PgMiniSingleTServerTest {
+ protected:
+  void SetUp() override {
+    FLAGS_pg_client_use_shared_memory = true;
+    PgMiniTest::SetUp();
+  }
+};
+
+// Queries and transactions work when Perform requests are sent through shared memory.
+TEST_F_EX(PgMiniTest, YB_DISABLE_TEST_IN_TSAN(SharedMemoryPerform), PgMiniSharedMemoryTest) {
+  constexpr int kRows = 100;
+
+  auto conn = ASSERT_RESULT(Connect());
+  ASSERT_OK(conn.Execute("CREATE TABLE t (k INT PRIMARY KEY, v TEXT)"));
+  ASSERT_OK(conn.ExecuteFormat(
+      "INSERT INTO t SELECT k, 'v' || k FROM generate_series(1, $0) k", kRows));
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int64_t>("SELECT count(*) FROM t")), kRows);
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<std::string>("SELECT v FROM t WHERE k = 10")), "v10");
+
+  ASSERT_OK(conn.StartTransaction(IsolationLevel::SNAPSHOT_ISOLATION));
+  ASSERT_OK(conn.Execute("UPDATE t SET v = 'updated' WHERE k <= 10"));
+  ASSERT_OK(conn.Execute("DELETE FROM t WHERE k > 90"));
+  ASSERT_OK(conn.CommitTransaction());
+
+  ASSERT_OK(conn.StartTransaction(IsolationLevel::SNAPSHOT_ISOLATION));
+  ASSERT_OK(conn.Execute("DELETE FROM t"));
+  ASSERT_OK(conn.RollbackTransaction());
+
+  // Another connection uses its own exchange.
+  auto conn2 = ASSERT_RESULT(Connect());
+  ASSERT_EQ(ASSERT_RESULT(conn2.FetchValue<int64_t>(
+      "SELECT count(*) FROM t WHERE v = 'updated'")), 10);
+  ASSERT_EQ(ASSERT_RESULT(conn2.FetchValue<int64_t>("SELECT count(*) FROM t")), kRows - 10);
+}
+
+class PgMiniHashKeyYbctidBatchingTest : public PgMiniTest {
+ protected:
+  static constexpr int kRequestLimit = 64;
+
+  void SetUp() override {
+    FLAGS_ysql_enable_hash_key_ybctid_batching = true;
+    FLAGS_ysql_request_limit = kRequestLimit;
+    PgMiniTest::SetUp();
+    read_rpc_watcher_ = std::make_unique<MetricWatcher>(
+        *cluster_->mini_tablet_server(0)->server(),
+        METRIC_handler_latency_yb_tserver_TabletServerService_Read);
+  }
+
+  size_t NumTabletServers() override {
+    return 1;
+  }
+
+  // Checks that the query returns the same result for the table and for its temporary copy, and
+  // returns the number of read RPCs to the tablets of the table.
+  Result<size_t> CheckQuery(PGConn* conn, const std::string& query) {
+    std::string result;
+    const auto rpc_count = VERIFY_RESULT(read_rpc_watcher_->Delta(
+        [conn, &query, &result]() -> Status {
+      result = VERIFY_RESULT(conn->FetchAllAsString(Format(query, "t")));
+      return Status::OK();
+    }));
+    const auto expected = VERIFY_RESULT(conn->FetchAllAsString(Format(query, "expected")));
+    SCHECK_EQ(result, expected, IllegalState, Format("Wrong result of $0", query));
+    return rpc_count;
+  }
+
+  std::unique_ptr<MetricWatcher> read_rpc_watcher_;
+};
+
+TEST_F_EX(PgMiniTest, YB_DISABLE_TEST_IN_TSAN(HashKeyYbctidBatching),
+          PgMiniHashKeyYbctidBatchingTest) {
+  constexpr int kRows = 500;
+  constexpr int kTablets = 3;
+  constexpr int kBatchSize = 100;
+
+  auto conn = ASSERT_RESULT(Connect());
+  ASSERT_OK(conn.ExecuteFormat(
+      "CREATE TABLE t (h1 INT, h2 TEXT, r INT, v TEXT, PRIMARY KEY ((h1, h2) HASH, r)) "
+      "SPLIT INTO $0 TABLETS", kTablets));
+  ASSERT_OK(conn.ExecuteFormat(
+      "INSERT INTO t SELECT k / 10, (k % 10)::TEXT, k % 3, repeat('v', k % 7) "
+      "FROM generate_series(1, $0) k", kRows));
+  // Temporary tables are not stored in DocDB, so they are used to get expected results, and as
+  // the outer side of joins, that does not send read RPCs.
+  ASSERT_OK(conn.Execute("CREATE TEMP TABLE expected AS SELECT * FROM t"));
+  ASSERT_OK(conn.ExecuteFormat(
+      "CREATE TEMP TABLE small_outer AS SELECT k, k / 10 AS h1, (k % 10)::TEXT AS h2, k % 3 AS r "
+      "FROM generate_series(1, $0) k", kRequestLimit / 2));
+  ASSERT_OK(conn.ExecuteFormat(
+      "CREATE TEMP TABLE large_outer AS SELECT k, k / 10 AS h1, (k % 10)::TEXT AS h2, k % 3 AS r "
+      "FROM generate_series(1, $0) k", kRequestLimit + kRequestLimit / 2));
+  ASSERT_OK(conn.ExecuteFormat("SET yb_bnl_batch_size = $0", kBatchSize));
+  ASSERT_OK(conn.Execute("SET enable_hashjoin = off"));
+  ASSERT_OK(conn.Execute("SET enable_mergejoin = off"));
+
+  // Hash key permutations are read by ybctids, one request per tablet.
+  for (const auto* query : {
+      "SELECT * FROM $0 WHERE h1 IN (1, 5, 7, 100) AND h2 IN ('1', '3', NULL) AND r = 1 "
+          "ORDER BY h1, h2",
+      "SELECT * FROM $0 WHERE h1 IN (2, 3) AND h2 IN ('2', '5', '6') AND r IN (0, 2) "
+          "ORDER BY h1, h2, r"}) {
+    ASSERT_LE(ASSERT_RESULT(CheckQuery(&conn, query)), kTablets) << query;
+  }
+
+  // Batched nested loop join zips join clauses into the tuple IN clause.
+  const std::string join_query =
+      "SELECT t.* FROM $1 o JOIN $0 t ON t.h1 = o.h1 AND t.h2 = o.h2 AND t.r = o.r ORDER BY o.k";
+  const auto explain = ASSERT_RESULT(conn.FetchAllAsString(
+      "EXPLAIN " + Format(join_query, "t", "small_outer")));
+  ASSERT_STR_CONTAINS(explain, "YB Batched Nested Loop");
+  ASSERT_LE(ASSERT_RESULT(CheckQuery(&conn, Format(join_query, "$0", "small_outer"))), kTablets);
+
+  // Number of ybctids exceeds ysql_request_limit, so hash permutations are read in several rounds.
+  ASSERT_GT(ASSERT_RESULT(CheckQuery(&conn, Format(join_query, "$0", "large_outer"))), kTablets);
+}
+
 TEST_F(PgMiniTest, YB_DISABLE_TEST_IN_TSAN(DDLWithRestart)) {
   SetAtomicFlag(1.0, &FLAGS_TEST_transaction_ignore_applying_probability);
   FLAGS_TEST_force_master_leader_resolution = true;
@@ -95,9 +95,10 @@ class MetricWatcher {
 
   Result<size_t> Delta(const DeltaFunctor& functor) const;
 
- private:
   Result<size_t> GetMetricCount() const;
 
+ private:
+
   const server::RpcServerBase& server_;
   const MetricPrototype& metric_;
 };
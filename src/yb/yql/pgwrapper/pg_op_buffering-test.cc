@@ -17,6 +17,7 @@
 #include "yb/util/metrics.h"
 #include "yb/util/status.h"
 #include "yb/util/test_macros.h"
+#include "yb/util/test_thread_holder.h"
 
 #include "yb/tserver/mini_tablet_server.h"
 #include "yb/tserver/tablet_server.h"
@@ -24,8 +25,17 @@
 #include "yb/yql/pgwrapper/libpq_utils.h"
 #include "yb/yql/pgwrapper/pg_mini_test_base.h"
 
+METRIC_DECLARE_histogram(handler_latency_yb_tserver_TabletServerService_Read);
 METRIC_DECLARE_histogram(handler_latency_yb_tserver_TabletServerService_Write);
 
+DECLARE_bool(ysql_enable_per_tablet_write_batching);
+DECLARE_bool(ysql_flush_dependent_ops_only);
+DECLARE_bool(ysql_non_txn_copy);
+DECLARE_uint64(ysql_prefetch_limit);
+DECLARE_bool(TEST_pause_preparer_before_replicate);
+
+using namespace std::literals;
+
 namespace yb {
 namespace pgwrapper {
 namespace {
@@ -301,5 +311,165 @@ TEST_F(PgOpBufferingTest, YB_DISABLE_TEST_IN_TSAN(TxnRollbackWithInFlightOperati
   ASSERT_RESULT(conn.Fetch("SELECT * FROM t"));
 }
 
+class PgOpBufferingFlushDependentOpsTest : public PgOpBufferingTest {
+ protected:
+  static constexpr int kBatchSize = 10;
+
+  void SetUp() override {
+    FLAGS_ysql_flush_dependent_ops_only = true;
+    // Read every batch of written rows with a separate read request.
+    FLAGS_ysql_prefetch_limit = kBatchSize;
+    PgOpBufferingTest::SetUp();
+  }
+};
+
+// The test checks that reads wait for in-flight writes into the tables they use only, and that the
+// error of in-flight write, which reads don't depend on, is reported at the end of the statement.
+TEST_F_EX(PgOpBufferingTest, YB_DISABLE_TEST_IN_TSAN(FlushDependentOpsOnly),
+          PgOpBufferingFlushDependentOpsTest) {
+  auto conn = ASSERT_RESULT(Connect());
+  ASSERT_OK(CreateTable(&conn));
+  const std::string src_table = "src_test";
+  ASSERT_OK(CreateTable(&conn, src_table));
+  ASSERT_OK(SetMaxBatchSize(&conn, kBatchSize));
+  constexpr int kBatches = 30;
+  constexpr int kRows = kBatchSize * kBatches;
+  ASSERT_OK(conn.ExecuteFormat(
+      "INSERT INTO $0 SELECT s, s FROM generate_series(1, $1) AS s", src_table, kRows));
+  const auto count_query = Format("SELECT COUNT(*) FROM $0", kTable);
+
+  MetricWatcher read_rpc_watcher(
+      *cluster_->mini_tablet_server(0)->server(),
+      METRIC_handler_latency_yb_tserver_TabletServerService_Read);
+  // Runs the statement while replication of writes is paused, and returns the number of reads
+  // performed before any of its writes could complete.
+  const auto reads_before_writes_complete = [&conn, &read_rpc_watcher](
+      const std::string& statement, size_t expected_reads) -> Result<size_t> {
+    const auto initial_reads = VERIFY_RESULT(read_rpc_watcher.GetMetricCount());
+    const auto reads_delta = [&read_rpc_watcher, initial_reads]() -> Result<size_t> {
+      return VERIFY_RESULT(read_rpc_watcher.GetMetricCount()) - initial_reads;
+    };
+    FLAGS_TEST_pause_preparer_before_replicate = true;
+    TestThreadHolder thread_holder;
+    thread_holder.AddThreadFunctor([&conn, &statement] {
+      ASSERT_OK(conn.Execute(statement));
+    });
+    auto status = WaitFor(
+        [&reads_delta, expected_reads]() -> Result<bool> {
+          return VERIFY_RESULT(reads_delta()) >= expected_reads;
+        },
+        30s, "Wait for reads");
+    // Reads which wait for writes would not be performed, even if given more time.
+    SleepFor(500ms);
+    auto result = reads_delta();
+    FLAGS_TEST_pause_preparer_before_replicate = false;
+    thread_holder.JoinAll();
+    RETURN_NOT_OK(status);
+    return result;
+  };
+
+  ASSERT_OK(conn.StartTransaction(IsolationLevel::SNAPSHOT_ISOLATION));
+  // Reads from the source table don't depend on in-flight writes into the destination table, so
+  // all of them are performed before any write completes.
+  ASSERT_GE(ASSERT_RESULT(reads_before_writes_complete(
+      Format("INSERT INTO $0 SELECT * FROM $1", kTable, src_table), kBatches)),
+            static_cast<size_t>(kBatches));
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int64_t>(count_query)), kRows);
+
+  // Source and destination tables are the same, so each read except the first one waits for
+  // preceding writes.
+  ASSERT_EQ(ASSERT_RESULT(reads_before_writes_complete(
+      Format("INSERT INTO $0 SELECT k + $1, v FROM $0", kTable, kRows), 1)), 1U);
+  // Reads in the same transaction see all the written rows.
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int64_t>(count_query)), kRows * 2);
+  ASSERT_OK(conn.CommitTransaction());
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int64_t>(count_query)), kRows * 2);
+
+  ASSERT_OK(conn.StartTransaction(IsolationLevel::SNAPSHOT_ISOLATION));
+  ASSERT_OK(EnsureDupKeyError(
+      conn.ExecuteFormat("INSERT INTO $0 SELECT k + $1, v FROM $2", kTable, kRows, src_table),
+      PKConstraintName(kTable)));
+  ASSERT_OK(conn.RollbackTransaction());
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int64_t>(count_query)), kRows * 2);
+}
+
+class PgOpBufferingPerTabletTest : public PgOpBufferingTest {
+ protected:
+  void SetUp() override {
+    FLAGS_ysql_enable_per_tablet_write_batching = true;
+    // COPY writes are not transactional, so they are grouped into separate tablet batches.
+    FLAGS_ysql_non_txn_copy = true;
+    PgOpBufferingTest::SetUp();
+  }
+};
+
+// The test checks that with per tablet batching each tablet receives full sized batches, so
+// the number of write RPCs does not depend on how rows are distributed across tablets.
+TEST_F_EX(PgOpBufferingTest, YB_DISABLE_TEST_IN_TSAN(PerTabletBatching),
+          PgOpBufferingPerTabletTest) {
+  auto conn = ASSERT_RESULT(Connect());
+  constexpr int kTablets = 3;
+  constexpr int kBatchSize = 100;
+  constexpr int kRows = kTablets * kBatchSize * 5;
+  ASSERT_OK(conn.ExecuteFormat(
+      "CREATE TABLE $0(k INT PRIMARY KEY, v INT) SPLIT INTO $1 TABLETS", kTable, kTablets));
+  ASSERT_OK(SetMaxBatchSize(&conn, kBatchSize));
+  const auto insert_query = Format(
+      "INSERT INTO $0 SELECT s, s FROM generate_series(1, $1) AS s", kTable, kRows);
+  const auto write_rpc_count = ASSERT_RESULT(write_rpc_watcher_->Delta(
+      [&conn, &insert_query]() {
+    return conn.Execute(insert_query);
+  }));
+  // Each tablet receives full batches, and a single partial batch at the end of the statement.
+  ASSERT_LE(write_rpc_count, kRows / kBatchSize + kTablets);
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int64_t>(Format(
+      "SELECT COUNT(*) FROM $0", kTable))), kRows);
+
+  // Writes of the same row are still performed in different RPCs.
+  ASSERT_OK(conn.ExecuteFormat(
+      "DO $$$$" \
+      "BEGIN" \
+      "  INSERT INTO $0 VALUES($1, 1);" \
+      "  UPDATE $0 SET v = v + 1 WHERE k = $1;" \
+      "END$$$$;",
+      kTable, kRows + 1));
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int32_t>(Format(
+      "SELECT v FROM $0 WHERE k = $1", kTable, kRows + 1))), 2);
+
+  // Number of tablets exceeds the number of in-flight batches of max_batch_size allowed by
+  // ysql_max_in_flight_ops, so tablets receive partial batches, each of them is not less than
+  // kBatchSize / kManyTablets.
+  constexpr int kManyTablets = 6;
+  const std::string many_tablets_table = "many_tablets_test";
+  ASSERT_OK(conn.ExecuteFormat(
+      "CREATE TABLE $0(k INT PRIMARY KEY, v INT) SPLIT INTO $1 TABLETS",
+      many_tablets_table, kManyTablets));
+  ASSERT_OK(conn.ExecuteFormat("SET ysql_max_in_flight_ops = $0", kBatchSize));
+  const auto max_write_rpc_count = kRows / (kBatchSize / kManyTablets) + kManyTablets;
+  const auto many_tablets_count_query = Format("SELECT COUNT(*) FROM $0", many_tablets_table);
+  const auto many_tablets_insert_query = Format(
+      "INSERT INTO $0 SELECT s, s FROM generate_series(1, $1) AS s", many_tablets_table, kRows);
+  const auto insert_rpc_count = ASSERT_RESULT(write_rpc_watcher_->Delta(
+      [&conn, &many_tablets_insert_query]() {
+    return conn.Execute(many_tablets_insert_query);
+  }));
+  ASSERT_LE(insert_rpc_count, max_write_rpc_count);
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int64_t>(many_tablets_count_query)), kRows);
+
+  // Non transactional COPY uses per tablet batching as well.
+  const auto copy_rpc_count = ASSERT_RESULT(write_rpc_watcher_->Delta(
+      [&conn, &many_tablets_table]() -> Status {
+    RETURN_NOT_OK(conn.CopyBegin(Format("COPY $0 FROM STDIN WITH BINARY", many_tablets_table)));
+    for (int i = 1; i <= kRows; ++i) {
+      conn.CopyStartRow(2);
+      conn.CopyPutInt32(kRows + i);
+      conn.CopyPutInt32(i);
+    }
+    return ResultToStatus(conn.CopyEnd());
+  }));
+  ASSERT_LE(copy_rpc_count, max_write_rpc_count);
+  ASSERT_EQ(ASSERT_RESULT(conn.FetchValue<int64_t>(many_tablets_count_query)), kRows * 2);
+}
+
 } // namespace pgwrapper
 } // namespace yb
@@ -61,6 +61,8 @@ DEFINE_UNKNOWN_int64(
     "set for Postgres backends");
 
 DECLARE_string(metric_node_name);
+DECLARE_bool(ysql_enable_catalog_snapshot);
+DECLARE_string(ysql_catalog_snapshot_dir);
 TAG_FLAG(pg_transactions_enabled, advanced);
 TAG_FLAG(pg_transactions_enabled, hidden);
 
@@ -688,6 +690,16 @@ void PgWrapper::SetCommonEnv(Subprocess* proc, bool yb_enabled) {
 
     proc->SetEnv("YB_PG_TRANSACTIONS_ENABLED", FLAGS_pg_transactions_enabled ? "1" : "0");
 
+    if (FLAGS_ysql_enable_catalog_snapshot && FLAGS_ysql_catalog_snapshot_dir.empty()) {
+      // Backends work in the data directory, so the path should not depend on the working dir.
+      const auto& data_dir = conf_.data_dir;
+      proc->SetEnv(
+          "FLAGS_ysql_catalog_snapshot_dir",
+          JoinPathSegments(
+              boost::starts_with(data_dir, "/") ? data_dir : JoinPathSegments(cwd, data_dir),
+              "yb_catalog_snapshot"));
+    }
+
 #ifdef ADDRESS_SANITIZER
     // Disable reporting signal-unsafe behavior for PostgreSQL because it does a lot of work in
     // signal handlers on shutdown.